@@ -53,9 +53,11 @@ draw_nodes/CCDrawNode.cpp \
 draw_nodes/CCDrawingPrimitives.cpp \
 images/CAImage.cpp \
 images/CAImageCache.cpp \
+images/CAGlyphAtlas.cpp \
 shaders/CATransformation.cpp \
 shaders/CAGLProgram.cpp \
 shaders/CAShaderCache.cpp \
+shaders/CARenderQueue.cpp \
 shaders/ccGLStateCache.cpp \
 shaders/ccShaders.cpp \
 support/md5.cpp \
@@ -103,6 +105,7 @@ kazmath/src/aabb.c \
 kazmath/src/mat3.c \
 kazmath/src/mat4.c \
 kazmath/src/neon_matrix_impl.c \
+kazmath/src/simd_matrix_impl.c \
 kazmath/src/plane.c \
 kazmath/src/quaternion.c \
 kazmath/src/ray2.c \
@@ -151,10 +154,12 @@ LOCAL_C_INCLUDES := $(LOCAL_PATH) \
                     $(LOCAL_PATH)/platform/android \
 
 LOCAL_LDLIBS := -lGLESv2 \
+                -lEGL \
                 -llog \
                 -lz
 
 LOCAL_EXPORT_LDLIBS := -lGLESv2 \
+                       -lEGL \
                        -llog \
                        -lz
 
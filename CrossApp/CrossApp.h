@@ -41,6 +41,7 @@
 #include "basics/CAScheduler.h"
 #include "basics/CASTLContainer.h"
 #include "basics/CAIndexPath.h"
+#include "basics/CAFenwickTree.h"
 #include "basics/CAThread.h"
 #include "basics/CASyncQueue.h"
 
@@ -74,6 +75,7 @@
 // images
 #include "images/CAImage.h"
 #include "images/CAImageCache.h"
+#include "images/CAGlyphAtlas.h"
 
 #include "animation/CAViewAnimation.h"
 
@@ -122,6 +124,7 @@
 #include "shaders/CAGLProgram.h"
 #include "shaders/ccGLStateCache.h"
 #include "shaders/CAShaderCache.h"
+#include "shaders/CARenderQueue.h"
 #include "shaders/ccShaders.h"
 
 
@@ -310,6 +310,19 @@ unsigned int CCActionManager::numberOfRunningActionsInTarget(CAObject *pTarget)
     return 0;
 }
 
+bool CCActionManager::hasRunningActions()
+{
+    for (tHashElement *pElement = m_pTargets; pElement != NULL; pElement = (tHashElement*)pElement->hh.next)
+    {
+        if (! pElement->paused && pElement->actions && pElement->actions->num > 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 // main loop
 void CCActionManager::update(float dt)
 {
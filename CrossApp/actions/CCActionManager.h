@@ -78,6 +78,9 @@ public:
      * - If you are running 7 Sequences of 2 actions, it will return 7.
      */
     unsigned int numberOfRunningActionsInTarget(CAObject *pTarget);
+    
+    /** Returns whether an action of a target that isn't paused is running */
+    bool hasRunningActions();
 
     /** Pauses the target: all running actions and newly added actions will be paused.
     */
@@ -11,135 +11,27 @@
 
 NS_CC_BEGIN
 
-class CAViewModel : public CAObject
-{
-public:
-    
-    CCPoint startFrameOrgin;
-    CCPoint endFrameOrgin;
-    CCPoint deltaFrameOrgin;
-    
-    CCPoint startCenterOrgin;
-    CCPoint endCenterOrgin;
-    CCPoint deltaCenterOrgin;
-    
-    CCSize startContentSize;
-    CCSize endContentSize;
-    CCSize deltaContentSize;
-    
-    float startScaleX;
-    float endScaleX;
-    float deltaScaleX;
-    
-    float startScaleY;
-    float endScaleY;
-    float deltaScaleY;
-    
-    int startZOrder;
-    int endZOrder;
-    int deltaZOrder;
-    
-    float startVertexZ;
-    float endVertexZ;
-    float deltaVertexZ;
-    
-    float startSkewX;
-    float endSkewX;
-    float deltaSkewX;
-    
-    float startSkewY;
-    float endSkewY;
-    float deltaSkewY;
-    
-    float startRotationX;
-    float endRotationX;
-    float deltaRotationX;
-    
-    float startRotationY;
-    float endRotationY;
-    float deltaRotationY;
-    
-    CAColor4B startColor;
-    CAColor4B endColor;
-    short deltaColorR;
-    short deltaColorG;
-    short deltaColorB;
-    short deltaColorA;
-    
-    float startAlpha;
-    float endAlpha;
-    float deltaAlpha;
-    
-    CCRect startImageRect;
-    CCRect endImageRect;
-    CCRect deltaImageRect;
-    
-    bool startFlipX;
-    bool endFlipX;
-    
-    bool startFlipY;
-    bool endFlipY;
-    
-    CAView* view;
-
-    CAViewModel(CAView* v)
-    :view(v)
-    ,deltaFrameOrgin(CCPointZero)
-    ,deltaCenterOrgin(CCPointZero)
-    ,deltaContentSize(CCSizeZero)
-    ,deltaScaleX(0.0f)
-    ,deltaScaleY(0.0f)
-    ,deltaZOrder(0)
-    ,deltaVertexZ(0.0f)
-    ,deltaSkewX(0.0f)
-    ,deltaSkewY(0.0f)
-    ,deltaRotationX(0.0f)
-    ,deltaRotationY(0.0f)
-    ,deltaColorR(0)
-    ,deltaColorG(0)
-    ,deltaColorB(0)
-    ,deltaColorA(0)
-    ,deltaAlpha(0.0f)
-    ,deltaImageRect(CCRectZero)
-    ,startFrameOrgin(v->getFrameOrigin())
-    ,startCenterOrgin(v->getCenterOrigin())
-    ,startContentSize(v->m_obContentSize)
-    ,startScaleX(v->m_fScaleX)
-    ,startScaleY(v->m_fScaleY)
-    ,startZOrder(v->m_nZOrder)
-    ,startVertexZ(v->m_fVertexZ)
-    ,startSkewX(v->m_fSkewX)
-    ,startSkewY(v->m_fSkewY)
-    ,startRotationX(v->m_fRotationX)
-    ,startRotationY(v->m_fRotationY)
-    ,startColor(v->_realColor)
-    ,startAlpha(v->_realAlpha)
-    ,startImageRect(v->m_obRect)
-    ,startFlipX(v->m_bFlipX)
-    ,startFlipY(v->m_bFlipY)
-    ,endFlipX(v->m_bFlipX)
-    ,endFlipY(v->m_bFlipY)
-    {
-        CC_SAFE_RETAIN(view);
-    }
-    
-    virtual ~CAViewModel()
-    {
-        CC_SAFE_RELEASE(view);
-    }
-    
-    static CAViewModel* create(CAView* v)
-    {
-        CAViewModel* model = new CAViewModel(v);
-        if (model)
-        {
-            model->autorelease();
-        }
-        return model;
-    }
+// the properties of a view that an animation changes
+enum
+{
+    CAViewAnimationFrameOrigin  = 1 << 0,
+    CAViewAnimationCenterOrigin = 1 << 1,
+    CAViewAnimationContentSize  = 1 << 2,
+    CAViewAnimationScaleX       = 1 << 3,
+    CAViewAnimationScaleY       = 1 << 4,
+    CAViewAnimationZOrder       = 1 << 5,
+    CAViewAnimationVertexZ      = 1 << 6,
+    CAViewAnimationSkewX        = 1 << 7,
+    CAViewAnimationSkewY        = 1 << 8,
+    CAViewAnimationRotationX    = 1 << 9,
+    CAViewAnimationRotationY    = 1 << 10,
+    CAViewAnimationColor        = 1 << 11,
+    CAViewAnimationAlpha        = 1 << 12,
+    CAViewAnimationImageRect    = 1 << 13,
+    CAViewAnimationFlipX        = 1 << 14,
+    CAViewAnimationFlipY        = 1 << 15
 };
 
-
 static CAViewAnimation* _viewAnimation = NULL;
 
 CAViewAnimation* CAViewAnimation::getInstance()
@@ -160,7 +52,23 @@ CAViewAnimation::CAViewAnimation()
 
 CAViewAnimation::~CAViewAnimation()
 {
-
+    std::vector<CAViewAnimation::CAViewAnimationModule>::iterator itr;
+    for (itr=m_vModules.begin(); itr!=m_vModules.end(); itr++)
+    {
+        this->freeModels(itr->models);
+    }
+    
+    std::deque<CAViewAnimation::CAViewAnimationModule>::iterator itr_will;
+    for (itr_will=m_vWillModules.begin(); itr_will!=m_vWillModules.end(); itr_will++)
+    {
+        this->freeModels(itr_will->models);
+    }
+    
+    std::vector<std::vector<CAViewModel>*>::iterator itr_models;
+    for (itr_models=m_vFreeModels.begin(); itr_models!=m_vFreeModels.end(); itr_models++)
+    {
+        delete *itr_models;
+    }
 }
 
 void CAViewAnimation::beginAnimations(const std::string& animationID, void* context)
@@ -173,6 +81,7 @@ void CAViewAnimation::beginAnimations(const std::string& animationID, void* cont
     module.delay = 0;
     module.time = 0;
     module.curve = CAViewAnimationCurveLinear;
+    module.models = CAViewAnimation::getInstance()->newModels();
     CAViewAnimation::getInstance()->m_vWillModules.push_back(module);
 }
 
@@ -272,118 +181,182 @@ bool CAViewAnimation::areBeginAnimations()
 
 void CAViewAnimation::update(float dt)
 {
-    std::vector<CAViewAnimation::CAViewAnimationModule>::iterator itr_module = m_vModules.begin();
-    while (itr_module != m_vModules.end())
+    // the callbacks may commit other animations, the modules are reached by their index
+    unsigned int index = 0;
+    while (index < m_vModules.size())
     {
-        CAViewAnimationModule& module = *itr_module;
-        module.time += dt;
-        float time = module.time - module.delay;
- 
-        if (time > -FLT_MIN)
+        m_vModules[index].time += dt;
+        float time = m_vModules[index].time - m_vModules[index].delay;
+        
+        if (time <= -FLT_MIN)
         {
-            if (module.willStartTarget)
+            ++index;
+            continue;
+        }
+        
+        if (m_vModules[index].willStartTarget)
+        {
+            CAObject* target = m_vModules[index].willStartTarget;
+            SEL_CAViewAnimation0 willStartSel0 = m_vModules[index].willStartSel0;
+            SEL_CAViewAnimation2 willStartSel2 = m_vModules[index].willStartSel2;
+            std::string animationID = m_vModules[index].animationID;
+            void* context = m_vModules[index].context;
+            
+            m_vModules[index].willStartTarget = NULL;
+            m_vModules[index].willStartSel0 = NULL;
+            m_vModules[index].willStartSel2 = NULL;
+            
+            if (willStartSel0)
             {
-                if (module.willStartSel0)
-                {
-                    ((CAObject *)module.willStartTarget->*module.willStartSel0)();
-                    module.willStartSel0 = NULL;
-                }
-                if (module.willStartSel2)
-                {
-                    ((CAObject *)module.willStartTarget->*module.willStartSel2)(module.animationID, module.context);
-                    module.willStartSel2 = NULL;
-                }
-                module.willStartTarget = NULL;
+                (target->*willStartSel0)();
             }
-
-            float s = time / module.duration;
-            s = MIN(s, 1.0f);
-
-            switch (module.curve)
+            if (willStartSel2)
             {
-                case CAViewAnimationCurveEaseOut:
-                {
-                    s = -1/3.0f * s * s + 4/3.0f * s;
-                }
-                    break;
-                case CAViewAnimationCurveEaseIn:
-                {
-                    s = 2 - sqrtf(4 - 3.0f * s);
-                }
-                    break;
-                case CAViewAnimationCurveEaseInOut:
-                {
-                    s = (s <= 0.5f) ? (-2 * s * s + 2 * s) : (1 - sqrtf((1 - s) / 2));
-                }
-                    break;
-                default:
-                    break;
+                (target->*willStartSel2)(animationID, context);
+            }
+        }
+        
+        CAViewAnimationModule& module = m_vModules[index];
+        
+        float s = time / module.duration;
+        s = MIN(s, 1.0f);
+        
+        switch (module.curve)
+        {
+            case CAViewAnimationCurveEaseOut:
+            {
+                s = -1/3.0f * s * s + 4/3.0f * s;
+            }
+                break;
+            case CAViewAnimationCurveEaseIn:
+            {
+                s = 2 - sqrtf(4 - 3.0f * s);
+            }
+                break;
+            case CAViewAnimationCurveEaseInOut:
+            {
+                s = (s <= 0.5f) ? (-2 * s * s + 2 * s) : (1 - sqrtf((1 - s) / 2));
             }
+                break;
+            default:
+                break;
+        }
+        
+        bool finished = time >= module.duration;
+        
+        std::vector<CAViewModel>::iterator itr_model;
+        for (itr_model=module.models->begin(); itr_model!=module.models->end(); itr_model++)
+        {
+            CAViewModel& model = *itr_model;
+            CAView* view = model.view;
+            unsigned int mask = model.mask;
             
-
-            CAMap<CAView*, CAObject*>& animations = itr_module->animations;
-            CAMap<CAView*, CAObject*>::iterator itr_animation = animations.begin();
-            while (itr_animation != animations.end())
+            // the setters of the view only mark it for the draw once, when they are all done
+            view->m_bUpdateDrawDeferred = true;
+            
+            if (mask & CAViewAnimationContentSize)
             {
-                CAView* view = itr_animation->first;
-                CAViewModel* model = (CAViewModel*)(itr_animation->second);
-                view->setContentSize(model->startContentSize + model->deltaContentSize * s);
-                if (view->m_bFrame)
-                {
-                    view->setFrameOrigin(model->startFrameOrgin + model->deltaFrameOrgin * s);
-                }
-                else
-                {
-                    view->setCenterOrigin(model->startCenterOrgin + model->deltaCenterOrgin * s);
-                }
-                view->setScaleX(model->startScaleX + model->deltaScaleX * s);
-                view->setScaleY(model->startScaleY + model->deltaScaleY * s);
-                view->setZOrder(model->startZOrder + model->deltaZOrder * s);
-                view->setVertexZ(model->startVertexZ + model->deltaVertexZ * s);
-                view->setSkewX(model->startSkewX + model->deltaSkewX * s);
-                view->setSkewY(model->startSkewY + model->deltaSkewY * s);
-                view->setRotationX(model->startRotationX + model->deltaRotationX * s);
-                view->setRotationY(model->startRotationY + model->deltaRotationY * s);
-                short colorR = model->startColor.r + model->deltaColorR * s;
-                short colorG = model->startColor.g + model->deltaColorG * s;
-                short colorB = model->startColor.b + model->deltaColorB * s;
-                short colorA = model->startColor.a + model->deltaColorA * s;
+                view->setContentSize(model.startContentSize + model.deltaContentSize * s);
+            }
+            if (mask & CAViewAnimationFrameOrigin)
+            {
+                view->setFrameOrigin(model.startFrameOrgin + model.deltaFrameOrgin * s);
+            }
+            else if (mask & CAViewAnimationCenterOrigin)
+            {
+                view->setCenterOrigin(model.startCenterOrgin + model.deltaCenterOrgin * s);
+            }
+            if (mask & CAViewAnimationScaleX)
+            {
+                view->setScaleX(model.startScaleX + model.deltaScaleX * s);
+            }
+            if (mask & CAViewAnimationScaleY)
+            {
+                view->setScaleY(model.startScaleY + model.deltaScaleY * s);
+            }
+            if (mask & CAViewAnimationZOrder)
+            {
+                view->setZOrder(model.startZOrder + model.deltaZOrder * s);
+            }
+            if (mask & CAViewAnimationVertexZ)
+            {
+                view->setVertexZ(model.startVertexZ + model.deltaVertexZ * s);
+            }
+            if (mask & CAViewAnimationSkewX)
+            {
+                view->setSkewX(model.startSkewX + model.deltaSkewX * s);
+            }
+            if (mask & CAViewAnimationSkewY)
+            {
+                view->setSkewY(model.startSkewY + model.deltaSkewY * s);
+            }
+            if (mask & CAViewAnimationRotationX)
+            {
+                view->setRotationX(model.startRotationX + model.deltaRotationX * s);
+            }
+            if (mask & CAViewAnimationRotationY)
+            {
+                view->setRotationY(model.startRotationY + model.deltaRotationY * s);
+            }
+            if (mask & CAViewAnimationColor)
+            {
+                short colorR = model.startColor.r + model.deltaColorR * s;
+                short colorG = model.startColor.g + model.deltaColorG * s;
+                short colorB = model.startColor.b + model.deltaColorB * s;
+                short colorA = model.startColor.a + model.deltaColorA * s;
                 view->setColor(ccc4(colorR, colorG, colorB, colorA));
-                view->setAlpha(model->startAlpha + model->deltaAlpha * s);
+            }
+            if (mask & CAViewAnimationAlpha)
+            {
+                view->setAlpha(model.startAlpha + model.deltaAlpha * s);
+            }
+            if (mask & CAViewAnimationImageRect)
+            {
                 CADipRect rect;
-                rect.origin = model->startImageRect.origin + model->deltaImageRect.origin * s;
-                rect.size = model->startImageRect.size + model->deltaImageRect.size * s;
+                rect.origin = model.startImageRect.origin + model.deltaImageRect.origin * s;
+                rect.size = model.startImageRect.size + model.deltaImageRect.size * s;
                 view->setImageRect(rect);
-
-                if (time >= module.duration)
-                {
-                    view->setFlipX(model->endFlipX);
-                    view->setFlipY(model->endFlipY);
-                }
-                
-                ++itr_animation;
+            }
+            if (finished && (mask & CAViewAnimationFlipX))
+            {
+                view->setFlipX(model.endFlipX);
+            }
+            if (finished && (mask & CAViewAnimationFlipY))
+            {
+                view->setFlipY(model.endFlipY);
             }
             
-            if (time >= module.duration)
+            view->m_bUpdateDrawDeferred = false;
+            if (view->m_bUpdateDrawPending)
             {
-                if (module.didStopTarget)
+                view->m_bUpdateDrawPending = false;
+                view->updateDraw();
+            }
+        }
+        
+        if (finished)
+        {
+            CAViewAnimationModule ended = module;
+            m_vModules.erase(m_vModules.begin() + index);
+            
+            if (ended.didStopTarget)
+            {
+                if (ended.didStopSel0)
                 {
-                    if (module.didStopSel0)
-                    {
-                        ((CAObject *)module.didStopTarget->*module.didStopSel0)();
-                    }
-                    if (module.didStopSel2)
-                    {
-                        ((CAObject *)module.didStopTarget->*module.didStopSel2)(module.animationID, module.context);
-                    }
+                    (ended.didStopTarget->*ended.didStopSel0)();
+                }
+                if (ended.didStopSel2)
+                {
+                    (ended.didStopTarget->*ended.didStopSel2)(ended.animationID, ended.context);
                 }
-                itr_module->animations.clear();
-                itr_module = m_vModules.erase(itr_module);
-                continue;
             }
-
+            
+            // the views are released after the callbacks
+            this->freeModels(ended.models);
+            continue;
         }
-        ++itr_module;
+        
+        ++index;
     }
     if (m_vModules.empty())
     {
@@ -393,153 +366,210 @@ void CAViewAnimation::update(float dt)
 
 void CAViewAnimation::setFrameOrgin(const CCPoint& point, CAView* view)
 {
-    CAViewAnimation::allocCAViewModel(view);
-    CAViewModel* model = (CAViewModel*)m_vWillModules.back().animations.getValue(view);
-    model->endFrameOrgin = point;
-    model->deltaFrameOrgin = point - model->startFrameOrgin;
-    model->endCenterOrgin = model->startCenterOrgin;
-    model->deltaCenterOrgin = CCPointZero;
+    CAViewModel& model = this->getViewModel(view);
+    model.mask = (model.mask | CAViewAnimationFrameOrigin) & ~CAViewAnimationCenterOrigin;
+    model.deltaFrameOrgin = point - model.startFrameOrgin;
 }
 
 void CAViewAnimation::setCenterOrgin(const CCPoint& point, CAView* view)
 {
-    CAViewAnimation::allocCAViewModel(view);
-    CAViewModel* model = (CAViewModel*)m_vWillModules.back().animations.getValue(view);
-    model->endCenterOrgin = point;
-    model->deltaCenterOrgin = point - model->startCenterOrgin;
-    model->endFrameOrgin = model->startFrameOrgin;
-    model->deltaFrameOrgin = CCPointZero;
+    CAViewModel& model = this->getViewModel(view);
+    model.mask = (model.mask | CAViewAnimationCenterOrigin) & ~CAViewAnimationFrameOrigin;
+    model.deltaCenterOrgin = point - model.startCenterOrgin;
 }
 
 void CAViewAnimation::setContentSize(const CCSize& size, CAView* view)
 {
-    CAViewAnimation::allocCAViewModel(view);
-    CAViewModel* model = (CAViewModel*)m_vWillModules.back().animations.getValue(view);
-    model->endContentSize = size;
-    model->deltaContentSize.width = size.width - model->startContentSize.width;
-    model->deltaContentSize.height = size.height - model->startContentSize.height;
-    CCLog("11--- %f", model->deltaContentSize.width);
-    CCLog("22--- %f", model->deltaContentSize.height);
+    CAViewModel& model = this->getViewModel(view);
+    model.mask |= CAViewAnimationContentSize;
+    model.deltaContentSize.width = size.width - model.startContentSize.width;
+    model.deltaContentSize.height = size.height - model.startContentSize.height;
+    
+    // the size changes around the anchor point, the origin is kept in place
+    if ((model.mask & (CAViewAnimationFrameOrigin | CAViewAnimationCenterOrigin)) == 0)
+    {
+        model.mask |= view->m_bFrame ? CAViewAnimationFrameOrigin : CAViewAnimationCenterOrigin;
+    }
 }
 
 void CAViewAnimation::setScaleX(float scaleX, CAView* view)
 {
-    CAViewAnimation::allocCAViewModel(view);
-    CAViewModel* model = (CAViewModel*)m_vWillModules.back().animations.getValue(view);
-    model->endScaleX = scaleX;
-    model->deltaScaleX = scaleX - model->startScaleX;
+    CAViewModel& model = this->getViewModel(view);
+    model.mask |= CAViewAnimationScaleX;
+    model.deltaScaleX = scaleX - model.startScaleX;
 }
 
 void CAViewAnimation::setScaleY(float scaleY, CAView* view)
 {
-    CAViewAnimation::allocCAViewModel(view);
-    CAViewModel* model = (CAViewModel*)m_vWillModules.back().animations.getValue(view);
-    model->endScaleY = scaleY;
-    model->deltaScaleY = scaleY - model->startScaleY;
+    CAViewModel& model = this->getViewModel(view);
+    model.mask |= CAViewAnimationScaleY;
+    model.deltaScaleY = scaleY - model.startScaleY;
 }
 
 void CAViewAnimation::setZOrder(int zOrder, CAView* view)
 {
-    CAViewAnimation::allocCAViewModel(view);
-    CAViewModel* model = (CAViewModel*)m_vWillModules.back().animations.getValue(view);
-    model->endZOrder = zOrder;
-    model->deltaZOrder = zOrder - model->startZOrder;
+    CAViewModel& model = this->getViewModel(view);
+    model.mask |= CAViewAnimationZOrder;
+    model.deltaZOrder = zOrder - model.startZOrder;
 }
 
 void CAViewAnimation::setVertexZ(float vertexZ, CAView* view)
 {
-    CAViewAnimation::allocCAViewModel(view);
-    CAViewModel* model = (CAViewModel*)m_vWillModules.back().animations.getValue(view);
-    model->endVertexZ = vertexZ;
-    model->deltaVertexZ = vertexZ - model->startVertexZ;
+    CAViewModel& model = this->getViewModel(view);
+    model.mask |= CAViewAnimationVertexZ;
+    model.deltaVertexZ = vertexZ - model.startVertexZ;
 }
 
 void CAViewAnimation::setSkewX(float skewX, CAView* view)
 {
-    CAViewAnimation::allocCAViewModel(view);
-    CAViewModel* model = (CAViewModel*)m_vWillModules.back().animations.getValue(view);
-    model->endSkewX = skewX;
-    model->deltaSkewX = skewX - model->startSkewX;
+    CAViewModel& model = this->getViewModel(view);
+    model.mask |= CAViewAnimationSkewX;
+    model.deltaSkewX = skewX - model.startSkewX;
 }
 
 void CAViewAnimation::setSkewY(float skewY, CAView* view)
 {
-    CAViewAnimation::allocCAViewModel(view);
-    CAViewModel* model = (CAViewModel*)m_vWillModules.back().animations.getValue(view);
-    model->endSkewY = skewY;
-    model->deltaSkewY = skewY - model->startSkewY;
+    CAViewModel& model = this->getViewModel(view);
+    model.mask |= CAViewAnimationSkewY;
+    model.deltaSkewY = skewY - model.startSkewY;
 }
 
 void CAViewAnimation::setRotationX(float rotationX, CAView* view)
 {
-    CAViewAnimation::allocCAViewModel(view);
-    CAViewModel* model = (CAViewModel*)m_vWillModules.back().animations.getValue(view);
-    model->endRotationX = rotationX;
-    model->deltaRotationX = rotationX - model->startRotationX;
+    CAViewModel& model = this->getViewModel(view);
+    model.mask |= CAViewAnimationRotationX;
+    model.deltaRotationX = rotationX - model.startRotationX;
 }
 
 void CAViewAnimation::setRotationY(float rotationY, CAView* view)
 {
-    CAViewAnimation::allocCAViewModel(view);
-    CAViewModel* model = (CAViewModel*)m_vWillModules.back().animations.getValue(view);
-    model->endRotationY = rotationY;
-    model->deltaRotationY = rotationY - model->startRotationY;
+    CAViewModel& model = this->getViewModel(view);
+    model.mask |= CAViewAnimationRotationY;
+    model.deltaRotationY = rotationY - model.startRotationY;
 }
 
 void CAViewAnimation::setColor(const CAColor4B& color, CAView* view)
 {
-    CAViewAnimation::allocCAViewModel(view);
-    CAViewModel* model = (CAViewModel*)m_vWillModules.back().animations.getValue(view);
-    model->endColor = color;
-    model->deltaColorR = (short)color.r - (short)view->_realColor.r;
-    model->deltaColorG = (short)color.g - (short)view->_realColor.g;
-    model->deltaColorB = (short)color.b - (short)view->_realColor.b;
-    model->deltaColorA = (short)color.a - (short)view->_realColor.a;
+    CAViewModel& model = this->getViewModel(view);
+    model.mask |= CAViewAnimationColor;
+    model.deltaColorR = (short)color.r - (short)view->_realColor.r;
+    model.deltaColorG = (short)color.g - (short)view->_realColor.g;
+    model.deltaColorB = (short)color.b - (short)view->_realColor.b;
+    model.deltaColorA = (short)color.a - (short)view->_realColor.a;
 }
 
 void CAViewAnimation::setAlpha(float alpha, CAView* view)
 {
-    CAViewAnimation::allocCAViewModel(view);
-    CAViewModel* model = (CAViewModel*)m_vWillModules.back().animations.getValue(view);
-    model->endAlpha = alpha;
-    model->deltaAlpha = alpha - model->startAlpha;
+    CAViewModel& model = this->getViewModel(view);
+    model.mask |= CAViewAnimationAlpha;
+    model.deltaAlpha = alpha - model.startAlpha;
 }
 
 void CAViewAnimation::setImageRect(const CCRect& imageRect, CAView* view)
 {
-    CAViewAnimation::allocCAViewModel(view);
-    CAViewModel* model = (CAViewModel*)m_vWillModules.back().animations.getValue(view);
-    model->endImageRect = imageRect;
-    model->deltaImageRect.origin = imageRect.origin - model->startImageRect.origin;
-    model->deltaImageRect.size = imageRect.size - model->startImageRect.size;
+    CAViewModel& model = this->getViewModel(view);
+    model.mask |= CAViewAnimationImageRect;
+    model.deltaImageRect.origin = imageRect.origin - model.startImageRect.origin;
+    model.deltaImageRect.size = imageRect.size - model.startImageRect.size;
 }
 
 void CAViewAnimation::setFlipX(bool flipX, CAView* view)
 {
-    CAViewAnimation::allocCAViewModel(view);
-    CAViewModel* model = (CAViewModel*)m_vWillModules.back().animations.getValue(view);
-    model->endFlipX = flipX;
+    CAViewModel& model = this->getViewModel(view);
+    model.mask |= CAViewAnimationFlipX;
+    model.endFlipX = flipX;
 }
 
 void CAViewAnimation::setFlipY(bool flipY, CAView* view)
 {
-    CAViewAnimation::allocCAViewModel(view);
-    CAViewModel* model = (CAViewModel*)m_vWillModules.back().animations.getValue(view);
-    model->endFlipY = flipY;
+    CAViewModel& model = this->getViewModel(view);
+    model.mask |= CAViewAnimationFlipY;
+    model.endFlipY = flipY;
 }
 
-void CAViewAnimation::allocCAViewModel(CAView* view)
+CAViewAnimation::CAViewModel& CAViewAnimation::getViewModel(CAView* view)
 {
-    CAViewAnimationModule& module = m_vWillModules.back();
-    if (module.animations.getValue(view) == NULL)
+    std::vector<CAViewModel>& models = *m_vWillModules.back().models;
+    
+    // the properties of a view are usually set together, the search starts from the last model
+    std::vector<CAViewModel>::reverse_iterator itr;
+    for (itr=models.rbegin(); itr!=models.rend(); itr++)
     {
-        module.animations.insert(view, CAViewModel::create(view));
+        if (itr->view == view)
+        {
+            return *itr;
+        }
     }
-
+    
+    // the start values are the ones of the view when the first of its properties is set
+    models.push_back(CAViewModel());
+    CAViewModel& model = models.back();
+    model.view = view;
+    model.mask = 0;
+    model.startFrameOrgin = view->getFrameOrigin();
+    model.deltaFrameOrgin = CCPointZero;
+    model.startCenterOrgin = view->getCenterOrigin();
+    model.deltaCenterOrgin = CCPointZero;
+    model.startContentSize = view->m_obContentSize;
+    model.deltaContentSize = CCSizeZero;
+    model.startScaleX = view->m_fScaleX;
+    model.deltaScaleX = 0.0f;
+    model.startScaleY = view->m_fScaleY;
+    model.deltaScaleY = 0.0f;
+    model.startZOrder = view->m_nZOrder;
+    model.deltaZOrder = 0;
+    model.startVertexZ = view->m_fVertexZ;
+    model.deltaVertexZ = 0.0f;
+    model.startSkewX = view->m_fSkewX;
+    model.deltaSkewX = 0.0f;
+    model.startSkewY = view->m_fSkewY;
+    model.deltaSkewY = 0.0f;
+    model.startRotationX = view->m_fRotationX;
+    model.deltaRotationX = 0.0f;
+    model.startRotationY = view->m_fRotationY;
+    model.deltaRotationY = 0.0f;
+    model.startColor = view->_realColor;
+    model.deltaColorR = 0;
+    model.deltaColorG = 0;
+    model.deltaColorB = 0;
+    model.deltaColorA = 0;
+    model.startAlpha = view->_realAlpha;
+    model.deltaAlpha = 0.0f;
+    model.startImageRect = view->m_obRect;
+    model.deltaImageRect = CCRectZero;
+    model.endFlipX = view->m_bFlipX;
+    model.endFlipY = view->m_bFlipY;
+    CC_SAFE_RETAIN(view);
+    
+    return model;
 }
 
+std::vector<CAViewAnimation::CAViewModel>* CAViewAnimation::newModels()
+{
+    if (m_vFreeModels.empty())
+    {
+        return new std::vector<CAViewModel>();
+    }
+    
+    std::vector<CAViewModel>* models = m_vFreeModels.back();
+    m_vFreeModels.pop_back();
+    return models;
+}
 
-
+void CAViewAnimation::freeModels(std::vector<CAViewModel>* models)
+{
+    CC_RETURN_IF(models == NULL);
+    
+    std::vector<CAViewModel>::iterator itr;
+    for (itr=models->begin(); itr!=models->end(); itr++)
+    {
+        CC_SAFE_RELEASE(itr->view);
+    }
+    
+    // the capacity is kept for the next animations
+    models->clear();
+    m_vFreeModels.push_back(models);
+}
 
 NS_CC_END
 
@@ -30,6 +30,61 @@ typedef enum
 
 class CC_DLL CAViewAnimation: public CAObject
 {
+    // what an animation does to a view: only the properties in the mask are animated
+    struct CAViewModel
+    {
+        CAView* view;       // retained
+        unsigned int mask;
+        
+        CCPoint startFrameOrgin;
+        CCPoint deltaFrameOrgin;
+        
+        CCPoint startCenterOrgin;
+        CCPoint deltaCenterOrgin;
+        
+        CCSize startContentSize;
+        CCSize deltaContentSize;
+        
+        float startScaleX;
+        float deltaScaleX;
+        
+        float startScaleY;
+        float deltaScaleY;
+        
+        int startZOrder;
+        int deltaZOrder;
+        
+        float startVertexZ;
+        float deltaVertexZ;
+        
+        float startSkewX;
+        float deltaSkewX;
+        
+        float startSkewY;
+        float deltaSkewY;
+        
+        float startRotationX;
+        float deltaRotationX;
+        
+        float startRotationY;
+        float deltaRotationY;
+        
+        CAColor4B startColor;
+        short deltaColorR;
+        short deltaColorG;
+        short deltaColorB;
+        short deltaColorA;
+        
+        float startAlpha;
+        float deltaAlpha;
+        
+        CCRect startImageRect;
+        CCRect deltaImageRect;
+        
+        bool endFlipX;
+        bool endFlipY;
+    };
+    
     struct CAViewAnimationModule
     {
         std::string animationID;
@@ -38,7 +93,7 @@ class CC_DLL CAViewAnimation: public CAObject
         float delay;
         CAViewAnimationCurve curve;
         float time;
-        CAMap<CAView*, CAObject*> animations;
+        std::vector<CAViewModel>* models;   // taken from m_vFreeModels, given back when the animation ends
         
         CAObject* willStartTarget;
         CAObject* didStopTarget;
@@ -50,7 +105,8 @@ class CC_DLL CAViewAnimation: public CAObject
         SEL_CAViewAnimation2 didStopSel2;
         
         CAViewAnimationModule()
-        :willStartTarget(NULL)
+        :models(NULL)
+        ,willStartTarget(NULL)
         ,didStopTarget(NULL)
         ,willStartSel0(NULL)
         ,didStopSel0(NULL)
@@ -63,6 +119,9 @@ class CC_DLL CAViewAnimation: public CAObject
     
     std::vector<CAViewAnimation::CAViewAnimationModule> m_vModules;
     
+    // the lists of models of the animations that ended, kept with their capacity
+    std::vector<std::vector<CAViewModel>*> m_vFreeModels;
+    
 public:
     
     static void beginAnimations(const std::string& animationID, void* context);
@@ -129,7 +188,11 @@ protected:
     
     void setFlipY(bool flipY, CAView* view);
     
-    void allocCAViewModel(CAView* view);
+    CAViewModel& getViewModel(CAView* view);
+    
+    std::vector<CAViewModel>* newModels();
+    
+    void freeModels(std::vector<CAViewModel>* models);
     
     void update(float dt);
     
@@ -11,6 +11,7 @@
 #include "support/CCPointExtension.h"
 #include "support/CANotificationCenter.h"
 #include "images/CAImageCache.h"
+#include "images/CAGlyphAtlas.h"
 #include "basics/CAAutoreleasePool.h"
 #include "platform/platform.h"
 #include "platform/CCFileUtils.h"
@@ -22,6 +23,7 @@
 #include "support/user_default/CAUserDefault.h"
 #include "shaders/ccGLStateCache.h"
 #include "shaders/CAShaderCache.h"
+#include "shaders/CARenderQueue.h"
 #include "kazmath/kazmath.h"
 #include "kazmath/GL/matrix.h"
 #include "support/CCProfiling.h"
@@ -87,13 +89,17 @@ bool CAApplication::init(void)
     m_pSPFLabel = NULL;
     m_pDrawsLabel = NULL;
     m_uTotalFrames = m_uFrames = 0;
-    m_pszFPS = new char[10];
+    m_pszFPS = new char[32];
     m_pLastUpdate = new struct cc_timeval();
     m_fSecondsPerFrame = 0.0f;
 
-    m_nDrawCount = 60;
+    m_bDrawFullScreen = true;
+    m_bIdle = false;
+    m_obDirtyRect = CCRectZero;
+    m_obDrawRect = CCRectZero;
     m_dAnimationInterval = 1.0 / 100.0f;
     m_bDisplayStats = false;
+    m_bViewCulling = true;
     
     // paused ?
     m_bPaused = false;
@@ -236,16 +242,69 @@ void CAApplication::setGLDefaultValues(void)
 
 void CAApplication::updateDraw()
 {
-    m_nDrawCount = 30;
+    m_bDrawFullScreen = true;
+}
+
+void CAApplication::updateDraw(const CCRect& rect)
+{
+    CC_RETURN_IF(m_bDrawFullScreen);
+    CC_RETURN_IF(rect.size.width <= 0 || rect.size.height <= 0);
+    
+    if (!this->isPartialDraw())
+    {
+        m_bDrawFullScreen = true;
+        return;
+    }
+    
+    if (m_obDirtyRect.size.width <= 0 || m_obDirtyRect.size.height <= 0)
+    {
+        m_obDirtyRect = rect;
+    }
+    else
+    {
+        float x = MIN(m_obDirtyRect.getMinX(), rect.getMinX());
+        float y = MIN(m_obDirtyRect.getMinY(), rect.getMinY());
+        float xx = MAX(m_obDirtyRect.getMaxX(), rect.getMaxX());
+        float yy = MAX(m_obDirtyRect.getMaxY(), rect.getMaxY());
+        m_obDirtyRect = CCRect(x, y, xx - x, yy - y);
+    }
+}
+
+bool CAApplication::isPartialDraw()
+{
+    // the stats are drawn over the whole screen, a partial redraw needs the previous frame
+    return !m_bDisplayStats
+        && m_pobOpenGLView
+        && m_pobOpenGLView->isRetainedBacking();
 }
 
 void CAApplication::drawScene(float dt)
 {
     //tick before glClear: issue #533
     
-    if (m_nDrawCount > 0)
+    if (m_bDrawFullScreen || m_obDirtyRect.size.width > 0)
     {
-        --m_nDrawCount;
+        CCRect winRect = CCRect(0, 0, m_obWinSizeInPoints.width, m_obWinSizeInPoints.height);
+        
+        bool bPartial = !m_bDrawFullScreen && this->isPartialDraw();
+        
+        // the changes made while drawing are drawn in the next frame
+        m_obDrawRect = bPartial ? m_obDirtyRect : winRect;
+        m_bDrawFullScreen = false;
+        m_obDirtyRect = CCRectZero;
+        
+        if (bPartial)
+        {
+            // the whole pixels covering the rect, with a margin for the subpixel offset of the scene
+            const CCRect& viewPort = m_pobOpenGLView->getViewPortRect();
+            float scaleX = m_pobOpenGLView->getScaleX();
+            float scaleY = m_pobOpenGLView->getScaleY();
+            float x = floorf(m_obDrawRect.getMinX() * scaleX + viewPort.origin.x) - 1.0f;
+            float y = floorf(m_obDrawRect.getMinY() * scaleY + viewPort.origin.y) - 1.0f;
+            float xx = ceilf(m_obDrawRect.getMaxX() * scaleX + viewPort.origin.x) + 1.0f;
+            float yy = ceilf(m_obDrawRect.getMaxY() * scaleY + viewPort.origin.y) + 1.0f;
+            ccGLPushScissor(x, y, xx - x, yy - y);
+        }
         
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         
@@ -265,6 +324,8 @@ void CAApplication::drawScene(float dt)
             m_pNotificationNode->visit();
         }
         
+        CARenderQueue::sharedRenderQueue()->flush();
+        
         if (m_bDisplayStats)
         {
             showStats();
@@ -272,6 +333,12 @@ void CAApplication::drawScene(float dt)
         
         kmGLPopMatrix();
         
+        if (bPartial)
+        {
+            ccGLPopScissor();
+        }
+        m_obDrawRect = winRect;
+        
         m_uTotalFrames++;
         
         // swap buffers
@@ -312,14 +379,45 @@ void CAApplication::calculateDeltaTime(void)
 
 #ifdef DEBUG
     // If we are debugging our code, prevent big delta time
-    if(m_fDeltaTime > 0.2f)
+    if(m_fDeltaTime > 0.2f && !m_bIdle)
     {
         m_fDeltaTime = 1 / 60.0f;
     }
 #endif
 
+    m_bIdle = false;
     *m_pLastUpdate = now;
 }
+
+float CAApplication::getIdleInterval(void)
+{
+    m_bIdle = false;
+    
+    if (m_bPurgeDirecotorInNextLoop || m_bDrawFullScreen || m_obDirtyRect.size.width > 0 || m_bDisplayStats)
+    {
+        return 0;
+    }
+    
+    if (CANotificationCenter::sharedNotificationCenter()->hasQueuedNotifications())
+    {
+        return 0;
+    }
+    
+    // the scheduler isn't updated while the director is paused
+    float interval = -1;
+    if (! m_bPaused)
+    {
+        // the action manager is called every frame, it has something to do only while actions run
+        if (m_pActionManager->hasRunningActions())
+        {
+            return 0;
+        }
+        interval = CAScheduler::getScheduler()->getTimeToNextUpdate(m_pActionManager);
+    }
+    
+    m_bIdle = interval != 0;
+    return interval;
+}
 float CAApplication::getDeltaTime()
 {
 	return m_fDeltaTime;
@@ -368,6 +466,8 @@ void CAApplication::setNextDeltaTimeZero(bool bNextDeltaTimeZero)
 
 void CAApplication::setProjection(ccDirectorProjection kProjection)
 {
+    CARenderQueue::sharedRenderQueue()->flush();
+    
     CCSize size = m_obWinSizeInPoints;
 
     setViewport();
@@ -632,8 +732,10 @@ void CAApplication::purgeDirector()
 
     // purge all managed caches
     ccDrawFree();
+    CAGlyphAtlas::purgeSharedGlyphAtlas();
     CAImageCache::purgeSharedImageCache();
     CAShaderCache::purgeSharedShaderCache();
+    CARenderQueue::purgeSharedRenderQueue();
     CCFileUtils::purgeFileUtils();
 	CALabelStyleCache::purgeSharedStyleCache();
 
@@ -689,6 +791,8 @@ void CAApplication::resume(void)
 // updates the FPS every frame
 void CAApplication::showStats(void)
 {
+    CARenderQueue* pRenderQueue = CARenderQueue::sharedRenderQueue();
+    
     m_uFrames++;
     m_fAccumDt += m_fDeltaTime;
     
@@ -708,16 +812,21 @@ void CAApplication::showStats(void)
                 sprintf(m_pszFPS, "%.1f", m_fFrameRate);
                 m_pFPSLabel->setText(m_pszFPS);
                 
-                sprintf(m_pszFPS, "%4lu", (unsigned long)g_uNumberOfDraws);
+                // draw calls issued / draw calls the frame would have issued without batching
+                unsigned long uDraws = (unsigned long)g_uNumberOfDraws;
+                unsigned long uUnbatchedDraws = uDraws - pRenderQueue->getBatchesCount() + pRenderQueue->getQuadsCount();
+                sprintf(m_pszFPS, "%lu/%lu", uDraws, uUnbatchedDraws);
                 m_pDrawsLabel->setText(m_pszFPS);
             }
             m_pSPFLabel->visit();
             m_pFPSLabel->visit();
             m_pDrawsLabel->visit();
+            pRenderQueue->flush();
         }
     }    
     
     g_uNumberOfDraws = 0;
+    pRenderQueue->resetStats();
 }
 
 void CAApplication::calculateMPF()
@@ -929,6 +1038,8 @@ void CCDisplayLinkDirector::mainLoop(void)
              CAScheduler::getScheduler()->update(m_fDeltaTime);
          }
          
+         CANotificationCenter::sharedNotificationCenter()->postQueuedNotifications();
+         
          drawScene();
          
          CAPoolManager::sharedPoolManager()->pop();        
@@ -88,6 +88,11 @@ public:
     /** Display the FPS on the bottom-left corner */
     inline void setDisplayStats(bool bDisplayStats) { m_bDisplayStats = bDisplayStats; }
     
+    /** Whether or not the views out of the screen or out of a clipping superview are skipped when visiting */
+    inline bool isViewCulling(void) { return m_bViewCulling; }
+    /** Skips the views out of the screen or out of a clipping superview when visiting. Default is true */
+    inline void setViewCulling(bool bViewCulling) { m_bViewCulling = bViewCulling; }
+    
     /** seconds per frame */
     inline float getSecondsPerFrame() { return m_fSecondsPerFrame; }
 
@@ -218,8 +223,22 @@ public:
     */
     //void drawView(CAView* var);
 
+    /** redraws the whole screen in the next frame */
     void updateDraw();
     
+    /** redraws the given rect in the next frame, in world (GL) points.
+     Only the union of the updated rects is redrawn when the GL view retains its back buffer,
+     nothing is drawn when no rect was updated.
+     */
+    void updateDraw(const CCRect& rect);
+    
+    /** whether the updated rects are redrawn alone, else every update redraws the whole screen
+     and the views don't need to compute their rects */
+    bool isPartialDraw();
+    
+    /** the rect redrawn in the current frame, in world (GL) points. It is the whole screen out of drawScene() */
+    inline const CCRect& getDrawRect() { return m_obDrawRect; }
+    
     void drawScene(float dt = 0);
     
     void run(float dt);
@@ -248,6 +267,12 @@ public:
 
     virtual void mainLoop(void) = 0;
 
+    /** Returns how long the platform can wait for an event before the next call of mainLoop, in seconds:
+     0 if there is something to draw or to animate, -1 if only an event can change the screen.
+     The time waited doesn't count as a long frame in the delta time of the next one.
+     */
+    float getIdleInterval(void);
+
     /** The size in pixels of the surface. It could be different than the screen size.
     High-res devices might have a higher surface size than the screen size.
     Only available when compiled using SDK >= 4.0.
@@ -315,6 +340,7 @@ protected:
     bool m_bLandscape;
     
     bool m_bDisplayStats;
+    bool m_bViewCulling;
     float m_fAccumDt;
     float m_fFrameRate;
     
@@ -360,7 +386,14 @@ protected:
     /* Projection protocol delegate */
     CAApplicationDelegate *m_pProjectionDelegate;
     
-    int m_nDrawCount;
+    bool m_bDrawFullScreen;
+    
+    /* whether the platform may wait for an event before the next frame */
+    bool m_bIdle;
+    
+    CCRect m_obDirtyRect;
+    
+    CCRect m_obDrawRect;
     
     // CCEGLViewProtocol will recreate stats labels to fit visible rect
     friend class CCEGLViewProtocol;
@@ -0,0 +1,143 @@
+//
+//  CAFenwickTree.h
+//  CrossApp
+//
+
+#ifndef __CrossApp_CAFenwickTree__
+#define __CrossApp_CAFenwickTree__
+
+#include "platform/CCPlatformMacros.h"
+#include <vector>
+
+NS_CC_BEGIN
+
+/** CAFenwickTree
+ Keeps the sums of the first values of a list (the offsets of the rows of a list view from
+ their heights). Reading an offset, changing a value and finding the value at an offset
+ cost O(log n), so the rows in view can be found without walking the whole list.
+ */
+class CAFenwickTree
+{
+public:
+
+    CAFenwickTree() {}
+
+    /** replaces the values, in O(n) */
+    void assign(const std::vector<unsigned int>& values)
+    {
+        m_vTree = values;
+        size_t n = m_vTree.size();
+        for (size_t i=1; i<=n; i++)
+        {
+            size_t j = i + (i & (~i + 1));
+            if (j <= n)
+            {
+                m_vTree[j - 1] += m_vTree[i - 1];
+            }
+        }
+    }
+
+    /** replaces the values from index on by the given ones (the size follows), in O(k + log² n)
+     for k new values: the sums before index are kept
+     */
+    void assign(unsigned int index, const std::vector<unsigned int>& values)
+    {
+        size_t begin = index < m_vTree.size() ? index : m_vTree.size();
+        unsigned int base = prefixSum((unsigned int)begin);
+
+        std::vector<unsigned int> sums(values.size() + 1, base);
+        for (size_t k=0; k<values.size(); k++)
+        {
+            sums[k + 1] = sums[k] + values[k];
+        }
+
+        // the nodes ending at or before index only cover the values kept
+        m_vTree.resize(begin + values.size());
+        for (size_t i=begin+1; i<=m_vTree.size(); i++)
+        {
+            size_t from = i - (i & (~i + 1));
+            unsigned int low = from >= begin ? sums[from - begin] : prefixSum((unsigned int)from);
+            m_vTree[i - 1] = sums[i - begin] - low;
+        }
+    }
+
+    /** appends a value, in O(log n) */
+    void push_back(unsigned int value)
+    {
+        size_t i = m_vTree.size() + 1;
+        size_t low = i & (~i + 1);
+        m_vTree.push_back(value + prefixSum((unsigned int)i - 1) - prefixSum((unsigned int)(i - low)));
+    }
+
+    /** adds delta to the value at index */
+    void add(unsigned int index, int delta)
+    {
+        for (size_t i = index + 1; i <= m_vTree.size(); i += i & (~i + 1))
+        {
+            m_vTree[i - 1] += delta;
+        }
+    }
+
+    /** sum of the first count values */
+    unsigned int prefixSum(unsigned int count) const
+    {
+        unsigned int sum = 0;
+        size_t i = count < m_vTree.size() ? count : m_vTree.size();
+        for (; i > 0; i -= i & (~i + 1))
+        {
+            sum += m_vTree[i - 1];
+        }
+        return sum;
+    }
+
+    unsigned int get(unsigned int index) const
+    {
+        return prefixSum(index + 1) - prefixSum(index);
+    }
+
+    void set(unsigned int index, unsigned int value)
+    {
+        this->add(index, (int)value - (int)this->get(index));
+    }
+
+    unsigned int total() const
+    {
+        return prefixSum((unsigned int)m_vTree.size());
+    }
+
+    /** index of the first value ending after the offset, size() if the offset is past the end */
+    unsigned int indexOf(unsigned int offset) const
+    {
+        size_t n = m_vTree.size();
+        size_t step = 1;
+        while (step * 2 <= n)
+        {
+            step *= 2;
+        }
+
+        size_t pos = 0;
+        for (; step > 0; step /= 2)
+        {
+            if (pos + step <= n && m_vTree[pos + step - 1] <= offset)
+            {
+                pos += step;
+                offset -= m_vTree[pos - 1];
+            }
+        }
+        return (unsigned int)pos;
+    }
+
+    inline unsigned int size() const { return (unsigned int)m_vTree.size(); }
+
+    inline bool empty() const { return m_vTree.empty(); }
+
+    void clear() { m_vTree.clear(); }
+
+protected:
+
+    std::vector<unsigned int> m_vTree;
+};
+
+NS_CC_END
+
+#endif /* defined(__CrossApp_CAFenwickTree__) */
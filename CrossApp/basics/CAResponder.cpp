@@ -13,7 +13,8 @@
 NS_CC_BEGIN;
 
 CAResponder::CAResponder()
-:m_bTouchMovedStopSubviews(false)
+:m_eResponderType(CAResponderTypeOther)
+,m_bTouchMovedStopSubviews(false)
 ,m_bTouchMovedListenHorizontal(true)
 ,m_bTouchMovedListenVertical(true)
 ,m_bTouchEnabled(true)
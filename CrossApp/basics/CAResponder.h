@@ -17,6 +17,13 @@ NS_CC_BEGIN;
 
 class CATouch;
 
+typedef enum
+{
+    CAResponderTypeOther = 0,
+    CAResponderTypeView,
+    CAResponderTypeViewController
+}CAResponderType;
+
 class CC_DLL CAResponder: public CAObject
 {
     
@@ -34,6 +41,8 @@ public:
     
     virtual CAResponder* nextResponder();
     
+    CC_SYNTHESIZE_READONLY(CAResponderType, m_eResponderType, ResponderType);
+    
     CC_SYNTHESIZE_IS_READONLY(bool, m_bTouchMovedStopSubviews, TouchMovedStopSubviews);
 
     CC_SYNTHESIZE_IS(bool, m_bTouchMovedListenHorizontal, TouchMovedListenHorizontal);
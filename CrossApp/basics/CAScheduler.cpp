@@ -36,10 +36,10 @@ typedef struct _hashSelectorEntry
 {
     ccArray             *timers;
     CAObject            *target;    // hash key (retained)
-    unsigned int        timerIndex;
     CCTimer             *currentTimer;
     bool                currentTimerSalvaged;
     bool                paused;
+    double              pausedTime; // clock of the scheduler when the target was paused
     UT_hash_handle      hh;
 } tHashTimerEntry;
 
@@ -58,6 +58,11 @@ CCTimer::CCTimer()
 , m_fInterval(0.0f)
 , m_pfnSelector(NULL)
 , m_nScriptHandler(0)
+, m_uHeapIndex(0xffffffff)
+, m_dLastUpdate(0)
+, m_dDueTime(0)
+, m_bScheduled(false)
+, m_bQueued(false)
 {
 }
 
@@ -181,6 +186,28 @@ void CCTimer::update(float dt)
     }
 }
 
+float CCTimer::getTimeToNextUpdate() const
+{
+    // the first update only starts the count
+    if (m_fElapsed == -1)
+    {
+        return 0;
+    }
+    
+    if (m_bUseDelay)
+    {
+        return m_fDelay - m_fElapsed;
+    }
+    
+    // triggered every frame
+    if (m_bRunForever && m_fInterval == 1/60.0f)
+    {
+        return 0;
+    }
+    
+    return m_fInterval - m_fElapsed;
+}
+
 float CCTimer::getInterval() const
 {
     return m_fInterval;
@@ -238,6 +265,7 @@ CAScheduler::CAScheduler(void)
 , m_pCurrentTarget(NULL)
 , m_bCurrentTargetSalvaged(false)
 , m_bUpdateHashLocked(false)
+, m_dTime(0)
 {
 
 }
@@ -245,6 +273,7 @@ CAScheduler::CAScheduler(void)
 CAScheduler::~CAScheduler(void)
 {
     unscheduleSelectorAll();
+    this->flushQueuedTimers();
 }
 
 CAScheduler* CAScheduler::getScheduler()
@@ -256,8 +285,67 @@ CAScheduler* CAScheduler::getScheduler()
     return _scheduler;
 }
 
+float CAScheduler::getTimeToNextUpdate(CAObject *pIgnoredTarget)
+{
+    // the update selectors are called every frame
+    if (m_pUpdatesNegList || m_pUpdates0List || m_pUpdatesPosList)
+    {
+        return 0;
+    }
+    
+    // the time stands still
+    if (m_fTimeScale <= 0)
+    {
+        return -1;
+    }
+    
+    double dueTime = -1;
+    
+    std::vector<CCTimer*>::iterator itr;
+    for (itr = m_vQueuedTimers.begin(); itr != m_vQueuedTimers.end(); ++itr)
+    {
+        CCTimer *pTimer = *itr;
+        CC_CONTINUE_IF(!pTimer->m_bScheduled || pTimer->m_pTarget == pIgnoredTarget);
+        double time = pTimer->m_dLastUpdate + pTimer->getTimeToNextUpdate();
+        if (dueTime < 0 || time < dueTime)
+        {
+            dueTime = time;
+        }
+    }
+    
+    // the first timer of the heap that isn't ignored: only the timers ignored are walked through
+    std::vector<unsigned int> nodes(1, 0);
+    while (!nodes.empty())
+    {
+        unsigned int index = nodes.back();
+        nodes.pop_back();
+        CC_CONTINUE_IF(index >= m_vTimersHeap.size());
+        
+        CCTimer *pTimer = m_vTimersHeap[index];
+        if (pTimer->m_pTarget == pIgnoredTarget)
+        {
+            nodes.push_back(2 * index + 1);
+            nodes.push_back(2 * index + 2);
+        }
+        else if (dueTime < 0 || pTimer->m_dDueTime < dueTime)
+        {
+            dueTime = pTimer->m_dDueTime;
+        }
+    }
+    
+    if (dueTime < 0)
+    {
+        return -1;
+    }
+    return MAX(0.0f, (float)((dueTime - m_dTime) / m_fTimeScale));
+}
+
 void CAScheduler::removeHashElement(_hashSelectorEntry *pElement)
 {
+    for (unsigned int i = 0; i < pElement->timers->num; ++i)
+    {
+        this->stopTimer((CCTimer*)pElement->timers->arr[i]);
+    }
     ccArrayFree(pElement->timers);
     HASH_DEL(m_pHashForTimers, pElement);
     free(pElement);
@@ -291,6 +379,7 @@ void CAScheduler::scheduleSelector(SEL_SCHEDULE pfnSelector, CAObject *pTarget,
 
         // Is this the 1st element ? Then set the pause level to all the selectors of this target
         pElement->paused = bPaused;
+        pElement->pausedTime = m_dTime;
     }
     else
     {
@@ -311,6 +400,13 @@ void CAScheduler::scheduleSelector(SEL_SCHEDULE pfnSelector, CAObject *pTarget,
             {
                 //CCLOG("CAScheduler#scheduleSelector. Selector already scheduled. Updating interval from: %.4f to %.4f", timer->getInterval(), fInterval);
                 timer->setInterval(fInterval);
+                
+                // the time it is due changes with the interval
+                if (timer->m_uHeapIndex != 0xffffffff)
+                {
+                    this->removeTimer(timer);
+                    this->queueTimer(timer);
+                }
                 return;
             }        
         }
@@ -319,10 +415,106 @@ void CAScheduler::scheduleSelector(SEL_SCHEDULE pfnSelector, CAObject *pTarget,
 
     CCTimer *pTimer = new CCTimer();
     pTimer->initWithTarget(pTarget, pfnSelector, fInterval, repeat, delay);
+    pTimer->m_bScheduled = true;
+    pTimer->m_dLastUpdate = m_dTime;
     ccArrayAppendObject(pElement->timers, pTimer);
+    this->queueTimer(pTimer);
     pTimer->release();    
 }
 
+void CAScheduler::pushTimer(CCTimer *pTimer)
+{
+    pTimer->m_uHeapIndex = (unsigned int)m_vTimersHeap.size();
+    m_vTimersHeap.push_back(pTimer);
+    this->siftTimerUp(pTimer->m_uHeapIndex);
+}
+
+void CAScheduler::removeTimer(CCTimer *pTimer)
+{
+    unsigned int index = pTimer->m_uHeapIndex;
+    CC_RETURN_IF(index == 0xffffffff);
+    pTimer->m_uHeapIndex = 0xffffffff;
+    
+    // the last timer takes its place, and goes up or down from there
+    CCTimer *pLast = m_vTimersHeap.back();
+    m_vTimersHeap.pop_back();
+    CC_RETURN_IF(pLast == pTimer);
+    
+    m_vTimersHeap[index] = pLast;
+    pLast->m_uHeapIndex = index;
+    this->siftTimerUp(index);
+    this->siftTimerDown(pLast->m_uHeapIndex);
+}
+
+void CAScheduler::siftTimerUp(unsigned int index)
+{
+    CCTimer *pTimer = m_vTimersHeap[index];
+    while (index > 0)
+    {
+        unsigned int parent = (index - 1) / 2;
+        CC_BREAK_IF(m_vTimersHeap[parent]->m_dDueTime <= pTimer->m_dDueTime);
+        m_vTimersHeap[index] = m_vTimersHeap[parent];
+        m_vTimersHeap[index]->m_uHeapIndex = index;
+        index = parent;
+    }
+    m_vTimersHeap[index] = pTimer;
+    pTimer->m_uHeapIndex = index;
+}
+
+void CAScheduler::siftTimerDown(unsigned int index)
+{
+    CCTimer *pTimer = m_vTimersHeap[index];
+    unsigned int size = (unsigned int)m_vTimersHeap.size();
+    while (2 * index + 1 < size)
+    {
+        unsigned int child = 2 * index + 1;
+        if (child + 1 < size && m_vTimersHeap[child + 1]->m_dDueTime < m_vTimersHeap[child]->m_dDueTime)
+        {
+            ++child;
+        }
+        CC_BREAK_IF(pTimer->m_dDueTime <= m_vTimersHeap[child]->m_dDueTime);
+        m_vTimersHeap[index] = m_vTimersHeap[child];
+        m_vTimersHeap[index]->m_uHeapIndex = index;
+        index = child;
+    }
+    m_vTimersHeap[index] = pTimer;
+    pTimer->m_uHeapIndex = index;
+}
+
+void CAScheduler::queueTimer(CCTimer *pTimer)
+{
+    CC_RETURN_IF(pTimer->m_bQueued);
+    pTimer->m_bQueued = true;
+    pTimer->retain();
+    m_vQueuedTimers.push_back(pTimer);
+}
+
+void CAScheduler::flushQueuedTimers()
+{
+    std::vector<CCTimer*> timers;
+    timers.swap(m_vQueuedTimers);
+    
+    std::vector<CCTimer*>::iterator itr;
+    for (itr = timers.begin(); itr != timers.end(); ++itr)
+    {
+        CCTimer *pTimer = *itr;
+        pTimer->m_bQueued = false;
+        if (pTimer->m_bScheduled && pTimer->m_uHeapIndex == 0xffffffff)
+        {
+            pTimer->m_dDueTime = pTimer->m_dLastUpdate + pTimer->getTimeToNextUpdate();
+            this->pushTimer(pTimer);
+        }
+        pTimer->release();
+    }
+}
+
+void CAScheduler::stopTimer(CCTimer *pTimer)
+{
+    // a queued timer is dropped when the queue is flushed
+    pTimer->m_bScheduled = false;
+    this->removeTimer(pTimer);
+}
+
 void CAScheduler::unscheduleSelector(SEL_SCHEDULE pfnSelector, CAObject *pTarget)
 {
     // explicity handle nil arguments when removing an object
@@ -351,14 +543,9 @@ void CAScheduler::unscheduleSelector(SEL_SCHEDULE pfnSelector, CAObject *pTarget
                     pElement->currentTimerSalvaged = true;
                 }
 
+                this->stopTimer(pTimer);
                 ccArrayRemoveObjectAtIndex(pElement->timers, i, true);
 
-                // update timerIndex in case we are in tick:, looping over the actions
-                if (pElement->timerIndex >= i)
-                {
-                    pElement->timerIndex--;
-                }
-
                 if (pElement->timers->num == 0)
                 {
                     if (m_pCurrentTarget == pElement)
@@ -511,6 +698,10 @@ void CAScheduler::unscheduleSelectorAllForTarget(CAObject *pTarget)
             pElement->currentTimer->retain();
             pElement->currentTimerSalvaged = true;
         }
+        for (unsigned int i = 0; i < pElement->timers->num; ++i)
+        {
+            this->stopTimer((CCTimer*)pElement->timers->arr[i]);
+        }
         ccArrayRemoveAllObjects(pElement->timers);
 
         if (m_pCurrentTarget == pElement)
@@ -566,9 +757,19 @@ void CAScheduler::resumeTarget(CAObject *pTarget)
     // custom selectors
     tHashTimerEntry *pElement = NULL;
     HASH_FIND_INT(m_pHashForTimers, &pTarget, pElement);
-    if (pElement)
+    if (pElement && pElement->paused)
     {
         pElement->paused = false;
+        
+        // the time spent paused doesn't count, the timers are due that much later
+        double pausedFor = m_dTime - pElement->pausedTime;
+        for (unsigned int i = 0; i < pElement->timers->num; ++i)
+        {
+            CCTimer *pTimer = (CCTimer*)pElement->timers->arr[i];
+            pTimer->m_dLastUpdate += pausedFor;
+            this->removeTimer(pTimer);
+            this->queueTimer(pTimer);
+        }
     }
 
     // update selector
@@ -588,9 +789,10 @@ void CAScheduler::pauseTarget(CAObject *pTarget)
     // custom selectors
     tHashTimerEntry *pElement = NULL;
     HASH_FIND_INT(m_pHashForTimers, &pTarget, pElement);
-    if (pElement)
+    if (pElement && !pElement->paused)
     {
         pElement->paused = true;
+        pElement->pausedTime = m_dTime;
     }
 
     // update selector
@@ -640,6 +842,10 @@ CCSet* CAScheduler::pauseAllTargetsWithMinPriority(int nMinPriority)
     for(tHashTimerEntry *element = m_pHashForTimers; element != NULL;
         element = (tHashTimerEntry*)element->hh.next)
     {
+        if (!element->paused)
+        {
+            element->pausedTime = m_dTime;
+        }
         element->paused = true;
         idsWithSelectors->addObject(element->target);
     }
@@ -728,38 +934,46 @@ void CAScheduler::update(float dt)
         }
     }
 
-    // Iterate over all the custom selectors
-    for (tHashTimerEntry *elt = m_pHashForTimers; elt != NULL; )
+    // Only the custom selectors that are due. The timers scheduled or updated
+    // from here wait in the queue for the next frame
+    m_dTime += dt;
+    this->flushQueuedTimers();
+    
+    while (!m_vTimersHeap.empty() && m_vTimersHeap.front()->m_dDueTime <= m_dTime)
     {
+        CCTimer *pTimer = m_vTimersHeap.front();
+        this->removeTimer(pTimer);
+        
+        tHashTimerEntry *elt = NULL;
+        CAObject *pTarget = pTimer->m_pTarget;
+        HASH_FIND_INT(m_pHashForTimers, &pTarget, elt);
+        
+        // out of the heap until the target is resumed
+        CC_CONTINUE_IF(elt == NULL || elt->paused);
+        
         m_pCurrentTarget = elt;
         m_bCurrentTargetSalvaged = false;
-
-        if (! m_pCurrentTarget->paused)
+        
+        elt->currentTimer = pTimer;
+        elt->currentTimerSalvaged = false;
+        
+        pTimer->update((float)(m_dTime - pTimer->m_dLastUpdate));
+        
+        if (elt->currentTimerSalvaged)
         {
-            // The 'timers' array may change while inside this loop
-            for (elt->timerIndex = 0; elt->timerIndex < elt->timers->num; ++(elt->timerIndex))
-            {
-                elt->currentTimer = (CCTimer*)(elt->timers->arr[elt->timerIndex]);
-                elt->currentTimerSalvaged = false;
-
-                elt->currentTimer->update(dt);
-
-                if (elt->currentTimerSalvaged)
-                {
-                    // The currentTimer told the remove itself. To prevent the timer from
-                    // accidentally deallocating itself before finishing its step, we retained
-                    // it. Now that step is done, it's safe to release it.
-                    elt->currentTimer->release();
-                }
-
-                elt->currentTimer = NULL;
-            }
+            // The currentTimer told the remove itself. To prevent the timer from
+            // accidentally deallocating itself before finishing its step, we retained
+            // it. Now that step is done, it's safe to release it.
+            pTimer->release();
         }
-
-        // elt, at this moment, is still valid
-        // so it is safe to ask this here (issue #490)
-        elt = (tHashTimerEntry *)elt->hh.next;
-
+        else
+        {
+            pTimer->m_dLastUpdate = m_dTime;
+            this->queueTimer(pTimer);
+        }
+        
+        elt->currentTimer = NULL;
+        
         // only delete currentTarget if no actions were scheduled during the cycle (issue #481)
         if (m_bCurrentTargetSalvaged && m_pCurrentTarget->timers->num == 0)
         {
@@ -5,6 +5,7 @@
 
 #include "CAObject.h"
 #include "support/data_support/uthash.h"
+#include <vector>
 
 NS_CC_BEGIN
 
@@ -77,6 +78,11 @@ public:
      */
     inline int getScriptHandler() { return m_nScriptHandler; };
 
+protected:
+    
+    /** seconds of elapsed time before the next call of update can trigger the timer */
+    float getTimeToNextUpdate() const;
+    
 protected:
     CAObject *m_pTarget;
     float m_fElapsed;
@@ -89,6 +95,16 @@ protected:
     SEL_SCHEDULE m_pfnSelector;
     
     int m_nScriptHandler;
+    
+    // kept by the scheduler: the place of the timer in its heap (0xffffffff if out of it),
+    // the clock of the last update and of the next one
+    unsigned int m_uHeapIndex;
+    double m_dLastUpdate;
+    double m_dDueTime;
+    bool m_bScheduled;
+    bool m_bQueued;
+    
+    friend class CAScheduler;
 };
 
 //
@@ -110,6 +126,9 @@ There are 2 different types of callbacks (selectors):
 
 The 'custom selectors' should be avoided when possible. It is faster, and consumes less memory to use the 'update selector'.
 
+The custom selectors are kept in a min-heap ordered by the time they are due, so a frame only
+updates the timers that can trigger: a timer firing in a minute costs nothing until then.
+
 */
 class CC_DLL CAScheduler : public CAObject
 {
@@ -135,6 +154,11 @@ public:
     
     static CAScheduler* getScheduler();
     
+    /** Returns the seconds before a selector has to be called: 0 if one has to be called in the next
+     frame, -1 if none is scheduled. The selectors of pIgnoredTarget are left out.
+     */
+    float getTimeToNextUpdate(CAObject *pIgnoredTarget = NULL);
+    
     /** 'update' the scheduler.
      *  You should NEVER call this method, unless you know what you are doing.
      *  @js NA
@@ -252,6 +276,16 @@ protected:
     
 private:
     void removeHashElement(struct _hashSelectorEntry *pElement);
+    
+    // timers heap
+    
+    void pushTimer(CCTimer *pTimer);
+    void removeTimer(CCTimer *pTimer);
+    void siftTimerUp(unsigned int index);
+    void siftTimerDown(unsigned int index);
+    void queueTimer(CCTimer *pTimer);
+    void flushQueuedTimers();
+    void stopTimer(CCTimer *pTimer);
     void removeUpdateFromHash(struct _listEntry *entry);
 
     // update specific
@@ -276,6 +310,15 @@ protected:
     bool m_bCurrentTargetSalvaged;
     // If true unschedule will not remove anything from a hash. Elements will only be marked for deletion.
     bool m_bUpdateHashLocked;
+    
+    // seconds of scaled time since the scheduler was created
+    double m_dTime;
+    
+    // the timers of the targets, by the time they are due
+    std::vector<CCTimer*> m_vTimersHeap;
+    
+    // the timers waiting to enter the heap (retained): the new ones, and the ones updated in the current frame
+    std::vector<CCTimer*> m_vQueuedTimers;
 };
 
 // end of global group
@@ -28,6 +28,7 @@ CAViewController::CAViewController()
 ,m_bLifeLock(false)
 ,m_bKeypadEnabled(false)
 {
+    m_eResponderType = CAResponderTypeViewController;
     this->setHaveNextResponder(true);
     m_pView = CAView::createWithColor(CAColor_white);
     m_pView->retain();
@@ -51,58 +51,39 @@ std::vector<CAResponder*> CATouchController::getEventListener(CATouch* touch, CA
     
     std::vector<CAResponder*> vector;
     
+    // the point follows the descent, in the node space of the last view reached
+    CCPoint point = CAApplication::getApplication()->convertToGL(touch->getLocation());
+    point = CCPointApplyAffineTransform(point, view->worldToNodeTransform());
+    
     do
     {
         vector.push_back(responder);
         
         CAResponder* nextResponder = NULL;
         
-        if (CAView* view = dynamic_cast<CAView*>(responder))
+        switch (responder->getResponderType())
         {
-            if (view->getViewDelegate())
-            {
-                nextResponder = view->nextResponder();
-            }
-            else
+            case CAResponderTypeView:
             {
-                view->sortAllSubviews();
-                
-                CAVector<CAView*>::const_reverse_iterator itr;
-                for (itr=view->getSubviews().rbegin(); itr!=view->getSubviews().rend(); itr++)
+                CAView* view = static_cast<CAView*>(responder);
+                if (view->getViewDelegate())
                 {
-                    CAView* subview = *itr;
-                    if (subview->isVisible() && subview->isTouchEnabled())
-                    {
-                        CCPoint point = subview->convertTouchToNodeSpace(touch);
-                        
-                        if (subview->getBounds().containsPoint(point))
-                        {
-                            nextResponder = subview;
-                            break;
-                        }
-                    }
+                    nextResponder = view->nextResponder();
                 }
-            }
-        }
-        else if (CAViewController* viewController = dynamic_cast<CAViewController*>(responder))
-        {
-            CAVector<CAView*>::const_reverse_iterator itr;
-            for (itr=viewController->getView()->getSubviews().rbegin();
-                 itr!=viewController->getView()->getSubviews().rend();
-                 itr++)
-            {
-                CAView* subview = *itr;
-                if (subview->isVisible() && subview->isTouchEnabled())
+                else
                 {
-                    CCPoint point = subview->convertTouchToNodeSpace(touch);
-                    
-                    if (subview->getBounds().containsPoint(point))
-                    {
-                        nextResponder = subview;
-                        break;
-                    }
+                    nextResponder = view->hitTestSubview(point);
                 }
             }
+                break;
+            case CAResponderTypeViewController:
+            {
+                CAViewController* viewController = static_cast<CAViewController*>(responder);
+                nextResponder = viewController->getView()->hitTestSubview(point);
+            }
+                break;
+            default:
+                break;
         }
         
         responder = nextResponder;
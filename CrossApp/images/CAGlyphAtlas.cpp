@@ -0,0 +1,258 @@
+//
+//  CAGlyphAtlas.cpp
+//  CrossApp
+//
+
+#include "CAGlyphAtlas.h"
+#include "ccMacros.h"
+#include "shaders/ccGLStateCache.h"
+#include "shaders/CARenderQueue.h"
+#include "support/CANotificationCenter.h"
+
+NS_CC_BEGIN
+
+// blank pixels kept around every glyph, so the linear filtering doesn't bleed into its neighbours
+#define kCAGlyphAtlasPadding 1
+
+// size of the opaque block at the origin of every page
+#define kCAGlyphAtlasSolidSize 4
+
+static CAGlyphAtlas* _sharedGlyphAtlas = NULL;
+
+CAGlyphAtlas* CAGlyphAtlas::sharedGlyphAtlas()
+{
+    if (!_sharedGlyphAtlas)
+    {
+        _sharedGlyphAtlas = new CAGlyphAtlas();
+    }
+    return _sharedGlyphAtlas;
+}
+
+void CAGlyphAtlas::purgeSharedGlyphAtlas()
+{
+    CC_SAFE_RELEASE_NULL(_sharedGlyphAtlas);
+}
+
+CAGlyphAtlas::CAGlyphAtlas()
+: m_uGeneration(0)
+{
+#if CC_ENABLE_CACHE_TEXTURE_DATA
+    // the pages come back blank with the GL context
+    CANotificationCenter::sharedNotificationCenter()->addObserver(this,
+                                                                  callfuncO_selector(CAGlyphAtlas::listenBackToForeground),
+                                                                  EVENT_COME_TO_FOREGROUND,
+                                                                  NULL);
+#endif
+}
+
+CAGlyphAtlas::~CAGlyphAtlas()
+{
+    CCLOGINFO("CrossApp deallocing 0x%X", this);
+
+    std::vector<CAGlyphPage>::iterator itr;
+    for (itr=m_vPages.begin(); itr!=m_vPages.end(); itr++)
+    {
+        CC_SAFE_RELEASE(itr->image);
+    }
+
+#if CC_ENABLE_CACHE_TEXTURE_DATA
+    CANotificationCenter::sharedNotificationCenter()->removeObserver(this, EVENT_COME_TO_FOREGROUND);
+#endif
+}
+
+void CAGlyphAtlas::listenBackToForeground(CAObject *obj)
+{
+    this->removeAllGlyphs();
+}
+
+const CAGlyphInfo* CAGlyphAtlas::glyphForKey(const CAGlyphKey& key)
+{
+    std::map<CAGlyphKey, CAGlyphInfo>::iterator itr = m_mGlyphs.find(key);
+    return itr != m_mGlyphs.end() ? &itr->second : NULL;
+}
+
+const CAGlyphInfo* CAGlyphAtlas::addGlyph(const CAGlyphKey& key, const unsigned char* bitmap, int width, int height, int pitch, int left, int top)
+{
+    CAGlyphInfo info;
+    info.page = 0;
+    info.rect = CCRectZero;
+    info.left = left;
+    info.top = top;
+
+    if (width > 0 && height > 0)
+    {
+        if (width + kCAGlyphAtlasPadding > kCAGlyphAtlasPageSize
+            || height + kCAGlyphAtlasPadding > kCAGlyphAtlasPageSize)
+        {
+            return NULL;
+        }
+
+        if (m_vPages.empty() && !this->addPage())
+        {
+            return NULL;
+        }
+
+        CCPoint origin;
+        if (!this->allocRect(m_vPages.back(), width, height, origin))
+        {
+            if (m_vPages.size() >= kCAGlyphAtlasMaxPages)
+            {
+                this->removeAllGlyphs();
+                return NULL;
+            }
+
+            if (!this->addPage() || !this->allocRect(m_vPages.back(), width, height, origin))
+            {
+                return NULL;
+            }
+        }
+
+        info.page = (unsigned int)m_vPages.size() - 1;
+        info.rect = CCRect(origin.x, origin.y, width, height);
+        this->uploadBitmap(m_vPages.back(), origin, bitmap, width, height, pitch);
+    }
+
+    return &(m_mGlyphs[key] = info);
+}
+
+CCRect CAGlyphAtlas::getSolidRect()
+{
+    // the center of the block, out of reach of the filtering of the blank pixels around it
+    return CCRect(1, 1, kCAGlyphAtlasSolidSize - 2, kCAGlyphAtlasSolidSize - 2);
+}
+
+CAImage* CAGlyphAtlas::getPage(unsigned int page)
+{
+    return page < m_vPages.size() ? m_vPages[page].image : NULL;
+}
+
+unsigned int CAGlyphAtlas::getPagesCount()
+{
+    return (unsigned int)m_vPages.size();
+}
+
+void CAGlyphAtlas::removeAllGlyphs()
+{
+    // the queued quads may still sample the pages
+    CARenderQueue::sharedRenderQueue()->flush();
+
+    m_mGlyphs.clear();
+
+    // keeps the first page, the following ones come back when they are needed
+    while (m_vPages.size() > 1)
+    {
+        CC_SAFE_RELEASE(m_vPages.back().image);
+        m_vPages.pop_back();
+    }
+
+    if (!m_vPages.empty())
+    {
+        CAGlyphPage& page = m_vPages.front();
+
+        unsigned char* blank = (unsigned char*)calloc(kCAGlyphAtlasPageSize * kCAGlyphAtlasPageSize, 1);
+        this->uploadBitmap(page, CCPointZero, blank, kCAGlyphAtlasPageSize, kCAGlyphAtlasPageSize, kCAGlyphAtlasPageSize);
+        free(blank);
+
+        unsigned char solid[kCAGlyphAtlasSolidSize * kCAGlyphAtlasSolidSize];
+        memset(solid, 0xff, sizeof(solid));
+        this->uploadBitmap(page, CCPointZero, solid, kCAGlyphAtlasSolidSize, kCAGlyphAtlasSolidSize, kCAGlyphAtlasSolidSize);
+
+        page.shelfX = kCAGlyphAtlasSolidSize + kCAGlyphAtlasPadding;
+        page.shelfY = 0;
+        page.shelfHeight = kCAGlyphAtlasSolidSize;
+    }
+
+    ++m_uGeneration;
+}
+
+bool CAGlyphAtlas::addPage()
+{
+    unsigned char* data = (unsigned char*)calloc(kCAGlyphAtlasPageSize * kCAGlyphAtlasPageSize, 1);
+    for (int y = 0; y < kCAGlyphAtlasSolidSize; y++)
+    {
+        memset(data + y * kCAGlyphAtlasPageSize, 0xff, kCAGlyphAtlasSolidSize);
+    }
+
+    // an A8 texture can't be read back, the page keeps its CPU copy up to date with the glyphs
+    CAImage* image = new CAImage();
+    bool bRet = image->initWithData(data, kCAImagePixelFormat_A8,
+                                    kCAGlyphAtlasPageSize, kCAGlyphAtlasPageSize,
+                                    CCSize(kCAGlyphAtlasPageSize, kCAGlyphAtlasPageSize));
+
+    free(data);
+
+    if (!bRet)
+    {
+        CC_SAFE_RELEASE(image);
+        return false;
+    }
+
+    CAGlyphPage page;
+    page.image = image;
+    page.shelfX = kCAGlyphAtlasSolidSize + kCAGlyphAtlasPadding;
+    page.shelfY = 0;
+    page.shelfHeight = kCAGlyphAtlasSolidSize;
+    m_vPages.push_back(page);
+
+    return true;
+}
+
+bool CAGlyphAtlas::allocRect(CAGlyphPage& page, int width, int height, CCPoint& origin)
+{
+    // shelf packing: the glyphs are put side by side on rows as high as their tallest glyph
+    if (page.shelfX + width > kCAGlyphAtlasPageSize)
+    {
+        page.shelfY += page.shelfHeight + kCAGlyphAtlasPadding;
+        page.shelfX = 0;
+        page.shelfHeight = 0;
+    }
+
+    if (page.shelfY + height > kCAGlyphAtlasPageSize)
+    {
+        return false;
+    }
+
+    origin = CCPoint(page.shelfX, page.shelfY);
+    page.shelfX += width + kCAGlyphAtlasPadding;
+    page.shelfHeight = MAX(page.shelfHeight, height);
+
+    return true;
+}
+
+void CAGlyphAtlas::uploadBitmap(CAGlyphPage& page, const CCPoint& origin, const unsigned char* bitmap, int width, int height, int pitch)
+{
+    const unsigned char* pixels = bitmap;
+    unsigned char* packed = NULL;
+
+    if (pitch != width)
+    {
+        packed = (unsigned char*)malloc(width * height);
+        for (int y = 0; y < height; y++)
+        {
+            memcpy(packed + y * width, bitmap + y * pitch, width);
+        }
+        pixels = packed;
+    }
+
+    ccGLBindTexture2D(page.image->getName());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, (GLint)origin.x, (GLint)origin.y, width, height, GL_ALPHA, GL_UNSIGNED_BYTE, pixels);
+
+    unsigned char* copy = page.image->getData();
+    if (copy)
+    {
+        for (int y = 0; y < height; y++)
+        {
+            memcpy(copy + ((int)origin.y + y) * kCAGlyphAtlasPageSize + (int)origin.x, pixels + y * width, width);
+        }
+    }
+
+    if (packed)
+    {
+        free(packed);
+    }
+
+    CHECK_GL_ERROR_DEBUG();
+}
+
+NS_CC_END
@@ -0,0 +1,142 @@
+//
+//  CAGlyphAtlas.h
+//  CrossApp
+//
+
+#ifndef __CAGlyphAtlas_H__
+#define __CAGlyphAtlas_H__
+
+#include "basics/CAObject.h"
+#include "basics/CAGeometry.h"
+#include "CAImage.h"
+#include <vector>
+#include <map>
+
+NS_CC_BEGIN
+
+/**
+ * @addtogroup images
+ * @{
+ */
+
+/** width and height in pixels of an atlas page */
+#define kCAGlyphAtlasPageSize 1024
+
+/** number of pages kept before the atlas is emptied */
+#define kCAGlyphAtlasMaxPages 4
+
+/** identifies a rendered glyph: the font it comes from (the font file buffer, kept until the
+ fonts are destroyed, and the size in pixels), the glyph index in the face and the bold / italics
+ style it was rendered with. The faces and size objects are created and destroyed per thread,
+ their addresses can't identify a glyph.
+ */
+typedef struct _CAGlyphKey
+{
+    const void*     font;
+    unsigned int    size;
+    unsigned int    index;
+    unsigned int    style;
+
+    bool operator<(const struct _CAGlyphKey& other) const
+    {
+        if (font != other.font) return font < other.font;
+        if (size != other.size) return size < other.size;
+        if (index != other.index) return index < other.index;
+        return style < other.style;
+    }
+}
+CAGlyphKey;
+
+typedef struct _CAGlyphInfo
+{
+    unsigned int    page;       // index of the page the glyph is stored in
+    CCRect          rect;       // rect of the glyph in the page, in pixels
+    int             left;       // offset of the bitmap from the pen
+    int             top;
+}
+CAGlyphInfo;
+
+/** a glyph placed in a text box, in pixels from its top left corner */
+typedef struct _CATextGlyph
+{
+    unsigned int    page;
+    CCRect          imageRect;  // rect of the pixels in the page
+    CCRect          rect;       // rect in the text box
+}
+CATextGlyph;
+
+/** CAGlyphAtlas
+ Singleton that keeps the glyphs rendered by FreeType in shared A8 pages, so the labels draw
+ their text as quads that reuse the glyphs of every other label instead of owning a texture.
+
+ When the pages are full the atlas is emptied and its generation changes: the text laid out
+ with an older generation has to be laid out again.
+ */
+class CC_DLL CAGlyphAtlas : public CAObject
+{
+public:
+
+    CAGlyphAtlas();
+
+    virtual ~CAGlyphAtlas();
+
+    /** returns the shared instance */
+    static CAGlyphAtlas* sharedGlyphAtlas();
+
+    /** purges the atlas. It releases the pages. */
+    static void purgeSharedGlyphAtlas();
+
+    /** returns the glyph, or NULL if it was not rendered yet */
+    const CAGlyphInfo* glyphForKey(const CAGlyphKey& key);
+
+    /** copies the A8 bitmap of a glyph in a page. Returns NULL if the glyph doesn't fit in a page,
+     or if the atlas had to be emptied to make room for it.
+     */
+    const CAGlyphInfo* addGlyph(const CAGlyphKey& key, const unsigned char* bitmap, int width, int height, int pitch, int left, int top);
+
+    /** a fully opaque block found at the same place in every page, used to draw the underlines */
+    CCRect getSolidRect();
+
+    CAImage* getPage(unsigned int page);
+
+    unsigned int getPagesCount();
+
+    /** empties the pages, the text laid out before has to be laid out again */
+    void removeAllGlyphs();
+
+    inline unsigned int getGeneration() { return m_uGeneration; }
+
+    void listenBackToForeground(CAObject *obj);
+
+protected:
+
+    typedef struct _CAGlyphPage
+    {
+        CAImage*        image;
+        int             shelfX;     // pen of the current shelf
+        int             shelfY;
+        int             shelfHeight;
+    }
+    CAGlyphPage;
+
+    bool addPage();
+
+    bool allocRect(CAGlyphPage& page, int width, int height, CCPoint& origin);
+
+    void uploadBitmap(CAGlyphPage& page, const CCPoint& origin, const unsigned char* bitmap, int width, int height, int pitch);
+
+protected:
+
+    std::map<CAGlyphKey, CAGlyphInfo> m_mGlyphs;
+
+    std::vector<CAGlyphPage> m_vPages;
+
+    unsigned int m_uGeneration;
+};
+
+// end of images group
+/// @}
+
+NS_CC_END
+
+#endif /* __CAGlyphAtlas_H__ */
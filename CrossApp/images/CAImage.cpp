@@ -39,6 +39,14 @@ static CAImagePixelFormat g_defaultAlphaPixelFormat = kCAImagePixelFormat_Defaul
 
 static CAImage* cc_white_image = NULL;
 
+// the pixels of the formats that aren't color-renderable can't be read back through a framebuffer
+static bool isPixelFormatReadable(CAImagePixelFormat format)
+{
+    return format != kCAImagePixelFormat_A8
+        && format != kCAImagePixelFormat_I8
+        && format != kCAImagePixelFormat_AI88;
+}
+
 CAImage::CAImage()
 : m_uPixelsWide(0)
 , m_uPixelsHigh(0)
@@ -47,6 +55,7 @@ CAImage::CAImage()
 , m_fMaxT(0.0)
 , m_bHasPremultipliedAlpha(false)
 , m_bHasMipmaps(false)
+, m_bGPUOnly(false)
 , m_pShaderProgram(NULL)
 , m_bMonochrome(false)
 , m_pData(NULL)
@@ -220,12 +229,28 @@ bool CAImage::initWithData(void* data, int lenght)
     if (bRet)
     {
         this->initWithImage(image);
+        
+#if CC_ENABLE_CACHE_TEXTURE_DATA
+        if (m_pData == NULL)
+        {
+            // the encoded bytes are much smaller than the pixels to reload the texture from
+            VolatileTexture::addEncodedDataTexture(this, data, lenght);
+        }
+#endif
     }
     image->release();
     return bRet;
 }
 
 bool CAImage::initWithData(const void *data, CAImagePixelFormat pixelFormat, unsigned int pixelsWide, unsigned int pixelsHigh, const CCSize& contentSize)
+{
+    this->uploadData(data, pixelFormat, pixelsWide, pixelsHigh, contentSize);
+    this->keepPixelData((unsigned char*)const_cast<void*>(data), false);
+    
+    return true;
+}
+
+void CAImage::uploadData(const void *data, CAImagePixelFormat pixelFormat, unsigned int pixelsWide, unsigned int pixelsHigh, const CCSize& contentSize)
 {
     unsigned int bitsPerPixel;
     //Hack: bitsPerPixelForFormat returns wrong number for RGB_888 textures. See function.
@@ -298,18 +323,6 @@ bool CAImage::initWithData(const void *data, CAImagePixelFormat pixelFormat, uns
         CCAssert(0, "NSInternalInconsistencyException");
 
     }
-    if (m_pData)
-    {
-        free(m_pData);
-    }
-    
-    m_nDataLenght = (unsigned long)pixelsWide * pixelsHigh;
-    m_pData = (unsigned char*)malloc(m_nDataLenght * sizeof(unsigned char) * bitsPerPixel/8);
-    unsigned char* pData = ((unsigned char*)const_cast<char*>((const char*)data));
-    
-    for (unsigned int i=0; i<m_nDataLenght * bitsPerPixel/8; i++)
-        m_pData[i] = pData[i];
-
     m_tContentSize = contentSize;
     m_uPixelsWide = pixelsWide;
     m_uPixelsHigh = pixelsHigh;
@@ -322,14 +335,146 @@ bool CAImage::initWithData(const void *data, CAImagePixelFormat pixelFormat, uns
 
     setShaderProgram(CAShaderCache::sharedShaderCache()->programForKey(kCCShader_PositionTexture));
 
+}
+
+void CAImage::keepPixelData(unsigned char* data, bool bTransfer)
+{
+    m_nDataLenght = (unsigned long)m_uPixelsWide * m_uPixelsHigh;
+    
+    if (data != m_pData)
+    {
+        if (m_pData)
+        {
+            free(m_pData);
+            m_pData = NULL;
+        }
+        
+        if (m_bGPUOnly && isPixelFormatReadable(m_ePixelFormat))
+        {
+            // the pixels only live in the texture
+        }
+        else if (bTransfer)
+        {
+            m_pData = data;
+        }
+        else
+        {
+            unsigned long length = this->getPixelDataLength();
+            m_pData = (unsigned char*)malloc(length);
+            memcpy(m_pData, data, length);
+        }
+    }
+    
 #if CC_ENABLE_CACHE_TEXTURE_DATA
-    VolatileTexture::addDataTexture(this, m_pData, m_ePixelFormat, CCSize(m_uPixelsWide, m_uPixelsHigh));
+    VolatileTexture::addDataTexture(this, m_pData ? m_pData : data, m_ePixelFormat, CCSize(m_uPixelsWide, m_uPixelsHigh));
 #endif
     
-    return true;
+    if (bTransfer && data != m_pData)
+    {
+        free(data);
+    }
 }
 
+unsigned char* CAImage::readPixelData()
+{
+    if (m_uName == 0 || !isPixelFormatReadable(m_ePixelFormat))
+    {
+        return NULL;
+    }
+    
+    GLint oldFBO = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &oldFBO);
+    
+    GLuint fbo = 0;
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_uName, 0);
+    
+    unsigned int length = m_uPixelsWide * m_uPixelsHigh;
+    unsigned char* rgba = NULL;
+    
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE)
+    {
+        // RGBA / UNSIGNED_BYTE is the only combination every GLES 2 driver can read
+        rgba = (unsigned char*)malloc(length * 4);
+        GLint oldAlignment = 4;
+        glGetIntegerv(GL_PACK_ALIGNMENT, &oldAlignment);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, (GLsizei)m_uPixelsWide, (GLsizei)m_uPixelsHigh, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+        glPixelStorei(GL_PACK_ALIGNMENT, oldAlignment);
+    }
+    else
+    {
+        CCLOG("CrossApp: CAImage. Can't read back the pixels of the texture %u, format %s", m_uName, this->stringForFormat());
+    }
+    
+    glBindFramebuffer(GL_FRAMEBUFFER, oldFBO);
+    glDeleteFramebuffers(1, &fbo);
+    
+    CHECK_GL_ERROR_DEBUG();
+    
+    if (rgba == NULL || m_ePixelFormat == kCAImagePixelFormat_RGBA8888)
+    {
+        return rgba;
+    }
+    
+    // Repack "RRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA" into the pixel format of the texture
+    unsigned char* data = (unsigned char*)malloc(this->getPixelDataLength());
+    unsigned char* inPixel8 = rgba;
+    unsigned char* outPixel8 = data;
+    unsigned short* outPixel16 = (unsigned short*)data;
+    
+    for (unsigned int i = 0; i < length; ++i, inPixel8 += 4)
+    {
+        switch (m_ePixelFormat)
+        {
+            case kCAImagePixelFormat_RGB888:
+                *outPixel8++ = inPixel8[0];
+                *outPixel8++ = inPixel8[1];
+                *outPixel8++ = inPixel8[2];
+                break;
+            case kCAImagePixelFormat_RGB565:
+                *outPixel16++ = ((inPixel8[0] >> 3) << 11) | ((inPixel8[1] >> 2) << 5) | (inPixel8[2] >> 3);
+                break;
+            case kCAImagePixelFormat_RGBA4444:
+                *outPixel16++ = ((inPixel8[0] >> 4) << 12) | ((inPixel8[1] >> 4) << 8) | ((inPixel8[2] >> 4) << 4) | (inPixel8[3] >> 4);
+                break;
+            case kCAImagePixelFormat_RGB5A1:
+                *outPixel16++ = ((inPixel8[0] >> 3) << 11) | ((inPixel8[1] >> 3) << 6) | ((inPixel8[2] >> 3) << 1) | (inPixel8[3] >> 7);
+                break;
+            case kCAImagePixelFormat_AI88:
+                *outPixel8++ = inPixel8[0];
+                *outPixel8++ = inPixel8[3];
+                break;
+            case kCAImagePixelFormat_A8:
+                *outPixel8++ = inPixel8[3];
+                break;
+            case kCAImagePixelFormat_I8:
+                *outPixel8++ = inPixel8[0];
+                break;
+            default:
+                break;
+        }
+    }
+    
+    free(rgba);
+    return data;
+}
 
+unsigned long CAImage::getPixelDataLength()
+{
+    unsigned int bitsPerPixel;
+    //Hack: bitsPerPixelForFormat returns wrong number for RGB_888 textures. See function.
+    if(m_ePixelFormat == kCAImagePixelFormat_RGB888)
+    {
+        bitsPerPixel = 24;
+    }
+    else
+    {
+        bitsPerPixel = bitsPerPixelForFormat(m_ePixelFormat);
+    }
+    return (unsigned long)m_uPixelsWide * m_uPixelsHigh * bitsPerPixel / 8;
+}
 const char* CAImage::description(void)
 {
     return CCString::createWithFormat("<CAImage | Name = %u | Dimensions = %u x %u | Coordinates = (%.2f, %.2f)>", m_uName, m_uPixelsWide, m_uPixelsHigh, m_fMaxS, m_fMaxT)->getCString();
@@ -395,7 +540,7 @@ bool CAImage::initPremultipliedATextureWithImage(CCImage *image, unsigned int wi
         {
             // Convert "RRRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA" to "RRRRRGGGGGGBBBBB"
             
-            tempData = new unsigned char[width * height * 2];
+            tempData = (unsigned char*)malloc(width * height * 2);
             outPixel16 = (unsigned short*)tempData;
             inPixel32 = (unsigned int*)image->getData();
             
@@ -411,7 +556,7 @@ bool CAImage::initPremultipliedATextureWithImage(CCImage *image, unsigned int wi
         {
             // Convert "RRRRRRRRRGGGGGGGGBBBBBBBB" to "RRRRRGGGGGGBBBBB"
             
-            tempData = new unsigned char[width * height * 2];
+            tempData = (unsigned char*)malloc(width * height * 2);
             outPixel16 = (unsigned short*)tempData;
             inPixel8 = (unsigned char*)image->getData();
             
@@ -429,7 +574,7 @@ bool CAImage::initPremultipliedATextureWithImage(CCImage *image, unsigned int wi
         // Convert "RRRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA" to "RRRRGGGGBBBBAAAA"
         
         inPixel32 = (unsigned int*)image->getData();  
-        tempData = new unsigned char[width * height * 2];
+        tempData = (unsigned char*)malloc(width * height * 2);
         outPixel16 = (unsigned short*)tempData;
         
         for(unsigned int i = 0; i < length; ++i, ++inPixel32)
@@ -445,7 +590,7 @@ bool CAImage::initPremultipliedATextureWithImage(CCImage *image, unsigned int wi
     {
         // Convert "RRRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA" to "RRRRRGGGGGBBBBBA"
         inPixel32 = (unsigned int*)image->getData();   
-        tempData = new unsigned char[width * height * 2];
+        tempData = (unsigned char*)malloc(width * height * 2);
         outPixel16 = (unsigned short*)tempData;
         
         for(unsigned int i = 0; i < length; ++i, ++inPixel32)
@@ -461,7 +606,7 @@ bool CAImage::initPremultipliedATextureWithImage(CCImage *image, unsigned int wi
     {
         // Convert "RRRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA" to "AAAAAAAA"
         inPixel32 = (unsigned int*)image->getData();
-        tempData = new unsigned char[width * height];
+        tempData = (unsigned char*)malloc(width * height);
         unsigned char *outPixel8 = tempData;
         
         for(unsigned int i = 0; i < length; ++i, ++inPixel32)
@@ -474,7 +619,7 @@ bool CAImage::initPremultipliedATextureWithImage(CCImage *image, unsigned int wi
     {
         // Convert "RRRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA" to "RRRRRRRRGGGGGGGGBBBBBBBB"
         inPixel32 = (unsigned int*)image->getData();
-        tempData = new unsigned char[width * height * 3];
+        tempData = (unsigned char*)malloc(width * height * 3);
         unsigned char *outPixel8 = tempData;
         
         for(unsigned int i = 0; i < length; ++i, ++inPixel32)
@@ -485,11 +630,15 @@ bool CAImage::initPremultipliedATextureWithImage(CCImage *image, unsigned int wi
         }
     }
     
-    initWithData(tempData, pixelFormat, width, height, imageSize);
-    
     if (tempData != image->getData())
     {
-        delete [] tempData;
+        // the repacked pixels are handed over to the image instead of being copied
+        this->uploadData(tempData, pixelFormat, width, height, imageSize);
+        this->keepPixelData(tempData, true);
+    }
+    else
+    {
+        initWithData(tempData, pixelFormat, width, height, imageSize);
     }
 
     m_bHasPremultipliedAlpha = image->isPremultipliedAlpha();
@@ -719,6 +868,16 @@ CAImagePixelFormat CAImage::defaultAlphaPixelFormat()
     return g_defaultAlphaPixelFormat;
 }
 
+void CAImage::setGPUOnly(bool bGPUOnly)
+{
+    m_bGPUOnly = bGPUOnly;
+}
+
+bool CAImage::isGPUOnly()
+{
+    return m_bGPUOnly;
+}
+
 unsigned int CAImage::bitsPerPixelForFormat(CAImagePixelFormat format)
 {
 	unsigned int ret=0;
@@ -765,14 +924,24 @@ unsigned int CAImage::bitsPerPixelForFormat()
 
 bool CAImage::saveToFile(const std::string& fullPath)
 {
+    unsigned char* data = m_pData ? m_pData : this->readPixelData();
+    
+    if (!data) return false;
+    
     FILE *fp = fopen(fullPath.c_str(), "wb+");
     
-	if (!fp) return false;
+    if (fp)
+    {
+        fwrite(data, sizeof(char), m_nDataLenght, fp);
+        fclose(fp);
+    }
     
-    fwrite(m_pData, sizeof(char), m_nDataLenght, fp);
-	fclose(fp);
+    if (data != m_pData)
+    {
+        free(data);
+    }
     
-    return true;
+    return fp != NULL;
 }
 
 float CAImage::getAspectRatio()
@@ -795,22 +964,19 @@ CAImage* CAImage::copy()
     copyImage->m_bHasMipmaps = this->m_bHasMipmaps;
     copyImage->m_bHasPremultipliedAlpha = this->m_bHasPremultipliedAlpha;
     
-    unsigned int bitsPerPixel;
-    //Hack: bitsPerPixelForFormat returns wrong number for RGB_888 textures. See function.
-    if(this->m_ePixelFormat == kCAImagePixelFormat_RGB888)
+    copyImage->m_nDataLenght = this->m_nDataLenght;
+    
+    if (this->m_pData)
     {
-        bitsPerPixel = 24;
+        unsigned long length = this->getPixelDataLength();
+        copyImage->m_pData = (unsigned char*)malloc(length);
+        memcpy(copyImage->m_pData, this->m_pData, length);
     }
     else
     {
-        bitsPerPixel = bitsPerPixelForFormat(this->m_ePixelFormat);
+        // the read back pixels are handed over to the copy
+        copyImage->m_pData = this->readPixelData();
     }
-    
-    copyImage->m_nDataLenght = this->m_nDataLenght;
-    copyImage->m_pData = (unsigned char*)malloc(this->m_nDataLenght * sizeof(unsigned char) * bitsPerPixel/8);
-    
-    for (unsigned int i=0; i<m_nDataLenght * bitsPerPixel/8; i++)
-        copyImage->m_pData[i] = this->m_pData[i];
 
     return copyImage;
 }
@@ -818,6 +984,11 @@ const char* CAImage::getImageFileType()
 {
     const char* text = NULL;
     
+    if (m_pData == NULL)
+    {
+        return text;
+    }
+    
     unsigned char p = m_pData[0] ;
     
     switch (p)
@@ -113,6 +113,18 @@ public:
 
     static CAImagePixelFormat defaultAlphaPixelFormat();
 
+    /** When enabled before the image is initialized, its CPU copy of the pixels is freed once
+     they are uploaded to the GPU. getData() returns NULL, saveToFile() and copy() read the pixels
+     back from the texture. GLES 2 only reads back the formats it can render to: the A8, I8 and AI88
+     images keep their copy. Default is false.
+     */
+    void setGPUOnly(bool bGPUOnly);
+
+    bool isGPUOnly();
+
+    /** length in bytes of the pixels of the texture, in its pixel format */
+    unsigned long getPixelDataLength();
+
     const CCSize& getContentSizeInPixels();
     
     bool hasPremultipliedAlpha();
@@ -157,12 +169,20 @@ private:
     
     bool initPremultipliedATextureWithImage(CCImage * image, unsigned int pixelsWide, unsigned int pixelsHigh);
 
+    void uploadData(const void* data, CAImagePixelFormat pixelFormat, unsigned int pixelsWide, unsigned int pixelsHigh, const CCSize& contentSize);
+
+    void keepPixelData(unsigned char* data, bool bTransfer);
+
+    unsigned char* readPixelData();
+
 protected:
     
     
     bool m_bHasPremultipliedAlpha;
     
     bool m_bHasMipmaps;
+    
+    bool m_bGPUOnly;
 };
 
 
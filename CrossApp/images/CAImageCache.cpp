@@ -21,6 +21,9 @@
 #include <cctype>
 #include <queue>
 #include <list>
+#include <map>
+#include <vector>
+#include <algorithm>
 #include <stdlib.h>
 
 #if (CC_TARGET_PLATFORM != CC_PLATFORM_WINRT) && (CC_TARGET_PLATFORM != CC_PLATFORM_WP8)
@@ -44,11 +47,21 @@ typedef enum _AsyncType
     AsyncStringType
 }AsyncType;
 
-typedef struct _AsyncStruct
+typedef struct _AsyncTarget
 {
-    std::string            filename;
     CAObject    *target;
     SEL_CallFuncO        selector;
+} AsyncTarget;
+
+// one request per file, shared by all the targets asking for it.
+// targets, cancelled and the map of requests are only used on the main thread.
+typedef struct _AsyncStruct
+{
+    std::string            filename;
+    int                    priority;
+    unsigned long          order;
+    bool                   cancelled;
+    std::vector<AsyncTarget> targets;
 } AsyncStruct;
 
 typedef struct _ImageInfo
@@ -58,9 +71,10 @@ typedef struct _ImageInfo
     CCImage::EImageFormat imageType;
 } ImageInfo;
 
-static pthread_t s_loadingThread;
+static std::vector<pthread_t> s_loadingThreads;
+
+static unsigned int s_nLoadingThreadsCount = 4;
 
-static pthread_mutex_t		s_SleepMutex;
 static pthread_cond_t		s_SleepCondition;
 
 static pthread_mutex_t      s_asyncStructQueueMutex;
@@ -69,16 +83,23 @@ static pthread_mutex_t      s_ImageInfoMutex;
 #ifdef EMSCRIPTEN
 // Hack to get ASM.JS validation (no undefined symbols allowed).
 #define pthread_cond_signal(_)
+#define pthread_cond_broadcast(_)
 #endif // EMSCRIPTEN
 
 static unsigned long s_nAsyncRefCount = 0;
 
+static unsigned long s_nAsyncOrder = 0;
+
 static bool need_quit = false;
 
-static std::queue<AsyncStruct*>* s_pAsyncStructQueue = NULL;
+// pending requests, the loading threads take the one with the highest priority first
+static std::vector<AsyncStruct*>* s_pAsyncStructQueue = NULL;
 
 static std::queue<ImageInfo*>*   s_pImageQueue = NULL;
 
+// requests not delivered yet, by file name
+static std::map<std::string, AsyncStruct*> s_mAsyncStructs;
+
 static CCImage::EImageFormat computeImageFormatType(string& filename)
 {
     CCImage::EImageFormat ret = CCImage::kFmtUnKnown;
@@ -121,12 +142,11 @@ static void loadImageData(AsyncStruct *pAsyncStruct)
     CCImage *pImage = new CCImage();
     if (pImage && !pImage->initWithImageFileThreadSafe(filename, imageType))
     {
-        CC_SAFE_RELEASE(pImage);
+        CC_SAFE_RELEASE_NULL(pImage);
         CCLOG("can not load %s", filename);
-        return;
     }
 
-    // generate image info
+    // generate image info, a NULL image tells the main thread to drop the request
     ImageInfo *pImageInfo = new ImageInfo();
     pImageInfo->asyncStruct = pAsyncStruct;
     pImageInfo->image = pImage;
@@ -137,47 +157,49 @@ static void loadImageData(AsyncStruct *pAsyncStruct)
     pthread_mutex_unlock(&s_ImageInfoMutex);   
 }
 
+static AsyncStruct* popAsyncStruct(std::vector<AsyncStruct*>* pQueue)
+{
+    std::vector<AsyncStruct*>::iterator best = pQueue->begin();
+    std::vector<AsyncStruct*>::iterator itr;
+    for (itr=pQueue->begin(); itr!=pQueue->end(); itr++)
+    {
+        if ((*itr)->priority > (*best)->priority
+            || ((*itr)->priority == (*best)->priority && (*itr)->order < (*best)->order))
+        {
+            best = itr;
+        }
+    }
+    
+    AsyncStruct* pAsyncStruct = *best;
+    pQueue->erase(best);
+    return pAsyncStruct;
+}
+
 static void* loadImage(void* data)
 {
     AsyncStruct *pAsyncStruct = NULL;
 
     while (true)
     {
-        std::queue<AsyncStruct*> *pQueue = s_pAsyncStructQueue;
+        std::vector<AsyncStruct*> *pQueue = s_pAsyncStructQueue;
         pthread_mutex_lock(&s_asyncStructQueueMutex);// get async struct from queue
-        if (pQueue->empty())
+        while (pQueue->empty() && !need_quit)
         {
-            pthread_mutex_unlock(&s_asyncStructQueueMutex);
-            if (need_quit) {
-                break;
-            }
-            else {
-                pthread_cond_wait(&s_SleepCondition, &s_SleepMutex);
-                continue;
-            }
+            pthread_cond_wait(&s_SleepCondition, &s_asyncStructQueueMutex);
         }
-        else
+        
+        if (pQueue->empty())
         {
-            pAsyncStruct = pQueue->front();
-            pQueue->pop();
             pthread_mutex_unlock(&s_asyncStructQueueMutex);
-            loadImageData(pAsyncStruct);
-        }        
-    }
-    
-    if( s_pAsyncStructQueue != NULL )
-    {
-        delete s_pAsyncStructQueue;
-        s_pAsyncStructQueue = NULL;
-        delete s_pImageQueue;
-        s_pImageQueue = NULL;
-
-        pthread_mutex_destroy(&s_asyncStructQueueMutex);
-        pthread_mutex_destroy(&s_ImageInfoMutex);
-        pthread_mutex_destroy(&s_SleepMutex);
-        pthread_cond_destroy(&s_SleepCondition);
+            break;
+        }
+        
+        pAsyncStruct = popAsyncStruct(pQueue);
+        pthread_mutex_unlock(&s_asyncStructQueueMutex);
+        loadImageData(pAsyncStruct);
     }
     
+    // the queues are released by ~CAImageCache once every thread is joined
     return 0;
 }
 
@@ -196,6 +218,14 @@ CAImageCache * CAImageCache::sharedImageCache()
 }
 
 CAImageCache::CAImageCache()
+: m_uImagesBytes(0)
+, m_uMemoryBudget(0)
+, m_uHitsCount(0)
+, m_uMissesCount(0)
+, m_uEvictionsCount(0)
+, m_bEvictionScheduled(false)
+, m_fAsyncUploadTimeBudget(8.0f)
+, m_uAsyncUploadBytesBudget(0)
 {
     CCAssert(g_sharedImageCache == NULL, "Attempted to allocate a second instance of a singleton.");
     
@@ -205,8 +235,62 @@ CAImageCache::CAImageCache()
 CAImageCache::~CAImageCache()
 {
     CCLOGINFO("CrossApp: deallocing CAImageCache.");
-    need_quit = true;
-    pthread_cond_signal(&s_SleepCondition);
+    if (s_pAsyncStructQueue)
+    {
+        // the pending requests are not loaded anymore, the threads finish the ones they hold
+        pthread_mutex_lock(&s_asyncStructQueueMutex);
+        need_quit = true;
+        s_pAsyncStructQueue->clear();
+        pthread_mutex_unlock(&s_asyncStructQueueMutex);
+        pthread_cond_broadcast(&s_SleepCondition);
+        
+        for (unsigned int i=0; i<s_loadingThreads.size(); i++)
+        {
+            pthread_join(s_loadingThreads[i], NULL);
+        }
+        
+        // the images loaded but not delivered, their requests are released below
+        while (!s_pImageQueue->empty())
+        {
+            ImageInfo *pImageInfo = s_pImageQueue->front();
+            s_pImageQueue->pop();
+            CC_SAFE_RELEASE(pImageInfo->image);
+            delete pImageInfo;
+        }
+        
+        delete s_pAsyncStructQueue;
+        s_pAsyncStructQueue = NULL;
+        delete s_pImageQueue;
+        s_pImageQueue = NULL;
+        
+        pthread_mutex_destroy(&s_asyncStructQueueMutex);
+        pthread_mutex_destroy(&s_ImageInfoMutex);
+        pthread_cond_destroy(&s_SleepCondition);
+    }
+    s_loadingThreads.clear();
+    
+    std::map<std::string, AsyncStruct*>::iterator itr;
+    for (itr=s_mAsyncStructs.begin(); itr!=s_mAsyncStructs.end(); itr++)
+    {
+        std::vector<AsyncTarget>::iterator itrTarget;
+        for (itrTarget=itr->second->targets.begin(); itrTarget!=itr->second->targets.end(); itrTarget++)
+        {
+            CC_SAFE_RELEASE(itrTarget->target);
+        }
+        delete itr->second;
+    }
+    s_mAsyncStructs.clear();
+    
+    if (s_nAsyncRefCount > 0)
+    {
+        s_nAsyncRefCount = 0;
+        CAScheduler::unschedule(schedule_selector(CAImageCache::addImageAsyncCallBack), this);
+    }
+    
+    if (m_bEvictionScheduled)
+    {
+        CAScheduler::unschedule(schedule_selector(CAImageCache::evictImages), this);
+    }
     CC_SAFE_RELEASE(m_pImages);
 }
 
@@ -232,16 +316,26 @@ CCDictionary* CAImageCache::snapshotTextures()
     return pRet;
 }
 
-void CAImageCache::addImageAsync(const std::string& path, CAObject *target, SEL_CallFuncO selector)
+void CAImageCache::setAsyncThreadsCount(unsigned int count)
+{
+    s_nLoadingThreadsCount = MAX(count, 1);
+}
+
+unsigned int CAImageCache::getAsyncThreadsCount()
+{
+    return s_nLoadingThreadsCount;
+}
+
+void CAImageCache::addImageAsync(const std::string& path, CAObject *target, SEL_CallFuncO selector, int priority)
 {
     std::string pathKey = path;
     
     pathKey = CCFileUtils::sharedFileUtils()->fullPathForFilename(pathKey.c_str());
     
-    this->addImageFullPathAsync(pathKey.c_str(), target, selector);
+    this->addImageFullPathAsync(pathKey.c_str(), target, selector, priority);
 }
 
-void CAImageCache::addImageFullPathAsync(const std::string& path, CAObject *target, SEL_CallFuncO selector)
+void CAImageCache::addImageFullPathAsync(const std::string& path, CAObject *target, SEL_CallFuncO selector, int priority)
 {
 #ifdef EMSCRIPTEN
     CCLOGWARN("Cannot load image %s asynchronously in Emscripten builds.", path);
@@ -252,7 +346,7 @@ void CAImageCache::addImageFullPathAsync(const std::string& path, CAObject *targ
     
     // optimization
     
-    image = (CAImage*)m_pImages->objectForKey(path);
+    image = this->cachedImageForKey(path);
     
     std::string fullpath = path;
     
@@ -267,21 +361,46 @@ void CAImageCache::addImageFullPathAsync(const std::string& path, CAObject *targ
         return;
     }
     
+    CC_SAFE_RETAIN(target);
+    
+    AsyncTarget asyncTarget;
+    asyncTarget.target = target;
+    asyncTarget.selector = selector;
+    
+    // the file is already requested, the targets share the decoding
+    std::map<std::string, AsyncStruct*>::iterator itr = s_mAsyncStructs.find(fullpath);
+    if (itr != s_mAsyncStructs.end())
+    {
+        AsyncStruct *data = itr->second;
+        data->cancelled = false;
+        data->targets.push_back(asyncTarget);
+        
+        if (priority > data->priority)
+        {
+            pthread_mutex_lock(&s_asyncStructQueueMutex);
+            data->priority = priority;
+            pthread_mutex_unlock(&s_asyncStructQueueMutex);
+        }
+        return;
+    }
     
     // lazy init
     if (s_pAsyncStructQueue == NULL)
     {
-        s_pAsyncStructQueue = new queue<AsyncStruct*>();
+        s_pAsyncStructQueue = new std::vector<AsyncStruct*>();
         s_pImageQueue = new queue<ImageInfo*>();
         
         pthread_mutex_init(&s_asyncStructQueueMutex, NULL);
         pthread_mutex_init(&s_ImageInfoMutex, NULL);
-        pthread_mutex_init(&s_SleepMutex, NULL);
         pthread_cond_init(&s_SleepCondition, NULL);
+        need_quit = false;
 #if (CC_TARGET_PLATFORM != CC_PLATFORM_WP8)
-        pthread_create(&s_loadingThread, NULL, loadImage, NULL);
+        s_loadingThreads.resize(s_nLoadingThreadsCount);
+        for (unsigned int i=0; i<s_nLoadingThreadsCount; i++)
+        {
+            pthread_create(&s_loadingThreads[i], NULL, loadImage, NULL);
+        }
 #endif
-        need_quit = false;
     }
     
     if (0 == s_nAsyncRefCount)
@@ -290,19 +409,20 @@ void CAImageCache::addImageFullPathAsync(const std::string& path, CAObject *targ
     }
     
     ++s_nAsyncRefCount;
-
-    CC_SAFE_RETAIN(target);
     
     // generate async struct
     AsyncStruct *data = new AsyncStruct();
     data->filename = fullpath.c_str();
-    data->target = target;
-    data->selector = selector;
+    data->priority = priority;
+    data->order = s_nAsyncOrder++;
+    data->cancelled = false;
+    data->targets.push_back(asyncTarget);
+    s_mAsyncStructs[fullpath] = data;
     
 #if (CC_TARGET_PLATFORM != CC_PLATFORM_WP8)
     // add async struct into queue
     pthread_mutex_lock(&s_asyncStructQueueMutex);
-    s_pAsyncStructQueue->push(data);
+    s_pAsyncStructQueue->push_back(data);
     pthread_mutex_unlock(&s_asyncStructQueueMutex);
     pthread_cond_signal(&s_SleepCondition);
 #else
@@ -314,51 +434,147 @@ void CAImageCache::addImageFullPathAsync(const std::string& path, CAObject *targ
 #endif
 }
 
+void CAImageCache::cancelImageAsync(const std::string& path, CAObject *target)
+{
+    std::map<std::string, AsyncStruct*>::iterator itr = s_mAsyncStructs.find(path);
+    CC_RETURN_IF(itr == s_mAsyncStructs.end());
+    
+    AsyncStruct *data = itr->second;
+    
+    std::vector<AsyncTarget>::iterator itrTarget = data->targets.begin();
+    while (itrTarget != data->targets.end())
+    {
+        if (target == NULL || itrTarget->target == target)
+        {
+            CC_SAFE_RELEASE(itrTarget->target);
+            itrTarget = data->targets.erase(itrTarget);
+        }
+        else
+        {
+            itrTarget++;
+        }
+    }
+    
+    CC_RETURN_IF(!data->targets.empty());
+    
+    // nobody waits for the image anymore, it is not decoded if still pending
+    bool bPending = false;
+    
+#if (CC_TARGET_PLATFORM != CC_PLATFORM_WP8)
+    pthread_mutex_lock(&s_asyncStructQueueMutex);
+    std::vector<AsyncStruct*>::iterator itrQueue = std::find(s_pAsyncStructQueue->begin(), s_pAsyncStructQueue->end(), data);
+    if (itrQueue != s_pAsyncStructQueue->end())
+    {
+        s_pAsyncStructQueue->erase(itrQueue);
+        bPending = true;
+    }
+    pthread_mutex_unlock(&s_asyncStructQueueMutex);
+#endif
+    
+    if (bPending)
+    {
+        s_mAsyncStructs.erase(itr);
+        delete data;
+        
+        --s_nAsyncRefCount;
+        if (0 == s_nAsyncRefCount)
+        {
+            CAScheduler::unschedule(schedule_selector(CAImageCache::addImageAsyncCallBack), this);
+        }
+    }
+    else
+    {
+        // being decoded, it is dropped when delivered
+        data->cancelled = true;
+    }
+}
+
+void CAImageCache::cancelImageAsync(CAObject *target)
+{
+    CC_RETURN_IF(target == NULL);
+    
+    std::vector<std::string> paths;
+    std::map<std::string, AsyncStruct*>::iterator itr;
+    for (itr=s_mAsyncStructs.begin(); itr!=s_mAsyncStructs.end(); itr++)
+    {
+        std::vector<AsyncTarget>& targets = itr->second->targets;
+        for (unsigned int i=0; i<targets.size(); i++)
+        {
+            if (targets[i].target == target)
+            {
+                paths.push_back(itr->first);
+                break;
+            }
+        }
+    }
+    
+    for (unsigned int i=0; i<paths.size(); i++)
+    {
+        this->cancelImageAsync(paths[i], target);
+    }
+}
 
 void CAImageCache::addImageAsyncCallBack(float dt)
 {
     // the image is generated in loading thread
     std::queue<ImageInfo*> *imagesQueue = s_pImageQueue;
-
-    pthread_mutex_lock(&s_ImageInfoMutex);
-    if (imagesQueue->empty())
-    {
-        pthread_mutex_unlock(&s_ImageInfoMutex);
-    }
-    else
+    
+    struct cc_timeval begin;
+    CCTime::gettimeofdayCrossApp(&begin, NULL);
+    unsigned long uploadedBytes = 0;
+    
+    // uploads the decoded images until the budget of the frame is spent, at least one
+    while (true)
     {
+        pthread_mutex_lock(&s_ImageInfoMutex);
+        if (imagesQueue->empty())
+        {
+            pthread_mutex_unlock(&s_ImageInfoMutex);
+            break;
+        }
+        
         ImageInfo *pImageInfo = imagesQueue->front();
         imagesQueue->pop();
         pthread_mutex_unlock(&s_ImageInfoMutex);
 
         AsyncStruct *pAsyncStruct = pImageInfo->asyncStruct;
         CCImage *pImage = pImageInfo->image;
-
-        CAObject *target = pAsyncStruct->target;
-        SEL_CallFuncO selector = pAsyncStruct->selector;
+        
         const char* filename = pAsyncStruct->filename.c_str();
-
-        // generate texture in render thread
-        CAImage* image = new CAImage();
-        image->initWithImage(pImage);
-
+        
+        s_mAsyncStructs.erase(pAsyncStruct->filename);
+        
+        CAImage* image = NULL;
+        
+        if (pImage && !pAsyncStruct->cancelled)
+        {
+            // generate texture in render thread
+            image = new CAImage();
+            image->initWithImage(pImage);
+            
 #if CC_ENABLE_CACHE_TEXTURE_DATA
-       // cache the image file name
-       VolatileTexture::addImageTexture(image, filename, pImageInfo->imageType);
+            // cache the image file name
+            VolatileTexture::addImageTexture(image, filename, pImageInfo->imageType);
 #endif
-
-        // cache the image
-        m_pImages->setObject(image, filename);
+            
+            // cache the image
+            this->cacheImageForKey(image, filename);
+            
+            uploadedBytes += image->getPixelsWide() * image->getPixelsHigh() * image->bitsPerPixelForFormat() / 8;
+        }
         
-
-        if (target && selector)
+        std::vector<AsyncTarget>::iterator itr;
+        for (itr=pAsyncStruct->targets.begin(); itr!=pAsyncStruct->targets.end(); itr++)
         {
-            (target->*selector)(image);
-            target->release();
+            if (image && itr->target && itr->selector)
+            {
+                (itr->target->*itr->selector)(image);
+            }
+            CC_SAFE_RELEASE(itr->target);
         }
         
-        image->release();
-        pImage->release();
+        CC_SAFE_RELEASE(image);
+        CC_SAFE_RELEASE(pImage);
         delete pAsyncStruct;
         delete pImageInfo;
 
@@ -366,7 +582,14 @@ void CAImageCache::addImageAsyncCallBack(float dt)
         if (0 == s_nAsyncRefCount)
         {
             CAScheduler::unschedule(schedule_selector(CAImageCache::addImageAsyncCallBack), this);
+            break;
         }
+        
+        CC_BREAK_IF(m_uAsyncUploadBytesBudget > 0 && uploadedBytes >= m_uAsyncUploadBytesBudget);
+        
+        struct cc_timeval now;
+        CCTime::gettimeofdayCrossApp(&now, NULL);
+        CC_BREAK_IF(CCTime::timersubCrossApp(&begin, &now) >= m_fAsyncUploadTimeBudget);
     }
 }
 
@@ -392,7 +615,7 @@ CAImage* CAImageCache::addImageFullPath(const std::string& fileimage)
     
     //pthread_mutex_lock(m_pDictLock);
     
-    image = (CAImage*)m_pImages->objectForKey(fileimage);
+    image = this->cachedImageForKey(fileimage);
     
     std::string fullpath = fileimage; // (CCFileUtils::sharedFileUtils()->fullPathFromRelativePath(path));
     if (!image)
@@ -445,7 +668,7 @@ CAImage* CAImageCache::addImageFullPath(const std::string& fileimage)
                     // cache the texture file name
                     VolatileTexture::addImageTexture(image, fullpath.c_str(), eImageFormat);
 #endif
-                    m_pImages->setObject(image, fileimage);
+                    this->cacheImageForKey(image, fileimage);
                     image->release();
                 }
                 else
@@ -467,7 +690,7 @@ CAImage* CAImageCache::addETCImage(const std::string& path)
     CAImage* texture = NULL;
     std::string key(path);
     
-    if( (texture = (CAImage*)m_pImages->objectForKey(key.c_str())) )
+    if( (texture = this->cachedImageForKey(key)) )
     {
         return texture;
     }
@@ -477,7 +700,7 @@ CAImage* CAImageCache::addETCImage(const std::string& path)
     texture = new CAImage();
     if(texture != NULL && texture->initWithETCFile(fullpath.c_str()))
     {
-        m_pImages->setObject(texture, key.c_str());
+        this->cacheImageForKey(texture, key);
         texture->autorelease();
     }
     else
@@ -504,7 +727,7 @@ CAImage* CAImageCache::addUIImage(CCImage *image, const std::string& key)
     do 
     {
         // If key is nil, then create a new texture each time
-        if((texture = (CAImage* )m_pImages->objectForKey(forKey)))
+        if((texture = this->cachedImageForKey(forKey)))
         {
             break;
         }
@@ -515,7 +738,7 @@ CAImage* CAImageCache::addUIImage(CCImage *image, const std::string& key)
 
         if(texture)
         {
-            m_pImages->setObject(texture, forKey);
+            this->cacheImageForKey(texture, forKey);
             texture->autorelease();
         }
         else
@@ -557,6 +780,9 @@ bool CAImageCache::reloadImage(const std::string& fileName)
             CC_BREAK_IF(!bRet);
             
             ret = texture->initWithImage(image);
+            
+            // the size of the image may have changed
+            this->cacheImageForKey(texture, fullpath);
         } while (0);
     }
     
@@ -568,6 +794,9 @@ bool CAImageCache::reloadImage(const std::string& fileName)
 void CAImageCache::removeAllImages()
 {
     m_pImages->removeAllObjects();
+    m_lImageKeys.clear();
+    m_mImageEntries.clear();
+    m_uImagesBytes = 0;
 }
 
 void CAImageCache::removeUnusedImages()
@@ -607,7 +836,7 @@ void CAImageCache::removeUnusedImages()
         for (list<CCDictElement*>::iterator iter = elementToRemove.begin(); iter != elementToRemove.end(); ++iter)
         {
             CCLOG("CrossApp: CAImageCache: removing unused texture: %s", (*iter)->getStrKey());
-            m_pImages->removeObjectForElememt(*iter);
+            this->uncacheImageForKey((*iter)->getStrKey());
         }
     }
 }
@@ -618,7 +847,7 @@ void CAImageCache::setImageForKey(CAImage* image, const std::string& key)
     {
         return;
     }
-    m_pImages->setObject(image, CCFileUtils::sharedFileUtils()->fullPathForFilename(key.c_str()));
+    this->cacheImageForKey(image, CCFileUtils::sharedFileUtils()->fullPathForFilename(key.c_str()));
 }
 
 void CAImageCache::removeImage(CAImage* image)
@@ -629,18 +858,129 @@ void CAImageCache::removeImage(CAImage* image)
     }
 
     CCArray* keys = m_pImages->allKeysForObject(image);
-    m_pImages->removeObjectsForKeys(keys);
+    CAObject* pObj = NULL;
+    CCARRAY_FOREACH(keys, pObj)
+    {
+        this->uncacheImageForKey(((CCString*)pObj)->getCString());
+    }
 }
 
 void CAImageCache::removeImageForKey(const std::string& imageKeyName)
 {
     string fullPath = CCFileUtils::sharedFileUtils()->fullPathForFilename(imageKeyName.c_str());
-    m_pImages->removeObjectForKey(fullPath);
+    this->uncacheImageForKey(fullPath);
 }
 
 CAImage* CAImageCache::imageForKey(const std::string& key)
 {
-    return (CAImage*)m_pImages->objectForKey(CCFileUtils::sharedFileUtils()->fullPathForFilename(key));
+    return this->cachedImageForKey(CCFileUtils::sharedFileUtils()->fullPathForFilename(key));
+}
+
+static unsigned long imageBytes(CAImage* image)
+{
+    // Each texture takes up width * height * bytesPerPixel bytes.
+    return (unsigned long)image->getPixelsWide() * image->getPixelsHigh() * image->bitsPerPixelForFormat() / 8;
+}
+
+CAImage* CAImageCache::cachedImageForKey(const std::string& key)
+{
+    CAImage* image = (CAImage*)m_pImages->objectForKey(key);
+    if (image)
+    {
+        ++m_uHitsCount;
+        
+        // most recently used last
+        std::map<std::string, CAImageCacheEntry>::iterator itr = m_mImageEntries.find(key);
+        if (itr != m_mImageEntries.end())
+        {
+            m_lImageKeys.splice(m_lImageKeys.end(), m_lImageKeys, itr->second.lru);
+        }
+    }
+    else
+    {
+        ++m_uMissesCount;
+    }
+    return image;
+}
+
+void CAImageCache::cacheImageForKey(CAImage* image, const std::string& key)
+{
+    m_pImages->setObject(image, key);
+    
+    std::map<std::string, CAImageCacheEntry>::iterator itr = m_mImageEntries.find(key);
+    if (itr != m_mImageEntries.end())
+    {
+        m_uImagesBytes -= itr->second.bytes;
+        m_lImageKeys.erase(itr->second.lru);
+        m_mImageEntries.erase(itr);
+    }
+    
+    CAImageCacheEntry entry;
+    entry.lru = m_lImageKeys.insert(m_lImageKeys.end(), key);
+    entry.bytes = imageBytes(image);
+    m_mImageEntries[key] = entry;
+    m_uImagesBytes += entry.bytes;
+    
+    // evicted in the next frame, the caller may not have retained the image yet
+    if (m_uMemoryBudget > 0 && m_uImagesBytes > m_uMemoryBudget && !m_bEvictionScheduled)
+    {
+        m_bEvictionScheduled = true;
+        CAScheduler::schedule(schedule_selector(CAImageCache::evictImages), this, 0);
+    }
+}
+
+void CAImageCache::uncacheImageForKey(const std::string& key)
+{
+    std::map<std::string, CAImageCacheEntry>::iterator itr = m_mImageEntries.find(key);
+    if (itr != m_mImageEntries.end())
+    {
+        m_uImagesBytes -= itr->second.bytes;
+        m_lImageKeys.erase(itr->second.lru);
+        m_mImageEntries.erase(itr);
+    }
+    
+    m_pImages->removeObjectForKey(key);
+}
+
+void CAImageCache::evictImages(float dt)
+{
+    CC_UNUSED_PARAM(dt);
+    
+    CAScheduler::unschedule(schedule_selector(CAImageCache::evictImages), this);
+    m_bEvictionScheduled = false;
+    
+    // least recently used first, only the images held by the cache alone
+    std::list<std::string>::iterator itr = m_lImageKeys.begin();
+    while (itr != m_lImageKeys.end() && m_uMemoryBudget > 0 && m_uImagesBytes > m_uMemoryBudget)
+    {
+        std::string key = *itr;
+        itr++;
+        
+        CAImage* image = (CAImage*)m_pImages->objectForKey(key);
+        if (image == NULL || image->retainCount() == 1)
+        {
+            this->uncacheImageForKey(key);
+            ++m_uEvictionsCount;
+        }
+    }
+}
+
+void CAImageCache::setMemoryBudget(unsigned long bytes)
+{
+    m_uMemoryBudget = bytes;
+    
+    if (m_uMemoryBudget > 0 && m_uImagesBytes > m_uMemoryBudget && !m_bEvictionScheduled)
+    {
+        m_bEvictionScheduled = true;
+        CAScheduler::schedule(schedule_selector(CAImageCache::evictImages), this, 0);
+    }
+}
+
+void CAImageCache::resetCounters()
+{
+    m_uHitsCount = 0;
+    m_uMissesCount = 0;
+    m_uEvictionsCount = 0;
 }
 
 void CAImageCache::reloadAllImages()
@@ -675,6 +1015,8 @@ void CAImageCache::dumpCachedImageInfo()
     }
 
     CCLOG("CrossApp: CAImageCache dumpDebugInfo: %ld textures, for %lu KB (%.2f MB)", (long)count, (long)totalBytes / 1024, totalBytes / (1024.0f*1024.0f));
+    CCLOG("CrossApp: CAImageCache budget %lu KB, hits %u, misses %u, evictions %u",
+          m_uMemoryBudget / 1024, m_uHitsCount, m_uMissesCount, m_uEvictionsCount);
 }
 
 
@@ -1305,6 +1647,8 @@ VolatileTexture::VolatileTexture(CAImage* t)
 : texture(t)
 , m_eCashedImageType(kInvalid)
 , m_pTextureData(NULL)
+, m_bOwnsTextureData(false)
+, m_uTextureDataLength(0)
 , m_PixelFormat(kImagePixelFormat_RGBA8888)
 , m_strFileName("")
 , m_FmtImage(CCImage::kFmtPng)
@@ -1327,6 +1671,18 @@ VolatileTexture::~VolatileTexture()
 {
     textures.remove(this);
     CC_SAFE_RELEASE(uiImage);
+    this->releaseTextureData();
+}
+
+void VolatileTexture::releaseTextureData()
+{
+    if (m_bOwnsTextureData)
+    {
+        free(m_pTextureData);
+    }
+    m_pTextureData = NULL;
+    m_bOwnsTextureData = false;
+    m_uTextureDataLength = 0;
 }
 
 void VolatileTexture::addImageTexture(CAImage* tt, const char* imageFileName, CCImage::EImageFormat format)
@@ -1338,6 +1694,7 @@ void VolatileTexture::addImageTexture(CAImage* tt, const char* imageFileName, CC
     
     VolatileTexture *vt = findVolotileTexture(tt);
     
+    vt->releaseTextureData();
     vt->m_eCashedImageType = kImageFile;
     vt->m_strFileName = imageFileName;
     vt->m_FmtImage    = format;
@@ -1347,6 +1704,7 @@ void VolatileTexture::addImageTexture(CAImage* tt, const char* imageFileName, CC
 void VolatileTexture::addCCImage(CAImage* tt, CCImage *image)
 {
     VolatileTexture *vt = findVolotileTexture(tt);
+    vt->releaseTextureData();
     image->retain();
     vt->uiImage = image;
     vt->m_eCashedImageType = kImage;
@@ -1383,10 +1741,41 @@ void VolatileTexture::addDataTexture(CAImage* tt, void* data, CAImagePixelFormat
     
     VolatileTexture *vt = findVolotileTexture(tt);
     
+    vt->releaseTextureData();
     vt->m_eCashedImageType = kImageData;
-    vt->m_pTextureData = data;
     vt->m_PixelFormat = pixelFormat;
     vt->m_TextureSize = contentSize;
+    
+    if (data == tt->getData())
+    {
+        vt->m_pTextureData = data;
+    }
+    else
+    {
+        // the image doesn't keep its pixels, keep a copy until a file or encoded bytes are known
+        vt->m_uTextureDataLength = tt->getPixelDataLength();
+        vt->m_pTextureData = malloc(vt->m_uTextureDataLength);
+        memcpy(vt->m_pTextureData, data, vt->m_uTextureDataLength);
+        vt->m_bOwnsTextureData = true;
+    }
+}
+
+void VolatileTexture::addEncodedDataTexture(CAImage* tt, void* data, int length)
+{
+    if (isReloading)
+    {
+        return;
+    }
+    
+    VolatileTexture *vt = findVolotileTexture(tt);
+    
+    vt->releaseTextureData();
+    vt->m_eCashedImageType = kEncodedData;
+    vt->m_uTextureDataLength = length;
+    vt->m_pTextureData = malloc(length);
+    memcpy(vt->m_pTextureData, data, length);
+    vt->m_bOwnsTextureData = true;
+    vt->m_PixelFormat = tt->getPixelFormat();
 }
 
 void VolatileTexture::setTexParameters(CAImage* t, ccTexParams *texParams)
@@ -1464,6 +1853,14 @@ void VolatileTexture::reloadAllImages()
                                           vt->m_TextureSize);
             }
                 break;
+            case kEncodedData:
+            {
+                CAImagePixelFormat oldPixelFormat = CAImage::defaultAlphaPixelFormat();
+                CAImage::setDefaultAlphaPixelFormat(vt->m_PixelFormat);
+                vt->texture->initWithData(vt->m_pTextureData, (int)vt->m_uTextureDataLength);
+                CAImage::setDefaultAlphaPixelFormat(oldPixelFormat);
+            }
+                break;
             case kImage:
             {
                 vt->texture->initWithImage(vt->uiImage);
@@ -7,6 +7,8 @@
 #include "cocoa/CCDictionary.h"
 #include "CAImage.h"
 #include <string>
+#include <list>
+#include <map>
 
 
 #if CC_ENABLE_CACHE_TEXTURE_DATA
@@ -40,9 +42,25 @@ public:
     
     CAImage* addImageFullPath(const std::string& fileimage);
     
-    void addImageAsync(const std::string& path, CAObject *target, SEL_CallFuncO selector);
+    /** decodes the image in a loading thread and calls the selector once it is uploaded.
+     Requests with a higher priority are decoded first, concurrent requests of the same file share one decoding.
+     */
+    void addImageAsync(const std::string& path, CAObject *target, SEL_CallFuncO selector, int priority = 0);
 
-    void addImageFullPathAsync(const std::string& path, CAObject *target, SEL_CallFuncO selector);
+    void addImageFullPathAsync(const std::string& path, CAObject *target, SEL_CallFuncO selector, int priority = 0);
+    
+    /** drops the request of the target for the file (full path), or of all its targets if target is NULL.
+     The file is not decoded if nobody else requested it.
+     */
+    void cancelImageAsync(const std::string& path, CAObject *target);
+    
+    /** drops all the requests of the target */
+    void cancelImageAsync(CAObject *target);
+    
+    /** number of loading threads, 4 by default. It takes effect when the threads are started */
+    static void setAsyncThreadsCount(unsigned int count);
+    
+    static unsigned int getAsyncThreadsCount();
     
     CAImage* addUIImage(CCImage *image, const std::string& key);
 
@@ -66,14 +84,73 @@ public:
     
     static void reloadAllImages();
     
+    /** GPU memory budget of the cached images, in bytes. 0 (default) means no budget.
+     When it is exceeded, the least recently used images held by the cache alone are released in the next frame.
+     */
+    void setMemoryBudget(unsigned long bytes);
+    
+    inline unsigned long getMemoryBudget() { return m_uMemoryBudget; }
+    
+    /** GPU memory of the cached images, in bytes (width * height * bits per pixel) */
+    inline unsigned long getMemoryBytes() { return m_uImagesBytes; }
+    
+    inline unsigned int getHitsCount() { return m_uHitsCount; }
+    
+    inline unsigned int getMissesCount() { return m_uMissesCount; }
+    
+    inline unsigned int getEvictionsCount() { return m_uEvictionsCount; }
+    
+    void resetCounters();
+    
 private:
     
     void addImageAsyncCallBack(float dt);
     
+    void evictImages(float dt);
+    
+protected:
+    
+    /** looks an image up, counts the hit or miss and marks the image as recently used */
+    CAImage* cachedImageForKey(const std::string& key);
+    
+    void cacheImageForKey(CAImage* image, const std::string& key);
+    
+    void uncacheImageForKey(const std::string& key);
+    
 protected:
     
+    typedef struct _CAImageCacheEntry
+    {
+        std::list<std::string>::iterator lru;
+        unsigned long bytes;
+    }
+    CAImageCacheEntry;
+    
+    // keys of the cached images, least recently used first
+    std::list<std::string> m_lImageKeys;
+    
+    std::map<std::string, CAImageCacheEntry> m_mImageEntries;
+    
+    unsigned long m_uImagesBytes;
+    
+    unsigned long m_uMemoryBudget;
+    
+    unsigned int m_uHitsCount;
+    
+    unsigned int m_uMissesCount;
+    
+    unsigned int m_uEvictionsCount;
+    
+    bool m_bEvictionScheduled;
+    
     CCDictionary* m_pImages;
     //pthread_mutex_t                *m_pDictLock;
+    
+    /** time spent uploading the decoded images in a frame, in milliseconds, 8 by default */
+    CC_SYNTHESIZE(float, m_fAsyncUploadTimeBudget, AsyncUploadTimeBudget);
+    
+    /** bytes of decoded images uploaded in a frame, 0 (no limit) by default */
+    CC_SYNTHESIZE(unsigned int, m_uAsyncUploadBytesBudget, AsyncUploadBytesBudget);
 };
 
 
@@ -172,6 +249,7 @@ class VolatileTexture
         kInvalid = 0,
         kImageFile,
         kImageData,
+        kEncodedData,
         kString,
         kImage,
     }ccCachedImageType;
@@ -186,6 +264,8 @@ public:
 
     static void addDataTexture(CAImage* tt, void* data, CAImagePixelFormat pixelFormat, const CCSize& contentSize);
     
+    static void addEncodedDataTexture(CAImage* tt, void* data, int length);
+    
     static void addCCImage(CAImage* tt, CCImage *image);
     
     static void setTexParameters(CAImage* t, ccTexParams *texParams);
@@ -204,6 +284,8 @@ private:
 
     static VolatileTexture* findVolotileTexture(CAImage* tt);
     
+    void releaseTextureData();
+    
 protected:
     
     CAImage* texture;
@@ -214,6 +296,11 @@ protected:
     
     void *m_pTextureData;
     
+    // whether m_pTextureData is a copy owned by the volatile texture
+    bool m_bOwnsTextureData;
+    
+    unsigned long m_uTextureDataLength;
+    
     CCSize m_TextureSize;
     
     CAImagePixelFormat m_PixelFormat;
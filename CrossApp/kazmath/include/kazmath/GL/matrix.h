@@ -52,6 +52,7 @@ void CC_DLL kmGLTranslatef(float x, float y, float z);
 void CC_DLL kmGLRotatef(float angle, float x, float y, float z);
 void CC_DLL kmGLScalef(float x, float y, float z);
 void CC_DLL kmGLGetMatrix(kmGLEnum mode, kmMat4* pOut);
+unsigned int CC_DLL kmGLGetMatrixGeneration(kmGLEnum mode); /** Changes every time the top matrix of the stack may change, 0 for an invalid mode */
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,50 @@
+/*
+ SIMD kernels of kazmath: SSE and NEON intrinsics for the matrix products
+ used every frame (modelview stack, vertices of the render queue).
+*/
+
+#ifndef __SIMD_MATRIX_IMPL_H__
+#define __SIMD_MATRIX_IMPL_H__
+
+// The 4 floats wide instructions are chosen at compile time: SSE on x86 (always there on x86-64),
+// NEON intrinsics on AArch64 and on ARMv7 built with NEON. KM_SIMD is defined when one of them is
+// used, the callers keep their scalar code otherwise. The ARMv7 builds defining _ARM_ARCH_7 keep
+// the assembly of neon_matrix_impl.h for the matrix product.
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define KM_SIMD_SSE 1
+#define KM_SIMD 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(__aarch64__)
+#define KM_SIMD_NEON 1
+#define KM_SIMD 1
+#endif
+
+#ifdef KM_SIMD
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Matrices are assumed to be stored in column major format according to OpenGL
+// specification.
+
+// Multiplies two 4x4 matrices (a,b) outputting a 4x4 matrix (output = a * b),
+// output may be a or b
+void SIMD_Matrix4Mul(const float* a, const float* b, float* output);
+
+// Multiplies a 4x4 matrix (m) with a vector 4 (v), outputting a vector 4
+void SIMD_Matrix4Vector4Mul(const float* m, const float* v, float* output);
+
+// Transforms count vectors 3 (w = 1) by a 4x4 matrix (m), the vectors are read from input and
+// written to output every inputStride and outputStride bytes, the bytes between are left as they are
+void SIMD_Matrix4Vector3ArrayMul(const float* m,
+                                 const float* input, unsigned int inputStride,
+                                 float* output, unsigned int outputStride,
+                                 unsigned int count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // KM_SIMD
+
+#endif // __SIMD_MATRIX_IMPL_H__
@@ -37,6 +37,26 @@ km_mat4_stack* current_stack = NULL;
 
 static unsigned char initialized = 0;
 
+/* The generation of a stack changes every time its top matrix may change, the values come from
+   one counter so that a pair of generations is never seen twice. 0 is never given. */
+static unsigned int matrix_generation = 0;
+static unsigned int modelview_generation = 0;
+static unsigned int projection_generation = 0;
+static unsigned int texture_generation = 0;
+
+static void touchCurrentStack(void)
+{
+    ++matrix_generation;
+
+    if (current_stack == &modelview_matrix_stack) {
+        modelview_generation = matrix_generation;
+    } else if (current_stack == &projection_matrix_stack) {
+        projection_generation = matrix_generation;
+    } else {
+        texture_generation = matrix_generation;
+    }
+}
+
 void lazyInitialize()
 {
 
@@ -62,6 +82,10 @@ void lazyInitialize()
         km_mat4_stack_push(&modelview_matrix_stack, &identity);
         km_mat4_stack_push(&projection_matrix_stack, &identity);
         km_mat4_stack_push(&texture_matrix_stack, &identity);
+
+        modelview_generation = ++matrix_generation;
+        projection_generation = ++matrix_generation;
+        texture_generation = ++matrix_generation;
     }
 }
 
@@ -102,6 +126,7 @@ void kmGLPopMatrix(void)
     assert(initialized && "Cannot Pop empty matrix stack");
     //No need to lazy initialize, you shouldn't be popping first anyway!
     km_mat4_stack_pop(current_stack, NULL);
+    touchCurrentStack();
 }
 
 void kmGLLoadIdentity()
@@ -109,6 +134,7 @@ void kmGLLoadIdentity()
     lazyInitialize();
 
     kmMat4Identity(current_stack->top); //Replace the top matrix with the identity matrix
+    touchCurrentStack();
 }
 
 void kmGLFreeAll()
@@ -128,12 +154,14 @@ void kmGLMultMatrix(const kmMat4* pIn)
 {
     lazyInitialize();
     kmMat4Multiply(current_stack->top, current_stack->top, pIn);
+    touchCurrentStack();
 }
 
 void kmGLLoadMatrix(const kmMat4* pIn)
 {
     lazyInitialize();
     kmMat4Assign(current_stack->top, pIn);
+    touchCurrentStack();
 }
 
 void kmGLGetMatrix(kmGLEnum mode, kmMat4* pOut)
@@ -157,6 +185,27 @@ void kmGLGetMatrix(kmGLEnum mode, kmMat4* pOut)
     }
 }
 
+unsigned int kmGLGetMatrixGeneration(kmGLEnum mode)
+{
+    lazyInitialize();
+
+    switch(mode)
+    {
+        case KM_GL_MODELVIEW:
+            return modelview_generation;
+        case KM_GL_PROJECTION:
+            return projection_generation;
+        case KM_GL_TEXTURE:
+            return texture_generation;
+        default:
+            assert(0 && "Invalid matrix mode specified");
+        break;
+    }
+
+    /* the stacks start at generation 1, 0 is never a valid one */
+    return 0;
+}
+
 void kmGLTranslatef(float x, float y, float z)
 {
     kmMat4 translation;
@@ -166,6 +215,7 @@ void kmGLTranslatef(float x, float y, float z)
 
     //Multiply the rotation matrix by the current matrix
     kmMat4Multiply(current_stack->top, current_stack->top, &translation);
+    touchCurrentStack();
 }
 
 void kmGLRotatef(float angle, float x, float y, float z)
@@ -181,6 +231,7 @@ void kmGLRotatef(float angle, float x, float y, float z)
 
     //Multiply the rotation matrix by the current matrix
     kmMat4Multiply(current_stack->top, current_stack->top, &rotation);
+    touchCurrentStack();
 }
 
 void kmGLScalef(float x, float y, float z)
@@ -188,4 +239,5 @@ void kmGLScalef(float x, float y, float z)
     kmMat4 scaling;
     kmMat4Scaling(&scaling, x, y, z);
     kmMat4Multiply(current_stack->top, current_stack->top, &scaling);
+    touchCurrentStack();
 }
@@ -38,6 +38,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "kazmath/plane.h"
 
 #include "kazmath/neon_matrix_impl.h"
+#include "kazmath/simd_matrix_impl.h"
 
 /**
  * Fills a kmMat4 structure with the values from a 16
@@ -166,18 +167,57 @@ int gaussj(kmMat4 *a, kmMat4 *b)
  */
 kmMat4* const kmMat4Inverse(kmMat4* pOut, const kmMat4* pM)
 {
-    kmMat4 inv;
-    kmMat4 tmp;
-
-    kmMat4Assign(&inv, pM);
-
-    kmMat4Identity(&tmp);
-
-    if(gaussj(&inv, &tmp) == KM_FALSE) {
+    /* The adjugate divided by the determinant, from the 2x2 minors of the first two and of the
+       last two columns: no pivoting nor branches, about a third of the work of gaussj() */
+    const float* m = pM->mat;
+    float inv[16];
+    float det;
+    int i;
+
+    float s0 = m[0] * m[5] - m[4] * m[1];
+    float s1 = m[0] * m[6] - m[4] * m[2];
+    float s2 = m[0] * m[7] - m[4] * m[3];
+    float s3 = m[1] * m[6] - m[5] * m[2];
+    float s4 = m[1] * m[7] - m[5] * m[3];
+    float s5 = m[2] * m[7] - m[6] * m[3];
+
+    float c5 = m[10] * m[15] - m[14] * m[11];
+    float c4 = m[9] * m[15] - m[13] * m[11];
+    float c3 = m[9] * m[14] - m[13] * m[10];
+    float c2 = m[8] * m[15] - m[12] * m[11];
+    float c1 = m[8] * m[14] - m[12] * m[10];
+    float c0 = m[8] * m[13] - m[12] * m[9];
+
+    det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+    if (det == 0.0f) {
         return NULL;
     }
 
-    kmMat4Assign(pOut, &inv);
+    inv[0] = m[5] * c5 - m[6] * c4 + m[7] * c3;
+    inv[1] = -m[1] * c5 + m[2] * c4 - m[3] * c3;
+    inv[2] = m[13] * s5 - m[14] * s4 + m[15] * s3;
+    inv[3] = -m[9] * s5 + m[10] * s4 - m[11] * s3;
+
+    inv[4] = -m[4] * c5 + m[6] * c2 - m[7] * c1;
+    inv[5] = m[0] * c5 - m[2] * c2 + m[3] * c1;
+    inv[6] = -m[12] * s5 + m[14] * s2 - m[15] * s1;
+    inv[7] = m[8] * s5 - m[10] * s2 + m[11] * s1;
+
+    inv[8] = m[4] * c4 - m[5] * c2 + m[7] * c0;
+    inv[9] = -m[0] * c4 + m[1] * c2 - m[3] * c0;
+    inv[10] = m[12] * s4 - m[13] * s2 + m[15] * s0;
+    inv[11] = -m[8] * s4 + m[9] * s2 - m[11] * s0;
+
+    inv[12] = -m[4] * c3 + m[5] * c1 - m[6] * c0;
+    inv[13] = m[0] * c3 - m[1] * c1 + m[2] * c0;
+    inv[14] = -m[12] * s3 + m[13] * s1 - m[14] * s0;
+    inv[15] = m[8] * s3 - m[9] * s1 + m[10] * s0;
+
+    det = 1.0f / det;
+    for (i = 0; i < 16; ++i) {
+        pOut->mat[i] = inv[i] * det;
+    }
+
     return pOut;
 }
 /**
@@ -223,6 +263,12 @@ kmMat4* const kmMat4Multiply(kmMat4* pOut, const kmMat4* pM1, const kmMat4* pM2)
     // Invert column-order with row-order
     NEON_Matrix4Mul( &pM2->mat[0], &pM1->mat[0], &mat[0] );
 
+#elif defined(KM_SIMD)
+
+    float mat[16];
+
+    SIMD_Matrix4Mul( &pM1->mat[0], &pM2->mat[0], &mat[0] );
+
 #else
     float mat[16];
 
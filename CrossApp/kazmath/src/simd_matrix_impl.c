@@ -0,0 +1,136 @@
+/*
+ SIMD kernels of kazmath: SSE and NEON intrinsics for the matrix products
+ used every frame (modelview stack, vertices of the render queue).
+*/
+
+#include <string.h>
+
+#include "kazmath/simd_matrix_impl.h"
+
+#if defined(KM_SIMD_SSE)
+
+#include <xmmintrin.h>
+
+void SIMD_Matrix4Mul(const float* a, const float* b, float* output)
+{
+    // the columns of a are loaded first, output may be a
+    __m128 a0 = _mm_loadu_ps(a);
+    __m128 a1 = _mm_loadu_ps(a + 4);
+    __m128 a2 = _mm_loadu_ps(a + 8);
+    __m128 a3 = _mm_loadu_ps(a + 12);
+    int i;
+
+    // column i of the output = a * column i of b, written after column i of b is read
+    for (i = 0; i < 16; i += 4)
+    {
+        __m128 r = _mm_mul_ps(a0, _mm_set1_ps(b[i]));
+        r = _mm_add_ps(r, _mm_mul_ps(a1, _mm_set1_ps(b[i + 1])));
+        r = _mm_add_ps(r, _mm_mul_ps(a2, _mm_set1_ps(b[i + 2])));
+        r = _mm_add_ps(r, _mm_mul_ps(a3, _mm_set1_ps(b[i + 3])));
+        _mm_storeu_ps(output + i, r);
+    }
+}
+
+void SIMD_Matrix4Vector4Mul(const float* m, const float* v, float* output)
+{
+    __m128 r = _mm_mul_ps(_mm_loadu_ps(m), _mm_set1_ps(v[0]));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(m + 4), _mm_set1_ps(v[1])));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(m + 8), _mm_set1_ps(v[2])));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(m + 12), _mm_set1_ps(v[3])));
+    _mm_storeu_ps(output, r);
+}
+
+void SIMD_Matrix4Vector3ArrayMul(const float* m,
+                                 const float* input, unsigned int inputStride,
+                                 float* output, unsigned int outputStride,
+                                 unsigned int count)
+{
+    __m128 m0 = _mm_loadu_ps(m);
+    __m128 m1 = _mm_loadu_ps(m + 4);
+    __m128 m2 = _mm_loadu_ps(m + 8);
+    __m128 m3 = _mm_loadu_ps(m + 12);
+    const char* in = (const char*)input;
+    char* out = (char*)output;
+
+    for (; count > 0; --count)
+    {
+        const float* v = (const float*)in;
+        float* o = (float*)out;
+
+        __m128 r = _mm_add_ps(m3, _mm_mul_ps(m0, _mm_set1_ps(v[0])));
+        r = _mm_add_ps(r, _mm_mul_ps(m1, _mm_set1_ps(v[1])));
+        r = _mm_add_ps(r, _mm_mul_ps(m2, _mm_set1_ps(v[2])));
+
+        // x and y, then z: the float after the vector belongs to the caller
+        _mm_storel_pi((__m64*)o, r);
+        _mm_store_ss(o + 2, _mm_movehl_ps(r, r));
+
+        in += inputStride;
+        out += outputStride;
+    }
+}
+
+#elif defined(KM_SIMD_NEON)
+
+#include <arm_neon.h>
+
+void SIMD_Matrix4Mul(const float* a, const float* b, float* output)
+{
+    // the columns of a are loaded first, output may be a
+    float32x4_t a0 = vld1q_f32(a);
+    float32x4_t a1 = vld1q_f32(a + 4);
+    float32x4_t a2 = vld1q_f32(a + 8);
+    float32x4_t a3 = vld1q_f32(a + 12);
+    int i;
+
+    // column i of the output = a * column i of b, written after column i of b is read
+    for (i = 0; i < 16; i += 4)
+    {
+        float32x4_t r = vmulq_n_f32(a0, b[i]);
+        r = vmlaq_n_f32(r, a1, b[i + 1]);
+        r = vmlaq_n_f32(r, a2, b[i + 2]);
+        r = vmlaq_n_f32(r, a3, b[i + 3]);
+        vst1q_f32(output + i, r);
+    }
+}
+
+void SIMD_Matrix4Vector4Mul(const float* m, const float* v, float* output)
+{
+    float32x4_t r = vmulq_n_f32(vld1q_f32(m), v[0]);
+    r = vmlaq_n_f32(r, vld1q_f32(m + 4), v[1]);
+    r = vmlaq_n_f32(r, vld1q_f32(m + 8), v[2]);
+    r = vmlaq_n_f32(r, vld1q_f32(m + 12), v[3]);
+    vst1q_f32(output, r);
+}
+
+void SIMD_Matrix4Vector3ArrayMul(const float* m,
+                                 const float* input, unsigned int inputStride,
+                                 float* output, unsigned int outputStride,
+                                 unsigned int count)
+{
+    float32x4_t m0 = vld1q_f32(m);
+    float32x4_t m1 = vld1q_f32(m + 4);
+    float32x4_t m2 = vld1q_f32(m + 8);
+    float32x4_t m3 = vld1q_f32(m + 12);
+    const char* in = (const char*)input;
+    char* out = (char*)output;
+
+    for (; count > 0; --count)
+    {
+        const float* v = (const float*)in;
+        float* o = (float*)out;
+
+        float32x4_t r = vmlaq_n_f32(m3, m0, v[0]);
+        r = vmlaq_n_f32(r, m1, v[1]);
+        r = vmlaq_n_f32(r, m2, v[2]);
+
+        // x and y, then z: the float after the vector belongs to the caller
+        vst1_f32(o, vget_low_f32(r));
+        vst1q_lane_f32(o + 2, r, 2);
+
+        in += inputStride;
+        out += outputStride;
+    }
+}
+
+#endif
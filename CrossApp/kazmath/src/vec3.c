@@ -34,6 +34,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "kazmath/vec4.h"
 #include "kazmath/mat4.h"
 #include "kazmath/vec3.h"
+#include "kazmath/simd_matrix_impl.h"
 
 /**
  * Fill a kmVec3 structure using 3 floating point values
@@ -164,6 +165,9 @@ kmVec3* kmVec3Transform(kmVec3* pOut, const kmVec3* pV, const kmMat4* pM)
         Out = (bx, by, bz)
     */
 
+#if defined(KM_SIMD)
+    SIMD_Matrix4Vector3ArrayMul(pM->mat, &pV->x, 0, &pOut->x, 0, 1);
+#else
     kmVec3 v;
 
     v.x = pV->x * pM->mat[0] + pV->y * pM->mat[4] + pV->z * pM->mat[8] + pM->mat[12];
@@ -173,6 +177,30 @@ kmVec3* kmVec3Transform(kmVec3* pOut, const kmVec3* pV, const kmMat4* pM)
     pOut->x = v.x;
     pOut->y = v.y;
     pOut->z = v.z;
+#endif
+
+    return pOut;
+}
+
+/**
+ * Transforms count vectors (assuming w=1) by a given matrix. The vectors are read every
+ * vStride bytes from pV and written every outStride bytes to pOut, for vertices interleaved
+ * with other attributes; pOut may be pV.
+ */
+kmVec3* kmVec3TransformInterleaved(kmVec3* pOut, unsigned int outStride, const kmVec3* pV, unsigned int vStride, const kmMat4* pM, unsigned int count)
+{
+#if defined(KM_SIMD)
+    SIMD_Matrix4Vector3ArrayMul(pM->mat, &pV->x, vStride, &pOut->x, outStride, count);
+#else
+    const char* in = (const char*)pV;
+    char* out = (char*)pOut;
+
+    for (; count > 0; --count) {
+        kmVec3Transform((kmVec3*)out, (const kmVec3*)in, pM);
+        in += vStride;
+        out += outStride;
+    }
+#endif
 
     return pOut;
 }
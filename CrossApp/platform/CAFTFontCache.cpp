@@ -2,6 +2,7 @@
 #include "basics/CAApplication.h"
 #include "platform/CCFileUtils.h"
 #include "support/ccUTF8.h"
+#include <algorithm>
 
 
 using namespace std;
@@ -10,14 +11,28 @@ NS_CC_BEGIN
 
 
 CAFTFontCache::CAFTFontCache()
-: m_pCurFontData(NULL)
 {
+	pthread_mutex_init(&m_tFontContextsMutex, NULL);
+	pthread_key_create(&m_tContextKey, &CAFTFontCache::destroyFontContext);
 	initDefaultFont();
 }
 
 CAFTFontCache::~CAFTFontCache()
 {
-	destroyAllFontData();
+	// no thread exit destroys a context from now on, the faces of every thread are released before the font files
+	pthread_key_delete(m_tContextKey);
+
+	pthread_mutex_lock(&m_tFontContextsMutex);
+	std::vector<FontContext*> contexts;
+	contexts.swap(m_vFontContexts);
+	pthread_mutex_unlock(&m_tFontContextsMutex);
+
+	for (std::vector<FontContext*>::iterator itr = contexts.begin(); itr != contexts.end(); itr++)
+	{
+		finiFontContext(*itr);
+	}
+
+	pthread_mutex_destroy(&m_tFontContextsMutex);
 	CAFreeTypeFont::destroyAllFontBuff();
 }
 
@@ -29,74 +44,144 @@ CAFTFontCache& CAFTFontCache::getAFTFontCache()
 
 void CAFTFontCache::initDefaultFont()
 {
-	if (!m_FontDataVect.empty())
+	getFontData("", 18);
+}
+
+FontContext* CAFTFontCache::getFontContext()
+{
+	FontContext* pContext = (FontContext*)pthread_getspecific(m_tContextKey);
+	if (pContext == NULL)
+	{
+		pContext = new FontContext();
+		pContext->pCache = this;
+		pContext->pCurFontData = NULL;
+		pContext->pFontDatas = NULL;
+		pthread_setspecific(m_tContextKey, pContext);
+
+		pthread_mutex_lock(&m_tFontContextsMutex);
+		m_vFontContexts.push_back(pContext);
+		pthread_mutex_unlock(&m_tFontContextsMutex);
+	}
+	return pContext;
+}
+
+void CAFTFontCache::destroyFontContext(void* pContext)
+{
+	FontContext* c = (FontContext*)pContext;
+	if (c == NULL)
 		return;
 
-	setCurrentFontData("", 18);
+	if (c->pCache->unregisterFontContext(c))
+	{
+		finiFontContext(c);
+	}
 }
 
-void CAFTFontCache::destroyAllFontData()
+bool CAFTFontCache::unregisterFontContext(FontContext* pContext)
+{
+	pthread_mutex_lock(&m_tFontContextsMutex);
+	std::vector<FontContext*>::iterator itr = std::find(m_vFontContexts.begin(), m_vFontContexts.end(), pContext);
+	bool bRegistered = itr != m_vFontContexts.end();
+	if (bRegistered)
+	{
+		m_vFontContexts.erase(itr);
+	}
+	pthread_mutex_unlock(&m_tFontContextsMutex);
+	return bRegistered;
+}
+
+void CAFTFontCache::finiFontContext(FontContext* c)
 {
-	for (int i = 0; i < m_FontDataVect.size(); i++)
+	FontDataTable *t = NULL, *tmp = NULL;
+	HASH_ITER(hh, c->pFontDatas, t, tmp)
 	{
-		FontDataTable* t = m_FontDataVect[i];
+		HASH_DEL(c->pFontDatas, t);
 		t->ftFont.finiFreeTypeFont();
 		delete t;
 	}
-	m_FontDataVect.clear();
+
+	// the sizes are gone, the faces can be released
+	for (FTFaceMap::iterator itr = c->faces.begin(); itr != c->faces.end(); itr++)
+	{
+		CAFreeTypeFont::doneFace(itr->second);
+	}
+	c->faces.clear();
+
+	c->tempFont.finiTempTypeFont();
+	delete c;
+}
+
+void CAFTFontCache::destroyAllFontData()
+{
+	FontContext* pContext = (FontContext*)pthread_getspecific(m_tContextKey);
+	pthread_setspecific(m_tContextKey, NULL);
+	destroyFontContext(pContext);
 }
 
 
-void CAFTFontCache::setCurrentFontData(const char* pFontName, int nSize)
+FontDataTable* CAFTFontCache::getFontData(const char* pFontName, int nSize)
 {
 	CCAssert(pFontName != NULL, "");
-	if (m_pCurFontData)
+	FontContext* pContext = getFontContext();
+
+	FontDataTable* pCurFontData = pContext->pCurFontData;
+	if (pCurFontData)
 	{
-		if (m_pCurFontData->szFontName == pFontName && m_pCurFontData->iFontSize == nSize)
-			return;
+		if (pCurFontData->iFontSize == nSize && pCurFontData->szFontName == pFontName)
+			return pCurFontData;
 	}
 
-	for (int i = 0; i < m_FontDataVect.size(); i++)
+	char szSize[16];
+	sprintf(szSize, "#%d", nSize);
+	std::string szKey(pFontName);
+	szKey += szSize;
+
+	FontDataTable* fData = NULL;
+	HASH_FIND(hh, pContext->pFontDatas, szKey.c_str(), szKey.size(), fData);
+	if (fData == NULL)
+	{
+		fData = new FontDataTable();
+		fData->szKey = szKey;
+		fData->szFontName = pFontName;
+		fData->iFontSize = nSize;
+		fData->ftFont.m_pTempFont = &pContext->tempFont;
+		fData->ftFont.initFreeTypeFont(pFontName, nSize, &pContext->faces);
+		fData->iFontHeight = fData->ftFont.getFontHeight();
+		HASH_ADD_KEYPTR(hh, pContext->pFontDatas, fData->szKey.c_str(), fData->szKey.size(), fData);
+	}
+	else
 	{
-		FontDataTable* v = m_FontDataVect[i];
-		if (v->szFontName == pFontName && v->iFontSize == nSize)
-		{
-			m_pCurFontData = v;
-			return;
-		}
+		// the other sizes of the face may have been used since
+		fData->ftFont.activateSize();
 	}
 
-	FontDataTable* fData = new FontDataTable();
-	fData->szFontName = pFontName;
-	fData->iFontSize = nSize;
-	fData->ftFont.initFreeTypeFont(pFontName, nSize);
-	fData->iFontHeight = fData->ftFont.getFontHeight();
-	m_FontDataVect.push_back(fData);
-	m_pCurFontData = m_FontDataVect.back();
+	pContext->pCurFontData = fData;
+	return fData;
 }
 
 int CAFTFontCache::getFontHeight(const char* pFontName, unsigned long nSize)
 {
-	setCurrentFontData(pFontName, nSize);
-	return m_pCurFontData->iFontHeight;
+	return getFontData(pFontName, nSize)->iFontHeight;
 }
 
 int CAFTFontCache::getStringWidth(const char* pFontName, unsigned long nSize, const std::string& text, bool bBold, bool bItalics)
 {
-	setCurrentFontData(pFontName, nSize);
-	return m_pCurFontData->ftFont.getStringWidth(text, bBold, bItalics);
+	return getFontData(pFontName, nSize)->ftFont.getStringWidth(text, bBold, bItalics);
+}
+
+void CAFTFontCache::measureStrings(const char* pFontName, unsigned long nSize, const std::vector<std::string>& texts, std::vector<int>& widths, bool bBold, bool bItalics)
+{
+	getFontData(pFontName, nSize)->ftFont.measureStrings(texts, widths, bBold, bItalics);
 }
 
 int CAFTFontCache::cutStringByWidth(const char* pFontName, unsigned long nSize, const std::string& text, int iLimitWidth, int& cutWidth, bool bBold, bool bItalics)
 {
-	setCurrentFontData(pFontName, nSize);
-	return m_pCurFontData->ftFont.cutStringByWidth(text, iLimitWidth, cutWidth);
+	return getFontData(pFontName, nSize)->ftFont.cutStringByWidth(text, iLimitWidth, cutWidth);
 }
 
 int CAFTFontCache::getStringHeight(const char* pFontName, unsigned long nSize, const std::string& text, int iLimitWidth, int iLineSpace, bool bWordWrap)
 {
-	setCurrentFontData(pFontName, nSize);
-	return m_pCurFontData->ftFont.getStringHeight(text, iLimitWidth, iLineSpace, bWordWrap);
+	return getFontData(pFontName, nSize)->ftFont.getStringHeight(text, iLimitWidth, iLineSpace, bWordWrap);
 }
 
 CAImage* CAFTFontCache::initWithString(const char* pText, const char* pFontName, int nSize, int width, int height, 
@@ -105,18 +190,36 @@ CAImage* CAFTFontCache::initWithString(const char* pText, const char* pFontName,
 	if (pText == NULL || pFontName == NULL)
 		return NULL;
 
-	setCurrentFontData(pFontName, nSize);
-	CAImage* pImage = m_pCurFontData->ftFont.initWithString(pText, pFontName, nSize, width, height, hAlignment, vAlignment, bWordWrap, iLineSpacing, bBold, bItalics, bUnderLine);
+	CAImage* pImage = getFontData(pFontName, nSize)->ftFont.initWithString(pText, pFontName, nSize, width, height, hAlignment, vAlignment, bWordWrap, iLineSpacing, bBold, bItalics, bUnderLine);
 	return pImage;
 }
 
+unsigned char* CAFTFontCache::initWithStringBitmap(const char* pText, const char* pFontName, int nSize, int width, int height,
+	CATextAlignment hAlignment, CAVerticalTextAlignment vAlignment, bool bWordWrap, int iLineSpacing, bool bBold, bool bItalics, bool bUnderLine,
+	int* outWidth, int* outHeight)
+{
+	if (pText == NULL || pFontName == NULL)
+		return NULL;
+
+	return getFontData(pFontName, nSize)->ftFont.initWithStringBitmap(pText, pFontName, nSize, width, height, hAlignment, vAlignment, bWordWrap, iLineSpacing, bBold, bItalics, bUnderLine, outWidth, outHeight);
+}
+
+bool CAFTFontCache::initWithStringGlyphs(const char* pText, const char* pFontName, int nSize, int width, int height,
+	CATextAlignment hAlignment, CAVerticalTextAlignment vAlignment, bool bWordWrap, int iLineSpacing, bool bBold, bool bItalics, bool bUnderLine,
+	std::vector<CATextGlyph>& glyphs, int* outWidth, int* outHeight)
+{
+	if (pText == NULL || pFontName == NULL)
+		return false;
+
+	return getFontData(pFontName, nSize)->ftFont.initWithStringGlyphs(pText, pFontName, nSize, width, height, hAlignment, vAlignment, bWordWrap, iLineSpacing, bBold, bItalics, bUnderLine, glyphs, outWidth, outHeight);
+}
+
 CAImage* CAFTFontCache::initWithStringEx(const char* pText, const char* pFontName, int nSize, int width, int height, std::vector<TextViewLineInfo>& linesText, int iLineSpace, bool bWordWrap)
 {
 	if (pText == NULL || pFontName == NULL)
 		return NULL;
 
-	setCurrentFontData(pFontName, nSize);
-	CAImage* pImage = m_pCurFontData->ftFont.initWithStringEx(pText, pFontName, nSize, width, height, linesText, iLineSpace, bWordWrap);
+	CAImage* pImage = getFontData(pFontName, nSize)->ftFont.initWithStringEx(pText, pFontName, nSize, width, height, linesText, iLineSpace, bWordWrap);
 	return pImage;
 }
 
@@ -11,19 +11,44 @@
 
 
 #include "platform/CAFreeTypeFont.h"
+#include "platform/CATempTypeFont.h"
+#include "support/data_support/uthash.h"
+#include <pthread.h>
+#include <vector>
 
 NS_CC_BEGIN
 
 
 typedef struct FontDataTable
 {
+	std::string szKey;          // name and size of the font, key of the hash table
 	std::string szFontName;
 	int iFontSize;
 	int iFontHeight;
 	CAFreeTypeFont ftFont;
+	UT_hash_handle hh;
 } FontDataTable;
 
+/** the fonts of a thread. A FreeType face can't be used by several threads at once,
+ so every thread measures and renders its text with its own faces.
+ */
+class CAFTFontCache;
 
+typedef struct FontContext
+{
+	CAFTFontCache* pCache;      // the cache the context is registered in
+	FontDataTable* pCurFontData;
+	FontDataTable* pFontDatas;  // hash table of the fonts by name and size
+	FTFaceMap faces;            // a face per font file, shared by its sizes
+	CATempTypeFont tempFont;
+} FontContext;
+
+
+/** CAFTFontCache
+ The fonts are kept per thread: the measuring functions and initWithStringBitmap can be called
+ from any thread. The functions returning images or glyphs of the glyph atlas create textures,
+ they have to be called from the GL thread.
+ */
 class CC_DLL CAFTFontCache
 {
 public:
@@ -36,6 +61,8 @@ public:
 
 	int getStringWidth(const char* pFontName, unsigned long nSize, const std::string& text, bool bBold = false, bool bItalics = false);
 
+	void measureStrings(const char* pFontName, unsigned long nSize, const std::vector<std::string>& texts, std::vector<int>& widths, bool bBold = false, bool bItalics = false);
+
 	int cutStringByWidth(const char* pFontName, unsigned long nSize, const std::string& text, int iLimitWidth, int& cutWidth, bool bBold = false, bool bItalics = false);
 
 	int getStringHeight(const char* pFontName, unsigned long nSize, const std::string& text, int iLimitWidth, int iLineSpace, bool bWordWrap);
@@ -43,21 +70,44 @@ public:
 	CAImage* initWithString(const char* pText, const char* pFontName, int nSize, int width, int height,
 		CATextAlignment hAlignment, CAVerticalTextAlignment vAlignment, bool bWordWrap = true, int iLineSpacing = 0, bool bBold = false, bool bItalics = false, bool bUnderLine = false);
 
+	/** renders the text in an A8 bitmap the caller deletes with delete[] */
+	unsigned char* initWithStringBitmap(const char* pText, const char* pFontName, int nSize, int width, int height,
+		CATextAlignment hAlignment, CAVerticalTextAlignment vAlignment, bool bWordWrap, int iLineSpacing, bool bBold, bool bItalics, bool bUnderLine,
+		int* outWidth, int* outHeight);
+
+	bool initWithStringGlyphs(const char* pText, const char* pFontName, int nSize, int width, int height,
+		CATextAlignment hAlignment, CAVerticalTextAlignment vAlignment, bool bWordWrap, int iLineSpacing, bool bBold, bool bItalics, bool bUnderLine,
+		std::vector<CATextGlyph>& glyphs, int* outWidth, int* outHeight);
+
 	CAImage* initWithStringEx(const char* pText, const char* pFontName, int nSize, int inWidth, int inHeight, 
 		std::vector<TextViewLineInfo>& linesText, int iLineSpace=0, bool bWordWrap = true);
 
+	/** destroys the fonts of the calling thread */
     void destroyAllFontData();
 
 protected:
 	void initDefaultFont();
 
+	FontContext* getFontContext();
 
-	void setCurrentFontData(const char* pFontName, int nSize);
+	/** called when a thread exits, unregisters and destroys its context */
+	static void destroyFontContext(void* pContext);
+
+	/** removes the context from the registered ones, returns false if it isn't registered anymore */
+	bool unregisterFontContext(FontContext* pContext);
+
+	static void finiFontContext(FontContext* pContext);
+
+	/** returns the font of the calling thread, ready to be used */
+	FontDataTable* getFontData(const char* pFontName, int nSize);
 
 private:
-	FontDataTable* m_pCurFontData;
+	pthread_key_t m_tContextKey;
+
+	// the contexts of all the threads, they are destroyed with the cache
+	std::vector<FontContext*> m_vFontContexts;
 
-	std::vector<FontDataTable*> m_FontDataVect;
+	pthread_mutex_t m_tFontContextsMutex;
 };
 
 
@@ -3,6 +3,7 @@
 #include "platform/CCFileUtils.h"
 #include "support/ccUTF8.h"
 #include "CATempTypeFont.h"
+#include <pthread.h>
 
 
 using namespace std;
@@ -11,7 +12,9 @@ NS_CC_BEGIN
 
 static map<std::string, FontBufferInfo> s_fontsNames;
 static FT_Library s_FreeTypeLibrary = NULL;
-static CATempTypeFont s_TempFont;
+
+// the font buffers and the library are shared by the threads, the faces are not
+static pthread_mutex_t s_FreeTypeMutex = PTHREAD_MUTEX_INITIALIZER;
 
 #define ITALIC_LEAN_VALUE (0.3f)
 
@@ -19,6 +22,8 @@ CAFreeTypeFont::CAFreeTypeFont()
 :m_space(" ")
 ,m_currentLine(NULL)
 ,m_face(NULL)
+,m_size(NULL)
+,m_pTempFont(NULL)
 ,m_inWidth(0)
 ,m_inHeight(0)
 ,m_width(0)
@@ -46,27 +51,85 @@ CAFreeTypeFont::~CAFreeTypeFont()
 
 void CAFreeTypeFont::destroyAllFontBuff()
 {
+	pthread_mutex_lock(&s_FreeTypeMutex);
 	map<std::string, FontBufferInfo>::iterator it = s_fontsNames.begin();
 	for (; it != s_fontsNames.end(); it++)
 	{
 		delete[]it->second.pBuffer;
 	}
 	s_fontsNames.clear();
+	pthread_mutex_unlock(&s_FreeTypeMutex);
 }
 
 
 CAImage* CAFreeTypeFont::initWithString(const char* pText, const char* pFontName, int nSize, int inWidth, int inHeight, 
 	CATextAlignment hAlignment, CAVerticalTextAlignment vAlignment, bool bWordWrap, int iLineSpacing, bool bBold, bool bItalics, bool bUnderLine)
+{
+	int width = 0, height = 0;
+	unsigned char* pData = initWithStringBitmap(pText, pFontName, nSize, inWidth, inHeight, hAlignment, vAlignment, bWordWrap, iLineSpacing, bBold, bItalics, bUnderLine, &width, &height);
+	if (pData == NULL)
+	{
+		return NULL;
+	}
+
+	CAImage* pCAImage = new CAImage();
+	if (!pCAImage->initWithData(pData, kCAImagePixelFormat_A8, width, height, CCSize(width, height)))
+	{
+		delete[]pData;
+		delete pCAImage;
+		return NULL;
+	}
+	delete[]pData;
+    pCAImage->autorelease();
+	return pCAImage;
+}
+
+unsigned char* CAFreeTypeFont::initWithStringBitmap(const char* pText, const char* pFontName, int nSize, int inWidth, int inHeight,
+	CATextAlignment hAlignment, CAVerticalTextAlignment vAlignment, bool bWordWrap, int iLineSpacing, bool bBold, bool bItalics, bool bUnderLine,
+	int* outWidth, int* outHeight)
 {
 	if (pText == NULL || pFontName == NULL)
 		return NULL;
 
+	CCImage::ETextAlign eAlign;
+	if (!initLines(pText, nSize, inWidth, inHeight, hAlignment, vAlignment, bWordWrap, iLineSpacing, bBold, bItalics, bUnderLine, eAlign))
+	{
+		return NULL;
+	}
+
+	unsigned char* pData = getBitmap(eAlign, outWidth, outHeight);
+	resetStyle();
+	return pData;
+}
+
+bool CAFreeTypeFont::initWithStringGlyphs(const char* pText, const char* pFontName, int nSize, int inWidth, int inHeight,
+	CATextAlignment hAlignment, CAVerticalTextAlignment vAlignment, bool bWordWrap, int iLineSpacing, bool bBold, bool bItalics, bool bUnderLine,
+	std::vector<CATextGlyph>& glyphs, int* outWidth, int* outHeight)
+{
+	if (pText == NULL || pFontName == NULL)
+		return false;
+
+	CCImage::ETextAlign eAlign;
+	if (!initLines(pText, nSize, inWidth, inHeight, hAlignment, vAlignment, bWordWrap, iLineSpacing, bBold, bItalics, bUnderLine, eAlign))
+	{
+		return false;
+	}
+
+	bool bRet = getGlyphs(eAlign, glyphs, outWidth, outHeight);
+	resetStyle();
+	return bRet;
+}
+
+bool CAFreeTypeFont::initLines(const char* pText, int nSize, int inWidth, int inHeight,
+	CATextAlignment hAlignment, CAVerticalTextAlignment vAlignment, bool bWordWrap, int iLineSpacing, bool bBold, bool bItalics, bool bUnderLine,
+	CCImage::ETextAlign& eAlign)
+{
 	std::u16string cszTemp;
 	std::string cszNewText = pText;
 
-	if (m_bOpenTypeFont)
+	if (m_bOpenTypeFont && m_pTempFont)
 	{
-		s_TempFont.initTempTypeFont(nSize);
+		m_pTempFont->initTempTypeFont(nSize);
 	}
 _AgaginInitGlyphs:
 	m_inWidth = inWidth;
@@ -113,7 +176,6 @@ _AgaginInitGlyphs:
 		}
 	}
 
-	CCImage::ETextAlign eAlign;
 	if (CAVerticalTextAlignmentTop == vAlignment)
 	{
 		eAlign = (CATextAlignmentCenter == hAlignment) ? CCImage::kAlignTop
@@ -132,31 +194,19 @@ _AgaginInitGlyphs:
 	else
 	{
 		CCAssert(false, "Not supported alignment format!");
-		return NULL;
+		return false;
 	}
 
-	int width = 0, height = 0;
-	unsigned char* pData = getBitmap(eAlign, &width, &height);
-	if (pData == NULL)
-	{
-		return NULL;
-	}
+	return true;
+}
+
+void CAFreeTypeFont::resetStyle()
+{
 	m_lineSpacing = 0;
 	m_bWordWrap = false;
 	m_bBold = false;
 	m_bItalics = false;
 	m_bUnderLine = false;
-
-	CAImage* pCAImage = new CAImage();
-	if (!pCAImage->initWithData(pData, kCAImagePixelFormat_A8, width, height, CCSize(width, height)))
-	{
-		delete[]pData;
-		delete pCAImage;
-		return NULL;
-	}
-	delete[]pData;
-    pCAImage->autorelease();
-	return pCAImage;
 }
 
 CAImage* CAFreeTypeFont::initWithStringEx(const char* pText, const char* pFontName, int nSize, int inWidth, int inHeight, 
@@ -261,6 +311,95 @@ unsigned char* CAFreeTypeFont::getBitmap(CCImage::ETextAlign eAlignMask, int* ou
     return pBuffer;
 }
 
+bool CAFreeTypeFont::getGlyphs(CCImage::ETextAlign eAlignMask, std::vector<CATextGlyph>& glyphs, int* outWidth, int* outHeight)
+{
+	CAGlyphAtlas* pAtlas = CAGlyphAtlas::sharedGlyphAtlas();
+	unsigned int generation = pAtlas->getGeneration();
+	bool bRet = true;
+
+	int lineNumber = 0;
+	int totalLines = m_lines.size();
+
+	m_width = m_inWidth ? m_inWidth : m_textWidth;
+	m_height = m_inHeight ? m_inHeight : m_textHeight;
+
+	glyphs.clear();
+
+	std::vector<FTLineInfo*>::iterator line;
+	for (line = m_lines.begin(); line != m_lines.end(); ++line)
+	{
+		FT_Vector pen = getPenForAlignment(*line, eAlignMask, lineNumber, totalLines);
+
+		std::vector<TGlyph>& lineGlyphs = (*line)->glyphs;
+		for (std::vector<TGlyph>::iterator glyph = lineGlyphs.begin(); glyph != lineGlyphs.end(); ++glyph)
+		{
+			if (!glyph->isLoaded)
+				continue;
+
+			// the faces come and go with the threads, the buffers of the font files stay
+			FT_Face face = glyph->isOpenType ? getTempFace() : m_face;
+			CAGlyphKey key;
+			key.font = face->stream->base;
+			key.size = face->size->metrics.y_ppem;
+			key.index = glyph->index;
+			key.style = (m_bBold ? 1 : 0) | (m_bItalics ? 2 : 0);
+
+			const CAGlyphInfo* info = bRet ? pAtlas->glyphForKey(key) : NULL;
+			if (bRet && info == NULL)
+			{
+				// only the glyphs missing from the atlas are rendered
+				FT_Glyph image = loadGlyphImage(*glyph);
+				if (image && !FT_Glyph_To_Bitmap(&image, FT_RENDER_MODE_NORMAL, 0, 1))
+				{
+					FT_BitmapGlyph bit = (FT_BitmapGlyph)image;
+					info = pAtlas->addGlyph(key, bit->bitmap.buffer, bit->bitmap.width, bit->bitmap.rows, bit->bitmap.pitch, bit->left, bit->top);
+
+					// the glyphs placed before are gone if the atlas was emptied
+					bRet = (info != NULL && generation == pAtlas->getGeneration());
+				}
+
+				if (image)
+				{
+					FT_Done_Glyph(image);
+				}
+			}
+
+			if (!bRet || info == NULL || info->rect.size.width <= 0)
+				continue;
+
+			int dtValue = 0;
+#if (CC_TARGET_PLATFORM==CC_PLATFORM_MAC) || (CC_TARGET_PLATFORM==CC_PLATFORM_IOS)
+			dtValue = (glyph->c > 0x80) ? 0 : (m_lineHeight / 12);
+#endif
+			CATextGlyph g;
+			g.page = info->page;
+			g.imageRect = info->rect;
+			g.rect = CCRect(pen.x + glyph->pos.x + info->left, pen.y - info->top + dtValue, info->rect.size.width, info->rect.size.height);
+			glyphs.push_back(g);
+		}
+
+		if (bRet && m_bUnderLine && pAtlas->getPagesCount() > 0)
+		{
+			CATextGlyph g;
+			g.page = glyphs.empty() ? 0 : glyphs.back().page;
+			g.imageRect = pAtlas->getSolidRect();
+			g.rect = CCRect(pen.x, pen.y, (*line)->width + 1, 1);
+			glyphs.push_back(g);
+		}
+		lineNumber++;
+	}
+
+	if (!bRet)
+	{
+		glyphs.clear();
+	}
+
+	*outWidth = m_width;
+	*outHeight = m_height;
+
+	return bRet;
+}
+
 int CAFreeTypeFont::getFontHeight()
 {
 	if (m_face != NULL)
@@ -273,22 +412,34 @@ int CAFreeTypeFont::getFontHeight()
 // text encode with utf8
 int CAFreeTypeFont::getStringWidth(const std::string& text, bool bBold, bool bItalics)
 {
-	int iStrWidth = 0;
-	std::vector<TGlyph> glyphs;
-
-	FT_Vector vt;
-	memset(&vt, 0, sizeof(vt));
+	FT_Pos iStrWidth = 0;
 
 	m_bBold = bBold;
 	m_bItalics = bItalics;
-	if (0 == initWordGlyphs(glyphs, text, vt))
+	if (0 != measureString(text, iStrWidth))
 	{
-		iStrWidth = vt.x;
+		iStrWidth = 0;
 	}
 	m_bBold = false;
 	m_bItalics = false;
 	m_bUnderLine = false;
-	return iStrWidth;
+	return (int)iStrWidth;
+}
+
+void CAFreeTypeFont::measureStrings(const std::vector<std::string>& texts, std::vector<int>& widths, bool bBold, bool bItalics)
+{
+	m_bBold = bBold;
+	m_bItalics = bItalics;
+
+	widths.resize(texts.size());
+	for (size_t i = 0; i < texts.size(); i++)
+	{
+		FT_Pos width = 0;
+		widths[i] = (0 == measureString(texts[i], width)) ? (int)width : 0;
+	}
+
+	m_bBold = false;
+	m_bItalics = false;
 }
 
 int CAFreeTypeFont::cutStringByWidth(const std::string& text, int iLimitWidth, int& cutWidth)
@@ -302,7 +453,6 @@ int CAFreeTypeFont::cutStringByWidth(const std::string& text, int iLimitWidth, i
     
     FT_BBox bbox;
     FT_BBox glyph_bbox;
-    FT_GlyphSlot slot = m_face->glyph;
     
     /* initialize string bbox to "empty" values */
     bbox.xMin = 32000;
@@ -319,11 +469,11 @@ int CAFreeTypeFont::cutStringByWidth(const std::string& text, int iLimitWidth, i
     cutWidth = 0;
     for (std::vector<TGlyph>::iterator glyph = glyphs.begin(); glyph != glyphs.end(); ++glyph)
     {
-        FT_Glyph_Get_CBox(glyph->image, ft_glyph_bbox_pixels, &glyph_bbox);
+        glyph_bbox = glyph->bbox;
         
         if (glyph_bbox.xMin == glyph_bbox.xMax)
         {
-            glyph_bbox.xMax = glyph_bbox.xMin + (slot->advance.x >> 6);
+            glyph_bbox.xMax = glyph_bbox.xMin + glyph->advance;
         }
         glyph_bbox.xMin += glyph->pos.x;
         glyph_bbox.xMax += glyph->pos.x;
@@ -343,7 +493,7 @@ int CAFreeTypeFont::cutStringByWidth(const std::string& text, int iLimitWidth, i
             bbox.yMax = glyph_bbox.yMax;
         
         int width = bbox.xMax - bbox.xMin;
-        cutWidth = glyph->pos.x - bbox.xMin + (slot->advance.x >> 6);
+        cutWidth = glyph->pos.x - bbox.xMin + glyph->advance;
         if (width > iLimitWidth)
         {
             cutWidth = glyph->pos.x - bbox.xMin;
@@ -466,13 +616,19 @@ void  CAFreeTypeFont::drawText(FTLineInfo* pInfo, unsigned char* pBuffer, FT_Vec
 	std::vector<TGlyph>& glyphs = pInfo->glyphs;
 	for (std::vector<TGlyph>::iterator glyph = glyphs.begin(); glyph != glyphs.end(); ++glyph)
     {
-		if (glyph->index == 0)
-		{
-		//	continue;
-		}
-        FT_Glyph image = glyph->image;
+		if (!glyph->isLoaded)
+			continue;
+
+        FT_Glyph image = loadGlyphImage(*glyph);
+        if (image == NULL)
+            continue;
+
         FT_Error error = FT_Glyph_To_Bitmap(&image, FT_RENDER_MODE_NORMAL, 0, 1);
-        if (!error)
+        if (error)
+        {
+            FT_Done_Glyph(image);
+        }
+        else
         {
             FT_BitmapGlyph  bit = (FT_BitmapGlyph)image;
 
@@ -539,7 +695,6 @@ void CAFreeTypeFont::newLine()
 
 void CAFreeTypeFont::calcuMultiLines(std::vector<TGlyph>& glyphs)
 {
-	FT_GlyphSlot slot = m_face->glyph;
 	int maxWidth = m_inWidth ? m_inWidth : 0xFFFF;
 	
 	m_currentLine->bbox.xMin = 32000;
@@ -550,12 +705,11 @@ void CAFreeTypeFont::calcuMultiLines(std::vector<TGlyph>& glyphs)
 	int i = 0;
 	for (; i < glyphs.size(); i++)
 	{
-		FT_BBox glyph_bbox;
-		FT_Glyph_Get_CBox(glyphs[i].image, ft_glyph_bbox_pixels, &glyph_bbox);
+		FT_BBox glyph_bbox = glyphs[i].bbox;
         
 		if (glyph_bbox.xMin == glyph_bbox.xMax)
 		{
-			glyph_bbox.xMax = glyph_bbox.xMin + (slot->advance.x >> 6);
+			glyph_bbox.xMax = glyph_bbox.xMin + glyphs[i].advance;
 		}
 
 		glyph_bbox.xMin += glyphs[i].pos.x;
@@ -725,7 +879,6 @@ FT_Error CAFreeTypeFont::initGlyphsLine(const std::string& line)
 
 FT_Error CAFreeTypeFont::initWordGlyphs(std::vector<TGlyph>& glyphs, const std::string& text, FT_Vector& pen) 
 {
-	FT_UInt			glyph_index;
 	FT_UInt			previous = 0;
 	FT_Error		error = 0;
 	PGlyph			glyph;
@@ -742,75 +895,183 @@ FT_Error CAFreeTypeFont::initWordGlyphs(std::vector<TGlyph>& glyphs, const std::
 	{
 		FT_ULong c = utf16String[n];
 
-		/* convert character code to glyph index */
 		glyphs.resize(glyphs.size() + 1);
 		glyph = &glyphs[numGlyphs];
 
-		
-		glyph_index = FT_Get_Char_Index(m_face, c);
-		glyph->isOpenType = (glyph_index == 0);
-		if (glyph_index == 0)
-		{
-			glyph_index = FT_Get_Char_Index(s_TempFont.m_CurFontFace, c);
-		}
-
-		FT_Face curFace = glyph->isOpenType ? s_TempFont.m_CurFontFace : m_face;
-		FT_GlyphSlot slot = curFace->glyph;
+		/* the glyph index, control box and advance are looked up once per character */
+		const TGlyphMetrics& metrics = getGlyphMetrics(c);
 
- 		if (useKerning && previous && glyph_index)
+ 		if (useKerning && previous && metrics.index)
 		{
-			FT_Vector  delta;
-			FT_Get_Kerning(curFace, previous, glyph_index, FT_KERNING_DEFAULT, &delta);
-			pen.x += delta.x >> 6;
+			pen.x += getKerning(metrics.face, previous, metrics.index);
 		}
 
 		/* store current pen position */
 		glyph->pos = pen;
-		glyph->index = glyph_index;
+		glyph->index = metrics.index;
 		glyph->c = c;
+		glyph->isOpenType = (metrics.face != m_face);
+		glyph->advance = metrics.advance;
+		glyph->isLoaded = false;
+		memset(&glyph->bbox, 0, sizeof(glyph->bbox));
 
-
-		/* load glyph image into the slot without rendering */
-		error = FT_Load_Glyph(curFace, glyph_index, FT_LOAD_NO_HINTING | FT_LOAD_NO_BITMAP);
+		error = metrics.error;
 		if (error)
 			continue;  /* ignore errors, jump to next glyph */
 
-		if (m_bBold)
-		{
-			FT_Outline_Embolden(&slot->outline, 1 << 6);
-		}
-
 		if (c == 10)
 		{
 			continue;
 		}
 
-		/* extract glyph image and store it in our table */
-		error = FT_Get_Glyph(curFace->glyph, &glyph->image);
-		if (error)
-			continue;  /* ignore errors, jump to next glyph */
-
-		FT_Matrix* pFTMat = m_bItalics ? &m_ItalicMatrix : NULL;
-
-		 /* translate the glyph image now */
-		FT_Glyph_Transform(glyph->image, pFTMat, NULL);//&glyph->pos
+		glyph->bbox = metrics.bbox;
+		glyph->isLoaded = true;
 
 		/* increment pen position */
-		pen.x += slot->advance.x >> 6;
+		pen.x += metrics.advance;
 
-		if (pFTMat)
+		if (m_bItalics)
 		{
 			pen.x += m_lineHeight * tan(ITALIC_LEAN_VALUE * 0.15 * M_PI);
 		}
 
 		/* record current glyph index */
-		previous = glyph_index;
+		previous = metrics.index;
 
 		numGlyphs++;
 	}
 	return error;
 }
 
+FT_Error CAFreeTypeFont::measureString(const std::string& text, FT_Pos& width)
+{
+	FT_UInt			previous = 0;
+	FT_Error		error = 0;
+
+	std::u16string utf16String;
+	if (!StringUtils::UTF8ToUTF16(text, utf16String))
+		return -1;
+
+	FT_Bool useKerning = FT_HAS_KERNING(m_face);
+
+	// same pen moves as initWordGlyphs, without the glyphs
+	width = 0;
+	for (size_t n = 0; n < utf16String.size(); n++)
+	{
+		FT_ULong c = utf16String[n];
+		const TGlyphMetrics& metrics = getGlyphMetrics(c);
+
+		if (useKerning && previous && metrics.index)
+		{
+			width += getKerning(metrics.face, previous, metrics.index);
+		}
+
+		error = metrics.error;
+		if (error || c == 10)
+			continue;
+
+		width += metrics.advance;
+
+		if (m_bItalics)
+		{
+			width += m_lineHeight * tan(ITALIC_LEAN_VALUE * 0.15 * M_PI);
+		}
+
+		previous = metrics.index;
+	}
+	return error;
+}
+
+const TGlyphMetrics& CAFreeTypeFont::getGlyphMetrics(FT_ULong c)
+{
+	// UTF-16 code units, with the style in the low bits
+	unsigned long key = (c << 2) | (m_bBold ? 1 : 0) | (m_bItalics ? 2 : 0);
+
+	std::map<unsigned long, TGlyphMetrics>::iterator itr = m_mGlyphMetrics.find(key);
+	if (itr != m_mGlyphMetrics.end()
+		&& (itr->second.face == m_face || itr->second.face == getTempFace()))
+	{
+		return itr->second;
+	}
+
+	TGlyphMetrics& metrics = m_mGlyphMetrics[key];
+	memset(&metrics, 0, sizeof(metrics));
+
+	/* convert character code to glyph index */
+	metrics.face = m_face;
+	metrics.index = FT_Get_Char_Index(m_face, c);
+	if (metrics.index == 0)
+	{
+		metrics.face = getTempFace();
+		metrics.index = FT_Get_Char_Index(metrics.face, c);
+	}
+
+	/* load glyph image into the slot without rendering */
+	metrics.error = FT_Load_Glyph(metrics.face, metrics.index, FT_LOAD_NO_HINTING | FT_LOAD_NO_BITMAP);
+	if (metrics.error)
+		return metrics;
+
+	FT_GlyphSlot slot = metrics.face->glyph;
+	metrics.advance = slot->advance.x >> 6;
+
+	if (m_bBold)
+	{
+		FT_Outline_Embolden(&slot->outline, 1 << 6);
+	}
+
+	/* the control box of the transformed image, the image itself isn't kept */
+	FT_Glyph image = NULL;
+	metrics.error = FT_Get_Glyph(slot, &image);
+	if (metrics.error)
+		return metrics;
+
+	FT_Glyph_Transform(image, m_bItalics ? &m_ItalicMatrix : NULL, NULL);
+	FT_Glyph_Get_CBox(image, ft_glyph_bbox_pixels, &metrics.bbox);
+	FT_Done_Glyph(image);
+
+	return metrics;
+}
+
+FT_Pos CAFreeTypeFont::getKerning(FT_Face face, FT_UInt previous, FT_UInt index)
+{
+	FT_Vector  delta;
+	if (face != m_face)
+	{
+		FT_Get_Kerning(face, previous, index, FT_KERNING_DEFAULT, &delta);
+		return delta.x >> 6;
+	}
+
+	std::pair<FT_UInt, FT_UInt> key(previous, index);
+	std::map<std::pair<FT_UInt, FT_UInt>, FT_Pos>::iterator itr = m_mKernings.find(key);
+	if (itr != m_mKernings.end())
+	{
+		return itr->second;
+	}
+
+	FT_Get_Kerning(face, previous, index, FT_KERNING_DEFAULT, &delta);
+	return m_mKernings[key] = delta.x >> 6;
+}
+
+FT_Glyph CAFreeTypeFont::loadGlyphImage(const TGlyph& glyph)
+{
+	FT_Face curFace = glyph.isOpenType ? getTempFace() : m_face;
+
+	if (FT_Load_Glyph(curFace, glyph.index, FT_LOAD_NO_HINTING | FT_LOAD_NO_BITMAP))
+		return NULL;
+
+	if (m_bBold)
+	{
+		FT_Outline_Embolden(&curFace->glyph->outline, 1 << 6);
+	}
+
+	FT_Glyph image = NULL;
+	if (FT_Get_Glyph(curFace->glyph, &image))
+		return NULL;
+
+	FT_Glyph_Transform(image, m_bItalics ? &m_ItalicMatrix : NULL, NULL);
+	return image;
+}
+
 
 FT_Error CAFreeTypeFont::initTextView(const char* pText, std::vector<TextViewLineInfo>& linesText)
 {
@@ -882,7 +1143,6 @@ void  CAFreeTypeFont::compute_bbox(std::vector<TGlyph>& glyphs, FT_BBox  *abbox)
 {
     FT_BBox bbox;
     FT_BBox glyph_bbox;
-	FT_GlyphSlot slot = m_face->glyph;
 
     /* initialize string bbox to "empty" values */
     bbox.xMin = 32000;
@@ -896,11 +1156,11 @@ void  CAFreeTypeFont::compute_bbox(std::vector<TGlyph>& glyphs, FT_BBox  *abbox)
     /* translate it, and grow the string bbox          */
 	for (std::vector<TGlyph>::iterator glyph = glyphs.begin(); glyph != glyphs.end(); ++glyph)
     {
-        FT_Glyph_Get_CBox(glyph->image, ft_glyph_bbox_pixels, &glyph_bbox);
+        glyph_bbox = glyph->bbox;
 
 		if (glyph_bbox.xMin == glyph_bbox.xMax)
 		{
-			glyph_bbox.xMax = (glyph_bbox.xMin + slot->advance.x) >> 6;
+			glyph_bbox.xMax = glyph_bbox.xMin + glyph->advance;
 		}
         glyph_bbox.xMin += glyph->pos.x;
         glyph_bbox.xMax += glyph->pos.x;
@@ -935,13 +1195,11 @@ void  CAFreeTypeFont::compute_bbox(std::vector<TGlyph>& glyphs, FT_BBox  *abbox)
 
 void CAFreeTypeFont::compute_bbox2(TGlyph& glyph, FT_BBox& bbox)
 {
-	FT_BBox glyph_bbox;
-	FT_GlyphSlot slot = m_face->glyph;
-	FT_Glyph_Get_CBox(glyph.image, ft_glyph_bbox_pixels, &glyph_bbox);
+	FT_BBox glyph_bbox = glyph.bbox;
 
 	if (glyph_bbox.xMin == glyph_bbox.xMax)
 	{
-		glyph_bbox.xMax = (glyph_bbox.xMin + slot->advance.x) >> 6;
+		glyph_bbox.xMax = glyph_bbox.xMin + glyph.advance;
 	}
 	glyph_bbox.xMin += glyph.pos.x;
 	glyph_bbox.xMax += glyph.pos.x;
@@ -969,7 +1227,7 @@ void CAFreeTypeFont::compute_bbox2(TGlyph& glyph, FT_BBox& bbox)
 	}
 }
 
-bool CAFreeTypeFont::initFreeTypeFont(const char* pFontName, unsigned long nSize)
+bool CAFreeTypeFont::initFreeTypeFont(const char* pFontName, unsigned long nSize, FTFaceMap* pFaces)
 {
 	unsigned long size = 0; int face_index = 0;
 	unsigned char* pBuffer = loadFont(pFontName, &size, face_index);
@@ -977,38 +1235,103 @@ bool CAFreeTypeFont::initFreeTypeFont(const char* pFontName, unsigned long nSize
 		return false;
 	
 	FT_Error error = 0;
-	if (!s_FreeTypeLibrary)
+	if (pFaces)
 	{
-		error = FT_Init_FreeType(&s_FreeTypeLibrary);
-	}
+		FTFaceMap::iterator itr = pFaces->find(pBuffer);
+		if (itr == pFaces->end())
+		{
+			FT_Face face = newFace(pBuffer, size, face_index);
+			if (face == NULL)
+				return false;
 
-	if (!error && !m_face)
-	{
-		error = FT_New_Memory_Face(s_FreeTypeLibrary, pBuffer, size, face_index, &m_face);
-	}
+			itr = pFaces->insert(std::make_pair(pBuffer, face)).first;
+		}
 
-	if (!error)
+		// the outlines and the charmap are loaded once per file, each size only scales them
+		m_face = itr->second;
+		error = FT_New_Size(m_face, &m_size);
+		if (!error)
+			error = FT_Activate_Size(m_size);
+	}
+	else if (!m_face)
 	{
-		error = FT_Select_Charmap(m_face, FT_ENCODING_UNICODE);
+		m_face = newFace(pBuffer, size, face_index);
+		if (m_face == NULL)
+			return false;
 	}
 
 	if (!error)
 		error = FT_Set_Char_Size(m_face, nSize << 6, nSize << 6, 72, 72);
 
+	m_mGlyphMetrics.clear();
+	m_mKernings.clear();
+
 	return (error==0);
 }
 
 void CAFreeTypeFont::finiFreeTypeFont()
 {
-	if (m_face)
+	if (m_size)
 	{
-		FT_Done_Face(m_face);
+		// the face belongs to the map it was shared from
+		FT_Done_Size(m_size);
+	}
+	else if (m_face)
+	{
+		doneFace(m_face);
 	}
 	m_face = NULL;
+	m_size = NULL;
 
+	m_mGlyphMetrics.clear();
+	m_mKernings.clear();
 	destroyAllLines();
 }
 
+void CAFreeTypeFont::activateSize()
+{
+	if (m_size)
+	{
+		FT_Activate_Size(m_size);
+	}
+}
+
+FT_Face CAFreeTypeFont::getTempFace()
+{
+	return m_pTempFont ? m_pTempFont->m_CurFontFace : NULL;
+}
+
+FT_Face CAFreeTypeFont::newFace(unsigned char* pBuffer, unsigned long size, int face_index)
+{
+	FT_Face face = NULL;
+
+	pthread_mutex_lock(&s_FreeTypeMutex);
+	FT_Error error = 0;
+	if (!s_FreeTypeLibrary)
+	{
+		error = FT_Init_FreeType(&s_FreeTypeLibrary);
+	}
+
+	if (!error)
+	{
+		error = FT_New_Memory_Face(s_FreeTypeLibrary, pBuffer, size, face_index, &face);
+	}
+	pthread_mutex_unlock(&s_FreeTypeMutex);
+
+	if (!error)
+	{
+		FT_Select_Charmap(face, FT_ENCODING_UNICODE);
+	}
+	return error ? NULL : face;
+}
+
+void CAFreeTypeFont::doneFace(FT_Face face)
+{
+	pthread_mutex_lock(&s_FreeTypeMutex);
+	FT_Done_Face(face);
+	pthread_mutex_unlock(&s_FreeTypeMutex);
+}
+
 unsigned char* CAFreeTypeFont::loadFont(const char *pFontName, unsigned long *size, int& ttfIndex)
 {
 	std::string path;
@@ -1033,14 +1356,18 @@ unsigned char* CAFreeTypeFont::loadFont(const char *pFontName, unsigned long *si
         path += ".ttf";
     }
 
+	pthread_mutex_lock(&s_FreeTypeMutex);
 	std::map<std::string, FontBufferInfo>::iterator ittFontNames = s_fontsNames.find(path.c_str());
 	if (ittFontNames != s_fontsNames.end())
 	{
 		ttfIndex = ittFontNames->second.face_index;
 		*size = ittFontNames->second.size;
 		m_bOpenTypeFont = ittFontNames->second.isOpenTypeFont;
-		return ittFontNames->second.pBuffer;
+		unsigned char* pBuffer = ittFontNames->second.pBuffer;
+		pthread_mutex_unlock(&s_FreeTypeMutex);
+		return pBuffer;
 	}
+	pthread_mutex_unlock(&s_FreeTypeMutex);
 
 	ttfIndex = 0;
 
@@ -1092,8 +1419,20 @@ unsigned char* CAFreeTypeFont::loadFont(const char *pFontName, unsigned long *si
 	info.size = *size;
 	info.face_index = ttfIndex;
 	info.isOpenTypeFont = m_bOpenTypeFont;
-	s_fontsNames[path] = info;
-	return pBuffer;
+
+	pthread_mutex_lock(&s_FreeTypeMutex);
+	// another thread may have loaded the same file meanwhile, its buffer is kept
+	std::pair<std::map<std::string, FontBufferInfo>::iterator, bool> inserted = s_fontsNames.insert(std::make_pair(path, info));
+	if (!inserted.second)
+	{
+		delete[]pBuffer;
+		info = inserted.first->second;
+		ttfIndex = info.face_index;
+		*size = info.size;
+		m_bOpenTypeFont = info.isOpenTypeFont;
+	}
+	pthread_mutex_unlock(&s_FreeTypeMutex);
+	return info.pBuffer;
 }
 
 NS_CC_END
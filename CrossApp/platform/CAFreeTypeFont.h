@@ -12,6 +12,7 @@
 #include "platform/CCCommon.h"
 #include "platform/CCImage.h"
 #include "images/CAImage.h"
+#include "images/CAGlyphAtlas.h"
 #include <map>
 #include <string>
 #include <sstream>
@@ -22,9 +23,11 @@
 #include <freetype/ftglyph.h>
 #include <freetype/ftoutln.h>
 #include <freetype/fttrigon.h>
+#include <freetype/ftsizes.h>
 
 NS_CC_BEGIN
 
+class CATempTypeFont;
 
 typedef struct _TextAttribute
 {
@@ -45,11 +48,22 @@ typedef struct TGlyph_
 {
 	FT_UInt    index;  // glyph index
     FT_Vector  pos;    // glyph origin on the baseline
-	FT_Glyph   image;  // glyph image
+	FT_BBox    bbox;   // control box of the glyph image in pixels, relative to its origin
+	FT_Pos     advance;// advance width in pixels
 	FT_ULong   c;
 	FT_Bool	   isOpenType;
+	FT_Bool    isLoaded;// false for the line breaks and the glyphs FreeType failed to load
 } TGlyph, *PGlyph;
 
+typedef struct TGlyphMetrics_
+{
+	FT_UInt    index;
+	FT_Face    face;   // face the glyph was found in
+	FT_BBox    bbox;
+	FT_Pos     advance;
+	FT_Error   error;
+} TGlyphMetrics;
+
 typedef struct FontBufferInfo
 {
 	unsigned char*  pBuffer;  
@@ -58,6 +72,9 @@ typedef struct FontBufferInfo
 	bool isOpenTypeFont;
 } FontBufferInfo;
 
+// faces of the font files loaded by a thread, by font buffer
+typedef std::map<unsigned char*, FT_Face> FTFaceMap;
+
 typedef struct FTLineInfo
 {
 	std::vector<TGlyph> glyphs;     // glyphs for the line text
@@ -78,15 +95,45 @@ public:
 	CAImage* initWithString(const char* pText, const char* pFontName, int nSize, int inWidth, int inHeight,
 		CATextAlignment hAlignment, CAVerticalTextAlignment vAlignment, bool bWordWrap = true, int iLineSpacing = 0, bool bBold = false, bool bItalics = false, bool bUnderLine = false);
 
+	/** lays the text out like initWithString, but returns the glyphs placed in the text box instead
+	 of a bitmap. The glyphs are rendered in the shared glyph atlas when it doesn't have them yet.
+	 Returns false if they couldn't all be put in the atlas.
+	 */
+	bool initWithStringGlyphs(const char* pText, const char* pFontName, int nSize, int inWidth, int inHeight,
+		CATextAlignment hAlignment, CAVerticalTextAlignment vAlignment, bool bWordWrap, int iLineSpacing, bool bBold, bool bItalics, bool bUnderLine,
+		std::vector<CATextGlyph>& glyphs, int* outWidth, int* outHeight);
+
+	/** renders the text like initWithString, but returns the A8 bitmap instead of an image.
+	 The caller deletes it with delete[].
+	 */
+	unsigned char* initWithStringBitmap(const char* pText, const char* pFontName, int nSize, int inWidth, int inHeight,
+		CATextAlignment hAlignment, CAVerticalTextAlignment vAlignment, bool bWordWrap, int iLineSpacing, bool bBold, bool bItalics, bool bUnderLine,
+		int* outWidth, int* outHeight);
+
 	CAImage* initWithStringEx(const char* pText, const char* pFontName, int nSize, int inWidth, int inHeight, 
 		std::vector<TextViewLineInfo>& linesText, int iLineSpace = 0, bool bWordWrap = true);
 
+	/** widths of several strings measured with the same font, without laying them out */
+	void measureStrings(const std::vector<std::string>& texts, std::vector<int>& widths, bool bBold = false, bool bItalics = false);
+
 	static void destroyAllFontBuff();
 protected:
-	bool initFreeTypeFont(const char* pFontName, unsigned long nSize);
+	/** the face of the font file is taken from pFaces, or added to it, when it is given:
+	 the fonts of a file then only own a size object of the face
+	 */
+	bool initFreeTypeFont(const char* pFontName, unsigned long nSize, FTFaceMap* pFaces = NULL);
 	void finiFreeTypeFont();
+	void activateSize();
+	FT_Face getTempFace();
+	static FT_Face newFace(unsigned char* pBuffer, unsigned long size, int face_index);
+	static void doneFace(FT_Face face);
 	unsigned char* loadFont(const char *pFontName, unsigned long *size, int& ttfIndex);
+	bool initLines(const char* pText, int nSize, int inWidth, int inHeight,
+		CATextAlignment hAlignment, CAVerticalTextAlignment vAlignment, bool bWordWrap, int iLineSpacing, bool bBold, bool bItalics, bool bUnderLine,
+		CCImage::ETextAlign& eAlign);
+	void resetStyle();
 	unsigned char* getBitmap(CCImage::ETextAlign eAlignMask, int* outWidth, int* outHeight);
+	bool getGlyphs(CCImage::ETextAlign eAlignMask, std::vector<CATextGlyph>& glyphs, int* outWidth, int* outHeight);
 	int getFontHeight();
 	int getStringWidth(const std::string& text, bool bBold = false, bool bItalics = false);
     int cutStringByWidth(const std::string& text, int iLimitWidth, int& cutWidth);
@@ -96,6 +143,10 @@ protected:
 	FT_Error initGlyphs(const char* text);
 	FT_Error initGlyphsLine(const std::string& line);
 	FT_Error initWordGlyphs(std::vector<TGlyph>& glyphs, const std::string& text, FT_Vector& pen);
+	FT_Error measureString(const std::string& text, FT_Pos& width);
+	const TGlyphMetrics& getGlyphMetrics(FT_ULong c);
+	FT_Pos getKerning(FT_Face face, FT_UInt previous, FT_UInt index);
+	FT_Glyph loadGlyphImage(const TGlyph& glyph);
 	FT_Error initTextView(const char* pText, std::vector<TextViewLineInfo>& linesText);
 	
 	void compute_bbox(std::vector<TGlyph>& glyphs, FT_BBox  *abbox);
@@ -116,6 +167,8 @@ protected:
 
     const std::string m_space;
 	FT_Face			m_face;
+	FT_Size			m_size;         // size object of the shared face, NULL if the face is owned
+	CATempTypeFont*	m_pTempFont;    // fallback font of the thread
 	std::vector<FTLineInfo*> m_lines;
 	FT_Matrix		m_ItalicMatrix;
 
@@ -135,6 +188,12 @@ protected:
 	bool m_bItalics;
 	bool m_bUnderLine;
 	bool m_bOpenTypeFont;
+
+	// advances and control boxes of the glyphs already measured, by character and style
+	std::map<unsigned long, TGlyphMetrics> m_mGlyphMetrics;
+
+	// kerning of the glyph pairs already measured
+	std::map<std::pair<FT_UInt, FT_UInt>, FT_Pos> m_mKernings;
 };
 
 NS_CC_END
@@ -21,30 +21,50 @@ CATempTypeFont::~CATempTypeFont()
 
 void CATempTypeFont::initTempTypeFont(unsigned long nSize)
 {
-	std::map<unsigned long, FT_Face>::iterator it=m_mTempFontMap.find(nSize);
-	if (it != m_mTempFontMap.end())
+	std::map<unsigned long, FT_Size>::iterator it = m_mTempSizeMap.find(nSize);
+	if (it != m_mTempSizeMap.end())
 	{
-		m_CurFontFace = it->second;
+		FT_Activate_Size(it->second);
+		return;
 	}
-	else
+
+	if (m_CurFontFace == NULL)
 	{
 		m_face = NULL;
 		initFreeTypeFont("arial", nSize);
 		m_CurFontFace = m_face;
-		m_mTempFontMap[nSize] = m_CurFontFace;
+		m_face = NULL;
+
+		if (m_CurFontFace)
+		{
+			m_mTempSizeMap[nSize] = m_CurFontFace->size;
+		}
+		return;
+	}
+
+	// the other sizes are size objects of the same face
+	FT_Size size = NULL;
+	if (FT_New_Size(m_CurFontFace, &size) == 0)
+	{
+		if (FT_Activate_Size(size) == 0 && FT_Set_Char_Size(m_CurFontFace, nSize << 6, nSize << 6, 72, 72) == 0)
+		{
+			m_mTempSizeMap[nSize] = size;
+		}
+		else
+		{
+			FT_Done_Size(size);
+		}
 	}
-	m_face = NULL;
 }
 
 void CATempTypeFont::finiTempTypeFont()
 {
-	std::map<unsigned long, FT_Face>::iterator it = m_mTempFontMap.begin();
-	while (it != m_mTempFontMap.end())
+	m_mTempSizeMap.clear();
+	if (m_CurFontFace)
 	{
-		FT_Done_Face(it->second);
-		it++;
+		doneFace(m_CurFontFace);
 	}
-	m_mTempFontMap.clear();
+	m_CurFontFace = NULL;
 }
 
 NS_CC_END
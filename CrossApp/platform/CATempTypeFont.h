@@ -26,7 +26,7 @@ public:
 
 	FT_Face m_CurFontFace;
 private:
-	std::map<unsigned long, FT_Face> m_mTempFontMap;
+	std::map<unsigned long, FT_Size> m_mTempSizeMap;
 };
 
 NS_CC_END
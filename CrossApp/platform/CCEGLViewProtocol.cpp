@@ -180,6 +180,11 @@ CCRect CCEGLViewProtocol::getScissorRect()
 	return CCRectMake(x, y, w, h);
 }
 
+bool CCEGLViewProtocol::isRetainedBacking()
+{
+    return false;
+}
+
 void CCEGLViewProtocol::setViewName(const char* pszViewName)
 {
     if (pszViewName != NULL && strlen(pszViewName) > 0)
@@ -134,6 +134,12 @@ public:
      * @lua NA
      */
     virtual CCRect getScissorRect();
+
+    /**
+     * Whether the content of the back buffer is preserved after swapping the buffers,
+     * so that only the changed rects of the screen need to be redrawn.
+     */
+    virtual bool isRetainedBacking();
     /**
      * @lua NA
      */
@@ -11,12 +11,11 @@
 #include <stdlib.h>
 #include <android/log.h>
 
-
+// <EGL/egl.h> exists since android 2.3
+#include <EGL/egl.h>
 
 #if CC_TEXTURE_ATLAS_USE_VAO
 
-// <EGL/egl.h> exists since android 2.3
-#include <EGL/egl.h>
 PFNGLGENVERTEXARRAYSOESPROC glGenVertexArraysOESEXT = 0;
 PFNGLBINDVERTEXARRAYOESPROC glBindVertexArrayOESEXT = 0;
 PFNGLDELETEVERTEXARRAYSOESPROC glDeleteVertexArraysOESEXT = 0;
@@ -34,6 +33,8 @@ void initExtensions() {
 NS_CC_BEGIN
 
 CCEGLView::CCEGLView()
+: m_pRetainedSurface(NULL)
+, m_bRetainedBacking(false)
 {
     initExtensions();
 }
@@ -101,5 +102,24 @@ void CCEGLView::setIMECursorPos(int pos)
 {
     setCursorPos(pos);
 }
+
+bool CCEGLView::isRetainedBacking()
+{
+    EGLSurface surface = eglGetCurrentSurface(EGL_DRAW);
+    if (surface != (EGLSurface)m_pRetainedSurface)
+    {
+        // a new surface has undefined content, it is drawn entirely first
+        m_pRetainedSurface = (void*)surface;
+        m_bRetainedBacking = false;
+        
+        if (surface != EGL_NO_SURFACE)
+        {
+            // fails if the config of the surface has no EGL_SWAP_BEHAVIOR_PRESERVED_BIT
+            m_bRetainedBacking = eglSurfaceAttrib(eglGetCurrentDisplay(), surface, EGL_SWAP_BEHAVIOR, EGL_BUFFER_PRESERVED) == EGL_TRUE;
+        }
+        return false;
+    }
+    return m_bRetainedBacking;
+}
 NS_CC_END
 
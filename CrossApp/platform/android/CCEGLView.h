@@ -34,11 +34,21 @@ public:
     virtual void setIMEKeyboardReturnDone();
 
     void setIMECursorPos(int pos);
+    
+    /** asks EGL to preserve the back buffer of the current surface, once per surface */
+    virtual bool isRetainedBacking();
+    
     // static function
     /**
     @brief    get the shared main open gl window
     */
     static CCEGLView* sharedOpenGLView();
+    
+protected:
+    
+    void* m_pRetainedSurface;
+    
+    bool m_bRetainedBacking;
 };
 
 NS_CC_END
@@ -8,7 +8,8 @@
 #include <unistd.h>
 #include <sys/time.h>
 #include <string>
-#include "CCDirector.h"
+#include "basics/CAApplication.h"
+#include "CCEGLView.h"
 #include "platform/CCFileUtils.h"
 
 NS_CC_BEGIN
@@ -48,14 +49,20 @@ int CCApplication::run()
 	}
 
 
+	CAApplication* pApplication = CAApplication::getApplication();
 	for (;;) {
 		long iLastTime = getCurrentMillSecond();
-		CCDirector::sharedDirector()->mainLoop();
+		pApplication->mainLoop();
 		long iCurTime = getCurrentMillSecond();
 		if (iCurTime-iLastTime<m_nAnimationInterval){
 			usleep((m_nAnimationInterval - iCurTime+iLastTime)*1000);
 		}
 
+		// nothing to draw or to animate: instead of the next frame, wait for an event or for the next timer
+		float fIdleInterval = pApplication->getIdleInterval();
+		if (fIdleInterval != 0) {
+			CCEGLView::sharedOpenGLView()->waitEvents(fIdleInterval);
+		}
 	}
 	return -1;
 }
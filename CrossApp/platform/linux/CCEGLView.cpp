@@ -9,7 +9,7 @@
 #include "CCGL.h"
 #include "GL/glfw.h"
 #include "ccMacros.h"
-#include "CCDirector.h"
+#include "basics/CAApplication.h"
 #include "touch_dispatcher/CCTouch.h"
 #include "touch_dispatcher/CATouchDispatcher.h"
 #include "text_input_node/CCIMEDispatcher.h"
@@ -27,6 +27,12 @@ PFNGLBUFFERDATAARBPROC glBufferDataARB = NULL;
 PFNGLBUFFERSUBDATAARBPROC glBufferSubDataARB = NULL;
 PFNGLDELETEBUFFERSARBPROC glDeleteBuffersARB = NULL;
 
+// GLFW can't wait for an event with a timeout, the events are polled this often until then
+#define kCCEGLViewEventPollInterval (1.0 / 60.0)
+
+// set by the handlers, to stop waiting for the events
+static bool s_bEventReceived = false;
+
 bool initExtensions() {
 #define LOAD_EXTENSION_FUNCTION(TYPE, FN)  FN = (TYPE)glfwGetProcAddress(#FN);
 	bool bRet = false;
@@ -86,6 +92,7 @@ CCEGLView::~CCEGLView()
 }
 
 void keyEventHandle(int iKeyID,int iKeyState) {
+	s_bEventReceived = true;
 	if (iKeyState ==GLFW_RELEASE) {
 		return;
 	}
@@ -100,6 +107,7 @@ void keyEventHandle(int iKeyID,int iKeyState) {
 }
 
 void charEventHandle(int iCharID,int iCharState) {
+	s_bEventReceived = true;
 	if (iCharState ==GLFW_RELEASE) {
 		return;
 	}
@@ -109,6 +117,7 @@ void charEventHandle(int iCharID,int iCharState) {
 }
 
 void mouseButtonEventHandle(int iMouseID,int iMouseState) {
+	s_bEventReceived = true;
 	if (iMouseID == GLFW_MOUSE_BUTTON_LEFT) {
         CCEGLView* pEGLView = CCEGLView::sharedOpenGLView();
 		//get current mouse pos
@@ -135,6 +144,7 @@ void mouseButtonEventHandle(int iMouseID,int iMouseState) {
 }
 
 void mousePosEventHandle(int iPosX,int iPosY) {
+	s_bEventReceived = true;
 	int iButtonState = glfwGetMouseButton(GLFW_MOUSE_BUTTON_LEFT);
 
 	//to test move
@@ -149,8 +159,15 @@ void mousePosEventHandle(int iPosX,int iPosY) {
 	}
 }
 
+void refreshEventHandle() {
+	s_bEventReceived = true;
+	// the content of the window was lost
+	CAApplication::getApplication()->updateDraw();
+}
+
 int closeEventHandle() {
-	CCDirector::sharedDirector()->end();
+	s_bEventReceived = true;
+	CAApplication::getApplication()->end();
 	return GL_TRUE;
 }
 
@@ -230,6 +247,8 @@ void CCEGLView::setFrameSize(float width, float height)
 		glfwSetMousePosCallback(mousePosEventHandle);
 
 		glfwSetWindowCloseCallback(closeEventHandle);
+		//register the glfw refresh event
+		glfwSetWindowRefreshCallback(refreshEventHandle);
 
 		//Inits extensions
 		eResult = initExtensions();
@@ -245,7 +264,7 @@ void CCEGLView::setFrameZoomFactor(float fZoomFactor)
 {
     m_fFrameZoomFactor = fZoomFactor;
     glfwSetWindowSize(m_obScreenSize.width * fZoomFactor, m_obScreenSize.height * fZoomFactor);
-    CCDirector::sharedDirector()->setProjection(CCDirector::sharedDirector()->getProjection());
+    CAApplication::getApplication()->setProjection(CAApplication::getApplication()->getProjection());
 }
 
 float CCEGLView::getFrameZoomFactor()
@@ -290,6 +309,30 @@ void CCEGLView::swapBuffers() {
 	}
 }
 
+bool CCEGLView::waitEvents(float timeout) {
+	s_bEventReceived = false;
+	if (!bIsInit) {
+		return false;
+	}
+
+	if (timeout < 0) {
+		glfwWaitEvents();
+		return true;
+	}
+
+	double deadline = glfwGetTime() + timeout;
+	glfwPollEvents();
+	while (!s_bEventReceived) {
+		double left = deadline - glfwGetTime();
+		if (left <= 0) {
+			break;
+		}
+		glfwSleep(left < kCCEGLViewEventPollInterval ? left : kCCEGLViewEventPollInterval);
+		glfwPollEvents();
+	}
+	return s_bEventReceived;
+}
+
 void CCEGLView::setIMEKeyboardState(bool bOpen) {
 
 }
@@ -45,6 +45,12 @@ public:
 	virtual void swapBuffers();
 	virtual void setIMEKeyboardState(bool bOpen);
 
+	/**
+	 @brief	waits for an event of the window, or for the timeout in seconds (-1 waits for the event only).
+	 Returns whether an event was received.
+	 */
+	bool waitEvents(float timeout);
+
 	/**
 	 @brief	get the shared main open gl window
 	 */
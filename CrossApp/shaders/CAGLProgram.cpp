@@ -3,6 +3,7 @@
 #include "basics/CAApplication.h"
 #include "CAGLProgram.h"
 #include "ccGLStateCache.h"
+#include "CARenderQueue.h"
 #include "ccMacros.h"
 #include "platform/CCFileUtils.h"
 #include "support/data_support/uthash.h"
@@ -29,10 +30,13 @@ CAGLProgram::CAGLProgram()
 , m_uVertShader(0)
 , m_uFragShader(0)
 , m_pHashForUniforms(NULL)
+, m_uProjectionGeneration(0)
+, m_uModelviewGeneration(0)
 , m_bUsesTime(false)
 , m_hasShaderCompiler(true)
 {
     memset(m_uUniforms, 0, sizeof(m_uUniforms));
+    memset(m_bBuiltinMatricesUploaded, 0, sizeof(m_bBuiltinMatricesUploaded));
 }
 
 CAGLProgram::~CAGLProgram()
@@ -236,6 +240,9 @@ void CAGLProgram::updateUniforms()
 	m_uUniforms[kCCUniformRandom01] = glGetUniformLocation(m_uProgram, kCCUniformRandom01_s);
 
     m_uUniforms[kCCUniformSampler] = glGetUniformLocation(m_uProgram, kCCUniformSampler_s);
+    
+    memset(m_bBuiltinMatricesUploaded, 0, sizeof(m_bBuiltinMatricesUploaded));
+    m_uProjectionGeneration = m_uModelviewGeneration = 0;
 
     this->use();
     
@@ -538,18 +545,35 @@ void CAGLProgram::setUniformLocationWithMatrix4fv(GLint location, GLfloat* matri
 
 void CAGLProgram::setUniformsForBuiltins()
 {
-    kmMat4 matrixP;
-	kmMat4 matrixMV;
-	kmMat4 matrixMVP;
-	
-	kmGLGetMatrix(KM_GL_PROJECTION, &matrixP);
-	kmGLGetMatrix(KM_GL_MODELVIEW, &matrixMV);
-	
-	kmMat4Multiply(&matrixMVP, &matrixP, &matrixMV);
+    // every immediate draw comes here first, the queued quads must be drawn before it
+    CARenderQueue::sharedRenderQueue()->flush();
     
-    setUniformLocationWithMatrix4fv(m_uUniforms[kCCUniformPMatrix], matrixP.mat, 1);
-    setUniformLocationWithMatrix4fv(m_uUniforms[kCCUniformMVMatrix], matrixMV.mat, 1);
-    setUniformLocationWithMatrix4fv(m_uUniforms[kCCUniformMVPMatrix], matrixMVP.mat, 1);
+    // the matrices are read and multiplied only when a stack changed since the last draw with this
+    // program: the projection about once a frame, the modelview of the render queue (identity) once a flush
+    unsigned int uProjectionGeneration = kmGLGetMatrixGeneration(KM_GL_PROJECTION);
+    unsigned int uModelviewGeneration = kmGLGetMatrixGeneration(KM_GL_MODELVIEW);
+    
+    if (uProjectionGeneration != m_uProjectionGeneration || uModelviewGeneration != m_uModelviewGeneration)
+    {
+        m_uProjectionGeneration = uProjectionGeneration;
+        m_uModelviewGeneration = uModelviewGeneration;
+        
+        kmMat4 matrixP;
+        kmMat4 matrixMV;
+        
+        kmGLGetMatrix(KM_GL_PROJECTION, &matrixP);
+        kmGLGetMatrix(KM_GL_MODELVIEW, &matrixMV);
+        
+        this->setBuiltinMatrix(kCCUniformPMatrix, matrixP);
+        this->setBuiltinMatrix(kCCUniformMVMatrix, matrixMV);
+        
+        if (m_uUniforms[kCCUniformMVPMatrix] != -1)
+        {
+            kmMat4 matrixMVP;
+            kmMat4Multiply(&matrixMVP, &matrixP, &matrixMV);
+            this->setBuiltinMatrix(kCCUniformMVPMatrix, matrixMVP);
+        }
+    }
 	
 	if(m_bUsesTime)
     {
@@ -570,10 +594,28 @@ void CAGLProgram::setUniformsForBuiltins()
 	}
 }
 
+void CAGLProgram::setBuiltinMatrix(int uniform, const kmMat4& matrix)
+{
+    GLint location = m_uUniforms[uniform];
+    CC_RETURN_IF(location == -1);
+    
+    if (m_bBuiltinMatricesUploaded[uniform]
+        && memcmp(m_tBuiltinMatrices[uniform].mat, matrix.mat, sizeof(matrix.mat)) == 0)
+    {
+        return;
+    }
+    
+    m_tBuiltinMatrices[uniform] = matrix;
+    m_bBuiltinMatricesUploaded[uniform] = true;
+    glUniformMatrix4fv(location, 1, GL_FALSE, matrix.mat);
+}
+
 void CAGLProgram::reset()
 {
     m_uVertShader = m_uFragShader = 0;
     memset(m_uUniforms, 0, sizeof(m_uUniforms));
+    memset(m_bBuiltinMatricesUploaded, 0, sizeof(m_bBuiltinMatricesUploaded));
+    m_uProjectionGeneration = m_uModelviewGeneration = 0;
     
 
     // it is already deallocated by android
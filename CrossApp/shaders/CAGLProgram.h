@@ -7,6 +7,7 @@
 #include "basics/CAObject.h"
 #include <string>
 #include "CCGL.h"
+#include "kazmath/mat4.h"
 
 NS_CC_BEGIN
 
@@ -247,6 +248,7 @@ public:
 
 private:
     bool updateUniformLocation(GLint location, GLvoid* data, unsigned int bytes);
+    void setBuiltinMatrix(int uniform, const kmMat4& matrix);
     const char* description();
     bool compileShader(GLuint * shader, GLenum type, const GLchar* source);
     const char* logForOpenGLObject(GLuint object, GLInfoFunction infoFunc, GLLogFunction logFunc);
@@ -257,6 +259,10 @@ private:
     GLuint            m_uFragShader;
     GLint             m_uUniforms[kCCUniform_MAX];
     struct _hashUniformEntry* m_pHashForUniforms;
+    kmMat4            m_tBuiltinMatrices[kCCUniformMVPMatrix + 1];          // values of CC_PMatrix, CC_MVMatrix and CC_MVPMatrix
+    bool              m_bBuiltinMatricesUploaded[kCCUniformMVPMatrix + 1];
+    unsigned int      m_uProjectionGeneration;                              // generations of the stacks the matrices come from
+    unsigned int      m_uModelviewGeneration;
     bool              m_bUsesTime;
     bool              m_hasShaderCompiler;
 
@@ -0,0 +1,223 @@
+#include "CARenderQueue.h"
+#include "CAGLProgram.h"
+#include "ccGLStateCache.h"
+#include "ccMacros.h"
+#include "support/CANotificationCenter.h"
+// extern
+#include "kazmath/GL/matrix.h"
+#include <stddef.h>
+
+NS_CC_BEGIN
+
+static CARenderQueue* _sharedRenderQueue = NULL;
+
+CARenderQueue* CARenderQueue::sharedRenderQueue()
+{
+    if (!_sharedRenderQueue)
+    {
+        _sharedRenderQueue = new CARenderQueue();
+    }
+    return _sharedRenderQueue;
+}
+
+void CARenderQueue::purgeSharedRenderQueue()
+{
+    CC_SAFE_RELEASE_NULL(_sharedRenderQueue);
+}
+
+CARenderQueue::CARenderQueue()
+: m_bEnabled(true)
+, m_bFlushing(false)
+, m_uQuadsCount(0)
+, m_uBatchesCount(0)
+{
+    m_pBuffersVBO[0] = m_pBuffersVBO[1] = 0;
+    m_vQuads.reserve(256);
+    m_vBatches.reserve(64);
+
+#if CC_ENABLE_CACHE_TEXTURE_DATA
+    // listen the event when app go to background
+    CANotificationCenter::sharedNotificationCenter()->addObserver(this,
+                                                                  callfuncO_selector(CARenderQueue::listenBackToForeground),
+                                                                  EVENT_COME_TO_FOREGROUND,
+                                                                  NULL);
+#endif
+}
+
+CARenderQueue::~CARenderQueue()
+{
+    CCLOGINFO("CrossApp deallocing 0x%X", this);
+
+    if (m_pBuffersVBO[0])
+    {
+        glDeleteBuffers(2, &m_pBuffersVBO[0]);
+    }
+
+#if CC_ENABLE_CACHE_TEXTURE_DATA
+    CANotificationCenter::sharedNotificationCenter()->removeObserver(this, EVENT_COME_TO_FOREGROUND);
+#endif
+}
+
+void CARenderQueue::setEnabled(bool bEnabled)
+{
+    if (!bEnabled)
+    {
+        this->flush();
+    }
+    m_bEnabled = bEnabled;
+}
+
+void CARenderQueue::listenBackToForeground(CAObject *obj)
+{
+    // the buffers were released together with the GL context
+    m_pBuffersVBO[0] = m_pBuffersVBO[1] = 0;
+}
+
+void CARenderQueue::setupBuffers()
+{
+    GLushort* indices = (GLushort*)malloc(kCARenderQueueMaxQuads * 6 * sizeof(GLushort));
+
+    for (unsigned int i=0; i<kCARenderQueueMaxQuads; i++)
+    {
+        indices[i*6+0] = i*4+0;
+        indices[i*6+1] = i*4+1;
+        indices[i*6+2] = i*4+2;
+
+        // inverted index. issue #179
+        indices[i*6+3] = i*4+3;
+        indices[i*6+4] = i*4+2;
+        indices[i*6+5] = i*4+1;
+    }
+
+    ccGLBindVAO(0);
+
+    glGenBuffers(2, &m_pBuffersVBO[0]);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_pBuffersVBO[1]);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, kCARenderQueueMaxQuads * 6 * sizeof(GLushort), indices, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    free(indices);
+
+    CHECK_GL_ERROR_DEBUG();
+}
+
+void CARenderQueue::addQuad(const ccV3F_C4B_T2F_Quad& quad,
+                            const kmMat4& modelview,
+                            GLuint texture,
+                            CAGLProgram* program,
+                            const ccBlendFunc& blendFunc)
+{
+    if (m_vQuads.size() >= kCARenderQueueMaxQuads)
+    {
+        this->flush();
+    }
+
+    // transform the 4 vertices to eye space, the batch is drawn with an identity modelview
+    ccV3F_C4B_T2F_Quad q = quad;
+    kmVec3TransformInterleaved((kmVec3*)&q.tl.vertices, sizeof(ccV3F_C4B_T2F),
+                               (const kmVec3*)&q.tl.vertices, sizeof(ccV3F_C4B_T2F),
+                               &modelview, 4);
+
+    bool merged = false;
+    if (!m_vBatches.empty())
+    {
+        CARenderBatch& last = m_vBatches.back();
+        if (last.texture == texture
+            && last.program == program
+            && last.blendFunc.src == blendFunc.src
+            && last.blendFunc.dst == blendFunc.dst)
+        {
+            ++last.count;
+            merged = true;
+        }
+    }
+
+    if (!merged)
+    {
+        CARenderBatch batch;
+        batch.texture = texture;
+        batch.program = program;
+        batch.blendFunc = blendFunc;
+        batch.start = (unsigned int)m_vQuads.size();
+        batch.count = 1;
+        m_vBatches.push_back(batch);
+    }
+
+    m_vQuads.push_back(q);
+    ++m_uQuadsCount;
+}
+
+void CARenderQueue::flush()
+{
+    CC_RETURN_IF(m_bFlushing);
+    CC_RETURN_IF(m_vBatches.empty());
+
+    m_bFlushing = true;
+
+    this->drawBatches();
+
+    m_vQuads.clear();
+    m_vBatches.clear();
+
+    m_bFlushing = false;
+}
+
+void CARenderQueue::drawBatches()
+{
+    if (m_pBuffersVBO[0] == 0)
+    {
+        this->setupBuffers();
+    }
+
+    // the vertices are already in eye space
+    kmGLPushMatrix();
+    kmGLLoadIdentity();
+
+    ccGLEnableVertexAttribs(kCCVertexAttribFlag_PosColorTex);
+
+#define kQuadSize sizeof(ccV3F_C4B_T2F)
+    glBindBuffer(GL_ARRAY_BUFFER, m_pBuffersVBO[0]);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(m_vQuads[0]) * m_vQuads.size(), &m_vQuads[0], GL_DYNAMIC_DRAW);
+
+    // vertices
+    glVertexAttribPointer(kCCVertexAttrib_Position, 3, GL_FLOAT, GL_FALSE, kQuadSize, (GLvoid*) offsetof(ccV3F_C4B_T2F, vertices));
+
+    // colors
+    glVertexAttribPointer(kCCVertexAttrib_Color, 4, GL_UNSIGNED_BYTE, GL_TRUE, kQuadSize, (GLvoid*) offsetof(ccV3F_C4B_T2F, colors));
+
+    // tex coords
+    glVertexAttribPointer(kCCVertexAttrib_TexCoords, 2, GL_FLOAT, GL_FALSE, kQuadSize, (GLvoid*) offsetof(ccV3F_C4B_T2F, texCoords));
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_pBuffersVBO[1]);
+
+    std::vector<CARenderBatch>::iterator itr;
+    for (itr=m_vBatches.begin(); itr!=m_vBatches.end(); itr++)
+    {
+        itr->program->use();
+        itr->program->setUniformsForBuiltins();
+
+        ccGLBlendFunc(itr->blendFunc.src, itr->blendFunc.dst);
+        ccGLBindTexture2D(itr->texture);
+
+        glDrawElements(GL_TRIANGLES, (GLsizei)itr->count * 6, GL_UNSIGNED_SHORT, (GLvoid*)(itr->start * 6 * sizeof(GLushort)));
+
+        CC_INCREMENT_GL_DRAWS(1);
+        ++m_uBatchesCount;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    kmGLPopMatrix();
+
+    CHECK_GL_ERROR_DEBUG();
+}
+
+void CARenderQueue::resetStats()
+{
+    m_uQuadsCount = 0;
+    m_uBatchesCount = 0;
+}
+
+NS_CC_END
@@ -0,0 +1,111 @@
+#ifndef __CARenderQueue_H__
+#define __CARenderQueue_H__
+
+#include "basics/CAObject.h"
+#include "ccTypes.h"
+#include "CCGL.h"
+#include "kazmath/mat4.h"
+#include <vector>
+
+NS_CC_BEGIN
+
+class CAGLProgram;
+
+/**
+ * @addtogroup shaders
+ * @{
+ */
+
+/** Maximum number of quads kept in the queue before it is flushed.
+ Limited by the GLushort index buffer (4 vertices per quad).
+ */
+#define kCARenderQueueMaxQuads 16384
+
+/** CARenderQueue
+ Singleton that collects the quads drawn by CAView::draw() during a visit.
+ Quads are transformed to eye space on the CPU when they are added, so consecutive
+ quads sharing the same image, shader and blend func are merged into a single
+ indexed VBO draw when the queue is flushed.
+
+ The queue is flushed automatically before any immediate draw (CAGLProgram::setUniformsForBuiltins),
+ before scissor / stencil / framebuffer / projection changes and at the end of every frame,
+ so the painter's order of the view tree is preserved.
+ */
+class CC_DLL CARenderQueue : public CAObject
+{
+public:
+
+    CARenderQueue();
+
+    virtual ~CARenderQueue();
+
+    /** returns the shared instance */
+    static CARenderQueue* sharedRenderQueue();
+
+    /** purges the queue. It releases the GL buffers. */
+    static void purgeSharedRenderQueue();
+
+    /** Whether views push their quads into the queue instead of drawing them immediately. Default is true. */
+    inline bool isEnabled() { return m_bEnabled; }
+
+    void setEnabled(bool bEnabled);
+
+    /** adds a quad in model space, it will be transformed by the given modelview matrix */
+    void addQuad(const ccV3F_C4B_T2F_Quad& quad,
+                 const kmMat4& modelview,
+                 GLuint texture,
+                 CAGLProgram* program,
+                 const ccBlendFunc& blendFunc);
+
+    /** draws all the pending quads and empties the queue */
+    void flush();
+
+    /** number of quads pushed since the last call of resetStats() */
+    inline unsigned int getQuadsCount() { return m_uQuadsCount; }
+
+    /** number of GL draw calls issued by the queue since the last call of resetStats() */
+    inline unsigned int getBatchesCount() { return m_uBatchesCount; }
+
+    void resetStats();
+
+    void listenBackToForeground(CAObject *obj);
+
+protected:
+
+    typedef struct _CARenderBatch
+    {
+        GLuint          texture;
+        CAGLProgram*    program;
+        ccBlendFunc     blendFunc;
+        unsigned int    start;
+        unsigned int    count;
+    }
+    CARenderBatch;
+
+    void setupBuffers();
+
+    void drawBatches();
+
+protected:
+
+    std::vector<ccV3F_C4B_T2F_Quad> m_vQuads;
+
+    std::vector<CARenderBatch> m_vBatches;
+
+    GLuint m_pBuffersVBO[2];
+
+    bool m_bEnabled;
+
+    bool m_bFlushing;
+
+    unsigned int m_uQuadsCount;
+
+    unsigned int m_uBatchesCount;
+};
+
+// end of shaders group
+/// @}
+
+NS_CC_END
+
+#endif /* __CARenderQueue_H__ */
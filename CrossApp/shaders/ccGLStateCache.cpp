@@ -2,12 +2,14 @@
 
 #include "ccGLStateCache.h"
 #include "CAGLProgram.h"
+#include "CARenderQueue.h"
 #include "basics/CAApplication.h"
 #include "ccConfig.h"
 
 // extern
 #include "kazmath/GL/matrix.h"
 #include "kazmath/kazmath.h"
+#include <vector>
 
 NS_CC_BEGIN
 
@@ -16,6 +18,14 @@ static bool        s_bVertexAttribPosition = false;
 static bool        s_bVertexAttribColor = false;
 static bool        s_bVertexAttribTexCoords = false;
 
+typedef struct _ccScissorRect
+{
+    GLfloat x, y, width, height;
+}
+ccScissorRect;
+
+static std::vector<ccScissorRect> s_vScissorStack;
+
 
 #if CC_ENABLE_GL_STATE_CACHE
 
@@ -150,6 +160,9 @@ void ccGLDeleteTexture(GLuint textureId)
 
 void ccGLDeleteTextureN(GLuint textureUnit, GLuint textureId)
 {
+    // queued quads may still reference the texture
+    CARenderQueue::sharedRenderQueue()->flush();
+    
 #if CC_ENABLE_GL_STATE_CACHE
 	if (s_uCurrentBoundTexture[textureUnit] == textureId)
     {
@@ -202,6 +215,64 @@ void ccGLEnable(ccGLServerState flags)
 #endif
 }
 
+void ccGLPushScissor(GLfloat x, GLfloat y, GLfloat width, GLfloat height)
+{
+    ccScissorRect rect = {x, y, width, height};
+    
+    if (s_vScissorStack.empty())
+    {
+        glEnable(GL_SCISSOR_TEST);
+    }
+    else
+    {
+        const ccScissorRect& top = s_vScissorStack.back();
+        rect.x = MAX(x, top.x);
+        rect.y = MAX(y, top.y);
+        rect.width = MAX(MIN(x + width, top.x + top.width) - rect.x, 0);
+        rect.height = MAX(MIN(y + height, top.y + top.height) - rect.y, 0);
+    }
+    
+    s_vScissorStack.push_back(rect);
+    glScissor(rect.x, rect.y, rect.width, rect.height);
+}
+
+void ccGLPopScissor(void)
+{
+    CC_RETURN_IF(s_vScissorStack.empty());
+    
+    s_vScissorStack.pop_back();
+    
+    if (s_vScissorStack.empty())
+    {
+        glDisable(GL_SCISSOR_TEST);
+    }
+    else
+    {
+        const ccScissorRect& top = s_vScissorStack.back();
+        glScissor(top.x, top.y, top.width, top.height);
+    }
+}
+
+bool ccGLIsScissorEnabled(void)
+{
+    return !s_vScissorStack.empty();
+}
+
+bool ccGLGetScissorRect(GLfloat* rect)
+{
+    if (s_vScissorStack.empty())
+    {
+        return false;
+    }
+    
+    const ccScissorRect& top = s_vScissorStack.back();
+    rect[0] = top.x;
+    rect[1] = top.y;
+    rect[2] = top.width;
+    rect[3] = top.height;
+    return true;
+}
+
 #if (CC_TARGET_PLATFORM == CC_PLATFORM_IOS) || (CC_TARGET_PLATFORM == CC_PLATFORM_MAC)
 //#pragma mark - GL Vertex Attrib functions
 #endif
@@ -128,6 +128,24 @@ void CC_DLL ccGLBindVAO(GLuint vaoId);
  */
 void CC_DLL ccGLEnable( ccGLServerState flags );
 
+/** Pushes a scissor rect, in window pixels. The rect is intersected with the current one,
+ GL_SCISSOR_TEST is enabled by the first push.
+ The stack is kept on the CPU side, no GL state is queried.
+ */
+void CC_DLL ccGLPushScissor(GLfloat x, GLfloat y, GLfloat width, GLfloat height);
+
+/** Pops the last scissor rect. The previous rect is restored, GL_SCISSOR_TEST is disabled by the last pop.
+ */
+void CC_DLL ccGLPopScissor(void);
+
+/** Whether the scissor stack is not empty.
+ */
+bool CC_DLL ccGLIsScissorEnabled(void);
+
+/** Gets the current scissor rect of the stack, in window pixels. Returns false if the stack is empty.
+ */
+bool CC_DLL ccGLGetScissorRect(GLfloat* rect);
+
 // end of shaders group
 /// @}
 
@@ -13,13 +13,25 @@ static CANotificationCenter *s_sharedNotifCenter = NULL;
 CANotificationCenter::CANotificationCenter()
 : m_scriptHandler(0)
 {
-    m_observers = CCArray::createWithCapacity(3);
-    m_observers->retain();
+
 }
 
 CANotificationCenter::~CANotificationCenter()
 {
-    m_observers->release();
+    std::map<const char*, CCArray*, CAStringLess>::iterator itr;
+    for (itr=m_mObservers.begin(); itr!=m_mObservers.end(); itr++)
+    {
+        itr->second->release();
+        delete[] itr->first;
+    }
+    m_mObservers.clear();
+    
+    std::vector<std::pair<std::string, CAObject*> >::iterator itr_queued;
+    for (itr_queued=m_vQueuedNotifications.begin(); itr_queued!=m_vQueuedNotifications.end(); itr_queued++)
+    {
+        CC_SAFE_RELEASE(itr_queued->second);
+    }
+    m_vQueuedNotifications.clear();
 }
 
 CANotificationCenter *CANotificationCenter::sharedNotificationCenter(void)
@@ -41,19 +53,48 @@ void CANotificationCenter::purgeNotificationCenter(void)
 //
 bool CANotificationCenter::observerExisted(CAObject *target,const char *name)
 {
+    std::map<const char*, CCArray*, CAStringLess>::iterator itr = m_mObservers.find(name);
+    if (itr == m_mObservers.end())
+        return false;
+    
     CAObject* obj = NULL;
-    CCARRAY_FOREACH(m_observers, obj)
+    CCARRAY_FOREACH(itr->second, obj)
     {
         CCNotificationObserver* observer = (CCNotificationObserver*) obj;
         if (!observer)
             continue;
         
-        if (!strcmp(observer->getName(),name) && observer->getTarget() == target)
+        if (observer->getTarget() == target)
             return true;
     }
     return false;
 }
 
+CCArray* CANotificationCenter::getObserversForWriting(const char *name)
+{
+    std::map<const char*, CCArray*, CAStringLess>::iterator itr = m_mObservers.find(name);
+    if (itr == m_mObservers.end())
+    {
+        char* key = new char[strlen(name) + 1];
+        strcpy(key, name);
+        
+        // not autoreleased, the count of references tells whether a post holds it
+        CCArray* observers = new CCArray(3);
+        m_mObservers.insert(std::make_pair((const char*)key, observers));
+        return observers;
+    }
+    
+    // a post holds the array, it goes on with the observers it had
+    if (itr->second->retainCount() > 1)
+    {
+        CCArray* observers = new CCArray(itr->second->count() + 1);
+        observers->addObjectsFromArray(itr->second);
+        itr->second->release();
+        itr->second = observers;
+    }
+    return itr->second;
+}
+
 //
 // observer functions
 //
@@ -67,21 +108,26 @@ void CANotificationCenter::addObserver(CAObject *target, SEL_CallFuncO selector,
         return;
     
     observer->autorelease();
-    m_observers->addObject(observer);
+    this->getObserversForWriting(name)->addObject(observer);
 }
 
 void CANotificationCenter::removeObserver(CAObject *target, const char *name)
 {
+    if (!this->observerExisted(target, name))
+        return;
+    
+    CCArray* observers = this->getObserversForWriting(name);
+    
     CAObject* obj = NULL;
-    CCARRAY_FOREACH(m_observers, obj)
+    CCARRAY_FOREACH(observers, obj)
     {
         CCNotificationObserver* observer = (CCNotificationObserver*) obj;
         if (!observer)
             continue;
         
-        if (!strcmp(observer->getName(),name) && observer->getTarget() == target)
+        if (observer->getTarget() == target)
         {
-            m_observers->removeObject(observer);
+            observers->removeObject(observer);
             return;
         }
     }
@@ -89,23 +135,26 @@ void CANotificationCenter::removeObserver(CAObject *target, const char *name)
 
 int CANotificationCenter::removeAllObservers(CAObject *target)
 {
-    CAObject *obj = NULL;
-    CCArray *toRemove = CCArray::create();
-
-    CCARRAY_FOREACH(m_observers, obj)
+    int count = 0;
+    
+    std::map<const char*, CCArray*, CAStringLess>::iterator itr;
+    for (itr=m_mObservers.begin(); itr!=m_mObservers.end(); itr++)
     {
-        CCNotificationObserver *observer = (CCNotificationObserver *)obj;
-        if (!observer)
+        if (!this->observerExisted(target, itr->first))
             continue;
-
-        if (observer->getTarget() == target)
+        
+        CCArray* observers = this->getObserversForWriting(itr->first);
+        for (int i=(int)observers->count()-1; i>=0; i--)
         {
-            toRemove->addObject(observer);
+            CCNotificationObserver* observer = (CCNotificationObserver*) observers->objectAtIndex(i);
+            if (observer->getTarget() == target)
+            {
+                observers->removeObjectAtIndex(i);
+                ++count;
+            }
         }
     }
-
-    m_observers->removeObjectsInArray(toRemove);
-    return toRemove->count();
+    return count;
 }
 
 void CANotificationCenter::registerScriptObserver( CAObject *target, int handler,const char* name)
@@ -120,37 +169,43 @@ void CANotificationCenter::registerScriptObserver( CAObject *target, int handler
     
     observer->setHandler(handler);
     observer->autorelease();
-    m_observers->addObject(observer);
+    this->getObserversForWriting(name)->addObject(observer);
 }
 
 void CANotificationCenter::unregisterScriptObserver(CAObject *target,const char* name)
-{        
-    CAObject* obj = NULL;
-    CCARRAY_FOREACH(m_observers, obj)
+{
+    if (!this->observerExisted(target, name))
+        return;
+    
+    CCArray* observers = this->getObserversForWriting(name);
+    for (int i=(int)observers->count()-1; i>=0; i--)
     {
-        CCNotificationObserver* observer = (CCNotificationObserver*) obj;
-        if (!observer)
-            continue;
-            
-        if ( !strcmp(observer->getName(),name) && observer->getTarget() == target)
+        CCNotificationObserver* observer = (CCNotificationObserver*) observers->objectAtIndex(i);
+        if (observer->getTarget() == target)
         {
-            m_observers->removeObject(observer);
+            observers->removeObjectAtIndex(i);
         }
     }
 }
 
 void CANotificationCenter::postNotification(const char *name, CAObject *object)
 {
-    CCArray* ObserversCopy = CCArray::createWithCapacity(m_observers->count());
-    ObserversCopy->addObjectsFromArray(m_observers);
+    std::map<const char*, CCArray*, CAStringLess>::iterator itr = m_mObservers.find(name);
+    if (itr == m_mObservers.end())
+        return;
+    
+    // the observers added or removed by the callbacks go to a copy, this array stays as it is
+    CCArray* observers = itr->second;
+    observers->retain();
+    
     CAObject* obj = NULL;
-    CCARRAY_FOREACH(ObserversCopy, obj)
+    CCARRAY_FOREACH(observers, obj)
     {
         CCNotificationObserver* observer = (CCNotificationObserver*) obj;
         if (!observer)
             continue;
         
-        if (!strcmp(name,observer->getName()) && (observer->getObject() == object || observer->getObject() == NULL || object == NULL))
+        if (observer->getObject() == object || observer->getObject() == NULL || object == NULL)
         {
             if (0 == observer->getHandler())
             {
@@ -158,6 +213,8 @@ void CANotificationCenter::postNotification(const char *name, CAObject *object)
             }
         }
     }
+    
+    observers->release();
 }
 
 void CANotificationCenter::postNotification(const char *name)
@@ -165,28 +222,66 @@ void CANotificationCenter::postNotification(const char *name)
     this->postNotification(name,NULL);
 }
 
-int CANotificationCenter::getObserverHandlerByName(const char* name)
+void CANotificationCenter::enqueueNotification(const char *name, CAObject *object)
 {
-    if (NULL == name || strlen(name) == 0)
+    // the duplicates are left for postQueuedNotifications, their references are released there
+    CAAutoLock lock(m_obQueueLock);
+    m_vQueuedNotifications.push_back(std::make_pair(std::string(name), object));
+}
+
+void CANotificationCenter::postQueuedNotifications()
+{
+    std::vector<std::pair<std::string, CAObject*> > notifications;
     {
-        return -1;
+        CAAutoLock lock(m_obQueueLock);
+        CC_RETURN_IF(m_vQueuedNotifications.empty());
+        notifications.swap(m_vQueuedNotifications);
     }
     
-    CAObject* obj = NULL;
-    CCARRAY_FOREACH(m_observers, obj)
+    // the notifications queued by the observers are posted at the next frame
+    std::vector<std::pair<std::string, CAObject*> >::iterator itr;
+    for (itr=notifications.begin(); itr!=notifications.end(); itr++)
     {
-        CCNotificationObserver* observer = (CCNotificationObserver*) obj;
-        if (NULL == observer)
-            continue;
+        std::vector<std::pair<std::string, CAObject*> >::iterator posted;
+        for (posted=notifications.begin(); posted!=itr; posted++)
+        {
+            if (posted->second == itr->second && posted->first == itr->first)
+                break;
+        }
         
-        if ( 0 == strcmp(observer->getName(),name) )
+        if (posted == itr)
         {
-            return observer->getHandler();
-            break;
+            this->postNotification(itr->first.c_str(), itr->second);
         }
     }
     
-    return -1;
+    for (itr=notifications.begin(); itr!=notifications.end(); itr++)
+    {
+        CC_SAFE_RELEASE(itr->second);
+    }
+}
+
+bool CANotificationCenter::hasQueuedNotifications()
+{
+    CAAutoLock lock(m_obQueueLock);
+    return !m_vQueuedNotifications.empty();
+}
+
+int CANotificationCenter::getObserverHandlerByName(const char* name)
+{
+    if (NULL == name || strlen(name) == 0)
+    {
+        return -1;
+    }
+    
+    std::map<const char*, CCArray*, CAStringLess>::iterator itr = m_mObservers.find(name);
+    if (itr == m_mObservers.end() || itr->second->count() == 0)
+    {
+        return -1;
+    }
+    
+    CCNotificationObserver* observer = (CCNotificationObserver*) itr->second->objectAtIndex(0);
+    return observer->getHandler();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
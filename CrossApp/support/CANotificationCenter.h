@@ -4,7 +4,11 @@
 #define __CANotificationCenter_H__
 
 #include "basics/CAObject.h"
+#include "basics/CASyncQueue.h"
 #include "cocoa/CCArray.h"
+#include <map>
+#include <string>
+#include <vector>
 
 NS_CC_BEGIN
 /**
@@ -68,6 +72,22 @@ public:
      */
     void postNotification(const char *name, CAObject *object);
     
+    /** @brief Queues one notification event, it is posted on the main thread at the next frame.
+     *  Notifications queued several times with the same name and object before then are
+     *  posted once. It may be called from any thread, the counts of references are not
+     *  thread safe so the object is not retained here.
+     *  @param name The name of this notification.
+     *  @param object The extra parameter, retained by the caller: the queue takes over that
+     *  reference and releases it on the main thread once the notification is posted.
+     */
+    void enqueueNotification(const char *name, CAObject *object = NULL);
+    
+    /** Posts the queued notifications, called by the application every frame. */
+    void postQueuedNotifications();
+    
+    /** Whether notifications wait to be posted at the next frame. */
+    bool hasQueuedNotifications();
+    
     /** @brief Gets script handler.
      *  @note Only supports Lua Binding now.
      *  @return The script handle.
@@ -85,9 +105,24 @@ private:
     // Check whether the observer exists by the specified target and name.
     bool observerExisted(CAObject *target,const char *name);
     
+    // The observers of the name, copied first if a post is walking them.
+    CCArray* getObserversForWriting(const char *name);
+    
+    struct CAStringLess
+    {
+        bool operator()(const char* one, const char* two) const { return strcmp(one, two) < 0; }
+    };
+    
     // variables
     //
-    CCArray *m_observers;
+    // the observers by name, the keys are copies of the names kept until the center is destroyed.
+    // a post retains the array it walks, the changes made meanwhile go to a new array.
+    std::map<const char*, CCArray*, CAStringLess> m_mObservers;
+    
+    std::vector<std::pair<std::string, CAObject*> > m_vQueuedNotifications;
+    
+    CALock  m_obQueueLock;
+    
     int     m_scriptHandler;
 };
 
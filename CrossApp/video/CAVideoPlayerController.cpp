@@ -22,7 +22,6 @@ NS_CC_BEGIN
 //static bool            m_bNeedExit = false;
 //static pthread_t       m_thread;
 //static pthread_mutex_t m_vp_data_mutex;
-//static pthread_mutex_t m_vp_cond_mutex;
 //static pthread_cond_t  m_vp_cond;
 
 static string formatTimeInterval(float seconds, bool isLeft)
@@ -51,9 +50,9 @@ static string formatTimeInterval(float seconds, bool isLeft)
 
 static void* decodeProcess(void* param)
 {
+    // retained by lazyInit
     CAVideoPlayerController* controller = (CAVideoPlayerController*)param;
     
-    controller->retain();
     controller->lazyProcess();
     CCLog("%s, retain=%d", __FUNCTION__, controller->retainCount());
     controller->release();
@@ -61,27 +60,193 @@ static void* decodeProcess(void* param)
     return NULL;
 }
 
+static void* videoDecodeProcess(void* param)
+{
+    CAVideoPlayerController* controller = (CAVideoPlayerController*)param;
+    controller->videoProcess();
+    return NULL;
+}
+
+static void* audioDecodeProcess(void* param)
+{
+    CAVideoPlayerController* controller = (CAVideoPlayerController*)param;
+    controller->audioProcess();
+    return NULL;
+}
+
 void CAVideoPlayerController::lazyProcess()
 {
+    while (!m_bNeedExit && !setMovieDecoder()) {
+        pthread_mutex_lock(&m_vp_data_mutex);
+        if (!m_bNeedExit) {
+            pthread_cond_wait(&m_vp_cond, &m_vp_data_mutex);
+        }
+        pthread_mutex_unlock(&m_vp_data_mutex);
+    }
+    
+    if (!m_bNeedExit) {
+        
+        // one decode thread per stream, this one demuxes the packets for them
+        if (_decoder->isValidVideo()) {
+            m_bVideoThread = pthread_create(&m_videoThread, NULL, videoDecodeProcess, (void*)this) == 0;
+        }
+        if (_decoder->isValidAudio()) {
+            m_bAudioThread = pthread_create(&m_audioThread, NULL, audioDecodeProcess, (void*)this) == 0;
+        }
+        
+        this->demuxPackets();
+        
+        _decoder->abortPacketQueues();
+        
+        if (m_bVideoThread) {
+            pthread_join(m_videoThread, NULL);
+            m_bVideoThread = false;
+        }
+        if (m_bAudioThread) {
+            pthread_join(m_audioThread, NULL);
+            m_bAudioThread = false;
+        }
+    }
+    
+}
+
+void CAVideoPlayerController::demuxPackets()
+{
+    vector<VPFrame*> frames;
+    
     while (true) {
+        
+        pthread_mutex_lock(&m_vp_data_mutex);
+        
+        // nothing to read after the end of the file until a seek
+        while (!m_bNeedExit && !_seekRequested && _decoder->isEOF()) {
+            pthread_cond_wait(&m_vp_cond, &m_vp_data_mutex);
+        }
+        
         if (m_bNeedExit) {
+            pthread_mutex_unlock(&m_vp_data_mutex);
             break;
         }
-        _decodeProcess();
-        if (m_bNeedExit) {
+        
+        // a packet read under an older serial is dropped by the packet queues
+        const unsigned int serial = _serial;
+        const bool seek = _seekRequested;
+        const float position = _seekPosition;
+        _seekRequested = false;
+        
+        pthread_mutex_unlock(&m_vp_data_mutex);
+        
+        if (seek) {
+            _decoder->seekStreams(position);
+        }
+        
+        // waits while the packet queue of the stream is full
+        _decoder->demuxPacket(serial, frames);
+        
+        if (!frames.empty()) {
+            this->addFrames(frames);
+            frames.clear();
+        }
+    }
+}
+
+void CAVideoPlayerController::videoProcess()
+{
+    vector<VPFrame*> frames;
+    
+    while (true) {
+        
+        pthread_mutex_lock(&m_vp_data_mutex);
+        
+        // presentFrame() makes room by taking the frames out
+        while (!m_bNeedExit && _bufferedDuration > 0 && _bufferedDuration >= _maxBufferedDuration) {
+            pthread_cond_wait(&m_vp_cond, &m_vp_data_mutex);
+        }
+        
+        const bool needExit = m_bNeedExit;
+        pthread_mutex_unlock(&m_vp_data_mutex);
+        
+        if (needExit) {
             break;
         }
-        pthread_mutex_lock(&m_vp_cond_mutex);
-        pthread_cond_wait(&m_vp_cond, &m_vp_cond_mutex);
-        pthread_mutex_unlock(&m_vp_cond_mutex);
+        
+        struct timeval begin, end;
+        gettimeofday(&begin, 0);
+        
+        unsigned int serial = 0;
+        bool finished = false;
+        if (!_decoder->decodeVideoPackets(frames, serial, finished)) {
+            break;
+        }
+        
+        gettimeofday(&end, 0);
+        
+        float decodedDuration = 0;
+        for (unsigned int i=0; i<frames.size(); i++) {
+            decodedDuration += frames.at(i)->getDuration();
+        }
+        
+        this->addFrames(frames);
+        frames.clear();
+        
+        pthread_mutex_lock(&m_vp_data_mutex);
+        if (serial == _serial) {
+            _videoFinished = _videoFinished || finished;
+            this->updateDecodeRate(decodedDuration,
+                                   (end.tv_sec - begin.tv_sec) + (end.tv_usec - begin.tv_usec) / 1000000.0f);
+        }
+        pthread_mutex_unlock(&m_vp_data_mutex);
     }
+}
+
+void CAVideoPlayerController::audioProcess()
+{
+    vector<VPFrame*> frames;
     
-    if (m_inited) {
-        pthread_mutex_destroy(&m_vp_data_mutex);
-        pthread_mutex_destroy(&m_vp_cond_mutex);
-        pthread_cond_destroy(&m_vp_cond);
-        m_inited = false;
-        m_bNeedExit = false;
+    while (true) {
+        
+        pthread_mutex_lock(&m_vp_data_mutex);
+        
+        // the audio callback makes room by taking the frames out
+        while (!m_bNeedExit && _bufferedAudioDuration > 0 && _bufferedAudioDuration >= _maxBufferedDuration) {
+            pthread_cond_wait(&m_vp_cond, &m_vp_data_mutex);
+        }
+        
+        const bool needExit = m_bNeedExit;
+        pthread_mutex_unlock(&m_vp_data_mutex);
+        
+        if (needExit) {
+            break;
+        }
+        
+        struct timeval begin, end;
+        gettimeofday(&begin, 0);
+        
+        unsigned int serial = 0;
+        bool finished = false;
+        if (!_decoder->decodeAudioPackets(frames, serial, finished)) {
+            break;
+        }
+        
+        gettimeofday(&end, 0);
+        
+        float decodedDuration = 0;
+        for (unsigned int i=0; i<frames.size(); i++) {
+            decodedDuration += frames.at(i)->getDuration();
+        }
+        
+        this->addFrames(frames);
+        frames.clear();
+        
+        pthread_mutex_lock(&m_vp_data_mutex);
+        if (serial == _serial) {
+            _audioFinished = _audioFinished || finished;
+            if (!_decoder->isValidVideo()) {
+                this->updateDecodeRate(decodedDuration,
+                                       (end.tv_sec - begin.tv_sec) + (end.tv_usec - begin.tv_usec) / 1000000.0f);
+            }
+        }
+        pthread_mutex_unlock(&m_vp_data_mutex);
     }
 }
 
@@ -89,15 +254,57 @@ void CAVideoPlayerController::lazyInit()
 {
     if (!m_inited) {
         pthread_mutex_init(&m_vp_data_mutex, NULL);
-        pthread_mutex_init(&m_vp_cond_mutex, NULL);
         pthread_cond_init(&m_vp_cond, NULL);
 #if (CC_TARGET_PLATFORM != CC_PLATFORM_WINRT) && (CC_TARGET_PLATFORM != CC_PLATFORM_WP8)
-        pthread_create(&m_thread, NULL, decodeProcess, (void*)this);
+        // the thread releases the controller when it ends
+        this->retain();
+        m_bThread = pthread_create(&m_thread, NULL, decodeProcess, (void*)this) == 0;
+        if (!m_bThread) {
+            this->release();
+        }
 #endif
         m_inited = true;
     }
 }
 
+void CAVideoPlayerController::stopThreads()
+{
+    CC_RETURN_IF(!m_inited);
+    
+    _interrupted = true;
+    
+    pthread_mutex_lock(&m_vp_data_mutex);
+    m_bNeedExit = true;
+    pthread_cond_broadcast(&m_vp_cond);
+    pthread_mutex_unlock(&m_vp_data_mutex);
+    
+    if (_decoder) {
+        _decoder->abortPacketQueues();
+    }
+    
+    // the demux thread joins the decode threads before it ends
+    if (m_bThread) {
+        if (pthread_equal(m_thread, pthread_self())) {
+            pthread_detach(m_thread);
+        } else {
+            pthread_join(m_thread, NULL);
+        }
+        m_bThread = false;
+    }
+    if (m_bVideoThread) {
+        pthread_join(m_videoThread, NULL);
+        m_bVideoThread = false;
+    }
+    if (m_bAudioThread) {
+        pthread_join(m_audioThread, NULL);
+        m_bAudioThread = false;
+    }
+    
+    pthread_mutex_destroy(&m_vp_data_mutex);
+    pthread_cond_destroy(&m_vp_cond);
+    m_inited = false;
+}
+
 #define LOCAL_MIN_BUFFERED_DURATION   0.2
 #define LOCAL_MAX_BUFFERED_DURATION   0.4
 #define NETWORK_MIN_BUFFERED_DURATION 2.0
@@ -112,16 +319,25 @@ CAVideoPlayerController::CAVideoPlayerController()
 , _moviePosition(0)
 , _interrupted(false)
 , _bufferedDuration(0)
+, _bufferedAudioDuration(0)
 , _minBufferedDuration(0)
 , _maxBufferedDuration(0)
+, _decodeRate(0)
 , _currentAudioFrame(NULL)
 , _playing(false)
 , _disableUpdateHUD(false)
-, _tickCorrectionPosition(0)
 , _tickCounter(0)
-, _decoding(false)
+, _serial(0)
+, _seekRequested(false)
+, _seekPosition(0)
+, _videoFinished(false)
+, _audioFinished(false)
+, _presentPending(false)
+, _clockPosition(0)
+, _clockLimit(MAXFLOAT)
+, _clockRunning(false)
 , _artworkFrame(NULL)
-, _buffered(false)
+, _buffered(true)
 , _glView(NULL)
 , _movieDuration(0)
 , _currentAudioFramePos(0)
@@ -130,17 +346,25 @@ CAVideoPlayerController::CAVideoPlayerController()
 , _HUDView(NULL)
 , m_bNeedExit(false)
 , m_inited(false)
+, m_bThread(false)
+, m_bVideoThread(false)
+, m_bAudioThread(false)
 , _activityView(NULL)
 , _playButton(NULL)
 , _playSlider(NULL)
 , _playTime(NULL)
 {
+    _clockTime.tv_sec = 0;
+    _clockTime.tv_usec = 0;
 }
 
 CAVideoPlayerController::~CAVideoPlayerController()
 {
 //    pause();
 
+    // the decoder and its packet queues are used until the threads end
+    this->stopThreads();
+    
     if (_decoder) {
         delete _decoder;
     }
@@ -257,8 +481,10 @@ bool CAVideoPlayerController::setMovieDecoder()
             _maxBufferedDuration = LOCAL_MAX_BUFFERED_DURATION;
         }
         
-        if (!decoder->isValidVideo())
+        if (!decoder->isValidVideo()) {
             _minBufferedDuration *= 10.0; // increase for audio
+            _maxBufferedDuration *= 10.0;
+        }
         
         _decoder = decoder;
         
@@ -283,25 +509,24 @@ void CAVideoPlayerController::didReceiveMemoryWarning()
             this->play();
             
             CCLog("didReceiveMemoryWarning, disable buffering and continue playing");
-            
-        } else {
-            
-            delete _decoder;
-            _decoder = NULL;
         }
         
     } else {
         
+        // the decode threads keep the decoder until the controller goes
         this->freeBufferedFrames();
-        delete _decoder;
-        _decoder = NULL;
     }
 }
 
 void CAVideoPlayerController::freeBufferedFrames()
 {
     pthread_mutex_lock(&m_vp_data_mutex);
-    
+    this->releaseBufferedFrames();
+    pthread_mutex_unlock(&m_vp_data_mutex);
+}
+
+void CAVideoPlayerController::releaseBufferedFrames()
+{
     CAObject* object = NULL;
         
     if (_videoFrames) {
@@ -328,8 +553,10 @@ void CAVideoPlayerController::freeBufferedFrames()
     
     _buffered = true;
     _bufferedDuration = 0;
+    _bufferedAudioDuration = 0;
     
-    pthread_mutex_unlock(&m_vp_data_mutex);
+    // the decode threads wait for room
+    pthread_cond_broadcast(&m_vp_cond);
 }
 
 
@@ -405,15 +632,17 @@ void CAVideoPlayerController::play()
     _playing = true;
     _interrupted = false;
     _disableUpdateHUD = false;
-    _tickCorrectionTime.tv_sec = 0;
-    _tickCorrectionTime.tv_usec = 0;
+    _presentPending = false;
     _tickCounter = 0;
-        
-    asyncDecodeFrames();
+    
+    // after a buffering the clock starts with the first frame, see tick()
+    if (!_buffered) {
+        this->startClock(this->getMasterClock());
+    }
     
     updatePlayButton();
     
-    tick(0);
+    CAScheduler::schedule(schedule_selector(CAVideoPlayerController::tick), this, 0);
     
     if (_decoder->isValidAudio()) {
         enableAudio(true);
@@ -430,7 +659,9 @@ void CAVideoPlayerController::pause()
 
 
     _playing = false;
+    this->stopClock();
     this->enableAudio(false);
+    CAScheduler::unschedule(schedule_selector(CAVideoPlayerController::tick), this);
     updatePlayButton();
 }
 
@@ -444,55 +675,6 @@ void CAVideoPlayerController::enableAudio(bool on)
     SDL_PauseAudio(!on);
 }
 
-void CAVideoPlayerController::asyncDecodeFrames()
-{
-    if (_decoding) {
-        return;
-    }
-    
-    if (!_playing) {
-        return;
-    }
-
-    pthread_mutex_lock(&m_vp_cond_mutex);
-    pthread_cond_signal(&m_vp_cond);
-    pthread_mutex_unlock(&m_vp_cond_mutex);
-
-}
-
-void CAVideoPlayerController::_decodeProcess()
-{
-    if (!_decoder && !setMovieDecoder()) {
-        return;
-    }
-    
-    if (_decoding) {
-        return;
-    }
-    
-    if (!_playing) {
-        return;
-    }
-    
-    float duration = _decoder->getIsNetwork() ? .0f : 0.1f;
-    
-    _decoding = true;
-    
-    bool good = true;
-    
-    while (good) {
-        good = false;
-        if (_decoder && (_decoder->isValidVideo() || _decoder->isValidAudio())) {
-            vector<VPFrame*> frames = _decoder->decodeFrames(duration);
-            if (frames.size()) {
-                good = addFrames(frames);
-            }
-        }
-    }
-    
-    _decoding = false;
-}
-
 void CAVideoPlayerController::updatePlayButton()
 {
     if (isPlaying()) {
@@ -512,139 +694,234 @@ bool CAVideoPlayerController::addFrames(const vector<VPFrame*>& frames)
 {
     pthread_mutex_lock(&m_vp_data_mutex);
     
-    vector<VPFrame*>::iterator obj;
-    
-    if (_decoder->isValidVideo()) {
-        for (int i=0; i<frames.size(); i++) {
-            VPFrame* frame = frames.at(i);
-            if (frame && frame->getType() == kFrameTypeVideo) {
-                _videoFrames->addObject(frame);
+    for (int i=0; i<frames.size(); i++) {
+        
+        VPFrame* frame = frames.at(i);
+        if (!frame) {
+            continue;
+        }
+        
+        // decoded before the last seek
+        if (frame->getSerial() != _serial) {
+            frame->release();
+            continue;
+        }
+        
+        if (frame->getType() == kFrameTypeVideo && _decoder->isValidVideo()) {
+            
+            _videoFrames->addObject(frame);
+            _bufferedDuration += frame->getDuration();
+            
+        } else if (frame->getType() == kFrameTypeAudio && _decoder->isValidAudio()) {
+            
+            _audioFrames->addObject(frame);
+            _bufferedAudioDuration += frame->getDuration();
+            if (!_decoder->isValidVideo()) {
                 _bufferedDuration += frame->getDuration();
             }
+            
+        } else if (frame->getType() == kFrameTypeArtwork && _decoder->isValidAudio() && _decoder->isValidVideo()) {
+            
+            CC_SAFE_RELEASE(_artworkFrame);
+            _artworkFrame = (VPArtworkFrame*)frame;
+            
+        } else if (frame->getType() == kFrameTypeSubtitle && _decoder->isValidSubtitles() && _subtitles) {
+            
+            _subtitles->addObject(frame);
+            
+        } else {
+            
+            frame->release();
         }
     }
     
-    if (_decoder->isValidAudio()) {
+    pthread_mutex_unlock(&m_vp_data_mutex);
+    
+    return _playing && _bufferedDuration < _maxBufferedDuration;
+}
 
-        for (int i=0; i<frames.size(); i++) {
-            VPFrame* frame = frames.at(i);
-            if (frame && frame->getType() == kFrameTypeAudio) {
-                _audioFrames->addObject(frame);
-                if (!_decoder->isValidVideo()) {
-                    _bufferedDuration += frame->getDuration();
-                }
-            }
-            if (frame && _decoder->isValidVideo() && frame->getType() == kFrameTypeArtwork) {
-                _artworkFrame = (VPArtworkFrame*)frame;
-            }
-        }
+void CAVideoPlayerController::updateDecodeRate(float decodedDuration, float elapsed)
+{
+    if (decodedDuration <= 0 || elapsed <= 0) {
+        return;
     }
     
-    if (_decoder->isValidSubtitles()) {
-        
-        for (int i=0; i<frames.size(); i++) {
-            VPFrame* frame = frames.at(i);
-            if (frame && frame->getType() == kFrameTypeSubtitle) {
-                _subtitles->addObject(frame);
-            }
-        }
+    // buffering was disabled by a memory warning
+    if (_maxBufferedDuration <= 0) {
+        return;
     }
     
+    const float rate = decodedDuration / elapsed;
+    _decodeRate = _decodeRate > 0 ? _decodeRate * 0.9f + rate * 0.1f : rate;
+    
+    // a decoder twice as fast as the playback refills quickly and keeps the low limits,
+    // one close to real time buffers up to the high ones to ride over the slow frames
+    const float t = MIN(1.0f, MAX(0.0f, 2.0f - _decodeRate));
+    const float low = _decoder->getIsNetwork() ? NETWORK_MIN_BUFFERED_DURATION : LOCAL_MIN_BUFFERED_DURATION;
+    const float high = _decoder->getIsNetwork() ? NETWORK_MAX_BUFFERED_DURATION : LOCAL_MAX_BUFFERED_DURATION;
+    const float scale = _decoder->isValidVideo() ? 1.0f : 10.0f; // increase for audio
+    
+    _minBufferedDuration = (low + (high - low) * 0.5f * t) * scale;
+    _maxBufferedDuration = (low + (high - low) * (0.5f + 0.5f * t)) * scale;
+}
+
+bool CAVideoPlayerController::isFinished()
+{
+    pthread_mutex_lock(&m_vp_data_mutex);
+    
+    const bool finished = _decoder->isEOF()
+    && (!_decoder->isValidVideo() || _videoFinished)
+    && (!_decoder->isValidAudio() || _audioFinished);
+    
     pthread_mutex_unlock(&m_vp_data_mutex);
     
-    return _playing && _bufferedDuration < _maxBufferedDuration;
+    return finished;
 }
 
-void CAVideoPlayerController::tick(float dt)
+float CAVideoPlayerController::clockAt(const struct timeval& now)
 {
-    if (_buffered && ((_bufferedDuration > _minBufferedDuration) || _decoder->isEOF())) {
-        
-        _tickCorrectionTime.tv_sec = 0;
-        _tickCorrectionTime.tv_usec = 0;
-        _buffered = false;
-        
-        _activityView->stopAnimating();
+    if (!_clockRunning) {
+        return _clockPosition;
     }
     
+    const float clock = _clockPosition
+    + (now.tv_sec - _clockTime.tv_sec) + (now.tv_usec - _clockTime.tv_usec)/1000000.0f;
     
-    float interval = 0;
-    if (!_buffered && _playing)
-        interval = presentFrame();
+    // never ahead of the audio the device has got
+    return MIN(clock, _clockLimit);
+}
+
+float CAVideoPlayerController::getMasterClock()
+{
+    struct timeval now;
+    gettimeofday(&now, 0);
+    
+    pthread_mutex_lock(&m_vp_data_mutex);
+    const float clock = this->clockAt(now);
+    pthread_mutex_unlock(&m_vp_data_mutex);
     
-    if (_playing) {
+    return clock;
+}
+
+void CAVideoPlayerController::startClock(float position)
+{
+    pthread_mutex_lock(&m_vp_data_mutex);
+    gettimeofday(&_clockTime, 0);
+    _clockPosition = position;
+    _clockLimit = MAXFLOAT;
+    _clockRunning = true;
+    pthread_mutex_unlock(&m_vp_data_mutex);
+}
+
+void CAVideoPlayerController::stopClock()
+{
+    struct timeval now;
+    gettimeofday(&now, 0);
+    
+    pthread_mutex_lock(&m_vp_data_mutex);
+    _clockPosition = this->clockAt(now);
+    _clockRunning = false;
+    pthread_mutex_unlock(&m_vp_data_mutex);
+}
+
+void CAVideoPlayerController::tick(float dt)
+{
+    if (!_decoder) {
+        return;
+    }
+    
+    if (!_playing) {
         
-        const unsigned int leftFrames =
-        (_decoder->isValidVideo() ? _videoFrames->count() : 0) +
-        (_decoder->isValidAudio() ? _audioFrames->count() : 0);
+        // a seek while paused shows the first frame decoded at the new position
+        VPVideoFrame *frame = NULL;
         
-        if (0 == leftFrames) {
-            
-            if (_decoder->isEOF()) {
-                
-                pause();
-                updateHUD();
-                return;
-            }
-            
-            if (_minBufferedDuration > 0 && !_buffered) {
-                
-                _buffered = true;
-                
-                _activityView->startAnimating();
-            }
+        pthread_mutex_lock(&m_vp_data_mutex);
+        if (!_decoder->isValidVideo()) {
+            _presentPending = false;
+        } else if (_videoFrames->count() > 0) {
+            frame = (VPVideoFrame*)_videoFrames->objectAtIndex(0);
+            _videoFrames->removeObjectAtIndex(0);
+            _bufferedDuration -= frame->getDuration();
+            pthread_cond_broadcast(&m_vp_cond);
         }
+        pthread_mutex_unlock(&m_vp_data_mutex);
         
-//        if (!leftFrames || !(_bufferedDuration > _minBufferedDuration)) {
-        if (_bufferedDuration < _maxBufferedDuration) {
-            asyncDecodeFrames();
+        if (frame) {
+            presentVideoFrame(frame);
+            frame->release();
+            _presentPending = false;
+            
+            pthread_mutex_lock(&m_vp_data_mutex);
+            _clockPosition = _moviePosition;
+            pthread_mutex_unlock(&m_vp_data_mutex);
         }
         
-        float correction = tickCorrection();
-        float time = MAX(interval + correction, 0.01);
-//        CCLog("%s, %f, %f, %f", __FUNCTION__, time, dt, correction);
-        
-        CAScheduler::schedule(schedule_selector(CAVideoPlayerController::tick), this, time);
+        if (!_presentPending || this->isFinished()) {
+            _presentPending = false;
+            _activityView->stopAnimating();
+            CAScheduler::unschedule(schedule_selector(CAVideoPlayerController::tick), this);
+            _disableUpdateHUD = false;
+            updateHUD();
+        }
+        return;
     }
     
-    if ((_tickCounter++ % 3) == 0) {
-        updateHUD();
-    }
-}
-
-
-float CAVideoPlayerController::tickCorrection()
-{
-    if (_buffered)
-        return 0;
+    const bool finished = this->isFinished();
     
-    struct timeval now;
-    gettimeofday(&now,  0);
+    pthread_mutex_lock(&m_vp_data_mutex);
+    const float bufferedDuration = _bufferedDuration;
+    pthread_mutex_unlock(&m_vp_data_mutex);
     
-    if (!_tickCorrectionTime.tv_sec) {
+    if (_buffered && ((bufferedDuration > _minBufferedDuration) || finished)) {
+        
+        _buffered = false;
+        
+        _activityView->stopAnimating();
+        
+        // the clock goes on from the first frame buffered
+        float position = _moviePosition;
+        
+        pthread_mutex_lock(&m_vp_data_mutex);
+        if (_decoder->isValidVideo() && _videoFrames->count() > 0) {
+            position = ((VPFrame*)_videoFrames->objectAtIndex(0))->getPosition();
+        } else if (_decoder->isValidAudio() && _audioFrames->count() > 0) {
+            position = ((VPFrame*)_audioFrames->objectAtIndex(0))->getPosition();
+        }
+        pthread_mutex_unlock(&m_vp_data_mutex);
         
-        _tickCorrectionTime = now;
-        _tickCorrectionPosition = _moviePosition;
-        return 0;
+        this->startClock(position);
     }
     
-    float dPosition = _moviePosition - _tickCorrectionPosition;
-    float dTime = (now.tv_sec - _tickCorrectionTime.tv_sec) + (now.tv_usec - _tickCorrectionTime.tv_usec)/1000000.0f;
-    float correction = dPosition - dTime;
-    
-//    CCLog("%s, %f", __FUNCTION__, correction);
+    if (!_buffered)
+        presentFrame();
     
-    //if ((_tickCounter % 200) == 0)
-    //    LoggerStream(1, @"tick correction %.4f", correction);
+    pthread_mutex_lock(&m_vp_data_mutex);
+    const unsigned int leftFrames =
+    (_decoder->isValidVideo() ? _videoFrames->count() : 0) +
+    (_decoder->isValidAudio() ? _audioFrames->count() : 0);
+    pthread_mutex_unlock(&m_vp_data_mutex);
     
-    if (correction > 1.f || correction < -1.f) {
+    if (0 == leftFrames) {
+        
+        if (finished) {
+            
+            pause();
+            updateHUD();
+            return;
+        }
         
-        CCLog("tick correction reset %.2f", correction);
-        correction = 0;
-        _tickCorrectionTime.tv_sec = 0;
-        _tickCorrectionTime.tv_usec = 0;
+        if (_minBufferedDuration > 0 && !_buffered) {
+            
+            _buffered = true;
+            this->stopClock();
+            
+            _activityView->startAnimating();
+        }
     }
     
-    return correction;
+    if ((_tickCounter++ % 15) == 0) {
+        updateHUD();
+    }
 }
 
 float CAVideoPlayerController::presentFrame()
@@ -653,15 +930,32 @@ float CAVideoPlayerController::presentFrame()
     
     if (_decoder->isValidVideo()) {
         
+        const float clock = this->getMasterClock();
+        
         VPVideoFrame *frame = NULL;
         
         pthread_mutex_lock(&m_vp_data_mutex);
-                    
-        if (_videoFrames->count() > 0) {
+        
+        // the last frame due is shown and the late ones before it are dropped,
+        // the frame on screen stays up while none is due
+        while (_videoFrames->count() > 0) {
             
-            frame = (VPVideoFrame*)_videoFrames->objectAtIndex(0);
-            _videoFrames->removeObject(frame);
-            _bufferedDuration -= frame->getDuration();
+            VPVideoFrame *next = (VPVideoFrame*)_videoFrames->objectAtIndex(0);
+            if (next->getPosition() > clock) {
+                break;
+            }
+            
+            _videoFrames->removeObjectAtIndex(0);
+            _bufferedDuration -= next->getDuration();
+            
+            if (frame) {
+                frame->release();
+            }
+            frame = next;
+        }
+        
+        if (frame) {
+            pthread_cond_broadcast(&m_vp_cond);
         }
         
         pthread_mutex_unlock(&m_vp_data_mutex);
@@ -672,7 +966,9 @@ float CAVideoPlayerController::presentFrame()
         }
         
     } else if (_decoder->isValidAudio()) {
-        //interval = _bufferedDuration * 0.5;
+        
+        _moviePosition = this->getMasterClock();
+        
         if (_artworkFrame) {
 //                TODO: _imageView
 //                _imageView.image = [self.artworkFrame asImage];
@@ -750,81 +1046,121 @@ void CAVideoPlayerController::presentSubtitles()
 
 void CAVideoPlayerController::audioCallback(unsigned char *stream, int len, int channels)
 {
-    if (_buffered) {
+    CC_UNUSED_PARAM(channels);
+    
+    pthread_mutex_lock(&m_vp_data_mutex);
+    
+    if (_buffered || !_playing) {
         memset(stream, 0, len);
+        pthread_mutex_unlock(&m_vp_data_mutex);
         return;
     }
     
+    struct timeval now;
+    gettimeofday(&now, 0);
+    
+    const float bytesPerSecond = MAX(1, _decoder->getAudioBytesPerSecond());
+    
+    // the device plays the buffer it holds before this one
+    const float latency = len / bytesPerSecond;
+    const float clock = this->clockAt(now) + latency;
+    
+    // the clock follows the audio already, the frames go on back to back
+    const bool synced = _clockLimit < MAXFLOAT;
+    
+    bool written = false;
+    float writtenPosition = 0;
+    float writtenEnd = 0;
+    
     while (len > 0) {
         
-        unsigned int count = _audioFrames->count();
-
         if (!_currentAudioFrame) {
             
-            if (count > 0) {
-                pthread_mutex_lock(&m_vp_data_mutex);
-                VPAudioFrame* frame = (VPAudioFrame*)_audioFrames->objectAtIndex(0);
-                pthread_mutex_unlock(&m_vp_data_mutex);
-
+            if (_audioFrames->count() == 0) {
+                break;
+            }
+            
+            VPAudioFrame* frame = (VPAudioFrame*)_audioFrames->objectAtIndex(0);
+            
+//            CCLog("Audio frame position: %f, %f", clock, frame->getPosition());
+            
+            if (_decoder->isValidVideo() && !synced && !written) {
+                const float delta = clock - frame->getPosition();
                 
-//                CCLog("Audio frame position: %f, %f", _moviePosition, frame->getPosition());
+                // early, silence until the clock gets there
+                if (delta < -0.1) {
+                    break;
+                }
                 
-                if (_decoder->isValidVideo()) {
-                    const float delta = _moviePosition - frame->getPosition();
-                    
-                    if (delta < -0.1) {
-                        memset(stream, 0, len * channels);
-                        break;
-                    }
-                    
-                    pthread_mutex_lock(&m_vp_data_mutex);
-                    _audioFrames->removeObjectAtIndex(0);
-                    pthread_mutex_unlock(&m_vp_data_mutex);
-                    
-                    if (delta > 0.1 && count > 1)
-                    {
-                        continue;
-                    }
-                    
-                } else {
+                // late, skipped
+                if (delta > 0.1 + frame->getDuration() && _audioFrames->count() > 1) {
                     _audioFrames->removeObjectAtIndex(0);
-                    _moviePosition = frame->getPosition();
-                    _bufferedDuration -= frame->getDuration();
+                    _bufferedAudioDuration -= frame->getDuration();
+                    frame->release();
+                    continue;
                 }
-                
-                _currentAudioFramePos = 0;
-                CC_SAFE_RELEASE_NULL(_currentAudioFrame);
-                _currentAudioFrame = frame;
-//                CC_SAFE_RETAIN(_currentAudioFrame);
             }
-        }
-        
-        if (_currentAudioFrame) {
-            unsigned char* bytes = (unsigned char*)(_currentAudioFrame->getData() + _currentAudioFramePos);
-            const unsigned int bytesLeft = _currentAudioFrame->getDataLength() - _currentAudioFramePos;
-            const unsigned int bytesToCopy = MIN(len, bytesLeft);
             
-//            CCLog("%s, copyLen = %d, leftLen = %d, count = %d", __FUNCTION__, bytesToCopy, len - bytesToCopy, count);
-            memcpy(stream, bytes, bytesToCopy);
-            stream += bytesToCopy;
-            len -= bytesToCopy;
-            
-            if (bytesToCopy < bytesLeft) {
-                _currentAudioFramePos += bytesToCopy;
-            } else {
-                CC_SAFE_RELEASE_NULL(_currentAudioFrame);
+            _audioFrames->removeObjectAtIndex(0);
+            _bufferedAudioDuration -= frame->getDuration();
+            if (!_decoder->isValidVideo()) {
+                _bufferedDuration -= frame->getDuration();
             }
+            
+            _currentAudioFramePos = 0;
+            _currentAudioFrame = frame;
+        }
+        
+        unsigned char* bytes = (unsigned char*)(_currentAudioFrame->getData() + _currentAudioFramePos);
+        const unsigned int bytesLeft = _currentAudioFrame->getDataLength() - _currentAudioFramePos;
+        const unsigned int bytesToCopy = MIN(len, bytesLeft);
+        
+        if (!written) {
+            written = true;
+            writtenPosition = _currentAudioFrame->getPosition() + _currentAudioFramePos / bytesPerSecond;
+        }
+        writtenEnd = _currentAudioFrame->getPosition() + (_currentAudioFramePos + bytesToCopy) / bytesPerSecond;
+        
+//        CCLog("%s, copyLen = %d, leftLen = %d", __FUNCTION__, bytesToCopy, len - bytesToCopy);
+        memcpy(stream, bytes, bytesToCopy);
+        stream += bytesToCopy;
+        len -= bytesToCopy;
+        
+        if (bytesToCopy < bytesLeft) {
+            _currentAudioFramePos += bytesToCopy;
         } else {
-            memset(stream, 0, len);
+            CC_SAFE_RELEASE_NULL(_currentAudioFrame);
         }
-    } 
+    }
+    
+    if (len > 0) {
+        memset(stream, 0, len);
+    }
+    
+    if (written) {
+        
+        // the audio is the master clock while there is some
+        _clockPosition = writtenPosition - latency;
+        _clockTime = now;
+        _clockLimit = writtenEnd;
+        
+    } else {
+        
+        // nothing to follow, the clock goes on with the wall time
+        _clockLimit = MAXFLOAT;
+    }
+    
+    // room for the audio decode thread
+    pthread_cond_broadcast(&m_vp_cond);
+    
+    pthread_mutex_unlock(&m_vp_data_mutex);
 }
 
 void CAVideoPlayerController::onCheckExit(float dt)
 {
-    pthread_mutex_lock(&m_vp_cond_mutex);
-    pthread_cond_signal(&m_vp_cond);
-    pthread_mutex_unlock(&m_vp_cond_mutex);
+    pthread_mutex_lock(&m_vp_data_mutex);
+    pthread_cond_broadcast(&m_vp_cond);
+    pthread_mutex_unlock(&m_vp_data_mutex);
 
 }
 
@@ -838,10 +1174,15 @@ void CAVideoPlayerController::onButtonBack(CrossApp::CAControl *control, CrossAp
     
     CCLog("%s, signal", __FUNCTION__);
     
+    pthread_mutex_lock(&m_vp_data_mutex);
     m_bNeedExit = true;
-    pthread_mutex_lock(&m_vp_cond_mutex);
-    pthread_cond_signal(&m_vp_cond);
-    pthread_mutex_unlock(&m_vp_cond_mutex);
+    pthread_cond_broadcast(&m_vp_cond);
+    pthread_mutex_unlock(&m_vp_data_mutex);
+    
+    // wakes the threads waiting for packets
+    if (_decoder) {
+        _decoder->abortPacketQueues();
+    }
 
 
 //    CAScheduler::schedule(schedule_selector(CAVideoPlayerController::onCheckExit), this, 0);
@@ -1041,7 +1382,7 @@ void CAVideoPlayerController::setDecoderPosition(float position)
 
 void CAVideoPlayerController::gotoWantedMoviePosition()
 {
-    if (_decoder && !_decoding) {
+    if (_decoder) {
         CAScheduler::unschedule(schedule_selector(CAVideoPlayerController::gotoWantedMoviePosition), this);
         setMoviePosition(_wantMoviePosition);
         _wantMoviePosition = 0;
@@ -1050,7 +1391,7 @@ void CAVideoPlayerController::gotoWantedMoviePosition()
 
 void CAVideoPlayerController::setMoviePosition(float position)
 {
-    if (!_decoder || _decoding) {
+    if (!_decoder) {
         _wantMoviePosition = position;
         CAScheduler::unschedule(schedule_selector(CAVideoPlayerController::gotoWantedMoviePosition), this);
         CAScheduler::schedule(schedule_selector(CAVideoPlayerController::gotoWantedMoviePosition), this, 0.1f);
@@ -1060,37 +1401,42 @@ void CAVideoPlayerController::setMoviePosition(float position)
     
     bool playing = _playing;
     
-    _playing = false;
-    enableAudio(false);
+    pause();
     updatePosition(position, playing);
 }
 
 void CAVideoPlayerController::updatePosition(float position, bool playing)
 {
-    freeBufferedFrames();
     position = MIN(_decoder->getDuration() - 1, MAX(0, position));
 
     pthread_mutex_lock(&m_vp_data_mutex);
+    
+    this->releaseBufferedFrames();
+    
+    // the demux thread seeks, what was read or decoded before carries an older serial
+    ++_serial;
+    _seekRequested = true;
+    _seekPosition = position;
+    _videoFinished = false;
+    _audioFinished = false;
+    _decoder->flushPacketQueues(_serial);
+    
+    _clockPosition = position;
+    _clockLimit = MAXFLOAT;
+    _clockRunning = false;
+    
+    pthread_cond_broadcast(&m_vp_cond);
+    pthread_mutex_unlock(&m_vp_data_mutex);
+    
+    _moviePosition = position;
+    _activityView->startAnimating();
 
     if (playing) {
-        setDecoderPosition(position);
-        setMoviePositionFromDecoder();
         play();
     } else {
-        setDecoderPosition(position);
-        vector<VPFrame*> frames;
-        if (_decoder->isValidAudio() || _decoder->isValidVideo()) {
-             frames = _decoder->decodeFrames(0);
-        }
-        if (frames.size() > 0) {
-            addFrames(frames);
-        }
-        _disableUpdateHUD = false;
-        setMoviePositionFromDecoder();
-        presentFrame();
-        updateHUD();
+        _presentPending = true;
+        CAScheduler::schedule(schedule_selector(CAVideoPlayerController::tick), this, 0);
     }
-    pthread_mutex_unlock(&m_vp_data_mutex);
 }
 
 void CAVideoPlayerController::dispearHUDView()
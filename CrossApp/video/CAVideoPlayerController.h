@@ -77,15 +77,24 @@ protected:
     float               _wantMoviePosition;
     float               _movieDuration;
     bool                _interrupted;    
-    float               _bufferedDuration;
+    float               _bufferedDuration;          // of the video frames, of the audio frames without video
+    float               _bufferedAudioDuration;
     float               _minBufferedDuration;
     float               _maxBufferedDuration;
+    float               _decodeRate;                // seconds of media decoded per second, averaged
     bool                _playing;
     bool                _disableUpdateHUD;
-    struct timeval      _tickCorrectionTime;
-    float               _tickCorrectionPosition;
     unsigned int        _tickCounter;
-    bool                _decoding;
+    unsigned int        _serial;                    // serial of the frames wanted, changes with every seek
+    bool                _seekRequested;
+    float               _seekPosition;
+    bool                _videoFinished;
+    bool                _audioFinished;
+    bool                _presentPending;            // a seek while paused waits for its first frame
+    float               _clockPosition;             // the presentation clock was at _clockPosition at _clockTime
+    struct timeval      _clockTime;
+    float               _clockLimit;                // end of the audio given to the device
+    bool                _clockRunning;
     VPArtworkFrame      *_artworkFrame;
     bool                _buffered;
     string              _path;
@@ -108,17 +117,22 @@ protected:
     bool interruptDecoder();
     bool setMovieDecoder();
     void freeBufferedFrames();
+    void releaseBufferedFrames();
     void enableAudio(bool on);
     void updatePlayButton();
-    void asyncDecodeFrames();
     void tick(float dt);
-    float tickCorrection();
+    bool isFinished();
+    float getMasterClock();
+    float clockAt(const struct timeval& now);
+    void startClock(float position);
+    void stopClock();
+    void updateDecodeRate(float decodedDuration, float elapsed);
     bool addFrames(const vector<VPFrame*>& frames);
     float presentFrame();
     float presentVideoFrame(VPVideoFrame* frame);
     void presentSubtitles();
     void audioCallback(unsigned char *stream, int len, int channels);
-    void _decodeProcess();
+    void demuxPackets();
     
     void setMoviePositionFromDecoder();
     void setDecoderPosition(float position);
@@ -148,15 +162,22 @@ protected:
 private: // THREAD
     bool            m_inited;
     bool            m_bNeedExit;
-    pthread_t       m_thread;
+    pthread_t       m_thread;               // demux, opens the decoder first
+    pthread_t       m_videoThread;
+    pthread_t       m_audioThread;
+    bool            m_bThread;
+    bool            m_bVideoThread;
+    bool            m_bAudioThread;
     pthread_mutex_t m_vp_data_mutex;
-    pthread_mutex_t m_vp_cond_mutex;
-    pthread_cond_t  m_vp_cond;
+    pthread_cond_t  m_vp_cond;              // with m_vp_data_mutex: room in the buffers, seek, exit
     
     void lazyInit();
+    void stopThreads();
     
 public:
     void lazyProcess();
+    void videoProcess();
+    void audioProcess();
 };
 
 NS_CC_END
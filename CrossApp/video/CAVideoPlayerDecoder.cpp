@@ -26,6 +26,9 @@ extern "C" {
 #include "libavutil/pixdesc.h"
 }
 
+#define LOCAL_MAX_QUEUED_PACKETS      256
+#define NETWORK_MAX_QUEUED_PACKETS    1024
+
 #pragma mark - static
 
 static void FFLog(void* context, int level, const char* pszFormat, va_list args) {
@@ -232,23 +235,6 @@ static std::vector<int> collectStreams(AVFormatContext *formatCtx, enum AVMediaT
     return ret;
 }
 
-static void copyFrameData(unsigned char *src, unsigned char **dst, int linesize, int width, int height, int *dstLength)
-{
-    if (dst) {
-        width = MIN(linesize, width);
-        *dst = (unsigned char*)malloc(width * height);
-        if (dstLength) {
-            *dstLength = width * height;
-        }
-        unsigned char* tmp = *dst;
-        for (int i=0; i<height; ++i) {
-            memcpy(tmp, src, width);
-            tmp += width;
-            src += linesize;
-        }
-    }
-}
-
 static bool isNetworkPath (std::string path)
 {
     std::size_t found = path.find(":");
@@ -283,6 +269,7 @@ VPFrame::VPFrame()
 : m_duration(0)
 , m_position(0)
 , m_type(kFrameTypeVideo)
+, m_serial(0)
 {
 
 }
@@ -345,32 +332,235 @@ CAImage* VPVideoFrameRGB::asImage()
     return NULL;
 }
 
+#pragma mark - VPVideoFramePool
+
+VPVideoFramePool::VPVideoFramePool()
+{
+    m_vFrames.reserve(16);
+}
+
+VPVideoFramePool::~VPVideoFramePool()
+{
+    std::vector<AVFrame*>::iterator itr;
+    for (itr=m_vFrames.begin(); itr!=m_vFrames.end(); itr++)
+    {
+        av_frame_free(&(*itr));
+    }
+}
+
+AVFrame* VPVideoFramePool::dequeueFrame()
+{
+    {
+        CAAutoLock lock(m_obLock);
+        
+        if (!m_vFrames.empty())
+        {
+            AVFrame* frame = m_vFrames.back();
+            m_vFrames.pop_back();
+            return frame;
+        }
+    }
+    
+    return av_frame_alloc();
+}
+
+void VPVideoFramePool::enqueueFrame(AVFrame* frame)
+{
+    CC_RETURN_IF(frame == NULL);
+    
+    // the pixel buffers go back to the codec here
+    av_frame_unref(frame);
+    
+    CAAutoLock lock(m_obLock);
+    m_vFrames.push_back(frame);
+}
+
+#pragma mark - VPPacketQueue
+
+VPPacketQueue::VPPacketQueue()
+: m_pPackets(NULL)
+, m_pSerials(NULL)
+, m_uCapacity(0)
+, m_uHead(0)
+, m_uCount(0)
+, m_uSerial(0)
+, m_bAborted(false)
+{
+    pthread_mutex_init(&m_tMutex, NULL);
+    pthread_cond_init(&m_tCond, NULL);
+}
+
+VPPacketQueue::~VPPacketQueue()
+{
+    this->clear();
+    
+    delete [] m_pPackets;
+    delete [] m_pSerials;
+    
+    pthread_cond_destroy(&m_tCond);
+    pthread_mutex_destroy(&m_tMutex);
+}
+
+void VPPacketQueue::setCapacity(unsigned int capacity)
+{
+    pthread_mutex_lock(&m_tMutex);
+    
+    this->clear();
+    
+    delete [] m_pPackets;
+    delete [] m_pSerials;
+    
+    m_uCapacity = MAX(1, capacity);
+    m_pPackets = new AVPacket[m_uCapacity];
+    m_pSerials = new unsigned int[m_uCapacity];
+    
+    pthread_mutex_unlock(&m_tMutex);
+}
+
+bool VPPacketQueue::push(AVPacket* packet, unsigned int serial)
+{
+    // the queued packet must own its data, the demuxer reuses its buffers
+    if (packet->data && av_dup_packet(packet) < 0) {
+        av_free_packet(packet);
+        return false;
+    }
+    
+    pthread_mutex_lock(&m_tMutex);
+    
+    while (!m_bAborted && serial == m_uSerial && m_uCount == m_uCapacity) {
+        pthread_cond_wait(&m_tCond, &m_tMutex);
+    }
+    
+    if (m_bAborted || serial != m_uSerial) {
+        
+        bool aborted = m_bAborted;
+        pthread_mutex_unlock(&m_tMutex);
+        
+        av_free_packet(packet);
+        return !aborted;
+    }
+    
+    unsigned int tail = (m_uHead + m_uCount) % m_uCapacity;
+    m_pPackets[tail] = *packet;
+    m_pSerials[tail] = serial;
+    ++m_uCount;
+    
+    pthread_cond_broadcast(&m_tCond);
+    pthread_mutex_unlock(&m_tMutex);
+    
+    return true;
+}
+
+bool VPPacketQueue::pop(AVPacket* packet, unsigned int* serial)
+{
+    pthread_mutex_lock(&m_tMutex);
+    
+    while (!m_bAborted && m_uCount == 0) {
+        pthread_cond_wait(&m_tCond, &m_tMutex);
+    }
+    
+    if (m_bAborted) {
+        pthread_mutex_unlock(&m_tMutex);
+        return false;
+    }
+    
+    *packet = m_pPackets[m_uHead];
+    if (serial) {
+        *serial = m_pSerials[m_uHead];
+    }
+    m_uHead = (m_uHead + 1) % m_uCapacity;
+    --m_uCount;
+    
+    pthread_cond_broadcast(&m_tCond);
+    pthread_mutex_unlock(&m_tMutex);
+    
+    return true;
+}
+
+void VPPacketQueue::flush(unsigned int serial)
+{
+    pthread_mutex_lock(&m_tMutex);
+    
+    this->clear();
+    m_uSerial = serial;
+    
+    pthread_cond_broadcast(&m_tCond);
+    pthread_mutex_unlock(&m_tMutex);
+}
+
+void VPPacketQueue::abort()
+{
+    pthread_mutex_lock(&m_tMutex);
+    
+    m_bAborted = true;
+    
+    pthread_cond_broadcast(&m_tCond);
+    pthread_mutex_unlock(&m_tMutex);
+}
+
+void VPPacketQueue::clear()
+{
+    for (unsigned int i=0; i<m_uCount; ++i) {
+        av_free_packet(&m_pPackets[(m_uHead + i) % m_uCapacity]);
+    }
+    m_uHead = 0;
+    m_uCount = 0;
+}
+
 #pragma mark - VPVideoFrameYUV
 
 VPVideoFrameYUV::VPVideoFrameYUV()
 : m_chromaB(NULL)
-, m_chromaBLength(0)
+, m_chromaBLineSize(0)
 , m_chromaR(NULL)
-, m_chromaRLength(0)
+, m_chromaRLineSize(0)
 , m_luma(NULL)
-, m_lumaLength(0)
+, m_lumaLineSize(0)
+, m_pAVFrame(NULL)
+, m_pFramePool(NULL)
 {
     m_format = kVideoFrameFormatYUV;
 }
 
 VPVideoFrameYUV::~VPVideoFrameYUV()
 {
-    if (m_luma) {
-        delete [] m_luma;
-    }
+    this->releaseAVFrame();
+}
+
+void VPVideoFrameYUV::setAVFrame(AVFrame* frame, VPVideoFramePool* pool)
+{
+    CC_SAFE_RETAIN(pool);
+    this->releaseAVFrame();
     
-    if (m_chromaB) {
-        delete [] m_chromaB;
-    }
+    m_pAVFrame = frame;
+    m_pFramePool = pool;
     
-    if (m_chromaR) {
-        delete [] m_chromaR;
+    m_luma = (char*)frame->data[0];
+    m_lumaLineSize = frame->linesize[0];
+    m_chromaB = (char*)frame->data[1];
+    m_chromaBLineSize = frame->linesize[1];
+    m_chromaR = (char*)frame->data[2];
+    m_chromaRLineSize = frame->linesize[2];
+}
+
+void VPVideoFrameYUV::releaseAVFrame()
+{
+    if (m_pAVFrame)
+    {
+        if (m_pFramePool)
+        {
+            m_pFramePool->enqueueFrame(m_pAVFrame);
+        }
+        else
+        {
+            av_frame_free(&m_pAVFrame);
+        }
+        m_pAVFrame = NULL;
     }
+    CC_SAFE_RELEASE_NULL(m_pFramePool);
+    
+    m_luma = m_chromaB = m_chromaR = NULL;
+    m_lumaLineSize = m_chromaBLineSize = m_chromaRLineSize = 0;
 }
 
 #pragma mark - VPArtworkFrame
@@ -416,6 +606,7 @@ VPDecoder::VPDecoder()
 , _audioCodecCtx(NULL)
 , _subtitleCodecCtx(NULL)
 , _videoFrame(NULL)
+, _videoFramePool(NULL)
 , _audioFrame(NULL)
 , _videoStream(0)
 , _audioStream(0)
@@ -436,6 +627,8 @@ VPDecoder::VPDecoder()
 , _isEOF(false)
 , _path(std::string(""))
 , _fps(0)
+, _videoPacketSerial(0)
+, _audioPacketSerial(0)
 , m_pInterruptTarget(NULL)
 , m_interruptCallback(NULL)
 , m_audioCallback(NULL)
@@ -506,6 +699,11 @@ float VPDecoder::getSampleRate()
     return _audioCodecCtx ? _audioCodecCtx->sample_rate : 0;
 }
 
+unsigned int VPDecoder::getAudioBytesPerSecond()
+{
+    return _audioCodecCtx ? s_audioSpec.freq * s_audioSpec.channels * av_get_bytes_per_sample(AV_SAMPLE_FMT_S16) : 0;
+}
+
 unsigned int VPDecoder::getAudioStreamsCount()
 {
     return _audioStreams.size();
@@ -755,6 +953,10 @@ bool VPDecoder::openFile(const std::string& path, std::string& perror)
     
     _path = path;
     
+    // a network stream queues more packets to ride over the throughput of the network
+    _videoPackets.setCapacity(_isNetwork ? NETWORK_MAX_QUEUED_PACKETS : LOCAL_MAX_QUEUED_PACKETS);
+    _audioPackets.setCapacity(_isNetwork ? NETWORK_MAX_QUEUED_PACKETS : LOCAL_MAX_QUEUED_PACKETS);
+    
     VPError errCode = openInput(path);
     
     if (errCode == kErrorNone) {
@@ -860,6 +1062,14 @@ VPError VPDecoder::openVideoStream(int videoStream)
     //if(codec->capabilities & CODEC_CAP_TRUNCATED)
     //    _codecCtx->flags |= CODEC_FLAG_TRUNCATED;
     
+    // the decoded pictures are handed to the renderer without copying, they must
+    // stay valid after the next decode call
+    codecCtx->refcounted_frames = 1;
+    
+    // frame and slice threads, thread_count 0 lets the codec use one per core
+    codecCtx->thread_count = 0;
+    codecCtx->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+    
     // open codec
     if (avcodec_open2(codecCtx, codec, NULL) < 0)
         return kErrorOpenCodec;
@@ -871,6 +1081,8 @@ VPError VPDecoder::openVideoStream(int videoStream)
         return kErrorAllocateFrame;
     }
     
+    _videoFramePool = new VPVideoFramePool();
+    
     _videoStream = videoStream;
     _videoCodecCtx = codecCtx;
     
@@ -1107,10 +1319,13 @@ void VPDecoder::closeVideoStream()
     
     if (_videoFrame) {
         
-        av_free(_videoFrame);
+        av_frame_free(&_videoFrame);
         _videoFrame = NULL;
     }
     
+    // frames still on screen keep the pool until they are released
+    CC_SAFE_RELEASE_NULL(_videoFramePool);
+    
     if (_videoCodecCtx) {
         
         avcodec_close(_videoCodecCtx);
@@ -1203,38 +1418,21 @@ VPVideoFrame* VPDecoder::handleVideoFrame()
         return NULL;
     
     VPVideoFrame *frame;
+    AVFrame *avFrame = _videoFrame;
     
     if (_videoFrameFormat == kVideoFrameFormatYUV) {
         
+        avFrame = _videoFramePool->dequeueFrame();
+        if (!avFrame) {
+            return NULL;
+        }
+        
+        // the planes are not copied, the decoded picture moves to a pooled AVFrame
+        av_frame_move_ref(avFrame, _videoFrame);
+        
         VPVideoFrameYUV * yuvFrame = new VPVideoFrameYUV();
+        yuvFrame->setAVFrame(avFrame, _videoFramePool);
         
-        unsigned char* data = NULL;
-        int dataLength = 0;
-        
-        copyFrameData(_videoFrame->data[0], &data,
-                      _videoFrame->linesize[0],
-                      _videoCodecCtx->width,
-                      _videoCodecCtx->height,
-                      &dataLength);
-        yuvFrame->setLuma((char*)data);
-        yuvFrame->setLumaLength(dataLength);
-
-        copyFrameData(_videoFrame->data[1], &data,
-                      _videoFrame->linesize[1],
-                      _videoCodecCtx->width / 2,
-                      _videoCodecCtx->height / 2,
-                      &dataLength);
-        yuvFrame->setChromaB((char*)data);
-        yuvFrame->setChromaBLength(dataLength);
-
-        copyFrameData(_videoFrame->data[2], &data,
-                      _videoFrame->linesize[2],
-                      _videoCodecCtx->width / 2,
-                      _videoCodecCtx->height / 2,
-                      &dataLength);
-        yuvFrame->setChromaR((char*)data);
-        yuvFrame->setChromaRLength(dataLength);
-
         frame = yuvFrame;
         
     } else {
@@ -1263,13 +1461,13 @@ VPVideoFrame* VPDecoder::handleVideoFrame()
     
     frame->setWidth(_videoCodecCtx->width);
     frame->setHeight(_videoCodecCtx->height);
-    frame->setPosition(av_frame_get_best_effort_timestamp(_videoFrame) * _videoTimeBase);
+    frame->setPosition(av_frame_get_best_effort_timestamp(avFrame) * _videoTimeBase);
     
-    const long long frameDuration = av_frame_get_pkt_duration(_videoFrame);
+    const long long frameDuration = av_frame_get_pkt_duration(avFrame);
     if (frameDuration) {
         
         frame->setDuration(frameDuration * _videoTimeBase);
-        frame->setDuration(frame->getDuration() + _videoFrame->repeat_pict * _videoTimeBase * 0.5);
+        frame->setDuration(frame->getDuration() + avFrame->repeat_pict * _videoTimeBase * 0.5);
         
         //if (_videoFrame->repeat_pict > 0) {
         //    CCLog("_videoFrame.repeat_pict %d", _videoFrame->repeat_pict);
@@ -1286,7 +1484,7 @@ VPVideoFrame* VPDecoder::handleVideoFrame()
     CCLog("VFD: %.4f %.4f | %lld ", 
           frame->getPosition(), 
           frame->getDuration(), 
-          av_frame_get_pkt_pos(_videoFrame));
+          av_frame_get_pkt_pos(avFrame));
 #endif
     
     return frame;
@@ -1491,141 +1689,328 @@ std::vector<VPFrame*> VPDecoder::decodeFrames(float minDuration)
         
         if (packet.stream_index == _videoStream) {
             
-            int pktSize = packet.size;
+            decodedDuration += this->decodeVideoPacket(&packet, result);
+            if (decodedDuration > minDuration)
+                finished = true;
             
-            while (pktSize > 0) {
-                
-                int gotframe = 0;
-                int len = avcodec_decode_video2(_videoCodecCtx,
-                                                _videoFrame,
-                                                &gotframe,
-                                                &packet);
-                
-                if (len < 0) {
-                    CCLog("decode video error, skip packet");
-                    break;
-                }
-                
-                if (gotframe) {
-                    
-                    if (!_disableDeinterlacing &&
-                        _videoFrame->interlaced_frame) {
-                        
-                        avpicture_deinterlace((AVPicture*)_videoFrame,
-                                              (AVPicture*)_videoFrame,
-                                              _videoCodecCtx->pix_fmt,
-                                              _videoCodecCtx->width,
-                                              _videoCodecCtx->height);
-                    }
-                    
-                    VPVideoFrame *frame = this->handleVideoFrame();
-                    if (frame) {
-                        
-                        result.push_back((VPFrame*)frame);
-                        
-                        _position = frame->getPosition();
-                        decodedDuration += frame->getDuration();
-                        if (decodedDuration > minDuration)
-                            finished = true;
-                    }
-                }
-                
-                if (0 == len)
-                    break;
+        } else if (packet.stream_index == _audioStream) {
+            
+            const float duration = this->decodeAudioPacket(&packet, result);
+            if (_videoStream == -1) {
                 
-                pktSize -= len;
+                decodedDuration += duration;
+                if (decodedDuration > minDuration)
+                    finished = true;
             }
             
-        } else if (packet.stream_index == _audioStream) {
+        } else {
             
-            int pktSize = packet.size;
+            this->decodeOtherPacket(&packet, result);
+        }
+        
+        av_free_packet(&packet);
+    }
+    
+    return result;
+}
+
+bool VPDecoder::demuxPacket(unsigned int serial, std::vector<VPFrame*>& frames)
+{
+    if (!_formatCtx || _isEOF) {
+        return false;
+    }
+    
+    AVPacket packet;
+    
+    if (av_read_frame(_formatCtx, &packet) < 0) {
+        
+        _isEOF = true;
+        
+        // an empty packet makes the decode stages drain the frames still held by their codecs
+        if (_videoStream != -1) {
+            av_init_packet(&packet);
+            packet.data = NULL;
+            packet.size = 0;
+            _videoPackets.push(&packet, serial);
+        }
+        
+        if (_audioStream != -1) {
+            av_init_packet(&packet);
+            packet.data = NULL;
+            packet.size = 0;
+            _audioPackets.push(&packet, serial);
+        }
+        
+        return false;
+    }
+    
+    if (packet.stream_index == _videoStream) {
+        
+        _videoPackets.push(&packet, serial);
+        
+    } else if (packet.stream_index == _audioStream) {
+        
+        _audioPackets.push(&packet, serial);
+        
+    } else {
+        
+        std::vector<VPFrame*>::size_type first = frames.size();
+        this->decodeOtherPacket(&packet, frames);
+        for (std::vector<VPFrame*>::size_type i=first; i<frames.size(); ++i) {
+            frames[i]->setSerial(serial);
+        }
+        
+        av_free_packet(&packet);
+    }
+    
+    return true;
+}
+
+bool VPDecoder::decodeVideoPackets(std::vector<VPFrame*>& frames, unsigned int& serial, bool& finished)
+{
+    AVPacket packet;
+    
+    if (!_videoPackets.pop(&packet, &serial)) {
+        return false;
+    }
+    
+    if (serial != _videoPacketSerial) {
+        
+        // first packet after a seek, the pictures decoded before are dropped
+        avcodec_flush_buffers(_videoCodecCtx);
+        _videoPacketSerial = serial;
+    }
+    
+    std::vector<VPFrame*>::size_type first = frames.size();
+    this->decodeVideoPacket(&packet, frames);
+    for (std::vector<VPFrame*>::size_type i=first; i<frames.size(); ++i) {
+        frames[i]->setSerial(serial);
+    }
+    
+    finished = (packet.data == NULL);
+    
+    av_free_packet(&packet);
+    
+    return true;
+}
+
+bool VPDecoder::decodeAudioPackets(std::vector<VPFrame*>& frames, unsigned int& serial, bool& finished)
+{
+    AVPacket packet;
+    
+    if (!_audioPackets.pop(&packet, &serial)) {
+        return false;
+    }
+    
+    if (serial != _audioPacketSerial) {
+        
+        avcodec_flush_buffers(_audioCodecCtx);
+        _audioPacketSerial = serial;
+    }
+    
+    std::vector<VPFrame*>::size_type first = frames.size();
+    this->decodeAudioPacket(&packet, frames);
+    for (std::vector<VPFrame*>::size_type i=first; i<frames.size(); ++i) {
+        frames[i]->setSerial(serial);
+    }
+    
+    finished = (packet.data == NULL);
+    
+    av_free_packet(&packet);
+    
+    return true;
+}
+
+void VPDecoder::seekStreams(float seconds)
+{
+    _position = seconds;
+    _isEOF = false;
+    
+    if (_videoStream != -1) {
+        long long ts = (long long)(seconds / _videoTimeBase);
+        avformat_seek_file(_formatCtx, _videoStream, ts, ts, ts, AVSEEK_FLAG_FRAME);
+    } else if (_audioStream != -1) {
+        long long ts = (long long)(seconds / _audioTimeBase);
+        avformat_seek_file(_formatCtx, _audioStream, ts, ts, ts, AVSEEK_FLAG_FRAME);
+    }
+}
+
+void VPDecoder::flushPacketQueues(unsigned int serial)
+{
+    _videoPackets.flush(serial);
+    _audioPackets.flush(serial);
+}
+
+void VPDecoder::abortPacketQueues()
+{
+    _videoPackets.abort();
+    _audioPackets.abort();
+}
+
+float VPDecoder::decodeVideoPacket(AVPacket* packet, std::vector<VPFrame*>& frames)
+{
+    float decodedDuration = 0;
+    
+    // an empty packet drains the pictures held back by the codec (frame threads, reordering)
+    const bool draining = (packet->size == 0);
+    
+    AVPacket pkt = *packet;
+    
+    while (pkt.size > 0 || draining) {
+        
+        int gotframe = 0;
+        int len = avcodec_decode_video2(_videoCodecCtx,
+                                        _videoFrame,
+                                        &gotframe,
+                                        &pkt);
+        
+        if (len < 0) {
+            CCLog("decode video error, skip packet");
+            break;
+        }
+        
+        if (gotframe) {
             
-            while (pktSize > 0) {
-                
-                int gotframe = 0;
-                int len = avcodec_decode_audio4(_audioCodecCtx,
-                                                _audioFrame,                                                
-                                                &gotframe,
-                                                &packet);
-                
-                if (len < 0) {
-                    CCLog("decode audio error, skip packet");
-                    break;
-                }
+            if (!_disableDeinterlacing &&
+                _videoFrame->interlaced_frame &&
+                av_frame_make_writable(_videoFrame) == 0) {
                 
-                if (gotframe) {
-                    
-                    VPAudioFrame *frame = this->handleAudioFrame();
-                    if (frame) {
-                        
-                        result.push_back((VPFrame*)frame);
-                        
-                        if (_videoStream == -1) {
-                            
-                            _position = frame->getPosition();
-                            decodedDuration += frame->getDuration();
-                            if (decodedDuration > minDuration)
-                                finished = true;
-                        }
-                    }
-                }
-                
-                if (0 == len)
-                    break;
-                
-                pktSize -= len;
+                // the decoder may still reference the picture, it is copied before being changed
+                avpicture_deinterlace((AVPicture*)_videoFrame,
+                                      (AVPicture*)_videoFrame,
+                                      _videoCodecCtx->pix_fmt,
+                                      _videoCodecCtx->width,
+                                      _videoCodecCtx->height);
             }
             
-        } else if (packet.stream_index == _artworkStream) {
+            VPVideoFrame *frame = this->handleVideoFrame();
             
-            if (packet.size) {
+            // a YUV frame took the reference already
+            av_frame_unref(_videoFrame);
+            
+            if (frame) {
+                
+                frames.push_back((VPFrame*)frame);
                 
-                VPArtworkFrame *frame = new VPArtworkFrame();
-                char* data = (char*)malloc(packet.size);
-                memcpy(data, packet.data, packet.size);
-                frame->setData(data);
-                frame->setDataLength(packet.size);
-                result.push_back((VPFrame*)frame);
+                _position = frame->getPosition();
+                decodedDuration += frame->getDuration();
             }
             
-        } else if (packet.stream_index == _subtitleStream) {
-            
-            int pktSize = packet.size;
+        } else if (draining) {
+            break;
+        }
+        
+        if (draining)
+            continue;
+        
+        if (0 == len)
+            break;
+        
+        pkt.data += len;
+        pkt.size -= len;
+    }
+    
+    return decodedDuration;
+}
+
+float VPDecoder::decodeAudioPacket(AVPacket* packet, std::vector<VPFrame*>& frames)
+{
+    float decodedDuration = 0;
+    
+    const bool draining = (packet->size == 0);
+    
+    AVPacket pkt = *packet;
+    
+    while (pkt.size > 0 || draining) {
+        
+        int gotframe = 0;
+        int len = avcodec_decode_audio4(_audioCodecCtx,
+                                        _audioFrame,
+                                        &gotframe,
+                                        &pkt);
+        
+        if (len < 0) {
+            CCLog("decode audio error, skip packet");
+            break;
+        }
+        
+        if (gotframe) {
             
-            while (pktSize > 0) {
-                
-                AVSubtitle subtitle;
-                int gotsubtitle = 0;
-                int len = avcodec_decode_subtitle2(_subtitleCodecCtx,
-                                                   &subtitle,
-                                                   &gotsubtitle,
-                                                   &packet);
+            VPAudioFrame *frame = this->handleAudioFrame();
+            if (frame) {
                 
-                if (len < 0) {
-                    CCLog("decode subtitle error, skip packet");
-                    break;
-                }
+                frames.push_back((VPFrame*)frame);
                 
-                if (gotsubtitle) {
-                    
-                    VPSubtitleFrame *frame = this->handleSubtitle(&subtitle);
-                    if (frame) {
-                        result.push_back((VPFrame*)frame);
-                    }
-                    avsubtitle_free(&subtitle);
+                if (_videoStream == -1) {
+                    _position = frame->getPosition();
                 }
-                
-                if (0 == len)
-                    break;
-                
-                pktSize -= len;
+                decodedDuration += frame->getDuration();
             }
+            
+        } else if (draining) {
+            break;
         }
         
-        av_free_packet(&packet);
+        if (draining)
+            continue;
+        
+        if (0 == len)
+            break;
+        
+        pkt.data += len;
+        pkt.size -= len;
     }
     
-    return result;
+    return decodedDuration;
+}
+
+void VPDecoder::decodeOtherPacket(AVPacket* packet, std::vector<VPFrame*>& frames)
+{
+    if (packet->stream_index == _artworkStream) {
+        
+        if (packet->size) {
+            
+            VPArtworkFrame *frame = new VPArtworkFrame();
+            char* data = (char*)malloc(packet->size);
+            memcpy(data, packet->data, packet->size);
+            frame->setData(data);
+            frame->setDataLength(packet->size);
+            frames.push_back((VPFrame*)frame);
+        }
+        
+    } else if (packet->stream_index == _subtitleStream) {
+        
+        int pktSize = packet->size;
+        
+        while (pktSize > 0) {
+            
+            AVSubtitle subtitle;
+            int gotsubtitle = 0;
+            int len = avcodec_decode_subtitle2(_subtitleCodecCtx,
+                                               &subtitle,
+                                               &gotsubtitle,
+                                               packet);
+            
+            if (len < 0) {
+                CCLog("decode subtitle error, skip packet");
+                break;
+            }
+            
+            if (gotsubtitle) {
+                
+                VPSubtitleFrame *frame = this->handleSubtitle(&subtitle);
+                if (frame) {
+                    frames.push_back((VPFrame*)frame);
+                }
+                avsubtitle_free(&subtitle);
+            }
+            
+            if (0 == len)
+                break;
+            
+            pktSize -= len;
+        }
+    }
 }
 
 #pragma mark - VPSubtitleASSParser
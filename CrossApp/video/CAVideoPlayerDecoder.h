@@ -13,6 +13,7 @@
 #include <vector>
 
 #include "basics/CAObject.h"
+#include "basics/CASyncQueue.h"
 #include "cocoa/CCArray.h"
 #include "cocoa/CCDictionary.h"
 #include "images/CAImage.h"
@@ -23,6 +24,7 @@ extern "C" {
     struct AVFormatContext;
     struct AVCodecContext;
     struct AVFrame;
+    struct AVPacket;
     struct AVPicture;
     struct SwrContext;
     struct AVSubtitle;
@@ -71,6 +73,7 @@ public:
     CC_SYNTHESIZE_PASS_BY_REF(VPFrameType, m_type, Type)
     CC_SYNTHESIZE_PASS_BY_REF(float, m_position, Position)
     CC_SYNTHESIZE_PASS_BY_REF(float, m_duration, Duration)
+    CC_SYNTHESIZE_PASS_BY_REF(unsigned int, m_serial, Serial) // serial of the packet queue it was decoded from
 };
 
 class VPAudioFrame : public VPFrame
@@ -108,19 +111,49 @@ public:
     CAImage* asImage();
 };
 
+// Recycles the AVFrame structures of the decoded pictures, the pixel buffers they reference
+// are recycled by the buffer pool of the codec. Shared by the decoder thread and the frames
+// released on the main thread.
+class VPVideoFramePool : public CAObject {
+    
+public:
+    VPVideoFramePool();
+    ~VPVideoFramePool();
+    
+    // an empty AVFrame, allocated only when none is waiting for reuse
+    AVFrame* dequeueFrame();
+    
+    // drops the buffers referenced by frame and keeps it for the next dequeueFrame()
+    void enqueueFrame(AVFrame* frame);
+    
+private:
+    std::vector<AVFrame*> m_vFrames;
+    CALock m_obLock;
+};
+
 class VPVideoFrameYUV : public VPVideoFrame {
     
 public:
     VPVideoFrameYUV();
     ~VPVideoFrameYUV();
     
-    CC_SYNTHESIZE(char*, m_luma, Luma)
-    CC_SYNTHESIZE_PASS_BY_REF(unsigned int, m_lumaLength, LumaLength)
-    CC_SYNTHESIZE(char*, m_chromaB, ChromaB)
-    CC_SYNTHESIZE_PASS_BY_REF(unsigned int, m_chromaBLength, ChromaBLength)
-    CC_SYNTHESIZE(char*, m_chromaR, ChromaR)
-    CC_SYNTHESIZE_PASS_BY_REF(unsigned int, m_chromaRLength, ChromaRLength)
+    // references the planes of frame without copying them, frame goes back to pool
+    // (or is freed without a pool) when this video frame is deleted
+    void setAVFrame(AVFrame* frame, VPVideoFramePool* pool);
+    
+    // rows of the planes are LineSize bytes apart, which may be more than their width
+    CC_SYNTHESIZE_READONLY(char*, m_luma, Luma)
+    CC_SYNTHESIZE_READONLY_PASS_BY_REF(unsigned int, m_lumaLineSize, LumaLineSize)
+    CC_SYNTHESIZE_READONLY(char*, m_chromaB, ChromaB)
+    CC_SYNTHESIZE_READONLY_PASS_BY_REF(unsigned int, m_chromaBLineSize, ChromaBLineSize)
+    CC_SYNTHESIZE_READONLY(char*, m_chromaR, ChromaR)
+    CC_SYNTHESIZE_READONLY_PASS_BY_REF(unsigned int, m_chromaRLineSize, ChromaRLineSize)
+    
+private:
+    void releaseAVFrame();
     
+    AVFrame* m_pAVFrame;
+    VPVideoFramePool* m_pFramePool;
 };
 
 class VPArtworkFrame : public VPFrame {
@@ -144,6 +177,42 @@ public:
     CC_SYNTHESIZE_PASS_BY_REF(std::string, m_text, Text);
 };
 
+// Bounded ring of the demuxed packets of one stream, between the demux thread and the decode
+// thread of the stream. The packet slots are allocated once, push() blocks while the ring is
+// full and pop() while it is empty, until abort().
+class VPPacketQueue {
+    
+public:
+    VPPacketQueue();
+    ~VPPacketQueue();
+    
+    void setCapacity(unsigned int capacity);
+    
+    // takes the packet, which is dropped when it was read under an older serial than the queue's
+    bool push(AVPacket* packet, unsigned int serial);
+    
+    // false once the queue is aborted
+    bool pop(AVPacket* packet, unsigned int* serial);
+    
+    // drops the queued packets, only the packets read under serial are queued from now on
+    void flush(unsigned int serial);
+    
+    void abort();
+    
+private:
+    void clear();
+    
+    AVPacket*       m_pPackets;
+    unsigned int*   m_pSerials;
+    unsigned int    m_uCapacity;
+    unsigned int    m_uHead;
+    unsigned int    m_uCount;
+    unsigned int    m_uSerial;
+    bool            m_bAborted;
+    pthread_mutex_t m_tMutex;
+    pthread_cond_t  m_tCond;
+};
+
 typedef bool (CAObject::*SEL_DecoderInterruptCallback)();
 #define decoder_selector(_SELECTOR) (SEL_DecoderInterruptCallback)(&_SELECTOR)
 
@@ -170,6 +239,25 @@ public:
     
     std::vector<VPFrame*> decodeFrames(float minDuration); // VPFrame
     
+    // Pipelined decoding, not to be mixed with decodeFrames(): demuxPacket() runs on one thread
+    // and feeds a packet queue per stream, decodeVideoPackets() and decodeAudioPackets() run on
+    // a thread each. The frames carry the serial the packets were read under.
+    
+    // reads one packet, artwork and subtitles come out as frames directly. At the end of the
+    // file the decode stages are told to drain their codecs and false is returned
+    bool demuxPacket(unsigned int serial, std::vector<VPFrame*>& frames);
+    
+    // decode the next packet of the stream, waiting for it. finished is set once the codec
+    // is drained at the end of the file. false when the packet queues are aborted
+    bool decodeVideoPackets(std::vector<VPFrame*>& frames, unsigned int& serial, bool& finished);
+    bool decodeAudioPackets(std::vector<VPFrame*>& frames, unsigned int& serial, bool& finished);
+    
+    // seeks the demuxer, the codecs are flushed by the decode stages when the serial changes
+    void seekStreams(float seconds);
+    void flushPacketQueues(unsigned int serial);
+    void abortPacketQueues();
+    
+
     bool interruputDecoder();
     
     void onAudioCallback(unsigned char *stream, int len);
@@ -200,6 +288,7 @@ public:
     float getPosition();
     void setPosition(float seconds);
     float getSampleRate();
+    unsigned int getAudioBytesPerSecond();
     unsigned int getFrameWidth();
     unsigned int getFrameHeight();
     unsigned int getAudioStreamsCount();
@@ -227,6 +316,7 @@ private:
     AVCodecContext      *_audioCodecCtx;
     AVCodecContext      *_subtitleCodecCtx;
     AVFrame             *_videoFrame;
+    VPVideoFramePool    *_videoFramePool;
     AVFrame             *_audioFrame;
     int                 _videoStream;
     int                 _audioStream;
@@ -252,6 +342,10 @@ private:
     bool                _isEOF;
     std::string         _path;
     float               _fps;
+    VPPacketQueue       _videoPackets;
+    VPPacketQueue       _audioPackets;
+    unsigned int        _videoPacketSerial;
+    unsigned int        _audioPacketSerial;
     
 private:
     VPError openInput(std::string path);
@@ -265,6 +359,9 @@ private:
     void closeSubtitleStream();
     void closeScaler();
     bool setupScaler();
+    float decodeVideoPacket(AVPacket* packet, std::vector<VPFrame*>& frames);
+    float decodeAudioPacket(AVPacket* packet, std::vector<VPFrame*>& frames);
+    void decodeOtherPacket(AVPacket* packet, std::vector<VPFrame*>& frames);
     VPVideoFrame* handleVideoFrame();
     VPAudioFrame* handleAudioFrame();
     VPSubtitleFrame* handleSubtitle(AVSubtitle *pSubtitle);
@@ -233,12 +233,90 @@ static void mat4f_LoadOrtho(float left, float right, float bottom, float top, fl
     mout[15] = 1.0f;
 }
 
+#pragma mark - Texture Upload
+
+// GL_UNPACK_ROW_LENGTH lets the planes be uploaded with the padding of their lines, it is core
+// on desktop GL and GLES 3, GLES 2 needs GL_EXT_unpack_subimage
+#if defined(GL_UNPACK_ROW_LENGTH)
+#define VP_UNPACK_ROW_LENGTH GL_UNPACK_ROW_LENGTH
+#elif defined(GL_UNPACK_ROW_LENGTH_EXT)
+#define VP_UNPACK_ROW_LENGTH GL_UNPACK_ROW_LENGTH_EXT
+#define VP_UNPACK_ROW_LENGTH_EXTENSION "GL_EXT_unpack_subimage"
+#endif
+
+#ifdef VP_UNPACK_ROW_LENGTH
+static bool supportsUnpackRowLength()
+{
+#ifdef VP_UNPACK_ROW_LENGTH_EXTENSION
+    static int s_iSupported = -1;
+    if (s_iSupported < 0)
+    {
+        const char* extensions = (const char*)glGetString(GL_EXTENSIONS);
+        s_iSupported = (extensions && strstr(extensions, VP_UNPACK_ROW_LENGTH_EXTENSION)) ? 1 : 0;
+    }
+    return s_iSupported == 1;
+#else
+    return true;
+#endif
+}
+#endif
+
+static void createTexture(GLuint texture, GLenum format, unsigned int width, unsigned int height)
+{
+    glBindTexture(GL_TEXTURE_2D, texture);
+    
+    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, NULL);
+    
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+}
+
+// Replaces the pixels of the bound texture by a plane of height rows, lineSize bytes apart
+static void uploadPlane(GLenum format, unsigned int bytesPerPixel, const char* pixels,
+                        unsigned int lineSize, unsigned int width, unsigned int height,
+                        std::vector<char>& packBuffer)
+{
+    const unsigned int rowSize = width * bytesPerPixel;
+    
+    if (lineSize != rowSize)
+    {
+#ifdef VP_UNPACK_ROW_LENGTH
+        if (supportsUnpackRowLength() && lineSize % bytesPerPixel == 0)
+        {
+            glPixelStorei(VP_UNPACK_ROW_LENGTH, lineSize / bytesPerPixel);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format, GL_UNSIGNED_BYTE, pixels);
+            glPixelStorei(VP_UNPACK_ROW_LENGTH, 0);
+            return;
+        }
+#endif
+        if (packBuffer.size() < rowSize * height)
+        {
+            packBuffer.resize(rowSize * height);
+        }
+        
+        char* dst = &packBuffer[0];
+        for (unsigned int i=0; i<height; ++i)
+        {
+            memcpy(dst, pixels, rowSize);
+            dst += rowSize;
+            pixels += lineSize;
+        }
+        pixels = &packBuffer[0];
+    }
+    
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format, GL_UNSIGNED_BYTE, pixels);
+}
+
 #pragma mark - Frame Render
 
 
 VPFrameRenderRGB::VPFrameRenderRGB()
 {
     _texture = 0;
+    _textureWidth = 0;
+    _textureHeight = 0;
     _uniformSampler = 0;
     _key = "CAVideoPlayerRenderRGB";
 }
@@ -246,7 +324,7 @@ VPFrameRenderRGB::VPFrameRenderRGB()
 VPFrameRenderRGB::~VPFrameRenderRGB()
 {
     if (_texture) {
-        glDeleteTextures(1, &_texture);
+        ccGLDeleteTexture(_texture);
         _texture = 0;
     }
 }
@@ -270,29 +348,32 @@ void VPFrameRenderRGB::setFrame(VPVideoFrame* frame)
 {
     VPVideoFrameRGB *rgbFrame = (VPVideoFrameRGB *)frame;
     
-    CCAssert((rgbFrame->getDataLength() == rgbFrame->getWidth() * rgbFrame->getHeight() * 3), "");
+    CCAssert((rgbFrame->getDataLength() == rgbFrame->getLineSize() * rgbFrame->getHeight()), "");
     
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    const unsigned int frameWidth = frame->getWidth();
+    const unsigned int frameHeight = frame->getHeight();
     
-    if (0 == _texture)
+    // the texture is allocated once, the frames only replace its pixels
+    if (0 == _texture || frameWidth != _textureWidth || frameHeight != _textureHeight) {
+        
+        if (_texture) {
+            ccGLDeleteTexture(_texture);
+        }
         glGenTextures(1, &_texture);
+        
+        ccGLBindTexture2D(_texture);
+        glActiveTexture(GL_TEXTURE0);
+        createTexture(_texture, GL_RGB, frameWidth, frameHeight);
+        
+        _textureWidth = frameWidth;
+        _textureHeight = frameHeight;
+    }
     
-    glBindTexture(GL_TEXTURE_2D, _texture);
-    
-    glTexImage2D(GL_TEXTURE_2D,
-                 0,
-                 GL_RGB,
-                 frame->getWidth(),
-                 frame->getHeight(),
-                 0,
-                 GL_RGB,
-                 GL_UNSIGNED_BYTE,
-                 rgbFrame->getData());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
     
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    ccGLBindTexture2D(_texture);
+    glActiveTexture(GL_TEXTURE0);
+    uploadPlane(GL_RGB, 3, rgbFrame->getData(), rgbFrame->getLineSize(), frameWidth, frameHeight, _packBuffer);
 }
 
 bool VPFrameRenderRGB::prepareRender()
@@ -301,8 +382,7 @@ bool VPFrameRenderRGB::prepareRender()
         return false;
     }
     
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, _texture);
+    ccGLBindTexture2D(_texture);
     glUniform1i(_uniformSampler, 0);
     
     return true;
@@ -316,22 +396,64 @@ const char* VPFrameRenderRGB::key()
 VPFrameRenderYUV::VPFrameRenderYUV()
 {
     for (int i=0; i<3; i++) {
-        _textures[i] = 0;
+        _textures[0][i] = 0;
+        _textures[1][i] = 0;
         _uniformSamplers[i] = 0;
     }
+    _textureIndex = 0;
+    _textureWidth = 0;
+    _textureHeight = 0;
     
     _key = "CAVideoPlayerRenderYUV";
 }
 
 VPFrameRenderYUV::~VPFrameRenderYUV()
 {
-    if (_textures[0])
-        glDeleteTextures(3, _textures);
+    this->deleteTextures();
+}
+
+void VPFrameRenderYUV::setupTextures(unsigned int width, unsigned int height)
+{
+    this->deleteTextures();
+    
+    glGenTextures(6, &_textures[0][0]);
+    
+    const unsigned int widths[3]  = { width, (width + 1) / 2, (width + 1) / 2 };
+    const unsigned int heights[3] = { height, (height + 1) / 2, (height + 1) / 2 };
+    
+    for (int i = 0; i < 3; ++i) {
+        
+        ccGLBindTexture2DN(i, _textures[0][i]);
+        glActiveTexture(GL_TEXTURE0 + i);
+        createTexture(_textures[0][i], GL_LUMINANCE, widths[i], heights[i]);
+        
+        ccGLBindTexture2DN(i, _textures[1][i]);
+        glActiveTexture(GL_TEXTURE0 + i);
+        createTexture(_textures[1][i], GL_LUMINANCE, widths[i], heights[i]);
+    }
+    glActiveTexture(GL_TEXTURE0);
+    
+    _textureIndex = 0;
+    _textureWidth = width;
+    _textureHeight = height;
+}
+
+void VPFrameRenderYUV::deleteTextures()
+{
+    if (_textures[0][0] == 0)
+        return;
+    
+    for (int i = 0; i < 3; ++i) {
+        ccGLDeleteTextureN(i, _textures[0][i]);
+        ccGLDeleteTextureN(i, _textures[1][i]);
+        _textures[0][i] = 0;
+        _textures[1][i] = 0;
+    }
 }
 
 bool VPFrameRenderYUV::isValid()
 {
-    return (_textures[0] != 0);
+    return (_textures[0][0] != 0);
 }
 
 const char* VPFrameRenderYUV::fragmentShader()
@@ -350,53 +472,42 @@ void VPFrameRenderYUV::setFrame(VPVideoFrame* frame)
 {
     VPVideoFrameYUV *yuvFrame = (VPVideoFrameYUV *)frame;
     
-    CCAssert((yuvFrame->getLumaLength() == yuvFrame->getWidth() * yuvFrame->getHeight()), "");
-    CCAssert((yuvFrame->getChromaBLength() == (yuvFrame->getWidth() * yuvFrame->getHeight())/4), "");
-    CCAssert((yuvFrame->getChromaRLength() == (yuvFrame->getWidth() * yuvFrame->getHeight())/4), "");
-    
     const unsigned int frameWidth = frame->getWidth();
     const unsigned int frameHeight = frame->getHeight();
     
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    // the textures are allocated once, the frames only replace their pixels
+    if (0 == _textures[0][0] || frameWidth != _textureWidth || frameHeight != _textureHeight)
+        this->setupTextures(frameWidth, frameHeight);
     
-    if (0 == _textures[0])
-        glGenTextures(3, _textures);
+    // the other set may still be read by the draw of the previous frame
+    _textureIndex = 1 - _textureIndex;
     
     const char *pixels[3] = { yuvFrame->getLuma(), yuvFrame->getChromaB(), yuvFrame->getChromaR() };
-    const unsigned int widths[3]  = { frameWidth, frameWidth / 2, frameWidth / 2 };
-    const unsigned int heights[3] = { frameHeight, frameHeight / 2, frameHeight / 2 };
+    const unsigned int lineSizes[3] = { yuvFrame->getLumaLineSize(), yuvFrame->getChromaBLineSize(), yuvFrame->getChromaRLineSize() };
+    const unsigned int widths[3]  = { frameWidth, (frameWidth + 1) / 2, (frameWidth + 1) / 2 };
+    const unsigned int heights[3] = { frameHeight, (frameHeight + 1) / 2, (frameHeight + 1) / 2 };
+    
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
     
     for (int i = 0; i < 3; ++i) {
         
-        glBindTexture(GL_TEXTURE_2D, _textures[i]);
-        
-        glTexImage2D(GL_TEXTURE_2D,
-                     0,
-                     GL_LUMINANCE,
-                     widths[i],
-                     heights[i],
-                     0,
-                     GL_LUMINANCE,
-                     GL_UNSIGNED_BYTE,
-                     pixels[i]);
-        
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        ccGLBindTexture2DN(i, _textures[_textureIndex][i]);
+        glActiveTexture(GL_TEXTURE0 + i);
+        uploadPlane(GL_LUMINANCE, 1, pixels[i], lineSizes[i], widths[i], heights[i], _packBuffer);
     }
+    glActiveTexture(GL_TEXTURE0);
 }
 
 bool VPFrameRenderYUV::prepareRender()
 {
-    if (_textures[0] == 0)
+    if (_textures[0][0] == 0)
         return false;
     
     for (int i = 0; i < 3; ++i) {
-        glActiveTexture(GL_TEXTURE0 + i);
-        glBindTexture(GL_TEXTURE_2D, _textures[i]);
+        ccGLBindTexture2DN(i, _textures[_textureIndex][i]);
         glUniform1i(_uniformSamplers[i], i);
     }
+    glActiveTexture(GL_TEXTURE0);
     
     return true;
 }
@@ -411,6 +522,7 @@ VPFrameRender::VPFrameRender()
     _program = 0;
     _renderBufer = 0;
     _uniformMatrix = 0;
+    _uploadedFrame = NULL;
     
     _vertices[0] = -1.0f;  // x0
     _vertices[1] = -1.0f;  // y0
@@ -424,6 +536,8 @@ VPFrameRender::VPFrameRender()
 
 VPFrameRender::~VPFrameRender()
 {
+    CC_SAFE_RELEASE_NULL(_uploadedFrame);
+    
     if (_program) {
         glDeleteProgram(_program);
         _program = 0;
@@ -554,12 +668,18 @@ void VPFrameRender::draw(VPVideoFrame *frame, long offset)
 //    ccGLUseProgram(_program);
 //    glUseProgram(_program);
     
-    if (frame) {
-        setFrame(frame);
-    } else {
+    if (!frame) {
         return;
     }
     
+    // the view draws every frame of the app, a video frame is uploaded only once
+    if (frame != _uploadedFrame) {
+        setFrame(frame);
+        CC_SAFE_RETAIN(frame);
+        CC_SAFE_RELEASE(_uploadedFrame);
+        _uploadedFrame = frame;
+    }
+    
     if (prepareRender()) {
         
     #define kQuadSize sizeof(ccV3F_C4B_T2F)
@@ -11,6 +11,7 @@
 
 #include <stdio.h>
 #include <string>
+#include <vector>
 #include "basics/CAObject.h"
 #include "basics/CAGeometry.h"
 #include "CCGL.h"
@@ -48,12 +49,20 @@ protected:
     GLuint _renderBufer;
     
     std::string _key;
+    
+    // last frame given to setFrame(), retained so that a new frame never shares its address
+    VPVideoFrame* _uploadedFrame;
+    
+    // rows of the frames packed together when GL cannot skip the padding of the lines
+    std::vector<char> _packBuffer;
 };
 
 class VPFrameRenderRGB : public VPFrameRender {
     
     GLint _uniformSampler;
     GLuint _texture;
+    unsigned int _textureWidth;
+    unsigned int _textureHeight;
 
 public:
     VPFrameRenderRGB();
@@ -70,7 +79,13 @@ public:
 class VPFrameRenderYUV : public VPFrameRender {
     
     GLint _uniformSamplers[3];
-    GLuint _textures[3];
+    GLuint _textures[2][3];         // two sets of Y, U and V planes, filled one after the other
+    unsigned int _textureIndex;     // set drawn by prepareRender()
+    unsigned int _textureWidth;
+    unsigned int _textureHeight;
+    
+    void setupTextures(unsigned int width, unsigned int height);
+    void deleteTextures();
     
 public:
     VPFrameRenderYUV();
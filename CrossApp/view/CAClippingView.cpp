@@ -4,6 +4,7 @@
 #include "kazmath/GL/matrix.h"
 #include "shaders/CAGLProgram.h"
 #include "shaders/CAShaderCache.h"
+#include "shaders/CARenderQueue.h"
 #include "basics/CAApplication.h"
 #include "support/CCPointExtension.h"
 #include "draw_nodes/CCDrawingPrimitives.h"
@@ -174,6 +175,9 @@ void CAClippingView::visit()
     // mask of all layers less than or equal to the current (ie: for layer 3: 00000111)
     GLint mask_layer_le = mask_layer | mask_layer_l;
     
+    // the queued quads must not be affected by the stencil state
+    CARenderQueue::sharedRenderQueue()->flush();
+    
     // manually save the stencil state
     GLboolean currentStencilEnabled = GL_FALSE;
     GLuint currentStencilWriteMask = ~0;
@@ -281,9 +285,15 @@ void CAClippingView::visit()
     // (according to the stencil test func/op and alpha (or alpha shader) test)
     kmGLPushMatrix();
     transform();
+    // the stencil is not a subview, the transform of the visit does not apply to it
+    pauseVisitCulling();
     m_pStencil->visit();
+    resumeVisitCulling();
     kmGLPopMatrix();
     
+    // the stencil quads are drawn with the stencil func above
+    CARenderQueue::sharedRenderQueue()->flush();
+    
     // restore alpha test state
     if (m_fAlphaThreshold < 1)
     {
@@ -320,6 +330,8 @@ void CAClippingView::visit()
     // draw (according to the stencil test func) this node and its childs
     CAView::visit();
     
+    CARenderQueue::sharedRenderQueue()->flush();
+    
     ///////////////////////////////////
     // CLEANUP
     
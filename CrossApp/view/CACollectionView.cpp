@@ -1,11 +1,14 @@
 #include "CACollectionView.h"
 #include "basics/CAApplication.h"
+#include "basics/CAScheduler.h"
 #include "control/CAButton.h"
+#include "view/CAImageView.h"
 #include "support/CCPointExtension.h"
 #include "dispatcher/CATouch.h"
 #include "animation/CAViewAnimation.h"
 #include "actions/CCActionInterval.h"
 #include "actions/CCActionInstant.h"
+#include <algorithm>
 
 NS_CC_BEGIN
 
@@ -25,12 +28,20 @@ CACollectionView::CACollectionView()
 , m_nVertInterval(0)
 , m_bAlwaysTopSectionHeader(true)
 , m_bAlwaysBottomSectionFooter(true)
+, m_nSections(0)
+, m_nUpdatesCount(0)
+, m_nFirstUpdatedItem(0xffffffff)
+, m_nPrefetchedFirstRow(1)
+, m_nPrefetchedLastRow(0)
 {
 }
 
 
 CACollectionView::~CACollectionView()
 {
+	CAScheduler::unschedule(schedule_selector(CACollectionView::prewarmCollectionCell), this);
+	this->clearData();
+	m_pFreedCollectionCells.clear();
 	CC_SAFE_RELEASE_NULL(m_pCollectionHeaderView);
 	CC_SAFE_RELEASE_NULL(m_pCollectionFooterView);
 	m_pCollectionViewDataSource = NULL;
@@ -112,7 +123,7 @@ void CACollectionView::setAllowsSelection(bool var)
 	std::set<CAIndexPath3E>::iterator itr;
 	for (itr = m_pSelectedCollectionCells.begin(); itr != m_pSelectedCollectionCells.end(); itr++)
 	{
-		if (CACollectionViewCell* cell = m_pUsedCollectionCells[(*itr)])
+		if (CACollectionViewCell* cell = this->cellForRowAtIndexPath(itr->section, itr->row, itr->item))
 		{
 			cell->setControlState(CAControlStateNormal);
 		}
@@ -127,7 +138,7 @@ void CACollectionView::setAllowsMultipleSelection(bool var)
 	std::set<CAIndexPath3E>::iterator itr;
 	for (itr = m_pSelectedCollectionCells.begin(); itr != m_pSelectedCollectionCells.end(); itr++)
 	{
-		if (CACollectionViewCell* cell = m_pUsedCollectionCells[(*itr)])
+		if (CACollectionViewCell* cell = this->cellForRowAtIndexPath(itr->section, itr->row, itr->item))
 		{
 			cell->setControlState(CAControlStateNormal);
 		}
@@ -137,14 +148,14 @@ void CACollectionView::setAllowsMultipleSelection(bool var)
 
 void CACollectionView::setSelectRowAtIndexPath(unsigned int section, unsigned int row, unsigned int item)
 {
-	CC_RETURN_IF(section >= m_rSectionRects.size());
+	CC_RETURN_IF(section >= m_nSections);
 
 	if (!m_pSelectedCollectionCells.empty() && m_bAllowsMultipleSelection == false)
 	{
 		std::set<CAIndexPath3E>::iterator itr;
 		for (itr = m_pSelectedCollectionCells.begin(); itr != m_pSelectedCollectionCells.end(); itr++)
 		{
-			if (CACollectionViewCell* cell = m_pUsedCollectionCells[(*itr)])
+			if (CACollectionViewCell* cell = this->cellForRowAtIndexPath(itr->section, itr->row, itr->item))
 			{
 				cell->setControlState(CAControlStateNormal);
 			}
@@ -153,7 +164,7 @@ void CACollectionView::setSelectRowAtIndexPath(unsigned int section, unsigned in
 	}
 
 	CAIndexPath3E indexPath = CAIndexPath3E(section, row, item);
-	if (CACollectionViewCell* cell = m_pUsedCollectionCells.at(indexPath))
+	if (CACollectionViewCell* cell = this->cellForRowAtIndexPath(section, row, item))
 	{
 		cell->setControlStateSelected();
 	}
@@ -162,11 +173,11 @@ void CACollectionView::setSelectRowAtIndexPath(unsigned int section, unsigned in
 
 void CACollectionView::setUnSelectRowAtIndexPath(unsigned int section, unsigned int row, unsigned int item)
 {
-	CC_RETURN_IF(section >= m_rSectionRects.size());
+	CC_RETURN_IF(section >= m_nSections);
     
 	CAIndexPath3E indexPath = CAIndexPath3E(section, row, item);
     CC_RETURN_IF(m_pSelectedCollectionCells.find(indexPath) == m_pSelectedCollectionCells.end());
-	if (CACollectionViewCell* cell = m_pUsedCollectionCells.at(indexPath))
+	if (CACollectionViewCell* cell = this->cellForRowAtIndexPath(section, row, item))
 	{
 		cell->setControlStateNormal();
 	}
@@ -188,10 +199,10 @@ bool CACollectionView::ccTouchBegan(CATouch *pTouch, CAEvent *pEvent)
 	{
 		CCPoint point = m_pContainer->convertTouchToNodeSpace(pTouch);
 
-		std::map<CAIndexPath3E, CACollectionViewCell*>::iterator itr;
-		for (itr = m_pUsedCollectionCells.begin(); itr != m_pUsedCollectionCells.end(); ++itr)
+		std::vector<CACollectionViewCell*>::iterator itr;
+		for (itr = m_vUsedCollectionCells.begin(); itr != m_vUsedCollectionCells.end(); ++itr)
 		{
-			CACollectionViewCell* pCell = itr->second;
+			CACollectionViewCell* pCell = *itr;
 			CC_CONTINUE_IF(pCell == NULL);
 
 			if (pCell->getFrame().containsPoint(point) && pCell->isVisible())
@@ -267,7 +278,7 @@ void CACollectionView::ccTouchEnded(CATouch *pTouch, CAEvent *pEvent)
 
 		if (deselectedIndexPath != CAIndexPath3EZero)
 		{
-			if (CACollectionViewCell* cell = m_pUsedCollectionCells[deselectedIndexPath])
+			if (CACollectionViewCell* cell = this->cellForRowAtIndexPath(deselectedIndexPath.section, deselectedIndexPath.row, deselectedIndexPath.item))
 			{
 				cell->setControlStateNormal();
 			}
@@ -280,7 +291,7 @@ void CACollectionView::ccTouchEnded(CATouch *pTouch, CAEvent *pEvent)
 
 		if (selectedIndexPath != CAIndexPath3EZero)
 		{
-			if (CACollectionViewCell* cell = m_pUsedCollectionCells[selectedIndexPath])
+			if (CACollectionViewCell* cell = this->cellForRowAtIndexPath(selectedIndexPath.section, selectedIndexPath.row, selectedIndexPath.item))
 			{
 				cell->setControlStateSelected();
 			}
@@ -325,19 +336,122 @@ CACollectionViewCell* CACollectionView::dequeueReusableCellWithIdentifier(const
 	return cell;
 }
 
-void CACollectionView::reloadViewSizeData()
+void CACollectionView::setReusableCellsLimit(const std::string& reuseIdentifier, unsigned int limit)
+{
+	if (limit == 0)
+	{
+		m_mReusableCellsLimits.erase(reuseIdentifier);
+		return;
+	}
+    
+	m_mReusableCellsLimits[reuseIdentifier] = limit;
+    
+	CAVector<CACollectionViewCell*>& freedCells = m_pFreedCollectionCells[reuseIdentifier];
+	while (freedCells.size() > limit)
+	{
+		freedCells.popBack();
+	}
+}
+
+void CACollectionView::prewarmReusableCells(const std::string& reuseIdentifier, unsigned int count)
+{
+	unsigned int size = (unsigned int)m_pFreedCollectionCells[reuseIdentifier].size();
+	CC_RETURN_IF(size >= count);
+    
+	m_mPrewarmCounts[reuseIdentifier] = count - size;
+	if (!CAScheduler::isScheduled(schedule_selector(CACollectionView::prewarmCollectionCell), this))
+	{
+		CAScheduler::schedule(schedule_selector(CACollectionView::prewarmCollectionCell), this, 0);
+	}
+}
+
+void CACollectionView::trimReusableCells(unsigned int count)
+{
+	std::map<std::string, CAVector<CACollectionViewCell*> >::iterator itr;
+	for (itr = m_pFreedCollectionCells.begin(); itr != m_pFreedCollectionCells.end(); itr++)
+	{
+		while (itr->second.size() > count)
+		{
+			itr->second.popBack();
+		}
+	}
+	m_mPrewarmCounts.clear();
+}
+
+void CACollectionView::prewarmCollectionCell(float dt)
 {
-    m_rUsedCollectionCellRects.clear();
+	CC_UNUSED_PARAM(dt);
+	
+	// the frames of a scroll are left to the cells in view
+	CC_RETURN_IF(m_bTracking || m_bDecelerating);
     
-	m_pUsedCollectionCells.clear();
-	m_rUsedCollectionCellRects.clear();
+	while (!m_mPrewarmCounts.empty())
+	{
+		std::map<std::string, unsigned int>::iterator itr = m_mPrewarmCounts.begin();
+		std::map<std::string, unsigned int>::iterator itrLimit = m_mReusableCellsLimits.find(itr->first);
+		if (itr->second == 0 || m_pCollectionViewDataSource == NULL
+			|| (itrLimit != m_mReusableCellsLimits.end() && m_pFreedCollectionCells[itr->first].size() >= itrLimit->second))
+		{
+			m_mPrewarmCounts.erase(itr);
+			continue;
+		}
+        
+		CACollectionViewCell* cell = m_pCollectionViewDataSource->collectionCellWithReuseIdentifier(this, itr->first);
+		if (cell == NULL)
+		{
+			m_mPrewarmCounts.erase(itr);
+			continue;
+		}
+        
+		// one cell per frame
+		m_pFreedCollectionCells[cell->getReuseIdentifier()].pushBack(cell);
+		--itr->second;
+		return;
+	}
     
+	CAScheduler::unschedule(schedule_selector(CACollectionView::prewarmCollectionCell), this);
+}
+
+CACollectionViewCell* CACollectionView::cellForRowAtIndexPath(unsigned int section, unsigned int row, unsigned int item)
+{
+	CAIndexPath3E indexPath = CAIndexPath3E(section, row, item);
+	unsigned int index = this->getUsedCellIndex(indexPath);
+	if (index < m_vUsedCollectionCells.size() && this->getIndexPathOfCell(m_vUsedCollectionCells[index]) == indexPath)
+	{
+		return m_vUsedCollectionCells[index];
+	}
+	return NULL;
+}
+
+void CACollectionView::clearData()
+{
+	for (size_t i = 0; i < m_vUsedCollectionCells.size(); i++)
+	{
+		this->recycleCollectionCell(m_vUsedCollectionCells[i]);
+	}
+	m_vUsedCollectionCells.clear();
 	m_pSelectedCollectionCells.clear();
     
+	m_pSectionHeaderViews.clear();
 	m_pSectionFooterViews.clear();
-	m_pSectionFooterViews.clear();
-	m_rSectionRects.clear();
     
+	m_nSections = 0;
+	m_nRowsInSections.clear();
+	m_nSectionHeights.clear();
+	m_nSectionHeaderHeights.clear();
+	m_nSectionFooterHeights.clear();
+	m_nRowHeightss.clear();
+	m_nItemsInRowss.clear();
+	m_obItemHeights.clear();
+	m_nSectionItemStarts.clear();
+	m_nFirstUpdatedItem = 0xffffffff;
+	m_nPrefetchedFirstRow = 1;
+	m_nPrefetchedLastRow = 0;
+}
+
+void CACollectionView::reloadViewSizeData()
+{
+	this->clearData();
     
     m_nSections = m_pCollectionViewDataSource->numberOfSections(this);
     m_nRowsInSections.resize(m_nSections);
@@ -362,34 +476,49 @@ void CACollectionView::reloadViewSizeData()
     }
     
     m_nRowHeightss.resize(m_nSections);
+    m_nItemsInRowss.resize(m_nSections);
     for (unsigned int i=0; i<m_nSections; i++)
     {
         std::vector<unsigned int> rowHeights(m_nRowsInSections.at(i));
+        std::vector<unsigned int> itemsInRows(m_nRowsInSections.at(i));
         for (unsigned int j=0; j<m_nRowsInSections.at(i); j++)
         {
             unsigned int rowHeight = m_pCollectionViewDataSource->collectionViewHeightForRowAtIndexPath(this, i, j);
             rowHeights[j] = rowHeight;
+            itemsInRows[j] = m_pCollectionViewDataSource->numberOfItemsInRowsInSection(this, i, j);
         }
         m_nRowHeightss[i] = rowHeights;
+        m_nItemsInRowss[i] = itemsInRows;
     }
     
     unsigned int viewHeight = 0;
     
+    // every section lays out its header, its rows (both followed by the vertical interval) and its footer
+    std::vector<unsigned int> itemHeights;
+    m_nSectionItemStarts.resize(m_nSections + 1);
     m_nSectionHeights.resize(m_nSections);
     for (unsigned int i=0; i<m_nSections; i++)
     {
+        m_nSectionItemStarts[i] = (unsigned int)itemHeights.size();
+        
         unsigned int sectionHeight = 0;
         sectionHeight += m_nSectionHeaderHeights.at(i);
-        sectionHeight += m_nSectionFooterHeights.at(i);
         sectionHeight += m_nVertInterval;
+        itemHeights.push_back(sectionHeight);
         for (unsigned int j=0; j<m_nRowHeightss.at(i).size(); j++)
         {
-            sectionHeight += m_nRowHeightss.at(i).at(j);
-            sectionHeight += m_nVertInterval;
+            unsigned int rowHeight = m_nRowHeightss.at(i).at(j) + m_nVertInterval;
+            sectionHeight += rowHeight;
+            itemHeights.push_back(rowHeight);
         }
+        sectionHeight += m_nSectionFooterHeights.at(i);
+        itemHeights.push_back(m_nSectionFooterHeights.at(i));
+        
         m_nSectionHeights[i] = sectionHeight;
         viewHeight += sectionHeight;
     }
+    m_nSectionItemStarts[m_nSections] = (unsigned int)itemHeights.size();
+    m_obItemHeights.assign(itemHeights);
     
     viewHeight += m_nCollectionHeaderHeight;
     viewHeight += m_nCollectionFooterHeight;
@@ -397,7 +526,6 @@ void CACollectionView::reloadViewSizeData()
     CCSize size = this->getBounds().size;
     size.height = viewHeight;
     this->setViewSize(size);
-
 }
 
 void CACollectionView::reloadData()
@@ -409,107 +537,48 @@ void CACollectionView::reloadData()
     
 	this->removeAllSubviews();
     
-	CCRect winRect = this->getBounds();
-	winRect.origin = getContentOffset();
-	float width = winRect.size.width;
-	int y = 0;
+	float width = this->getBounds().size.width;
     
 	if (m_nCollectionHeaderHeight > 0 && m_pCollectionHeaderView)
 	{
 		m_pCollectionHeaderView->setDisplayRange(true);
-		m_pCollectionHeaderView->setFrame(CCRect(0, y, width, m_nCollectionHeaderHeight));
 		addSubview(m_pCollectionHeaderView);
-		y += m_nCollectionHeaderHeight;
 	}
     
-;
-    int begin = m_rSectionRects.size();
-    m_rSectionRects.resize(m_rSectionRects.size() + m_nSections);
-	for (int i = 0; i < m_nSections; i++)
+	for (unsigned int i = 0; i < m_nSections; i++)
 	{
 		unsigned int iSectionHeaderHeight = m_nSectionHeaderHeights.at(i);
-		CCRect sectionHeaderRect = CCRect(0, y, width, iSectionHeaderHeight);
 		if (iSectionHeaderHeight>0)
 		{
-			CAView* pSectionHeaderView = m_pCollectionViewDataSource->collectionViewSectionViewForHeaderInSection(this, sectionHeaderRect.size, i);
+			CAView* pSectionHeaderView = m_pCollectionViewDataSource->collectionViewSectionViewForHeaderInSection(this, CCSize(width, iSectionHeaderHeight), i);
 			if (pSectionHeaderView != NULL)
 			{
 				pSectionHeaderView->setDisplayRange(true);
-				pSectionHeaderView->setFrame(sectionHeaderRect);
 				insertSubview(pSectionHeaderView, 1);
 				m_pSectionHeaderViews[i] = pSectionHeaderView;
-				y += iSectionHeaderHeight;
-			}
-		}
-        
-		y += m_nVertInterval;
-		unsigned int rowCount = m_nRowsInSections.at(i);
-		for (int j = 0; j < rowCount; j++)
-		{
-			int iHeight = m_nRowHeightss.at(i).at(j);
-            
-			unsigned int itemCount = m_pCollectionViewDataSource->numberOfItemsInRowsInSection(this, i, j);
-            
-			unsigned int cellWidth = 0;
-			if (itemCount>0)
-			{
-				cellWidth = (width - m_nHoriInterval) / itemCount - m_nHoriInterval;
 			}
-			for (int k = 0; k < itemCount; k++)
-			{
-				CAIndexPath3E indexPath = CAIndexPath3E(i, j, k);
-				CCRect cellRect = CCRect(m_nHoriInterval + (cellWidth + m_nHoriInterval)*k, y, cellWidth, iHeight);
-				m_rUsedCollectionCellRects[indexPath] = cellRect;
-                
-				std::pair<std::map<CAIndexPath3E, CACollectionViewCell*>::iterator, bool> itrResult =
-                m_pUsedCollectionCells.insert(std::make_pair(indexPath, (CACollectionViewCell*)NULL));
-                
-				CC_CONTINUE_IF(!winRect.intersectsRect(cellRect));
-                
-				CACollectionViewCell* pCellView = m_pCollectionViewDataSource->collectionCellAtIndex(this, cellRect.size, i, j, k);
-				if (pCellView)
-				{
-					addSubview(pCellView);
-					pCellView->setFrame(cellRect);
-					pCellView->m_nSection = i;
-					pCellView->m_nRow = j;
-					pCellView->m_nItem = k;
-					itrResult.first->second = pCellView;
-				}
-			}
-			y += (iHeight + m_nVertInterval);
 		}
         
 		unsigned int iSectionFooterHeight = m_nSectionFooterHeights.at(i);
-		CCRect sectionFooterRect = CCRectMake(0, y, width, iSectionFooterHeight);
 		if (iSectionFooterHeight > 0)
 		{
-			CAView* pSectionFooterView = m_pCollectionViewDataSource->collectionViewSectionViewForFooterInSection(this, sectionFooterRect.size, i);
+			CAView* pSectionFooterView = m_pCollectionViewDataSource->collectionViewSectionViewForFooterInSection(this, CCSize(width, iSectionFooterHeight), i);
 			if (pSectionFooterView != NULL)
 			{
 				pSectionFooterView->setDisplayRange(true);
-				pSectionFooterView->setFrame(sectionFooterRect);
 				insertSubview(pSectionFooterView, 1);
 				m_pSectionFooterViews[i] = pSectionFooterView;
-				y += iSectionFooterHeight;
 			}
 		}
-        
-		CCRect sectionRect = sectionHeaderRect;
-		sectionRect.size.height = sectionFooterRect.origin.y
-        + sectionFooterRect.size.height
-        - sectionHeaderRect.origin.y;
-//		m_rSectionRects.push_back(sectionRect);
-        m_rSectionRects[begin + i] = sectionRect;
 	}
     
-	if (m_nCollectionFooterHeight > 0 && m_pCollectionHeaderView)
+	if (m_nCollectionFooterHeight > 0 && m_pCollectionFooterView)
 	{
-		m_pCollectionFooterView->setFrame(CCRect(0, y, width, m_nCollectionFooterHeight));
 		addSubview(m_pCollectionFooterView);
-		y += m_nCollectionFooterHeight;
 	}
     
+	this->layoutCollectionViews();
+	this->loadCollectionCell();
 	this->updateSectionHeaderAndFooterRects();
 	this->layoutPullToRefreshView();
 	this->startDeaccelerateScroll();
@@ -517,61 +586,561 @@ void CACollectionView::reloadData()
 
 void CACollectionView::firstReloadData()
 {
-	CC_RETURN_IF(!m_pUsedCollectionCells.empty());
+	CC_RETURN_IF(!m_vUsedCollectionCells.empty());
 	this->reloadData();
 }
 
-void CACollectionView::recoveryCollectionCell()
+unsigned int CACollectionView::getFlatRow(unsigned int section, unsigned int row)
 {
-	CCRect rect = this->getBounds();
-	rect.origin = getContentOffset();
-	rect.origin.y -= rect.size.height * 0.1f;
-	rect.size.height *= 1.2f;
+	// the header and the footer of every section before are items too
+	return m_nSectionItemStarts[section] - 2 * section + row;
+}
 
-	std::map<CAIndexPath3E, CACollectionViewCell*>::iterator itr;
-	for (itr = m_pUsedCollectionCells.begin(); itr != m_pUsedCollectionCells.end(); itr++)
+CAIndexPath2E CACollectionView::getIndexPathOfFlatRow(unsigned int flatRow)
+{
+	// the last section starting at or before the row
+	unsigned int begin = 0;
+	unsigned int end = m_nSections;
+	while (end - begin > 1)
 	{
-		CACollectionViewCell* cell = itr->second;
-		CC_CONTINUE_IF(cell == NULL);
+		unsigned int mid = (begin + end) / 2;
+		if (m_nSectionItemStarts[mid] - 2 * mid <= flatRow)
+		{
+			begin = mid;
+		}
+		else
+		{
+			end = mid;
+		}
+	}
+	return CAIndexPath2E(begin, flatRow - (m_nSectionItemStarts[begin] - 2 * begin));
+}
+
+unsigned int CACollectionView::getSectionOfItem(unsigned int item)
+{
+	std::vector<unsigned int>::iterator itr = std::upper_bound(m_nSectionItemStarts.begin(), m_nSectionItemStarts.end(), item);
+	return (unsigned int)(itr - m_nSectionItemStarts.begin()) - 1;
+}
 
-		CCRect cellRect = cell->getFrame();
-		CC_CONTINUE_IF(rect.intersectsRect(cellRect));
+unsigned int CACollectionView::getItemsOriginY()
+{
+	// the sections start below the collection header view
+	return (m_nCollectionHeaderHeight > 0 && m_pCollectionHeaderView) ? m_nCollectionHeaderHeight : 0;
+}
 
-		m_pFreedCollectionCells[cell->getReuseIdentifier()].pushBack(cell);
-		cell->removeFromSuperview();
-		cell->resetCollectionViewCell();
-		itr->second = NULL;
+CCRect CACollectionView::getSectionRect(unsigned int section)
+{
+	unsigned int begin = m_obItemHeights.prefixSum(m_nSectionItemStarts[section]);
+	unsigned int end = m_obItemHeights.prefixSum(m_nSectionItemStarts[section + 1]);
+	return CCRect(0, this->getItemsOriginY() + begin, this->getBounds().size.width, end - begin);
+}
+
+CCRect CACollectionView::getCellRect(unsigned int section, unsigned int row, unsigned int item)
+{
+	// the items of a row share its width
+	float width = this->getBounds().size.width;
+	unsigned int itemCount = m_nItemsInRowss[section][row];
+	unsigned int cellWidth = 0;
+	if (itemCount > 0)
+	{
+		cellWidth = (width - m_nHoriInterval) / itemCount - m_nHoriInterval;
 	}
+    
+	unsigned int y = m_obItemHeights.prefixSum(m_nSectionItemStarts[section] + 1 + row);
+	return CCRect(m_nHoriInterval + (cellWidth + m_nHoriInterval) * item,
+                  this->getItemsOriginY() + y,
+                  cellWidth,
+                  m_nRowHeightss[section][row]);
 }
 
-void CACollectionView::loadCollectionCell()
+bool CACollectionView::getVisibleRows(unsigned int& first, unsigned int& last)
 {
 	CCRect rect = this->getBounds();
 	rect.origin = getContentOffset();
 	rect.origin.y -= rect.size.height * 0.1f;
 	rect.size.height *= 1.2f;
+    
+	return this->getRowsInRange(rect.getMinY(), rect.getMaxY(), first, last);
+}
+
+bool CACollectionView::getRowsInRange(float top, float bottom, unsigned int& first, unsigned int& last)
+{
+	if (m_obItemHeights.empty())
+	{
+		return false;
+	}
+    
+	top -= this->getItemsOriginY();
+	bottom -= this->getItemsOriginY();
+	if (bottom < 0)
+	{
+		return false;
+	}
+    
+	// the items at both ends of the rect, found by bisecting the offsets
+	unsigned int firstItem = m_obItemHeights.indexOf(top > 0 ? (unsigned int)top : 0);
+	unsigned int lastItem = m_obItemHeights.indexOf((unsigned int)bottom);
+	if (firstItem >= m_obItemHeights.size())
+	{
+		return false;
+	}
+	lastItem = MIN(lastItem, m_obItemHeights.size() - 1);
+    
+	// the first row at or after the first item, and the rows up to the last item
+	unsigned int section = this->getSectionOfItem(firstItem);
+	first = firstItem - 2 * section - (firstItem > m_nSectionItemStarts[section] ? 1 : 0);
+    
+	section = this->getSectionOfItem(lastItem);
+	unsigned int local = lastItem - m_nSectionItemStarts[section];
+	unsigned int rows = lastItem - 2 * section - (local > 0 ? 1 : 0);
+	if (local > 0 && local <= m_nRowsInSections[section])
+	{
+		++rows;
+	}
+	if (rows <= first)
+	{
+		return false;
+	}
+	last = rows - 1;
+    
+	return true;
+}
+
+CAIndexPath3E CACollectionView::getIndexPathOfCell(CACollectionViewCell* cell)
+{
+	return CAIndexPath3E(cell->m_nSection, cell->m_nRow, cell->m_nItem);
+}
+
+unsigned int CACollectionView::getUsedCellIndex(const CAIndexPath3E& indexPath)
+{
+	// the first live cell at or after the index path
+	unsigned int begin = 0;
+	unsigned int end = (unsigned int)m_vUsedCollectionCells.size();
+	while (begin < end)
+	{
+		unsigned int mid = (begin + end) / 2;
+		if (this->getIndexPathOfCell(m_vUsedCollectionCells[mid]) < indexPath)
+		{
+			begin = mid + 1;
+		}
+		else
+		{
+			end = mid;
+		}
+	}
+	return begin;
+}
+
+void CACollectionView::layoutCollectionViews()
+{
+	float width = this->getBounds().size.width;
+    
+	for (unsigned int i = 0; i < m_nSections; i++)
+	{
+		CCRect sectionRect = this->getSectionRect(i);
+        
+		std::map<int, CAView*>::iterator itr = m_pSectionHeaderViews.find(i);
+		if (itr != m_pSectionHeaderViews.end())
+		{
+			itr->second->setFrame(CCRect(0, sectionRect.origin.y, width, m_nSectionHeaderHeights[i]));
+		}
+        
+		itr = m_pSectionFooterViews.find(i);
+		if (itr != m_pSectionFooterViews.end())
+		{
+			itr->second->setFrame(CCRect(0,
+                                         sectionRect.origin.y + sectionRect.size.height - m_nSectionFooterHeights[i],
+                                         width,
+                                         m_nSectionFooterHeights[i]));
+		}
+	}
+    
+	for (size_t i = 0; i < m_vUsedCollectionCells.size(); i++)
+	{
+		CACollectionViewCell* cell = m_vUsedCollectionCells[i];
+		cell->setFrame(this->getCellRect(cell->m_nSection, cell->m_nRow, cell->m_nItem));
+	}
+    
+	if (m_pCollectionHeaderView && m_nCollectionHeaderHeight > 0)
+	{
+		m_pCollectionHeaderView->setFrame(CCRect(0, 0, width, m_nCollectionHeaderHeight));
+	}
+    
+	unsigned int y = this->getItemsOriginY() + m_obItemHeights.total();
+	if (m_pCollectionFooterView && m_nCollectionFooterHeight > 0)
+	{
+		m_pCollectionFooterView->setFrame(CCRect(0, y, width, m_nCollectionFooterHeight));
+	}
+    
+	CCSize size = this->getBounds().size;
+	size.height = m_nCollectionHeaderHeight + m_obItemHeights.total() + m_nCollectionFooterHeight;
+	this->setViewSize(size);
+}
+
+void CACollectionView::beginUpdates()
+{
+	++m_nUpdatesCount;
+}
+
+void CACollectionView::endUpdates()
+{
+	CC_RETURN_IF(m_nUpdatesCount == 0);
+	--m_nUpdatesCount;
+	CC_RETURN_IF(m_nUpdatesCount > 0);
+    
+	this->applyUpdates();
+}
+
+void CACollectionView::insertRowsAtIndexPaths(const std::vector<CAIndexPath2E>& indexPaths)
+{
+	CC_RETURN_IF(m_pCollectionViewDataSource == NULL);
+    
+	// the lower rows are inserted first, so every index path is the one of the new row
+	std::vector<CAIndexPath2E> sorted = indexPaths;
+	std::sort(sorted.begin(), sorted.end());
+	sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+    
+	this->beginUpdates();
+	for (size_t i = 0; i < sorted.size(); i++)
+	{
+		unsigned int section = sorted[i].section;
+		unsigned int row = sorted[i].row;
+		CC_CONTINUE_IF(section >= m_nSections || row > m_nRowsInSections[section]);
+        
+		unsigned int height = m_pCollectionViewDataSource->collectionViewHeightForRowAtIndexPath(this, section, row);
+		unsigned int items = m_pCollectionViewDataSource->numberOfItemsInRowsInSection(this, section, row);
+		this->insertRowItem(section, row, height, items, std::vector<CACollectionViewCell*>());
+	}
+	this->endUpdates();
+}
+
+void CACollectionView::deleteRowsAtIndexPaths(const std::vector<CAIndexPath2E>& indexPaths)
+{
+	// the higher rows are deleted first, so every index path is the one of the row before the call
+	std::vector<CAIndexPath2E> sorted = indexPaths;
+	std::sort(sorted.begin(), sorted.end());
+	sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+    
+	this->beginUpdates();
+	std::vector<CAIndexPath2E>::reverse_iterator itr;
+	for (itr = sorted.rbegin(); itr != sorted.rend(); itr++)
+	{
+		CC_CONTINUE_IF(itr->section >= m_nSections || itr->row >= m_nRowsInSections[itr->section]);
+        
+		std::vector<CACollectionViewCell*> cells;
+		this->eraseRowItem(itr->section, itr->row, cells);
+		for (size_t i = 0; i < cells.size(); i++)
+		{
+			this->recycleCollectionCell(cells[i]);
+		}
+	}
+	this->endUpdates();
+}
+
+void CACollectionView::reloadRowsAtIndexPaths(const std::vector<CAIndexPath2E>& indexPaths)
+{
+	CC_RETURN_IF(m_pCollectionViewDataSource == NULL);
+    
+	this->beginUpdates();
+	std::vector<CAIndexPath2E>::const_iterator itr;
+	for (itr = indexPaths.begin(); itr != indexPaths.end(); itr++)
+	{
+		unsigned int section = itr->section;
+		unsigned int row = itr->row;
+		CC_CONTINUE_IF(section >= m_nSections || row >= m_nRowsInSections[section]);
+        
+		unsigned int height = m_pCollectionViewDataSource->collectionViewHeightForRowAtIndexPath(this, section, row);
+		unsigned int items = m_pCollectionViewDataSource->numberOfItemsInRowsInSection(this, section, row);
+        
+		// the cells of the row are asked again, the selection of its remaining items is kept
+		unsigned int begin = this->getUsedCellIndex(CAIndexPath3E(section, row, 0));
+		unsigned int end = this->getUsedCellIndex(CAIndexPath3E(section, row + 1, 0));
+		for (unsigned int i = begin; i < end; i++)
+		{
+			this->recycleCollectionCell(m_vUsedCollectionCells[i]);
+		}
+		m_vUsedCollectionCells.erase(m_vUsedCollectionCells.begin() + begin, m_vUsedCollectionCells.begin() + end);
+        
+		for (unsigned int k = items; k < m_nItemsInRowss[section][row]; k++)
+		{
+			m_pSelectedCollectionCells.erase(CAIndexPath3E(section, row, k));
+		}
+        
+		if (height != m_nRowHeightss[section][row])
+		{
+			m_nSectionHeights[section] += (int)height - (int)m_nRowHeightss[section][row];
+			m_nRowHeightss[section][row] = height;
+			m_nFirstUpdatedItem = MIN(m_nFirstUpdatedItem, m_nSectionItemStarts[section] + 1 + row);
+		}
+		m_nItemsInRowss[section][row] = items;
+	}
+	this->endUpdates();
+}
+
+void CACollectionView::moveRowAtIndexPath(const CAIndexPath2E& indexPath, const CAIndexPath2E& newIndexPath)
+{
+	CC_RETURN_IF(indexPath == newIndexPath);
+	CC_RETURN_IF(indexPath.section >= m_nSections || indexPath.row >= m_nRowsInSections[indexPath.section]);
+	CC_RETURN_IF(newIndexPath.section >= m_nSections);
+    
+	unsigned int rows = m_nRowsInSections[newIndexPath.section];
+	if (newIndexPath.section == indexPath.section)
+	{
+		--rows;
+	}
+	CC_RETURN_IF(newIndexPath.row > rows);
+    
+	unsigned int height = m_nRowHeightss[indexPath.section][indexPath.row];
+	unsigned int items = m_nItemsInRowss[indexPath.section][indexPath.row];
+    
+	std::vector<unsigned int> selectedItems;
+	for (unsigned int k = 0; k < items; k++)
+	{
+		if (m_pSelectedCollectionCells.count(CAIndexPath3E(indexPath.section, indexPath.row, k)))
+		{
+			selectedItems.push_back(k);
+		}
+	}
+    
+	this->beginUpdates();
+    
+	// the row keeps its cells and the selection of its items
+	std::vector<CACollectionViewCell*> cells;
+	this->eraseRowItem(indexPath.section, indexPath.row, cells);
+	this->insertRowItem(newIndexPath.section, newIndexPath.row, height, items, cells);
+    
+	for (size_t i = 0; i < selectedItems.size(); i++)
+	{
+		m_pSelectedCollectionCells.insert(CAIndexPath3E(newIndexPath.section, newIndexPath.row, selectedItems[i]));
+	}
+    
+	this->endUpdates();
+}
+
+void CACollectionView::insertRowItem(unsigned int section, unsigned int row, unsigned int height, unsigned int items, const std::vector<CACollectionViewCell*>& cells)
+{
+	this->shiftRowsInSection(section, row, 1);
+    
+	m_nRowHeightss[section].insert(m_nRowHeightss[section].begin() + row, height);
+	m_nItemsInRowss[section].insert(m_nItemsInRowss[section].begin() + row, items);
+	++m_nRowsInSections[section];
+	m_nSectionHeights[section] += height + m_nVertInterval;
+	for (unsigned int i = section + 1; i <= m_nSections; i++)
+	{
+		++m_nSectionItemStarts[i];
+	}
+	m_nFirstUpdatedItem = MIN(m_nFirstUpdatedItem, m_nSectionItemStarts[section] + 1 + row);
+    
+	// the cells given keep the live cells sorted: they all go where the row starts
+	unsigned int index = this->getUsedCellIndex(CAIndexPath3E(section, row, 0));
+	for (size_t i = 0; i < cells.size(); i++)
+	{
+		CACollectionViewCell* cell = cells[i];
+		cell->m_nSection = section;
+		cell->m_nRow = row;
+		m_vUsedCollectionCells.insert(m_vUsedCollectionCells.begin() + index, cell);
+		++index;
+	}
+}
+
+void CACollectionView::eraseRowItem(unsigned int section, unsigned int row, std::vector<CACollectionViewCell*>& cells)
+{
+	// the live cells of the row are taken out
+	unsigned int begin = this->getUsedCellIndex(CAIndexPath3E(section, row, 0));
+	unsigned int end = this->getUsedCellIndex(CAIndexPath3E(section, row + 1, 0));
+	cells.assign(m_vUsedCollectionCells.begin() + begin, m_vUsedCollectionCells.begin() + end);
+	m_vUsedCollectionCells.erase(m_vUsedCollectionCells.begin() + begin, m_vUsedCollectionCells.begin() + end);
+    
+	for (unsigned int k = 0; k < m_nItemsInRowss[section][row]; k++)
+	{
+		m_pSelectedCollectionCells.erase(CAIndexPath3E(section, row, k));
+	}
+	this->shiftRowsInSection(section, row + 1, -1);
+    
+	m_nSectionHeights[section] -= m_nRowHeightss[section][row] + m_nVertInterval;
+	m_nRowHeightss[section].erase(m_nRowHeightss[section].begin() + row);
+	m_nItemsInRowss[section].erase(m_nItemsInRowss[section].begin() + row);
+	--m_nRowsInSections[section];
+	for (unsigned int i = section + 1; i <= m_nSections; i++)
+	{
+		--m_nSectionItemStarts[i];
+	}
+	m_nFirstUpdatedItem = MIN(m_nFirstUpdatedItem, m_nSectionItemStarts[section] + 1 + row);
+}
+
+void CACollectionView::shiftRowsInSection(unsigned int section, unsigned int fromRow, int delta)
+{
+	// the cells of the rows after the change are kept under their new index path, still sorted
+	unsigned int begin = this->getUsedCellIndex(CAIndexPath3E(section, fromRow, 0));
+	unsigned int end = this->getUsedCellIndex(CAIndexPath3E(section + 1, 0, 0));
+	for (unsigned int i = begin; i < end; i++)
+	{
+		m_vUsedCollectionCells[i]->m_nRow += delta;
+	}
+    
+	CC_RETURN_IF(m_pSelectedCollectionCells.empty());
+    
+	std::set<CAIndexPath3E> selectedCollectionCells;
+	std::set<CAIndexPath3E>::iterator itr;
+	for (itr = m_pSelectedCollectionCells.begin(); itr != m_pSelectedCollectionCells.end(); itr++)
+	{
+		CAIndexPath3E indexPath = *itr;
+		if (indexPath.section == section && indexPath.row >= fromRow)
+		{
+			indexPath.row += delta;
+		}
+		selectedCollectionCells.insert(indexPath);
+	}
+	m_pSelectedCollectionCells = selectedCollectionCells;
+}
+
+void CACollectionView::updateItemHeights(unsigned int firstItem)
+{
+	// the items from the first one changed are laid out again, the offsets before it are kept
+	std::vector<unsigned int> itemHeights;
+	for (unsigned int i = this->getSectionOfItem(firstItem); i < m_nSections; i++)
+	{
+		unsigned int start = m_nSectionItemStarts[i];
+		for (unsigned int item = MAX(firstItem, start); item < m_nSectionItemStarts[i + 1]; item++)
+		{
+			unsigned int local = item - start;
+			if (local == 0)
+			{
+				itemHeights.push_back(m_nSectionHeaderHeights[i] + m_nVertInterval);
+			}
+			else if (local <= m_nRowsInSections[i])
+			{
+				itemHeights.push_back(m_nRowHeightss[i][local - 1] + m_nVertInterval);
+			}
+			else
+			{
+				itemHeights.push_back(m_nSectionFooterHeights[i]);
+			}
+		}
+	}
+	m_obItemHeights.assign(firstItem, itemHeights);
+}
 
-	std::map<CAIndexPath3E, CACollectionViewCell*>::iterator itr;
-	for (itr = m_pUsedCollectionCells.begin(); itr != m_pUsedCollectionCells.end(); itr++)
+void CACollectionView::applyUpdates()
+{
+	if (m_nFirstUpdatedItem != 0xffffffff)
+	{
+		this->updateItemHeights(m_nFirstUpdatedItem);
+		m_nFirstUpdatedItem = 0xffffffff;
+	}
+	this->layoutCollectionViews();
+    
+	// only the cells missing are asked to the data source
+	this->recoveryCollectionCell();
+	this->loadCollectionCell();
+	this->updateSectionHeaderAndFooterRects();
+}
+
+void CACollectionView::recycleCollectionCell(CACollectionViewCell* cell)
+{
+	CC_RETURN_IF(cell == NULL);
+    
+	if (cell == m_pHighlightedCollectionCells)
+	{
+		m_pContainer->stopAllActions();
+		m_pHighlightedCollectionCells = NULL;
+	}
+    
+	// the images of the cell are not waited for anymore
+	CAImageView::cancelImageAsyncInView(cell);
+    
+	// the cells above the limit of the pool are released by the removal, only the pooled ones are reset
+	CAVector<CACollectionViewCell*>& freedCells = m_pFreedCollectionCells[cell->getReuseIdentifier()];
+	std::map<std::string, unsigned int>::iterator itr = m_mReusableCellsLimits.find(cell->getReuseIdentifier());
+	if (itr == m_mReusableCellsLimits.end() || freedCells.size() < itr->second)
 	{
-		CC_CONTINUE_IF(itr->second != NULL);
+		freedCells.pushBack(cell);
+		cell->removeFromSuperview();
+		cell->resetCollectionViewCell();
+	}
+	else
+	{
+		cell->removeFromSuperview();
+	}
+}
 
-		CAIndexPath3E r = itr->first;
-		CCRect cellRect = m_rUsedCollectionCellRects[r];
-		CC_CONTINUE_IF(!rect.intersectsRect(cellRect));
+void CACollectionView::recoveryCollectionCell()
+{
+	unsigned int first = 0, last = 0;
+	bool visible = this->getVisibleRows(first, last);
+    
+	// the live cells are sorted, the rows out of view are at both ends
+	size_t begin = 0;
+	while (begin < m_vUsedCollectionCells.size())
+	{
+		CACollectionViewCell* cell = m_vUsedCollectionCells[begin];
+		CC_BREAK_IF(visible && this->getFlatRow(cell->m_nSection, cell->m_nRow) >= first);
+		this->recycleCollectionCell(cell);
+		++begin;
+	}
+	m_vUsedCollectionCells.erase(m_vUsedCollectionCells.begin(), m_vUsedCollectionCells.begin() + begin);
+    
+	while (!m_vUsedCollectionCells.empty())
+	{
+		CACollectionViewCell* cell = m_vUsedCollectionCells.back();
+		CC_BREAK_IF(this->getFlatRow(cell->m_nSection, cell->m_nRow) <= last);
+		this->recycleCollectionCell(cell);
+		m_vUsedCollectionCells.pop_back();
+	}
+}
 
-		CACollectionViewCell* cell = m_pCollectionViewDataSource->collectionCellAtIndex(this, cellRect.size, r.section, r.row, r.item);
-		if (cell)
+void CACollectionView::loadCollectionCell()
+{
+	unsigned int first = 0, last = 0;
+	CC_RETURN_IF(!this->getVisibleRows(first, last));
+    
+	// the rows in view are merged with the live cells, which stay sorted
+	unsigned int index = 0;
+	CAIndexPath2E rowPath = this->getIndexPathOfFlatRow(first);
+	for (unsigned int flatRow = first; flatRow <= last; flatRow++, rowPath.row++)
+	{
+		while (rowPath.row >= m_nRowsInSections[rowPath.section])
 		{
-			cell->m_nSection = r.section;
-			cell->m_nRow = r.row;
-			cell->m_nItem = r.item;
+			++rowPath.section;
+			rowPath.row = 0;
+		}
+        
+		unsigned int i = rowPath.section;
+		unsigned int j = rowPath.row;
+		for (unsigned int k = 0; k < m_nItemsInRowss[i][j]; k++)
+		{
+			CAIndexPath3E indexPath = CAIndexPath3E(i, j, k);
+			while (index < m_vUsedCollectionCells.size()
+                   && this->getIndexPathOfCell(m_vUsedCollectionCells[index]) < indexPath)
+			{
+				++index;
+			}
+			if (index < m_vUsedCollectionCells.size()
+                && this->getIndexPathOfCell(m_vUsedCollectionCells[index]) == indexPath)
+			{
+				++index;
+				continue;
+			}
+            
+			CCRect cellRect = this->getCellRect(i, j, k);
+            
+			// the images of the cells in view are decoded before the prefetched ones
+			int asyncPriority = CAImageView::getAsyncPriority();
+			CAImageView::setAsyncPriority(kCAImageViewAsyncPriorityVisible);
+			CACollectionViewCell* cell = m_pCollectionViewDataSource->collectionCellAtIndex(this, cellRect.size, i, j, k);
+			CAImageView::setAsyncPriority(asyncPriority);
+			CC_CONTINUE_IF(cell == NULL);
+            
+			cell->m_nSection = i;
+			cell->m_nRow = j;
+			cell->m_nItem = k;
 			cell->updateDisplayedAlpha(this->getAlpha());
 			this->addSubview(cell);
 			cell->setFrame(cellRect);
-			itr->second = cell;
-
-			if (m_pSelectedCollectionCells.count(r))
+			m_vUsedCollectionCells.insert(m_vUsedCollectionCells.begin() + index, cell);
+			++index;
+            
+			if (m_pSelectedCollectionCells.count(indexPath))
 			{
 				cell->setControlStateSelected();
 			}
@@ -581,14 +1150,26 @@ void CACollectionView::loadCollectionCell()
 
 void CACollectionView::updateSectionHeaderAndFooterRects()
 {
+	CC_RETURN_IF(m_obItemHeights.empty());
+    
 	CCRect rect = this->getBounds();
 	rect.origin = getContentOffset();
-
-	std::vector<CCRect>::iterator itr;
-	for (itr = m_rSectionRects.begin(); itr != m_rSectionRects.end(); itr++)
+    
+	float top = rect.getMinY() - this->getItemsOriginY();
+	float bottom = rect.getMaxY() - this->getItemsOriginY();
+	CC_RETURN_IF(bottom < 0);
+    
+	// only the sections in view
+	unsigned int firstItem = m_obItemHeights.indexOf(top > 0 ? (unsigned int)top : 0);
+	unsigned int lastItem = m_obItemHeights.indexOf((unsigned int)bottom);
+	CC_RETURN_IF(firstItem >= m_obItemHeights.size());
+	lastItem = MIN(lastItem, m_obItemHeights.size() - 1);
+    
+	unsigned int lastSection = this->getSectionOfItem(lastItem);
+	for (unsigned int i = this->getSectionOfItem(firstItem); i <= lastSection; i++)
 	{
-		CC_CONTINUE_IF(!rect.intersectsRect(*itr));
-		int i = itr - m_rSectionRects.begin();
+		CCRect sectionRect = this->getSectionRect(i);
+		CC_CONTINUE_IF(!rect.intersectsRect(sectionRect));
 		CAView* header = NULL;
 		CAView* footer = NULL;
 		float headerHeight = 0;
@@ -606,8 +1187,8 @@ void CACollectionView::updateSectionHeaderAndFooterRects()
 		if (header && m_bAlwaysTopSectionHeader)
 		{
 			CCPoint p1 = rect.origin;
-			p1.y = MAX(p1.y, itr->origin.y);
-			p1.y = MIN(p1.y, itr->origin.y + itr->size.height
+			p1.y = MAX(p1.y, sectionRect.origin.y);
+			p1.y = MIN(p1.y, sectionRect.origin.y + sectionRect.size.height
 				- headerHeight - footerHeight);
 			header->setFrameOrigin(p1);
 		}
@@ -615,8 +1196,8 @@ void CACollectionView::updateSectionHeaderAndFooterRects()
 		{
 			CCPoint p2 = CCPointZero;
 			p2.y = MIN(rect.origin.y + this->getBounds().size.height - footerHeight,
-				itr->origin.y + itr->size.height - footerHeight);
-			p2.y = MAX(p2.y, itr->origin.y + headerHeight);
+				sectionRect.origin.y + sectionRect.size.height - footerHeight);
+			p2.y = MAX(p2.y, sectionRect.origin.y + headerHeight);
 			footer->setFrameOrigin(p2);
 		}
 	}
@@ -626,11 +1207,60 @@ void CACollectionView::update(float dt)
 {
 	CAScrollView::update(dt);
     
+	// the rows are being changed, endUpdates lays them out
+	CC_RETURN_IF(m_nUpdatesCount > 0);
+    
 	recoveryCollectionCell();
     
 	loadCollectionCell();
     
 	updateSectionHeaderAndFooterRects();
+    
+	prefetchCollectionCells();
+}
+
+void CACollectionView::prefetchCollectionCells()
+{
+	CC_RETURN_IF(m_pCollectionViewDataSource == NULL);
+    
+	unsigned int visibleFirst = 0, visibleLast = 0;
+	CC_RETURN_IF(!this->getVisibleRows(visibleFirst, visibleLast));
+    
+	CCPoint distance = this->getPrefetchDistance();
+	CC_RETURN_IF(fabsf(distance.y) < 1.0f);
+    
+	// the rows between the edge of the view and where the scroll is going
+	CCRect rect = this->getBounds();
+	rect.origin = getContentOffset();
+	rect.origin.y -= rect.size.height * 0.1f;
+	rect.size.height *= 1.2f;
+    
+	float top = distance.y > 0 ? rect.getMaxY() : rect.getMinY() + distance.y;
+	float bottom = distance.y > 0 ? rect.getMaxY() + distance.y : rect.getMinY();
+    
+	unsigned int first = 0, last = 0;
+	CC_RETURN_IF(!this->getRowsInRange(top, bottom, first, last));
+    
+	std::vector<CAIndexPath2E> indexPaths;
+	CAIndexPath2E rowPath = this->getIndexPathOfFlatRow(first);
+	for (unsigned int flatRow = first; flatRow <= last; flatRow++, rowPath.row++)
+	{
+		while (rowPath.row >= m_nRowsInSections[rowPath.section])
+		{
+			++rowPath.section;
+			rowPath.row = 0;
+		}
+        
+		// neither the rows in view, nor the ones given the last time
+		CC_CONTINUE_IF(flatRow >= visibleFirst && flatRow <= visibleLast);
+		CC_CONTINUE_IF(flatRow >= m_nPrefetchedFirstRow && flatRow <= m_nPrefetchedLastRow);
+		indexPaths.push_back(rowPath);
+	}
+	m_nPrefetchedFirstRow = first;
+	m_nPrefetchedLastRow = last;
+    
+	CC_RETURN_IF(indexPaths.empty());
+	m_pCollectionViewDataSource->collectionViewPrefetchRowsAtIndexPaths(this, indexPaths);
 }
 
 CACollectionViewCell* CACollectionView::getHighlightCollectionCell()
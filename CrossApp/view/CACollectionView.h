@@ -13,6 +13,7 @@
 #include "view/CAScale9ImageView.h"
 #include "controller/CABarItem.h"
 #include "view/CATableView.h"
+#include "basics/CAFenwickTree.h"
 #include "view/CALabel.h"
 
 NS_CC_BEGIN
@@ -65,6 +66,18 @@ public:
         return 1;
     }
     
+    //Optional. The rows ahead of the scroll, before the cells of their items are asked
+    virtual void collectionViewPrefetchRowsAtIndexPaths(CACollectionView* collectionView, const std::vector<CAIndexPath2E>& indexPaths)
+    {
+        
+    }
+    
+    //Optional. A cell made in an idle frame for the reuse pool of the identifier, see prewarmReusableCells
+    virtual CACollectionViewCell* collectionCellWithReuseIdentifier(CACollectionView* collectionView, const std::string& reuseIdentifier)
+    {
+        return NULL;
+    }
+    
 	virtual CAView* collectionViewSectionViewForHeaderInSection(CACollectionView *collectionView, const CCSize& viewSize, unsigned int section)
     {
         return NULL;
@@ -107,6 +120,15 @@ public:
 
 	CACollectionViewCell* dequeueReusableCellWithIdentifier(const char* reuseIdentifier);
     
+    // the freed cells of the identifier are kept up to the limit, 0 keeps them all
+    void setReusableCellsLimit(const std::string& reuseIdentifier, unsigned int limit);
+    
+    // fills the freed cells of the identifier up to count, one cell per idle frame, with collectionCellWithReuseIdentifier
+    void prewarmReusableCells(const std::string& reuseIdentifier, unsigned int count);
+    
+    // releases the freed cells above count, for every identifier
+    void trimReusableCells(unsigned int count = 0);
+    
     virtual void setAllowsSelection(bool var);
     
     virtual void setAllowsMultipleSelection(bool var);
@@ -115,6 +137,26 @@ public:
 
     void setUnSelectRowAtIndexPath(unsigned int section, unsigned int row, unsigned int item);
     
+    CACollectionViewCell* cellForRowAtIndexPath(unsigned int section, unsigned int row, unsigned int item);
+    
+    // the changes made between beginUpdates and endUpdates are laid out once, by endUpdates
+    void beginUpdates();
+    
+    void endUpdates();
+    
+    // the rows come with all their items. The data source is already changed,
+    // the index paths are the ones of the new rows
+    void insertRowsAtIndexPaths(const std::vector<CAIndexPath2E>& indexPaths);
+    
+    // the index paths are the ones of the rows before the call
+    void deleteRowsAtIndexPaths(const std::vector<CAIndexPath2E>& indexPaths);
+    
+    // the height, the items and the cells of the rows are asked again to the data source
+    void reloadRowsAtIndexPaths(const std::vector<CAIndexPath2E>& indexPaths);
+    
+    // the row keeps its cells and the selection of its items
+    void moveRowAtIndexPath(const CAIndexPath2E& indexPath, const CAIndexPath2E& newIndexPath);
+    
     CC_SYNTHESIZE(CACollectionViewDataSource*, m_pCollectionViewDataSource, CollectionViewDataSource);
     
 	CC_SYNTHESIZE(CACollectionViewDelegate*, m_pCollectionViewDelegate, CollectionViewDelegate);
@@ -149,6 +191,8 @@ protected:
     
     inline virtual float decelerationRatio(float dt);
     
+    void clearData();
+    
     void reloadViewSizeData();
     
     virtual void update(float dt);
@@ -161,6 +205,44 @@ protected:
     
     void firstReloadData();
     
+    unsigned int getFlatRow(unsigned int section, unsigned int row);
+    
+    CAIndexPath2E getIndexPathOfFlatRow(unsigned int flatRow);
+    
+    unsigned int getSectionOfItem(unsigned int item);
+    
+    unsigned int getItemsOriginY();
+    
+    CCRect getSectionRect(unsigned int section);
+    
+    CCRect getCellRect(unsigned int section, unsigned int row, unsigned int item);
+    
+    bool getRowsInRange(float top, float bottom, unsigned int& first, unsigned int& last);
+    
+    bool getVisibleRows(unsigned int& first, unsigned int& last);
+    
+    void prefetchCollectionCells();
+    
+    void prewarmCollectionCell(float dt);
+    
+    CAIndexPath3E getIndexPathOfCell(CACollectionViewCell* cell);
+    
+    unsigned int getUsedCellIndex(const CAIndexPath3E& indexPath);
+    
+    void layoutCollectionViews();
+    
+    void recycleCollectionCell(CACollectionViewCell* cell);
+    
+    void insertRowItem(unsigned int section, unsigned int row, unsigned int height, unsigned int items, const std::vector<CACollectionViewCell*>& cells);
+    
+    void eraseRowItem(unsigned int section, unsigned int row, std::vector<CACollectionViewCell*>& cells);
+    
+    void shiftRowsInSection(unsigned int section, unsigned int fromRow, int delta);
+    
+    void updateItemHeights(unsigned int firstItem);
+    
+    void applyUpdates();
+    
 public:
 
 	virtual bool ccTouchBegan(CATouch *pTouch, CAEvent *pEvent);
@@ -185,9 +267,14 @@ private:
     
     std::vector<std::vector<unsigned int> > m_nRowHeightss;
     
-    std::vector<CCRect> m_rSectionRects;
+    std::vector<std::vector<unsigned int> > m_nItemsInRowss;
+    
+    // heights of the section headers and rows (both followed by the vertical interval)
+    // and of the section footers, in layout order
+    CAFenwickTree m_obItemHeights;
     
-    std::map<CAIndexPath3E, CCRect> m_rUsedCollectionCellRects;
+    // index in m_obItemHeights of the header of every section, followed by the count of items
+    std::vector<unsigned int> m_nSectionItemStarts;
     
     std::map<int, CAView*> m_pSectionHeaderViews;
     
@@ -197,9 +284,25 @@ private:
 
 	CACollectionViewCell* m_pHighlightedCollectionCells;
 
-	std::map<CAIndexPath3E, CACollectionViewCell*> m_pUsedCollectionCells;
+	// the live cells only, sorted by index path
+	std::vector<CACollectionViewCell*> m_vUsedCollectionCells;
 
 	std::map<std::string, CAVector<CACollectionViewCell*> > m_pFreedCollectionCells;
+    
+    unsigned int m_nUpdatesCount;
+    
+    // first item of m_obItemHeights changed by the updates, 0xffffffff if none
+    unsigned int m_nFirstUpdatedItem;
+    
+    // flat rows given to collectionViewPrefetchRowsAtIndexPaths the last time, none if the first is after the last
+    unsigned int m_nPrefetchedFirstRow;
+    
+    unsigned int m_nPrefetchedLastRow;
+    
+    std::map<std::string, unsigned int> m_mReusableCellsLimits;
+    
+    // cells left to make for the reuse pools, by identifier
+    std::map<std::string, unsigned int> m_mPrewarmCounts;
 };
 
 class CC_DLL CACollectionViewCell : public CAControl
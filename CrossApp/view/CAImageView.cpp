@@ -24,6 +24,8 @@
 
 NS_CC_BEGIN
 
+static int s_nAsyncPriority = kCAImageViewAsyncPriorityPrefetch;
+
 CAImageView* CAImageView::createWithImage(CAImage* image)
 {
     CAImageView *pobSprite = new CAImageView();
@@ -252,7 +254,46 @@ bool CAImageView::initWithCenter(const CCRect& rect, const CAColor4B& color4B)
 
 void CAImageView::setImageAsyncWithFile(const std::string& path)
 {
-    CAImageCache::sharedImageCache()->addImageFullPathAsync(path, this, callfuncO_selector(CAImageView::asyncFinish));
+    int priority = s_nAsyncPriority;
+    if (priority < kCAImageViewAsyncPriorityVisible && this->isRunning() && this->isVisible())
+    {
+        CCSize winSize = CAApplication::getApplication()->getWinSize();
+        CCRect rect = this->convertRectToWorldSpace(this->getBounds());
+        if (rect.intersectsRect(CCRect(0, 0, winSize.width, winSize.height)))
+        {
+            priority = kCAImageViewAsyncPriorityVisible;
+        }
+    }
+    
+    // a reused view (table cells) does not wait for its previous image anymore
+    CAImageCache::sharedImageCache()->cancelImageAsync(this);
+    CAImageCache::sharedImageCache()->addImageFullPathAsync(path, this, callfuncO_selector(CAImageView::asyncFinish), priority);
+}
+
+void CAImageView::setAsyncPriority(int priority)
+{
+    s_nAsyncPriority = priority;
+}
+
+int CAImageView::getAsyncPriority()
+{
+    return s_nAsyncPriority;
+}
+
+void CAImageView::cancelImageAsyncInView(CAView* view)
+{
+    CC_RETURN_IF(view == NULL);
+    
+    if (CAImageView* imageView = dynamic_cast<CAImageView*>(view))
+    {
+        CAImageCache::sharedImageCache()->cancelImageAsync(imageView);
+    }
+    
+    const CAVector<CAView*>& subviews = view->getSubviews();
+    for (CAVector<CAView*>::const_iterator itr = subviews.begin(); itr != subviews.end(); itr++)
+    {
+        cancelImageAsyncInView(*itr);
+    }
 }
 
 void CAImageView::asyncFinish(CrossApp::CAObject *var)
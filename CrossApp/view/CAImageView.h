@@ -23,6 +23,10 @@ typedef enum
 }
 CAImageViewScaleType;
 
+/** priorities of the images requested by setImageAsyncWithFile, the images in view are decoded first */
+#define kCAImageViewAsyncPriorityPrefetch 0
+#define kCAImageViewAsyncPriorityVisible 1
+
 class CC_DLL CAImageView : public CAView
 {
 public:
@@ -49,6 +53,16 @@ public:
 
     virtual void setImageAsyncWithFile(const std::string& path);
     
+    /** priority of the requests of setImageAsyncWithFile, besides the views already on the screen.
+     The lists raise it while they load the cells in view.
+     */
+    static void setAsyncPriority(int priority);
+    
+    static int getAsyncPriority();
+    
+    /** drops the requests of the image views of the subtree, for the cells that are recycled */
+    static void cancelImageAsyncInView(CAView* view);
+    
     using CAView::setImageRect;
     
     CC_SYNTHESIZE_PASS_BY_REF(CAImageViewScaleType, m_eImageViewScaleType, ImageViewScaleType);
@@ -12,9 +12,15 @@
 #include <cstdlib>
 #include "CALabelStyle.h"
 #include "shaders/CAShaderCache.h"
+#include "shaders/CARenderQueue.h"
+#include "platform/CAFTFontCache.h"
+#include "basics/CAApplication.h"
+#include "kazmath/GL/matrix.h"
 
 NS_CC_BEGIN
 
+static bool s_bGlyphAtlasEnabled = true;
+
 
 CALabel::CALabel()
 :m_nNumberOfLine(0)
@@ -33,6 +39,8 @@ CALabel::CALabel()
 ,m_bBold(false)
 ,m_bItalics(false)
 ,m_bUnderLine(false)
+,m_uGlyphsGeneration(0)
+,m_obGlyphsSize(CCSizeZero)
 {
     m_obContentSize = CCSizeZero;
 
@@ -152,19 +160,37 @@ void CALabel::updateImage()
     
     
     
-	CAImage* image = CAImage::createWithString(m_nText.c_str(),
-                                               m_nfontName.c_str(),
-                                               m_nfontSize,
-                                               size,
-                                               m_nTextAlignment,
-											   m_nVerticalTextAlignmet, 
-											   m_bWordWrap, 
-											   m_iLineSpacing, 
-											   m_bBold, 
-											   m_bItalics,
-											   m_bUnderLine);
-
-	CC_RETURN_IF(image == NULL);
+    CAImage* image = NULL;
+    CCSize imageSize = CCSizeZero;
+    
+#ifndef EMSCRIPTEN
+    if (s_bGlyphAtlasEnabled && this->updateGlyphs(size))
+    {
+        imageSize = CC_SIZE_PIXELS_TO_POINTS(m_obGlyphsSize);
+    }
+    else
+#endif
+    {
+        m_vGlyphs.clear();
+        m_vGlyphQuads.clear();
+        m_vGlyphTextures.clear();
+        
+        image = CAImage::createWithString(m_nText.c_str(),
+                                          m_nfontName.c_str(),
+                                          m_nfontSize,
+                                          size,
+                                          m_nTextAlignment,
+                                          m_nVerticalTextAlignmet,
+                                          m_bWordWrap,
+                                          m_iLineSpacing,
+                                          m_bBold,
+                                          m_bItalics,
+                                          m_bUnderLine);
+        
+        CC_RETURN_IF(image == NULL);
+        
+        imageSize = image->getContentSize();
+    }
 
     m_cLabelSize = size;
     
@@ -172,7 +198,7 @@ void CALabel::updateImage()
     rect.size.width = this->getBounds().size.width;
     rect.size.height = size.height;
     
-    float width = m_bFitFlag ? image->getContentSize().width : MIN(this->getBounds().size.width, image->getContentSize().width);
+    float width = m_bFitFlag ? imageSize.width : MIN(this->getBounds().size.width, imageSize.width);
     
     rect.size.width = width;
     
@@ -219,6 +245,93 @@ void CALabel::updateImageRect()
     m_sQuad.br.vertices = vertex3(x2, y1, 0);
     m_sQuad.tl.vertices = vertex3(x1, y2, 0);
     m_sQuad.tr.vertices = vertex3(x2, y2, 0);
+    
+    this->updateGlyphQuads();
+}
+
+bool CALabel::updateGlyphs(const CCSize& size)
+{
+    int width = 0, height = 0;
+    if (!g_AFTFontCache.initWithStringGlyphs(m_nText.c_str(),
+                                             m_nfontName.c_str(),
+                                             m_nfontSize,
+                                             size.width,
+                                             size.height,
+                                             m_nTextAlignment,
+                                             m_nVerticalTextAlignmet,
+                                             m_bWordWrap,
+                                             m_iLineSpacing,
+                                             m_bBold,
+                                             m_bItalics,
+                                             m_bUnderLine,
+                                             m_vGlyphs,
+                                             &width,
+                                             &height))
+    {
+        m_vGlyphs.clear();
+        return false;
+    }
+    
+    m_uGlyphsGeneration = CAGlyphAtlas::sharedGlyphAtlas()->getGeneration();
+    m_obGlyphsSize = CCSize(width, height);
+    
+    return true;
+}
+
+void CALabel::updateGlyphQuads()
+{
+    m_vGlyphQuads.clear();
+    m_vGlyphTextures.clear();
+    CC_RETURN_IF(m_vGlyphs.empty());
+    
+    CAGlyphAtlas* pAtlas = CAGlyphAtlas::sharedGlyphAtlas();
+    if (m_uGlyphsGeneration != pAtlas->getGeneration())
+    {
+        m_bUpdateImage = true;
+        return;
+    }
+    
+    // the glyphs are shown through the same window as the image of the text would be
+    float scale = CC_CONTENT_SCALE_FACTOR();
+    float boxWidth = MIN(m_obRect.size.width, m_obGlyphsSize.width / scale);
+    float boxHeight = MIN(m_obRect.size.height, m_obGlyphsSize.height / scale);
+    float top = m_obContentSize.height - pTextHeight;
+    float pageSize = kCAGlyphAtlasPageSize;
+    
+    for (unsigned int i=0; i<m_vGlyphs.size(); i++)
+    {
+        const CATextGlyph& glyph = m_vGlyphs[i];
+        
+        CCRect rect = CC_RECT_PIXELS_TO_POINTS(glyph.rect);
+        float x1 = MAX(rect.getMinX(), 0);
+        float x2 = MIN(rect.getMaxX(), boxWidth);
+        float y1 = MAX(rect.getMinY(), 0);
+        float y2 = MIN(rect.getMaxY(), boxHeight);
+        if (x1 >= x2 || y1 >= y2)
+        {
+            continue;
+        }
+        
+        // texture coordinates of the visible part of the glyph
+        const CCRect& imageRect = glyph.imageRect;
+        float left = (imageRect.origin.x + (x1 - rect.origin.x) / rect.size.width * imageRect.size.width) / pageSize;
+        float right = (imageRect.origin.x + (x2 - rect.origin.x) / rect.size.width * imageRect.size.width) / pageSize;
+        float upper = (imageRect.origin.y + (y1 - rect.origin.y) / rect.size.height * imageRect.size.height) / pageSize;
+        float lower = (imageRect.origin.y + (y2 - rect.origin.y) / rect.size.height * imageRect.size.height) / pageSize;
+        
+        ccV3F_C4B_T2F_Quad quad = m_sQuad;
+        quad.bl.vertices = vertex3(x1, top - y2, 0);
+        quad.br.vertices = vertex3(x2, top - y2, 0);
+        quad.tl.vertices = vertex3(x1, top - y1, 0);
+        quad.tr.vertices = vertex3(x2, top - y1, 0);
+        quad.bl.texCoords = tex2(left, lower);
+        quad.br.texCoords = tex2(right, lower);
+        quad.tl.texCoords = tex2(left, upper);
+        quad.tr.texCoords = tex2(right, upper);
+        
+        m_vGlyphQuads.push_back(quad);
+        m_vGlyphTextures.push_back(pAtlas->getPage(glyph.page)->getName());
+    }
 }
 
 void CALabel::setDimensions(const CCSize& var)
@@ -403,8 +516,24 @@ void CALabel::setContentSize(const CrossApp::CCSize &var)
     }
 }
 
+void CALabel::setGlyphAtlasEnabled(bool bEnabled)
+{
+    s_bGlyphAtlasEnabled = bEnabled;
+}
+
+bool CALabel::isGlyphAtlasEnabled()
+{
+    return s_bGlyphAtlasEnabled;
+}
+
 void CALabel::visit()
 {
+    if (!m_vGlyphs.empty() && m_uGlyphsGeneration != CAGlyphAtlas::sharedGlyphAtlas()->getGeneration())
+    {
+        // the atlas was emptied since the text was laid out
+        m_bUpdateImage = true;
+    }
+    
     if (m_bUpdateImage)
     {
         m_bUpdateImage = false;
@@ -413,6 +542,38 @@ void CALabel::visit()
     CAView::visit();
 }
 
+void CALabel::draw()
+{
+    if (m_vGlyphQuads.empty())
+    {
+        CAView::draw();
+        return;
+    }
+    
+    CC_RETURN_IF(m_pShaderProgram == NULL);
+    
+    kmMat4 matrixMV;
+    kmGLGetMatrix(KM_GL_MODELVIEW, &matrixMV);
+    
+    // same blending as the A8 image of the text
+    ccBlendFunc blendFunc = {GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA};
+    
+    CARenderQueue* pRenderQueue = CARenderQueue::sharedRenderQueue();
+    const CAColor4B& color = m_sQuad.bl.colors;
+    
+    for (unsigned int i=0; i<m_vGlyphQuads.size(); i++)
+    {
+        ccV3F_C4B_T2F_Quad& quad = m_vGlyphQuads[i];
+        quad.bl.colors = quad.br.colors = quad.tl.colors = quad.tr.colors = color;
+        pRenderQueue->addQuad(quad, matrixMV, m_vGlyphTextures[i], m_pShaderProgram, blendFunc);
+    }
+    
+    if (!pRenderQueue->isEnabled())
+    {
+        pRenderQueue->flush();
+    }
+}
+
 void CALabel::applyStyle(const string& sStyleName)
 {
 	const CALabelStyle* pStyle = CALabelStyleCache::sharedStyleCache()->getStyle(sStyleName);
@@ -10,7 +10,9 @@
 #define __project__CALabel__
 
 #include <iostream>
+#include <vector>
 #include "CAView.h"
+#include "images/CAGlyphAtlas.h"
 
 NS_CC_BEGIN
 using namespace std;
@@ -62,6 +64,8 @@ public:
     
     virtual void visit();
     
+    virtual void draw();
+    
     void sizeToFit();
     
     void unsizeToFit();
@@ -72,11 +76,32 @@ public:
     
     void updateImage();
     
+    /** Whether the labels draw their text with the glyphs of the shared glyph atlas
+     instead of rendering it in an image of their own. Default is true.
+     */
+    static void setGlyphAtlasEnabled(bool bEnabled);
+    
+    static bool isGlyphAtlasEnabled();
+    
 protected:
     
     virtual void setContentSize(const CCSize& var);
     
     virtual void updateImageRect();
+    
+    bool updateGlyphs(const CCSize& size);
+    
+    void updateGlyphQuads();
+    
+    std::vector<CATextGlyph> m_vGlyphs;
+    
+    std::vector<ccV3F_C4B_T2F_Quad> m_vGlyphQuads;
+    
+    std::vector<GLuint> m_vGlyphTextures;
+    
+    unsigned int m_uGlyphsGeneration;
+    
+    CCSize m_obGlyphsSize;
         
     bool m_bUpdateImage;
     
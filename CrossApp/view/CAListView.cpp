@@ -1,6 +1,7 @@
 #include "CAListView.h"
 #include "basics/CAApplication.h"
 #include "control/CAButton.h"
+#include "view/CAImageView.h"
 #include "support/CCPointExtension.h"
 #include "basics/CAScheduler.h"
 #include "dispatcher/CATouch.h"
@@ -26,6 +27,11 @@ CAListView::CAListView()
 , m_nListFooterHeight(0)
 , m_obSeparatorColor(CAColor_gray)
 , m_nSeparatorViewHeight(1)
+, m_nIndexs(0)
+, m_nEstimatedCellHeight(0)
+, m_nFirstUsedIndex(0)
+, m_nPrefetchedFirstIndex(1)
+, m_nPrefetchedLastIndex(0)
 {
     
 }
@@ -33,6 +39,7 @@ CAListView::CAListView()
 
 CAListView::~CAListView()
 {
+    CAScheduler::unschedule(schedule_selector(CAListView::prewarmListCell), this);
 	CC_SAFE_RELEASE_NULL(m_pListHeaderView);
 	CC_SAFE_RELEASE_NULL(m_pListFooterView);
     m_pListViewDataSource = NULL;
@@ -117,8 +124,9 @@ void CAListView::reloadViewSizeData()
 	float height = winRect.size.height;
 
     m_nIndexs = 0;
-	m_rIndexRects.clear();
-	m_rLineRects.clear();
+	m_nIndexHeights.clear();
+	m_bIndexMeasured.clear();
+	m_obItemHeights.clear();
 	m_rHeaderRect = m_rFooterRect = CCRectZero;
 
 	int iStartPosition = 0;
@@ -131,27 +139,22 @@ void CAListView::reloadViewSizeData()
 	}
 
 	m_nIndexs = m_pListViewDataSource->numberOfIndex(this);
-    m_rIndexRects.resize(m_nIndexs);
-    m_rLineRects.resize(m_nIndexs);
+	m_nEstimatedCellHeight = m_pListViewDataSource->listViewEstimatedCellHeight(this);
+	m_nIndexHeights.resize(m_nIndexs, m_nEstimatedCellHeight);
+	m_bIndexMeasured.resize(m_nIndexs, m_nEstimatedCellHeight == 0);
+	
+	std::vector<unsigned int> itemHeights(m_nIndexs);
 	for (unsigned i = 0; i < m_nIndexs; i++)
 	{
-		unsigned int cellHeight = m_pListViewDataSource->listViewHeightForIndex(this, i);
-		if (cellHeight > 0)
+		// with an estimate, the cells are measured when they come near the view
+		if (m_nEstimatedCellHeight == 0)
 		{
-			CCRect cellRect = (m_pListViewOrientation == CAListViewOrientationVertical)
-                            ? CCRect(0, iStartPosition, width, cellHeight)
-                            : CCRect(iStartPosition, 0, cellHeight, height);
-			m_rIndexRects[i] = cellRect;
-			iStartPosition += cellHeight;
+			m_nIndexHeights[i] = m_pListViewDataSource->listViewHeightForIndex(this, i);
 		}
-        if (m_nSeparatorViewHeight > 0)
-        {
-            m_rLineRects[i] = (m_pListViewOrientation == CAListViewOrientationVertical)
-            ? CCRect(0, iStartPosition, width, m_nSeparatorViewHeight)
-            : CCRect(iStartPosition, 0, m_nSeparatorViewHeight, height);
-            iStartPosition += m_nSeparatorViewHeight;
-        }
+		itemHeights[i] = m_nIndexHeights[i] + m_nSeparatorViewHeight;
 	}
+	m_obItemHeights.assign(itemHeights);
+	iStartPosition += m_obItemHeights.total();
 
 	if (m_nListFooterHeight > 0)
 	{
@@ -178,15 +181,21 @@ void CAListView::reloadData()
     
     this->reloadViewSizeData();
     
+    // the cells go back to their pools, which are kept with what was prewarmed in them
+    for (size_t i = 0; i < m_pUsedListCells.size(); i++)
+    {
+        this->recycleListCell(m_pUsedListCells[i], m_pUsedLines[i]);
+    }
+    m_pHighlightedListCells = NULL;
+    
     this->removeAllSubviews();
     
     m_pUsedLines.clear();
 	m_pUsedListCells.clear();
-	m_pFreedListCells.clear();
+	m_nFirstUsedIndex = 0;
+	m_nPrefetchedFirstIndex = 1;
+	m_nPrefetchedLastIndex = 0;
     m_pSelectedListCells.clear();
-	
-	CCRect winRect = this->getBounds();
-    winRect.origin = this->getContentOffset();
     
 	if (m_nListHeaderHeight > 0)
 	{
@@ -197,34 +206,6 @@ void CAListView::reloadData()
 		}
 	}
 
-	unsigned int cellCount = m_pListViewDataSource->numberOfIndex(this);
-	for (unsigned i = 0; i < cellCount; i++)
-	{
-		if (m_nIndexs > 0)
-		{
-			std::pair<std::map<unsigned int, CAListViewCell*>::iterator, bool> itrResult =
-				m_pUsedListCells.insert(std::make_pair(i, (CAListViewCell*)NULL));
-
-			CC_CONTINUE_IF(!winRect.intersectsRect(m_rIndexRects[i]));
-
-			CAListViewCell* pCellView = m_pListViewDataSource->listViewCellAtIndex(this, m_rIndexRects[i].size, i);
-			if (pCellView)
-			{
-				pCellView->m_nIndex = i;
-				pCellView->setFrame(m_rIndexRects[i]);
-				addSubview(pCellView);
-				itrResult.first->second = pCellView;
-			}
-		}
-        
-		if (m_nSeparatorViewHeight > 0)
-		{
-			CAView* view = CAView::createWithFrame(m_rLineRects[i], m_obSeparatorColor);
-			addSubview(view);
-            m_pUsedLines[i] = view;
-		}
-	}
-
 	if (m_nListFooterHeight > 0)
 	{
 		if (m_pListFooterView)
@@ -233,6 +214,8 @@ void CAListView::reloadData()
 			addSubview(m_pListFooterView);
 		}
 	}
+    
+    this->loadCollectionCell();
     this->layoutPullToRefreshView();
     this->startDeaccelerateScroll();
 }
@@ -245,7 +228,7 @@ void CAListView::setAllowsSelection(bool var)
 	std::set<unsigned int>::iterator itr;
 	for (itr = m_pSelectedListCells.begin(); itr != m_pSelectedListCells.end(); itr++)
     {
-		if (CAListViewCell* cell = m_pUsedListCells[(*itr)])
+		if (CAListViewCell* cell = this->getUsedCellAtIndex(*itr))
 		{
 			cell->setControlState(CAControlStateNormal);
 		}
@@ -260,7 +243,7 @@ void CAListView::setAllowsMultipleSelection(bool var)
 	std::set<unsigned int>::iterator itr;
 	for (itr = m_pSelectedListCells.begin(); itr != m_pSelectedListCells.end(); itr++)
     {
-		if (CAListViewCell* cell = m_pUsedListCells[(*itr)])
+		if (CAListViewCell* cell = this->getUsedCellAtIndex(*itr))
 		{
 			cell->setControlState(CAControlStateNormal);
 		}
@@ -275,7 +258,7 @@ void CAListView::setSelectAtIndex(unsigned int index)
 		std::set<unsigned int>::iterator itr;
 		for (itr = m_pSelectedListCells.begin(); itr != m_pSelectedListCells.end(); itr++)
 		{
-			if (CAListViewCell* cell = m_pUsedListCells[(*itr)])
+			if (CAListViewCell* cell = this->getUsedCellAtIndex(*itr))
 			{
 				cell->setControlState(CAControlStateNormal);
 			}
@@ -283,7 +266,7 @@ void CAListView::setSelectAtIndex(unsigned int index)
 		m_pSelectedListCells.clear();
 	}
 
-	if (CAListViewCell* cell = m_pUsedListCells[index])
+	if (CAListViewCell* cell = this->getUsedCellAtIndex(index))
 	{
 		cell->setControlStateSelected();
 	}
@@ -292,10 +275,10 @@ void CAListView::setSelectAtIndex(unsigned int index)
 
 void CAListView::setUnSelectAtIndex(unsigned int index)
 {
-    CC_RETURN_IF(index >= m_rIndexRects.size());
+    CC_RETURN_IF(index >= m_nIndexs);
     
     CC_RETURN_IF(m_pSelectedListCells.find(index) == m_pSelectedListCells.end());
-    if (CAListViewCell* cell = m_pUsedListCells.at(index))
+    if (CAListViewCell* cell = this->getUsedCellAtIndex(index))
     {
         cell->setControlStateNormal();
     }
@@ -335,10 +318,10 @@ bool CAListView::ccTouchBegan(CATouch *pTouch, CAEvent *pEvent)
 	{
 		CCPoint point = m_pContainer->convertTouchToNodeSpace(pTouch);
 
-		std::map<unsigned int, CAListViewCell*>::iterator itr;
+		std::deque<CAListViewCell*>::iterator itr;
 		for (itr = m_pUsedListCells.begin(); itr != m_pUsedListCells.end(); ++itr)
 		{
-			CAListViewCell* pCell = itr->second;
+			CAListViewCell* pCell = *itr;
 			CC_CONTINUE_IF(pCell == NULL);
 
 			if (pCell->getFrame().containsPoint(point) && pCell->isVisible())
@@ -414,7 +397,7 @@ void CAListView::ccTouchEnded(CATouch *pTouch, CAEvent *pEvent)
 
 		if (iDeSelectIndex != -1)
 		{
-			if (CAListViewCell* cell = m_pUsedListCells[iDeSelectIndex])
+			if (CAListViewCell* cell = this->getUsedCellAtIndex(iDeSelectIndex))
 			{
 				cell->setControlStateNormal();
 			}
@@ -426,7 +409,7 @@ void CAListView::ccTouchEnded(CATouch *pTouch, CAEvent *pEvent)
 
 		if (iSelectIndex != -1)
 		{
-			if (CAListViewCell* cell = m_pUsedListCells[iSelectIndex])
+			if (CAListViewCell* cell = this->getUsedCellAtIndex(iSelectIndex))
 			{
 				cell->setControlStateSelected();
 			}
@@ -461,79 +444,333 @@ void CAListView::update(float dt)
 	recoveryCollectionCell();
 
 	loadCollectionCell();
+
+	prefetchListCells();
 }
 
 
-void CAListView::recoveryCollectionCell()
+CCRect CAListView::getIndexRect(unsigned int index)
+{
+	float position = m_nListHeaderHeight + m_obItemHeights.prefixSum(index);
+	float length = m_nIndexHeights[index];
+	CCSize size = this->getBounds().size;
+	return (m_pListViewOrientation == CAListViewOrientationVertical)
+           ? CCRect(0, position, size.width, length)
+           : CCRect(position, 0, length, size.height);
+}
+
+CCRect CAListView::getLineRect(unsigned int index)
+{
+	float position = m_nListHeaderHeight + m_obItemHeights.prefixSum(index) + m_nIndexHeights[index];
+	CCSize size = this->getBounds().size;
+	return (m_pListViewOrientation == CAListViewOrientationVertical)
+           ? CCRect(0, position, size.width, m_nSeparatorViewHeight)
+           : CCRect(position, 0, m_nSeparatorViewHeight, size.height);
+}
+
+bool CAListView::getVisibleIndexs(unsigned int& first, unsigned int& last)
 {
 	CCRect rect = this->getBounds();
 	rect.origin = getContentOffset();
-    rect.origin.y -= rect.size.height * 0.1f;
-    rect.size.height *= 1.2f;
-    
-	std::map<unsigned int, CAListViewCell*>::iterator itr;
-	for (itr = m_pUsedListCells.begin(); itr != m_pUsedListCells.end(); itr++)
+
+	float begin = 0, end = 0;
+	if (m_pListViewOrientation == CAListViewOrientationVertical)
 	{
-		CAListViewCell* cell = itr->second;
-		CC_CONTINUE_IF(cell == NULL);
+		rect.origin.y -= rect.size.height * 0.1f;
+		rect.size.height *= 1.2f;
+		begin = rect.getMinY();
+		end = rect.getMaxY();
+	}
+	else
+	{
+		rect.origin.x -= rect.size.width * 0.1f;
+		rect.size.width *= 1.2f;
+		begin = rect.getMinX();
+		end = rect.getMaxX();
+	}
+	return this->getIndexsInRange(begin, end, first, last);
+}
 
-		CCRect cellRect = cell->getFrame();
-		CC_CONTINUE_IF(rect.intersectsRect(cellRect));
+bool CAListView::getIndexsInRange(float begin, float end, unsigned int& first, unsigned int& last)
+{
+	if (m_obItemHeights.empty())
+	{
+		return false;
+	}
 
-		m_pFreedListCells[cell->getReuseIdentifier()].pushBack(cell);
-		cell->removeFromSuperview();
-		cell->resetListViewCell();
-		itr->second = NULL;
-        
-        
-        CAView* line = m_pUsedLines[itr->first];
-        CC_CONTINUE_IF(line == NULL);
-        m_pFreedLines.pushBack(line);
-        line->removeFromSuperview();
-        m_pUsedLines[itr->first] = NULL;
+	begin -= m_nListHeaderHeight;
+	end -= m_nListHeaderHeight;
+	if (end < 0)
+	{
+		return false;
+	}
+
+	// the cells at both ends of the rect, found by bisecting the offsets
+	first = m_obItemHeights.indexOf(begin > 0 ? (unsigned int)begin : 0);
+	last = m_obItemHeights.indexOf((unsigned int)end);
+	if (first >= m_obItemHeights.size())
+	{
+		return false;
 	}
+	last = MIN(last, m_obItemHeights.size() - 1);
+	return true;
 }
 
-void CAListView::loadCollectionCell()
+CAListViewCell* CAListView::getUsedCellAtIndex(unsigned int index)
+{
+	if (index < m_nFirstUsedIndex || index >= m_nFirstUsedIndex + m_pUsedListCells.size())
+	{
+		return NULL;
+	}
+	return m_pUsedListCells[index - m_nFirstUsedIndex];
+}
+
+void CAListView::recycleListCell(CAListViewCell* cell, CAView* line)
+{
+	if (cell)
+	{
+		// the images of the cell are not waited for anymore
+		CAImageView::cancelImageAsyncInView(cell);
+
+		// the cells above the limit of the pool are released by the removal, only the pooled ones are reset
+		CAVector<CAListViewCell*>& freedCells = m_pFreedListCells[cell->getReuseIdentifier()];
+		std::map<std::string, unsigned int>::iterator itr = m_mReusableCellsLimits.find(cell->getReuseIdentifier());
+		if (itr == m_mReusableCellsLimits.end() || freedCells.size() < itr->second)
+		{
+			freedCells.pushBack(cell);
+			cell->removeFromSuperview();
+			cell->resetListViewCell();
+		}
+		else
+		{
+			cell->removeFromSuperview();
+		}
+	}
+
+	if (line)
+	{
+		m_pFreedLines.pushBack(line);
+		line->removeFromSuperview();
+	}
+}
+
+void CAListView::prefetchListCells()
 {
+	CC_RETURN_IF(m_pListViewDataSource == NULL);
+
+	unsigned int visibleFirst = 0, visibleLast = 0;
+	CC_RETURN_IF(!this->getVisibleIndexs(visibleFirst, visibleLast));
+
+	// the cells between the edge of the view and where the scroll is going
 	CCRect rect = this->getBounds();
 	rect.origin = getContentOffset();
-    rect.origin.y -= rect.size.height * 0.1f;
-    rect.size.height *= 1.2f;
-    
-	std::map<unsigned int, CAListViewCell*>::iterator itr;
-	for (itr = m_pUsedListCells.begin(); itr != m_pUsedListCells.end(); itr++)
+
+	float distance = 0, begin = 0, end = 0;
+	if (m_pListViewOrientation == CAListViewOrientationVertical)
 	{
-		CC_CONTINUE_IF(itr->second != NULL);
+		distance = this->getPrefetchDistance().y;
+		rect.origin.y -= rect.size.height * 0.1f;
+		rect.size.height *= 1.2f;
+		begin = distance > 0 ? rect.getMaxY() : rect.getMinY() + distance;
+		end = distance > 0 ? rect.getMaxY() + distance : rect.getMinY();
+	}
+	else
+	{
+		distance = this->getPrefetchDistance().x;
+		rect.origin.x -= rect.size.width * 0.1f;
+		rect.size.width *= 1.2f;
+		begin = distance > 0 ? rect.getMaxX() : rect.getMinX() + distance;
+		end = distance > 0 ? rect.getMaxX() + distance : rect.getMinX();
+	}
+	CC_RETURN_IF(fabsf(distance) < 1.0f);
 
-		unsigned int index = itr->first;
-		CCRect cellRect = m_rIndexRects[index];
-		CC_CONTINUE_IF(!rect.intersectsRect(cellRect));
+	unsigned int first = 0, last = 0;
+	CC_RETURN_IF(!this->getIndexsInRange(begin, end, first, last));
 
-		CAListViewCell* cell = m_pListViewDataSource->listViewCellAtIndex(this, cellRect.size, index);
-		if (cell)
+	std::vector<unsigned int> indexs;
+	for (unsigned int i = first; i <= last; i++)
+	{
+		// neither the cells in view, nor the ones given the last time
+		CC_CONTINUE_IF(i >= visibleFirst && i <= visibleLast);
+		CC_CONTINUE_IF(i >= m_nPrefetchedFirstIndex && i <= m_nPrefetchedLastIndex);
+		indexs.push_back(i);
+	}
+	m_nPrefetchedFirstIndex = first;
+	m_nPrefetchedLastIndex = last;
+
+	CC_RETURN_IF(indexs.empty());
+	m_pListViewDataSource->listViewPrefetchIndexs(this, indexs);
+}
+
+void CAListView::measureIndexsInView()
+{
+	CC_RETURN_IF(m_nEstimatedCellHeight == 0);
+
+	bool bVertical = m_pListViewOrientation == CAListViewOrientationVertical;
+	CCPoint offset = this->getContentOffset();
+	float offsetDelta = 0;
+	bool changed = false;
+
+	// the measured cells move the others in or out of the view, until the cells in view are all measured
+	unsigned int first = 0, last = 0;
+	bool measuring = true;
+	while (measuring && this->getVisibleIndexs(first, last))
+	{
+		measuring = false;
+
+		for (unsigned int index = first; index <= last; index++)
 		{
-            cell->m_nIndex = index;
-            cell->updateDisplayedAlpha(this->getAlpha());
-			addSubview(cell);
-			cell->setFrame(cellRect);
-            m_pUsedListCells[index] = cell;
+			CC_CONTINUE_IF(m_bIndexMeasured[index]);
+			m_bIndexMeasured[index] = true;
+			measuring = true;
+
+			unsigned int height = m_pListViewDataSource->listViewHeightForIndex(this, index);
+			CC_CONTINUE_IF(height == m_nIndexHeights[index]);
+
+			// the cells starting before the view keep the cells in view in place
+			float position = m_nListHeaderHeight + m_obItemHeights.prefixSum(index);
+			if (position < (bVertical ? offset.y : offset.x) + offsetDelta)
+			{
+				offsetDelta += (float)height - (float)m_nIndexHeights[index];
+				CCPoint point = bVertical ? ccp(offset.x, offset.y + offsetDelta) : ccp(offset.x + offsetDelta, offset.y);
+				this->setContainerFrame(ccpMult(point, -1));
+			}
+
+			m_obItemHeights.add(index, (int)height - (int)m_nIndexHeights[index]);
+			m_nIndexHeights[index] = height;
+			changed = true;
 		}
+	}
+
+	if (changed)
+	{
+		this->layoutListViews();
+	}
+}
+
+void CAListView::layoutListViews()
+{
+	for (size_t i = 0; i < m_pUsedListCells.size(); i++)
+	{
+		unsigned int index = m_nFirstUsedIndex + (unsigned int)i;
+		if (m_pUsedListCells[i])
+		{
+			m_pUsedListCells[i]->setFrame(this->getIndexRect(index));
+		}
+		if (m_pUsedLines[i])
+		{
+			m_pUsedLines[i]->setFrame(this->getLineRect(index));
+		}
+	}
+
+	CCSize size = this->getBounds().size;
+	unsigned int position = m_nListHeaderHeight + m_obItemHeights.total();
+	if (m_nListFooterHeight > 0)
+	{
+		m_rFooterRect = (m_pListViewOrientation == CAListViewOrientationVertical)
+                        ? CCRect(0, position, size.width, m_nListFooterHeight)
+                        : CCRect(position, 0, m_nListFooterHeight, size.height);
+		if (m_pListFooterView)
+		{
+			m_pListFooterView->setFrame(m_rFooterRect);
+		}
+		position += m_nListFooterHeight;
+	}
+
+	if (m_pListViewOrientation == CAListViewOrientationVertical)
+	{
+		this->setViewSize(CCSize(size.width, position));
+	}
+	else
+	{
+		this->setViewSize(CCSize(position, size.height));
+	}
+}
+
+void CAListView::recoveryCollectionCell()
+{
+	unsigned int first = 0, last = 0;
+	bool visible = this->getVisibleIndexs(first, last);
+
+	// the cells leave the ring by its ends
+	while (!m_pUsedListCells.empty() && (!visible || m_nFirstUsedIndex < first || m_nFirstUsedIndex > last))
+	{
+		this->recycleListCell(m_pUsedListCells.front(), m_pUsedLines.front());
+		m_pUsedListCells.pop_front();
+		m_pUsedLines.pop_front();
+		++m_nFirstUsedIndex;
+	}
+
+	while (!m_pUsedListCells.empty() && m_nFirstUsedIndex + m_pUsedListCells.size() - 1 > last)
+	{
+		this->recycleListCell(m_pUsedListCells.back(), m_pUsedLines.back());
+		m_pUsedListCells.pop_back();
+		m_pUsedLines.pop_back();
+	}
+}
+
+void CAListView::loadCollectionCell()
+{
+	this->measureIndexsInView();
+
+	unsigned int first = 0, last = 0;
+	CC_RETURN_IF(!this->getVisibleIndexs(first, last));
+
+	// grows the ring to the cells in view
+	if (m_pUsedListCells.empty())
+	{
+		m_nFirstUsedIndex = first;
+	}
+	while (m_nFirstUsedIndex > first)
+	{
+		m_pUsedListCells.push_front(NULL);
+		m_pUsedLines.push_front(NULL);
+		--m_nFirstUsedIndex;
+	}
+	while (m_nFirstUsedIndex + m_pUsedListCells.size() <= last)
+	{
+		m_pUsedListCells.push_back(NULL);
+		m_pUsedLines.push_back(NULL);
+	}
+
+	for (unsigned int index = first; index <= last; index++)
+	{
+		unsigned int i = index - m_nFirstUsedIndex;
+
+		if (m_pUsedLines[i] == NULL && m_nSeparatorViewHeight > 0)
+		{
+			CAView* view = this->dequeueReusableLine();
+			CCRect lineRect = this->getLineRect(index);
+			if (view == NULL)
+			{
+				view = CAView::createWithFrame(lineRect, m_obSeparatorColor);
+			}
+			m_pUsedLines[i] = view;
+			this->insertSubview(view, 1);
+			view->setFrame(lineRect);
+		}
+
+		CC_CONTINUE_IF(m_pUsedListCells[i] || m_nIndexHeights[index] == 0);
+
+		CCRect cellRect = this->getIndexRect(index);
+		
+		// the images of the cells in view are decoded before the prefetched ones
+		int asyncPriority = CAImageView::getAsyncPriority();
+		CAImageView::setAsyncPriority(kCAImageViewAsyncPriorityVisible);
+		CAListViewCell* cell = m_pListViewDataSource->listViewCellAtIndex(this, cellRect.size, index);
+		CAImageView::setAsyncPriority(asyncPriority);
+		CC_CONTINUE_IF(cell == NULL);
+
+		cell->m_nIndex = index;
+		cell->updateDisplayedAlpha(this->getAlpha());
+		addSubview(cell);
+		cell->setFrame(cellRect);
+		m_pUsedListCells[i] = cell;
 
 		if (m_pSelectedListCells.count(index))
 		{
 			cell->setControlStateSelected();
 		}
-        
-        CAView* view = this->dequeueReusableLine();
-        CCRect lineRect = m_rLineRects[index];
-        if (view == NULL)
-        {
-            view = CAView::createWithFrame(lineRect, m_obSeparatorColor);
-        }
-        m_pUsedLines[index] = view;
-        this->insertSubview(view, 1);
-        view->setFrame(lineRect);
 	}
 }
 
@@ -551,6 +788,82 @@ CAListViewCell* CAListView::dequeueReusableCellWithIdentifier(const char* reuseI
 	return cell;
 }
 
+void CAListView::setReusableCellsLimit(const std::string& reuseIdentifier, unsigned int limit)
+{
+	if (limit == 0)
+	{
+		m_mReusableCellsLimits.erase(reuseIdentifier);
+		return;
+	}
+
+	m_mReusableCellsLimits[reuseIdentifier] = limit;
+
+	CAVector<CAListViewCell*>& freedCells = m_pFreedListCells[reuseIdentifier];
+	while (freedCells.size() > limit)
+	{
+		freedCells.popBack();
+	}
+}
+
+void CAListView::prewarmReusableCells(const std::string& reuseIdentifier, unsigned int count)
+{
+	unsigned int size = (unsigned int)m_pFreedListCells[reuseIdentifier].size();
+	CC_RETURN_IF(size >= count);
+
+	m_mPrewarmCounts[reuseIdentifier] = count - size;
+	if (!CAScheduler::isScheduled(schedule_selector(CAListView::prewarmListCell), this))
+	{
+		CAScheduler::schedule(schedule_selector(CAListView::prewarmListCell), this, 0);
+	}
+}
+
+void CAListView::trimReusableCells(unsigned int count)
+{
+	std::map<std::string, CAVector<CAListViewCell*> >::iterator itr;
+	for (itr = m_pFreedListCells.begin(); itr != m_pFreedListCells.end(); itr++)
+	{
+		while (itr->second.size() > count)
+		{
+			itr->second.popBack();
+		}
+	}
+	m_mPrewarmCounts.clear();
+}
+
+void CAListView::prewarmListCell(float dt)
+{
+	CC_UNUSED_PARAM(dt);
+	
+	// the frames of a scroll are left to the cells in view
+	CC_RETURN_IF(m_bTracking || m_bDecelerating);
+
+	while (!m_mPrewarmCounts.empty())
+	{
+		std::map<std::string, unsigned int>::iterator itr = m_mPrewarmCounts.begin();
+		std::map<std::string, unsigned int>::iterator itrLimit = m_mReusableCellsLimits.find(itr->first);
+		if (itr->second == 0 || m_pListViewDataSource == NULL
+			|| (itrLimit != m_mReusableCellsLimits.end() && m_pFreedListCells[itr->first].size() >= itrLimit->second))
+		{
+			m_mPrewarmCounts.erase(itr);
+			continue;
+		}
+
+		CAListViewCell* cell = m_pListViewDataSource->listViewCellWithReuseIdentifier(this, itr->first);
+		if (cell == NULL)
+		{
+			m_mPrewarmCounts.erase(itr);
+			continue;
+		}
+
+		// one cell per frame
+		m_pFreedListCells[cell->getReuseIdentifier()].pushBack(cell);
+		--itr->second;
+		return;
+	}
+
+	CAScheduler::unschedule(schedule_selector(CAListView::prewarmListCell), this);
+}
+
 CAView* CAListView::dequeueReusableLine()
 {
     if (m_pFreedLines.empty())
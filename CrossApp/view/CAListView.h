@@ -15,7 +15,9 @@
 #include "controller/CABarItem.h"
 #include "view/CALabel.h"
 #include "basics/CASTLContainer.h"
+#include "basics/CAFenwickTree.h"
 #include <set>
+#include <deque>
 
 NS_CC_BEGIN
 
@@ -49,7 +51,17 @@ public:
 
 	virtual unsigned int listViewHeightForIndex(CAListView *listView, unsigned int index) = 0;
 
+	// an estimate of the heights of the cells: when it isn't 0, the height of a cell is only
+	// asked when the cell comes near the view, and the layout is corrected then
+	virtual unsigned int listViewEstimatedCellHeight(CAListView *listView) { return 0; };
+
 	virtual CAListViewCell* listViewCellAtIndex(CAListView *listView, const CCSize& cellSize, unsigned int index) = 0;
+
+	// the indexs ahead of the scroll, before their cells are asked
+	virtual void listViewPrefetchIndexs(CAListView *listView, const std::vector<unsigned int>& indexs) {};
+
+	// a cell made in an idle frame for the reuse pool of the identifier, see prewarmReusableCells
+	virtual CAListViewCell* listViewCellWithReuseIdentifier(CAListView *listView, const std::string& reuseIdentifier) { return NULL; };
 };
 
 
@@ -75,6 +87,15 @@ public:
 
 	CAListViewCell* dequeueReusableCellWithIdentifier(const char* reuseIdentifier);
     
+    // the freed cells of the identifier are kept up to the limit, 0 keeps them all
+    void setReusableCellsLimit(const std::string& reuseIdentifier, unsigned int limit);
+    
+    // fills the freed cells of the identifier up to count, one cell per idle frame, with listViewCellWithReuseIdentifier
+    void prewarmReusableCells(const std::string& reuseIdentifier, unsigned int count);
+    
+    // releases the freed cells above count, for every identifier
+    void trimReusableCells(unsigned int count = 0);
+    
     virtual void setAllowsSelection(bool var);
     
     virtual void setAllowsMultipleSelection(bool var);
@@ -123,6 +144,26 @@ protected:
     
     CAView* dequeueReusableLine();
     
+    CCRect getIndexRect(unsigned int index);
+    
+    CCRect getLineRect(unsigned int index);
+    
+    bool getIndexsInRange(float begin, float end, unsigned int& first, unsigned int& last);
+    
+    bool getVisibleIndexs(unsigned int& first, unsigned int& last);
+    
+    void prefetchListCells();
+    
+    void prewarmListCell(float dt);
+    
+    CAListViewCell* getUsedCellAtIndex(unsigned int index);
+    
+    void recycleListCell(CAListViewCell* cell, CAView* line);
+    
+    void measureIndexsInView();
+    
+    void layoutListViews();
+    
 public:
 
 	virtual bool ccTouchBegan(CATouch *pTouch, CAEvent *pEvent);
@@ -183,21 +224,40 @@ private:
 
     unsigned int m_nIndexs;
     
-    std::vector<CCRect> m_rIndexRects;
-
-    std::vector<CCRect> m_rLineRects;
+    std::vector<unsigned int> m_nIndexHeights;
+    
+    // whether the height of a cell was asked to the data source, or is still the estimate
+    std::vector<bool> m_bIndexMeasured;
+    
+    unsigned int m_nEstimatedCellHeight;
     
-	std::map<unsigned int, CAListViewCell*> m_pUsedListCells;
+    // heights of the cells followed by their separator, along the orientation
+    CAFenwickTree m_obItemHeights;
+    
+    // cells in view: a ring of consecutive indexs from m_nFirstUsedIndex
+	std::deque<CAListViewCell*> m_pUsedListCells;
 
 	std::map<std::string, CAVector<CAListViewCell*> > m_pFreedListCells;
     
-    std::map<unsigned int, CAView*> m_pUsedLines;
+    std::deque<CAView*> m_pUsedLines;
+    
+    unsigned int m_nFirstUsedIndex;
     
     CAList<CAView*> m_pFreedLines;
     
     CAListViewCell* m_pHighlightedListCells;
     
     std::set<unsigned int> m_pSelectedListCells;
+    
+    // indexs given to listViewPrefetchIndexs the last time, none if the first is after the last
+    unsigned int m_nPrefetchedFirstIndex;
+    
+    unsigned int m_nPrefetchedLastIndex;
+    
+    std::map<std::string, unsigned int> m_mReusableCellsLimits;
+    
+    // cells left to make for the reuse pools, by identifier
+    std::map<std::string, unsigned int> m_mPrewarmCounts;
 };
 
 class CC_DLL CAListViewCell : public CAControl
@@ -6,6 +6,7 @@
 #include "platform/CCImage.h"
 #include "shaders/CAGLProgram.h"
 #include "shaders/ccGLStateCache.h"
+#include "shaders/CARenderQueue.h"
 #include "support/ccUtils.h"
 #include "images/CAImageCache.h"
 #include "platform/CCFileUtils.h"
@@ -318,6 +319,11 @@ bool CARenderImage::initWithWidthAndHeight(int w, int h, CAImagePixelFormat eFor
 
 void CARenderImage::begin()
 {
+    CARenderQueue::sharedRenderQueue()->flush();
+    
+    // the views are drawn into the image, not on the screen
+    beginVisitRenderTarget();
+    
     kmGLMatrixMode(KM_GL_PROJECTION);
 	kmGLPushMatrix();
 	kmGLMatrixMode(KM_GL_MODELVIEW);
@@ -417,6 +423,10 @@ void CARenderImage::beginWithClear(float r, float g, float b, float a, float dep
 
 void CARenderImage::end()
 {
+    CARenderQueue::sharedRenderQueue()->flush();
+    
+    endVisitRenderTarget();
+    
     CAApplication *director = CAApplication::getApplication();
     
     glBindFramebuffer(GL_FRAMEBUFFER, m_nOldFBO);
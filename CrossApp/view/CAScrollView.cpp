@@ -695,6 +695,31 @@ void CAScrollView::updatePointOffset(float dt)
     }
 }
 
+CCPoint CAScrollView::getPrefetchDistance()
+{
+    CCPoint distance = CCPointZero;
+    
+    if (m_bDecelerating && !m_tInertia.equals(CCPointZero))
+    {
+        // the inertia loses decelerationRatio every frame, the distance left is its sum
+        float ratio = this->decelerationRatio(1/60.0f);
+        if (ratio > FLT_EPSILON)
+        {
+            distance = ccpMult(m_tInertia, 1.0f / ratio);
+        }
+    }
+    else if (m_bTracking && !m_tPointOffset.empty())
+    {
+        distance = ccpMult(m_tPointOffset.back(), 10.0f);
+    }
+    
+    // the content offset moves against the container
+    CCSize size = this->getBounds().size;
+    distance.x = MAX(MIN(-distance.x, size.width), -size.width);
+    distance.y = MAX(MIN(-distance.y, size.height), -size.height);
+    return distance;
+}
+
 void CAScrollView::stopDeaccelerateScroll()
 {
     CAScheduler::unschedule(schedule_selector(CAScrollView::deaccelerateScrolling), this);
@@ -209,6 +209,10 @@ protected:
     
     void updatePointOffset(float dt = 0);
     
+    // how far the content offset is expected to go: what the inertia has left when decelerating,
+    // a few frames of the finger when dragging. No more than the size of the view, either way
+    CCPoint getPrefetchDistance();
+    
 public:
     
     virtual bool ccTouchBegan(CATouch *pTouch, CAEvent *pEvent);
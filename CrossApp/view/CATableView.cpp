@@ -17,6 +17,7 @@
 #include "animation/CAViewAnimation.h"
 #include "actions/CCActionInterval.h"
 #include "actions/CCActionInstant.h"
+#include <algorithm>
 
 NS_CC_BEGIN
 
@@ -37,12 +38,20 @@ CATableView::CATableView()
 ,m_bAllowsMultipleSelection(false)
 ,m_bAlwaysTopSectionHeader(true)
 ,m_bAlwaysBottomSectionFooter(true)
+,m_nEstimatedRowHeight(0)
+,m_nFirstUsedRow(0)
+,m_nUpdatesCount(0)
+,m_nFirstUpdatedItem(0xffffffff)
+,m_nPrefetchedFirstRow(1)
+,m_nPrefetchedLastRow(0)
 {
 
 }
 
 CATableView::~CATableView()
 {
+    CAScheduler::unschedule(schedule_selector(CATableView::prewarmTableCell), this);
+    
     std::map<std::string, CAVector<CATableViewCell*> >::iterator itr;
     for (itr=m_pFreedTableCells.begin(); itr!=m_pFreedTableCells.end(); itr++)
     {
@@ -130,10 +139,10 @@ bool CATableView::ccTouchBegan(CATouch *pTouch, CAEvent *pEvent)
     {
         CCPoint point = m_pContainer->convertTouchToNodeSpace(pTouch);
         
-        std::map<CAIndexPath2E, CATableViewCell*>::iterator itr;
+        std::deque<CATableViewCell*>::iterator itr;
         for (itr=m_pUsedTableCells.begin(); itr!=m_pUsedTableCells.end(); itr++)
         {
-            CATableViewCell* cell = itr->second;
+            CATableViewCell* cell = *itr;
             CC_CONTINUE_IF(cell == NULL);
             if (cell->getFrame().containsPoint(point) && cell->isVisible())
             {
@@ -211,7 +220,7 @@ void CATableView::ccTouchEnded(CATouch *pTouch, CAEvent *pEvent)
 
         if (deselectedIndexPath != CAIndexPath2EZero)
         {
-            if (CATableViewCell* cell = m_pUsedTableCells[deselectedIndexPath])
+            if (CATableViewCell* cell = this->cellForRowAtIndexPath(deselectedIndexPath.section, deselectedIndexPath.row))
             {
                 cell->setControlStateNormal();
             }
@@ -225,7 +234,7 @@ void CATableView::ccTouchEnded(CATouch *pTouch, CAEvent *pEvent)
         
         if (selectedIndexPath != CAIndexPath2EZero)
         {
-            if (CATableViewCell* cell = m_pUsedTableCells[selectedIndexPath])
+            if (CATableViewCell* cell = this->cellForRowAtIndexPath(selectedIndexPath.section, selectedIndexPath.row))
             {
                 cell->setControlStateSelected();
             }
@@ -286,6 +295,126 @@ CATableViewCell* CATableView::dequeueReusableCellWithIdentifier(const char* reus
     return cell;
 }
 
+void CATableView::setReusableCellsLimit(const std::string& reuseIdentifier, unsigned int limit)
+{
+    if (limit == 0)
+    {
+        m_mReusableCellsLimits.erase(reuseIdentifier);
+        return;
+    }
+    
+    m_mReusableCellsLimits[reuseIdentifier] = limit;
+    
+    CAVector<CATableViewCell*>& freedCells = m_pFreedTableCells[reuseIdentifier];
+    while (freedCells.size() > limit)
+    {
+        freedCells.popBack();
+    }
+}
+
+void CATableView::prewarmReusableCells(const std::string& reuseIdentifier, unsigned int count)
+{
+    unsigned int size = (unsigned int)m_pFreedTableCells[reuseIdentifier].size();
+    CC_RETURN_IF(size >= count);
+    
+    m_mPrewarmCounts[reuseIdentifier] = count - size;
+    if (!CAScheduler::isScheduled(schedule_selector(CATableView::prewarmTableCell), this))
+    {
+        CAScheduler::schedule(schedule_selector(CATableView::prewarmTableCell), this, 0);
+    }
+}
+
+void CATableView::trimReusableCells(unsigned int count)
+{
+    std::map<std::string, CAVector<CATableViewCell*> >::iterator itr;
+    for (itr=m_pFreedTableCells.begin(); itr!=m_pFreedTableCells.end(); itr++)
+    {
+        while (itr->second.size() > count)
+        {
+            itr->second.popBack();
+        }
+    }
+    m_mPrewarmCounts.clear();
+}
+
+void CATableView::prewarmTableCell(float dt)
+{
+    CC_UNUSED_PARAM(dt);
+    
+    // the frames of a scroll are left to the cells in view
+    CC_RETURN_IF(m_bTracking || m_bDecelerating);
+    
+    while (!m_mPrewarmCounts.empty())
+    {
+        std::map<std::string, unsigned int>::iterator itr = m_mPrewarmCounts.begin();
+        std::map<std::string, unsigned int>::iterator itrLimit = m_mReusableCellsLimits.find(itr->first);
+        if (itr->second == 0 || m_pTableViewDataSource == NULL
+            || (itrLimit != m_mReusableCellsLimits.end() && m_pFreedTableCells[itr->first].size() >= itrLimit->second))
+        {
+            m_mPrewarmCounts.erase(itr);
+            continue;
+        }
+        
+        CATableViewCell* cell = m_pTableViewDataSource->tableCellWithReuseIdentifier(this, itr->first);
+        if (cell == NULL)
+        {
+            m_mPrewarmCounts.erase(itr);
+            continue;
+        }
+        
+        // one cell per frame
+        m_pFreedTableCells[cell->getReuseIdentifier()].pushBack(cell);
+        --itr->second;
+        return;
+    }
+    
+    CAScheduler::unschedule(schedule_selector(CATableView::prewarmTableCell), this);
+}
+
+void CATableView::prefetchTableCells()
+{
+    CC_RETURN_IF(m_pTableViewDataSource == NULL);
+    
+    unsigned int visibleFirst = 0, visibleLast = 0;
+    CC_RETURN_IF(!this->getVisibleRows(visibleFirst, visibleLast));
+    
+    CCPoint distance = this->getPrefetchDistance();
+    CC_RETURN_IF(fabsf(distance.y) < 1.0f);
+    
+    // the rows between the edge of the view and where the scroll is going
+    CCRect rect = this->getBounds();
+	rect.origin = getContentOffset();
+    rect.origin.y -= rect.size.height * 0.1f;
+    rect.size.height *= 1.2f;
+    
+    float top = distance.y > 0 ? rect.getMaxY() : rect.getMinY() + distance.y;
+    float bottom = distance.y > 0 ? rect.getMaxY() + distance.y : rect.getMinY();
+    
+    unsigned int first = 0, last = 0;
+    CC_RETURN_IF(!this->getRowsInRange(top, bottom, first, last));
+    
+    std::vector<CAIndexPath2E> indexPaths;
+    CAIndexPath2E indexPath = this->getIndexPathOfFlatRow(first);
+    for (unsigned int flatRow=first; flatRow<=last; flatRow++, indexPath.row++)
+    {
+        while (indexPath.row >= m_nRowsInSections[indexPath.section])
+        {
+            ++indexPath.section;
+            indexPath.row = 0;
+        }
+        
+        // neither the rows in view, nor the ones given the last time
+        CC_CONTINUE_IF(flatRow >= visibleFirst && flatRow <= visibleLast);
+        CC_CONTINUE_IF(flatRow >= m_nPrefetchedFirstRow && flatRow <= m_nPrefetchedLastRow);
+        indexPaths.push_back(indexPath);
+    }
+    m_nPrefetchedFirstRow = first;
+    m_nPrefetchedLastRow = last;
+    
+    CC_RETURN_IF(indexPaths.empty());
+    m_pTableViewDataSource->tableViewPrefetchRowsAtIndexPaths(this, indexPaths);
+}
+
 void CATableView::setAllowsSelection(bool var)
 {
     m_bAllowsSelection = var;
@@ -294,7 +423,7 @@ void CATableView::setAllowsSelection(bool var)
     std::set<CAIndexPath2E>::iterator itr;
     for (itr=m_pSelectedTableCells.begin(); itr!=m_pSelectedTableCells.end(); itr++)
     {
-        if (CATableViewCell* cell = m_pUsedTableCells[(*itr)])
+        if (CATableViewCell* cell = this->cellForRowAtIndexPath(itr->section, itr->row))
         {
             cell->setControlState(CAControlStateNormal);
         }
@@ -309,7 +438,7 @@ void CATableView::setAllowsMultipleSelection(bool var)
     std::set<CAIndexPath2E>::iterator itr;
     for (itr=m_pSelectedTableCells.begin(); itr!=m_pSelectedTableCells.end(); itr++)
     {
-        if (CATableViewCell* cell = m_pUsedTableCells[(*itr)])
+        if (CATableViewCell* cell = this->cellForRowAtIndexPath(itr->section, itr->row))
         {
             cell->setControlState(CAControlStateNormal);
         }
@@ -327,7 +456,7 @@ void CATableView::setSelectRowAtIndexPath(unsigned int section, unsigned int row
         std::set<CAIndexPath2E>::iterator itr;
         for (itr=m_pSelectedTableCells.begin(); itr!=m_pSelectedTableCells.end(); itr++)
         {
-            if (CATableViewCell* cell = m_pUsedTableCells[(*itr)])
+            if (CATableViewCell* cell = this->cellForRowAtIndexPath(itr->section, itr->row))
             {
                 cell->setControlState(CAControlStateNormal);
             }
@@ -336,7 +465,7 @@ void CATableView::setSelectRowAtIndexPath(unsigned int section, unsigned int row
     }
     
     CAIndexPath2E indexPath = CAIndexPath2E(section, row);
-    if (CATableViewCell* cell = m_pUsedTableCells[indexPath])
+    if (CATableViewCell* cell = this->cellForRowAtIndexPath(section, row))
     {
         cell->setControlStateSelected();
     }
@@ -346,11 +475,11 @@ void CATableView::setSelectRowAtIndexPath(unsigned int section, unsigned int row
 
 void CATableView::setUnSelectRowAtIndexPath(unsigned int section, unsigned int row)
 {
-    CC_RETURN_IF(section >= m_rSectionRects.size());
+    CC_RETURN_IF(section >= m_nSections);
     
     CAIndexPath2E indexPath = CAIndexPath2E(section, row);
     CC_RETURN_IF(m_pSelectedTableCells.find(indexPath) == m_pSelectedTableCells.end());
-    if (CATableViewCell* cell = m_pUsedTableCells.at(indexPath))
+    if (CATableViewCell* cell = this->cellForRowAtIndexPath(section, row))
     {
         cell->setControlStateNormal();
     }
@@ -360,7 +489,17 @@ void CATableView::setUnSelectRowAtIndexPath(unsigned int section, unsigned int r
 
 CATableViewCell* CATableView::cellForRowAtIndexPath(unsigned int section, unsigned int row)
 {
-    return m_pUsedTableCells[CAIndexPath2E(section, row)];
+    if (section >= m_nSections || row >= m_nRowsInSections[section])
+    {
+        return NULL;
+    }
+    
+    unsigned int flatRow = this->getFlatRow(section, row);
+    if (flatRow < m_nFirstUsedRow || flatRow >= m_nFirstUsedRow + m_pUsedTableCells.size())
+    {
+        return NULL;
+    }
+    return m_pUsedTableCells[flatRow - m_nFirstUsedRow];
 }
 
 void CATableView::clearData()
@@ -375,37 +514,23 @@ void CATableView::clearData()
         itr->clear();
     }
     m_nRowHeightss.clear();
+    m_bRowMeasuredss.clear();
     
-    std::vector<std::vector<CCRect> >::iterator itr2;
-    for (itr2=m_rTableCellRectss.begin(); itr2!=m_rTableCellRectss.end(); itr2++)
-    {
-        itr2->clear();
-    }
-    m_rTableCellRectss.clear();
-    
-    m_rSectionRects.clear();
-    
-    std::vector<std::vector<CCRect> >::iterator itr3;
-    for (itr3=m_rLineRectss.begin(); itr3!=m_rLineRectss.end(); itr3++)
-    {
-        itr3->clear();
-    }
-    m_rLineRectss.clear();
+    m_obItemHeights.clear();
+    m_nSectionItemStarts.clear();
+    m_nFirstUpdatedItem = 0xffffffff;
+    m_nPrefetchedFirstRow = 1;
+    m_nPrefetchedLastRow = 0;
     
     m_pSelectedTableCells.clear();
-    m_pUsedLines.clear();
     
-    std::map<CAIndexPath2E, CATableViewCell*>::iterator itr4;
-    for (itr4=m_pUsedTableCells.begin(); itr4!=m_pUsedTableCells.end(); itr4++)
+    for (size_t i=0; i<m_pUsedTableCells.size(); i++)
     {
-        CATableViewCell* cell = itr4->second;
-        CC_CONTINUE_IF(cell == NULL);
-        m_pFreedTableCells[cell->getReuseIdentifier()].pushBack(cell);
-        itr4->second = NULL;
-        cell->removeFromSuperview();
-        cell->resetTableViewCell();
+        this->recycleTableCell(m_pUsedTableCells[i], m_pUsedLines[i]);
     }
     m_pUsedTableCells.clear();
+    m_pUsedLines.clear();
+    m_nFirstUsedRow = 0;
     m_pSectionHeaderViews.clear();
     m_pSectionHeaderViews.clear();
 }
@@ -436,9 +561,21 @@ void CATableView::reloadViewSizeData()
         m_nSectionFooterHeights[i] = sectionFooterHeight;
     }
     
+    m_nEstimatedRowHeight = m_pTableViewDataSource->tableViewEstimatedRowHeight(this);
+    
     m_nRowHeightss.resize(m_nSections);
+    m_bRowMeasuredss.resize(m_nSections);
     for (unsigned int i=0; i<m_nSections; i++)
     {
+        if (m_nEstimatedRowHeight > 0)
+        {
+            // the rows are measured when they come near the view
+            m_nRowHeightss[i].assign(m_nRowsInSections.at(i), m_nEstimatedRowHeight);
+            m_bRowMeasuredss[i].assign(m_nRowsInSections.at(i), false);
+            continue;
+        }
+        
+        m_bRowMeasuredss[i].assign(m_nRowsInSections.at(i), true);
         std::vector<unsigned int> rowHeights(m_nRowsInSections.at(i));
         for (unsigned int j=0; j<m_nRowsInSections.at(i); j++)
         {
@@ -450,20 +587,31 @@ void CATableView::reloadViewSizeData()
     
     unsigned int viewHeight = 0;
     
+    // every section lays out its header, its rows followed by their separator and its footer
+    std::vector<unsigned int> itemHeights;
+    m_nSectionItemStarts.resize(m_nSections + 1);
     m_nSectionHeights.resize(m_nSections);
     for (unsigned int i=0; i<m_nSections; i++)
     {
+        m_nSectionItemStarts[i] = (unsigned int)itemHeights.size();
+        
         unsigned int sectionHeight = 0;
         sectionHeight += m_nSectionHeaderHeights.at(i);
-        sectionHeight += m_nSectionFooterHeights.at(i);
+        itemHeights.push_back(m_nSectionHeaderHeights.at(i));
         for (unsigned int j=0; j<m_nRowHeightss.at(i).size(); j++)
         {
-            sectionHeight += m_nRowHeightss.at(i).at(j);
-            sectionHeight += m_nSeparatorViewHeight;
+            unsigned int rowHeight = m_nRowHeightss.at(i).at(j) + m_nSeparatorViewHeight;
+            sectionHeight += rowHeight;
+            itemHeights.push_back(rowHeight);
         }
+        sectionHeight += m_nSectionFooterHeights.at(i);
+        itemHeights.push_back(m_nSectionFooterHeights.at(i));
+        
         m_nSectionHeights[i] = sectionHeight;
         viewHeight += sectionHeight;
     }
+    m_nSectionItemStarts[m_nSections] = (unsigned int)itemHeights.size();
+    m_obItemHeights.assign(itemHeights);
     
     viewHeight += m_nTableHeaderHeight;
     viewHeight += m_nTableFooterHeight;
@@ -489,13 +637,11 @@ void CATableView::reloadData()
         y += m_nTableHeaderHeight;
     }
     
-    unsigned int sectionCount = m_pTableViewDataSource->numberOfSections(this);
-    
-    m_rTableCellRectss.resize(sectionCount);
-    m_rLineRectss.resize(sectionCount);
-    for (unsigned int i=0; i<sectionCount; i++)
+    for (unsigned int i=0; i<m_nSections; i++)
     {
-        CCRect sectionHeaderRect = CCRect(0, y, width, m_nSectionHeaderHeights.at(i));
+        CCRect sectionRect = this->getSectionRect(i);
+        
+        CCRect sectionHeaderRect = CCRect(0, sectionRect.origin.y, width, m_nSectionHeaderHeights.at(i));
         CAView* sectionHeaderView = m_pTableViewDataSource->tableViewSectionViewForHeaderInSection(this, sectionHeaderRect.size, i);
         
         //CC_DEPRECATED_ATTRIBUTE
@@ -510,20 +656,11 @@ void CATableView::reloadData()
             this->insertSubview(sectionHeaderView, 2);
             m_pSectionHeaderViews[i] = sectionHeaderView;
         }
-         y += m_nSectionHeaderHeights[i];
         
-        m_rTableCellRectss[i].resize(m_nRowHeightss[i].size());
-        m_rLineRectss[i].resize(m_nRowHeightss[i].size());
-        for (unsigned int j=0; j<m_rTableCellRectss[i].size(); j++)
-        {
-            m_rTableCellRectss[i][j] = CCRect(0, y, width, m_nRowHeightss[i][j]);
-            y += m_nRowHeightss[i][j];
-            
-            m_rLineRectss[i][j] = CCRect(0, y, width, m_nSeparatorViewHeight);
-            y += m_nSeparatorViewHeight;
-        }
-        
-        CCRect sectionFooterRect = CCRect(0, y, width, m_nSectionFooterHeights.at(i));
+        CCRect sectionFooterRect = CCRect(0,
+                                          sectionRect.origin.y + sectionRect.size.height - m_nSectionFooterHeights.at(i),
+                                          width,
+                                          m_nSectionFooterHeights.at(i));
         
         CAView* sectionFooterView = m_pTableViewDataSource->tableViewSectionViewForFooterInSection(this, sectionFooterRect.size, i);
         
@@ -539,15 +676,8 @@ void CATableView::reloadData()
             this->insertSubview(sectionFooterView, 2);
             m_pSectionFooterViews[i] = sectionFooterView;
         }
-        
-        CCRect sectionRect = sectionHeaderRect;
-        sectionRect.size.height = sectionFooterRect.origin.y
-                                + sectionFooterRect.size.height
-                                - sectionHeaderRect.origin.y;
-        m_rSectionRects.push_back(sectionRect);
-        
-        y += m_nSectionFooterHeights.at(i);
     }
+    y += m_obItemHeights.total();
     
     if (m_pTableFooterView)
     {
@@ -568,74 +698,348 @@ void CATableView::firstReloadData()
     this->reloadData();
 }
 
-void CATableView::loadTableCell()
+unsigned int CATableView::getFlatRow(unsigned int section, unsigned int row)
+{
+    // the header and the footer of every section before are items too
+    return m_nSectionItemStarts[section] - 2 * section + row;
+}
+
+CAIndexPath2E CATableView::getIndexPathOfFlatRow(unsigned int flatRow)
+{
+    // the last section starting at or before the row
+    unsigned int begin = 0;
+    unsigned int end = m_nSections;
+    while (end - begin > 1)
+    {
+        unsigned int mid = (begin + end) / 2;
+        if (m_nSectionItemStarts[mid] - 2 * mid <= flatRow)
+        {
+            begin = mid;
+        }
+        else
+        {
+            end = mid;
+        }
+    }
+    return CAIndexPath2E(begin, flatRow - (m_nSectionItemStarts[begin] - 2 * begin));
+}
+
+unsigned int CATableView::getSectionOfItem(unsigned int item)
+{
+    std::vector<unsigned int>::iterator itr = std::upper_bound(m_nSectionItemStarts.begin(), m_nSectionItemStarts.end(), item);
+    return (unsigned int)(itr - m_nSectionItemStarts.begin()) - 1;
+}
+
+unsigned int CATableView::getItemsOriginY()
+{
+    // the sections start below the table header view
+    return m_pTableHeaderView ? m_nTableHeaderHeight : 0;
+}
+
+CCRect CATableView::getSectionRect(unsigned int section)
+{
+    unsigned int begin = m_obItemHeights.prefixSum(m_nSectionItemStarts[section]);
+    unsigned int end = m_obItemHeights.prefixSum(m_nSectionItemStarts[section + 1]);
+    return CCRect(0, this->getItemsOriginY() + begin, this->getBounds().size.width, end - begin);
+}
+
+CCRect CATableView::getRowRect(unsigned int section, unsigned int row)
+{
+    unsigned int y = m_obItemHeights.prefixSum(m_nSectionItemStarts[section] + 1 + row);
+    return CCRect(0, this->getItemsOriginY() + y, this->getBounds().size.width, m_nRowHeightss[section][row]);
+}
+
+CCRect CATableView::getLineRect(unsigned int section, unsigned int row)
+{
+    CCRect rect = this->getRowRect(section, row);
+    rect.origin.y += rect.size.height;
+    rect.size.height = m_nSeparatorViewHeight;
+    return rect;
+}
+
+bool CATableView::getVisibleRows(unsigned int& first, unsigned int& last)
 {
     CCRect rect = this->getBounds();
 	rect.origin = getContentOffset();
     rect.origin.y -= rect.size.height * 0.1f;
     rect.size.height *= 1.2f;
     
-    for (size_t i=0; i<m_rTableCellRectss.size(); i++)
+    return this->getRowsInRange(rect.getMinY(), rect.getMaxY(), first, last);
+}
+
+bool CATableView::getRowsInRange(float top, float bottom, unsigned int& first, unsigned int& last)
+{
+    if (m_obItemHeights.empty())
+    {
+        return false;
+    }
+    
+    top -= this->getItemsOriginY();
+    bottom -= this->getItemsOriginY();
+    if (bottom < 0)
+    {
+        return false;
+    }
+    
+    // the items at both ends of the rect, found by bisecting the offsets
+    unsigned int firstItem = m_obItemHeights.indexOf(top > 0 ? (unsigned int)top : 0);
+    unsigned int lastItem = m_obItemHeights.indexOf((unsigned int)bottom);
+    if (firstItem >= m_obItemHeights.size())
+    {
+        return false;
+    }
+    lastItem = MIN(lastItem, m_obItemHeights.size() - 1);
+    
+    // the first row at or after the first item, and the rows up to the last item
+    unsigned int section = this->getSectionOfItem(firstItem);
+    first = firstItem - 2 * section - (firstItem > m_nSectionItemStarts[section] ? 1 : 0);
+    
+    section = this->getSectionOfItem(lastItem);
+    unsigned int local = lastItem - m_nSectionItemStarts[section];
+    unsigned int rows = lastItem - 2 * section - (local > 0 ? 1 : 0);
+    if (local > 0 && local <= m_nRowsInSections[section])
     {
-        for (size_t j=0; j<m_rTableCellRectss.at(i).size(); j++)
+        ++rows;
+    }
+    if (rows <= first)
+    {
+        return false;
+    }
+    last = rows - 1;
+    
+    return true;
+}
+
+void CATableView::recycleTableCell(CATableViewCell* cell, CAView* line)
+{
+    if (cell && cell == m_pHighlightedTableCells)
+    {
+        m_pContainer->stopAllActions();
+        m_pHighlightedTableCells = NULL;
+    }
+    
+    if (cell)
+    {
+        // the images of the cell are not waited for anymore
+        CAImageView::cancelImageAsyncInView(cell);
+        
+        // the cells above the limit of the pool are released by the removal, only the pooled ones are reset
+        CAVector<CATableViewCell*>& freedCells = m_pFreedTableCells[cell->getReuseIdentifier()];
+        std::map<std::string, unsigned int>::iterator itr = m_mReusableCellsLimits.find(cell->getReuseIdentifier());
+        if (itr == m_mReusableCellsLimits.end() || freedCells.size() < itr->second)
         {
-            CAIndexPath2E indexPath = CAIndexPath2E(i, j);
-            CC_CONTINUE_IF(m_pUsedTableCells.count(indexPath) && m_pUsedTableCells[indexPath]);
-            CCRect cellRect = m_rTableCellRectss[i][j];
-            CC_CONTINUE_IF(!rect.intersectsRect(cellRect));
-            CATableViewCell* cell = m_pTableViewDataSource->tableCellAtIndex(this, m_rTableCellRectss[i][j].size, i, j);
-            CC_CONTINUE_IF(cell == NULL);
-            cell->m_nSection = i;
-            cell->m_nRow = j;
-            cell->updateDisplayedAlpha(this->getAlpha());
-            m_pContainer->addSubview(cell);
-            cell->setFrame(m_rTableCellRectss[i][j]);
-            m_pUsedTableCells[indexPath] = cell;
-            if (m_pSelectedTableCells.count(indexPath))
+            freedCells.pushBack(cell);
+            cell->removeFromSuperview();
+            cell->resetTableViewCell();
+        }
+        else
+        {
+            cell->removeFromSuperview();
+        }
+    }
+    
+    if (line)
+    {
+        m_pFreedLines.pushBack(line);
+        line->removeFromSuperview();
+    }
+}
+
+void CATableView::setRowHeight(unsigned int section, unsigned int row, unsigned int height)
+{
+    int delta = (int)height - (int)m_nRowHeightss[section][row];
+    m_nRowHeightss[section][row] = height;
+    m_nSectionHeights[section] += delta;
+    m_obItemHeights.add(m_nSectionItemStarts[section] + 1 + row, delta);
+}
+
+void CATableView::measureRowsInView()
+{
+    CC_RETURN_IF(m_nEstimatedRowHeight == 0);
+    
+    CCPoint offset = this->getContentOffset();
+    float offsetDelta = 0;
+    bool changed = false;
+    
+    // the measured rows move the others in or out of the view, until the rows in view are all measured
+    unsigned int first = 0, last = 0;
+    bool measuring = true;
+    while (measuring && this->getVisibleRows(first, last))
+    {
+        measuring = false;
+        
+        CAIndexPath2E indexPath = this->getIndexPathOfFlatRow(first);
+        for (unsigned int flatRow=first; flatRow<=last; flatRow++, indexPath.row++)
+        {
+            while (indexPath.row >= m_nRowsInSections[indexPath.section])
             {
-                cell->setControlStateSelected();
+                ++indexPath.section;
+                indexPath.row = 0;
             }
             
-            CAView* view = this->dequeueReusableLine();
-            CCRect lineRect = m_rLineRectss[i][j];
-            if (view == NULL)
+            unsigned int i = indexPath.section;
+            unsigned int j = indexPath.row;
+            CC_CONTINUE_IF(m_bRowMeasuredss[i][j]);
+            m_bRowMeasuredss[i][j] = true;
+            measuring = true;
+            
+            unsigned int height = m_pTableViewDataSource->tableViewHeightForRowAtIndexPath(this, i, j);
+            CC_CONTINUE_IF(height == m_nRowHeightss[i][j]);
+            
+            // the rows starting above the view keep the rows in view in place
+            if (this->getRowRect(i, j).origin.y < offset.y + offsetDelta)
             {
-                view = CAView::createWithFrame(lineRect, m_obSeparatorColor);
+                offsetDelta += (float)height - (float)m_nRowHeightss[i][j];
+                this->setContainerFrame(ccpMult(ccp(offset.x, offset.y + offsetDelta), -1));
             }
-            m_pUsedLines[indexPath] = view;
-            this->insertSubview(view, 1);
-            view->setFrame(lineRect);
+            
+            this->setRowHeight(i, j, height);
+            changed = true;
         }
     }
+    
+    if (changed)
+    {
+        this->layoutTableViews();
+    }
 }
 
-void CATableView::recoveryTableCell()
+void CATableView::layoutTableViews()
 {
-    CCRect rect = this->getBounds();
-	rect.origin = getContentOffset();
-    rect.origin.y -= rect.size.height * 0.1f;
-    rect.size.height *= 1.2f;
+    float width = this->getBounds().size.width;
     
-    std::map<CAIndexPath2E, CATableViewCell*>::iterator itr;
-    for (itr=m_pUsedTableCells.begin();
-         itr!=m_pUsedTableCells.end();
-         itr++)
+    for (unsigned int i=0; i<m_nSections; i++)
     {
-        CATableViewCell* cell = itr->second;
-        CC_CONTINUE_IF(cell == NULL);
-        CCRect cellRect = cell->getFrame();
+        CCRect sectionRect = this->getSectionRect(i);
+        
+        std::map<int, CAView*>::iterator itr = m_pSectionHeaderViews.find(i);
+        if (itr != m_pSectionHeaderViews.end())
+        {
+            itr->second->setFrame(CCRect(0, sectionRect.origin.y, width, m_nSectionHeaderHeights[i]));
+        }
+        
+        itr = m_pSectionFooterViews.find(i);
+        if (itr != m_pSectionFooterViews.end())
+        {
+            itr->second->setFrame(CCRect(0,
+                                         sectionRect.origin.y + sectionRect.size.height - m_nSectionFooterHeights[i],
+                                         width,
+                                         m_nSectionFooterHeights[i]));
+        }
+    }
+    
+    for (size_t i=0; i<m_pUsedTableCells.size(); i++)
+    {
+        CAIndexPath2E indexPath = this->getIndexPathOfFlatRow(m_nFirstUsedRow + (unsigned int)i);
+        if (m_pUsedTableCells[i])
+        {
+            m_pUsedTableCells[i]->setFrame(this->getRowRect(indexPath.section, indexPath.row));
+        }
+        if (m_pUsedLines[i])
+        {
+            m_pUsedLines[i]->setFrame(this->getLineRect(indexPath.section, indexPath.row));
+        }
+    }
+    
+    unsigned int y = this->getItemsOriginY() + m_obItemHeights.total();
+    if (m_pTableFooterView)
+    {
+        m_pTableFooterView->setFrame(CCRect(0, y, width, m_nTableFooterHeight));
+    }
+    
+    CCSize size = this->getBounds().size;
+    size.height = m_nTableHeaderHeight + m_obItemHeights.total() + m_nTableFooterHeight;
+    this->setViewSize(size);
+}
 
-        CC_CONTINUE_IF(rect.intersectsRect(cellRect));
-        m_pFreedTableCells[cell->getReuseIdentifier()].pushBack(cell);
-        cell->removeFromSuperview();
-        cell->resetTableViewCell();
-        itr->second = NULL;
+void CATableView::loadTableCell()
+{
+    this->measureRowsInView();
+    
+    unsigned int first = 0, last = 0;
+    CC_RETURN_IF(!this->getVisibleRows(first, last));
+    
+    // grows the ring to the rows in view
+    if (m_pUsedTableCells.empty())
+    {
+        m_nFirstUsedRow = first;
+    }
+    while (m_nFirstUsedRow > first)
+    {
+        m_pUsedTableCells.push_front(NULL);
+        m_pUsedLines.push_front(NULL);
+        --m_nFirstUsedRow;
+    }
+    while (m_nFirstUsedRow + m_pUsedTableCells.size() <= last)
+    {
+        m_pUsedTableCells.push_back(NULL);
+        m_pUsedLines.push_back(NULL);
+    }
+    
+    CAIndexPath2E indexPath = this->getIndexPathOfFlatRow(first);
+    for (unsigned int flatRow=first; flatRow<=last; flatRow++, indexPath.row++)
+    {
+        while (indexPath.row >= m_nRowsInSections[indexPath.section])
+        {
+            ++indexPath.section;
+            indexPath.row = 0;
+        }
         
-        CAView* line = m_pUsedLines[itr->first];
-        CC_CONTINUE_IF(line == NULL);
-        m_pFreedLines.pushBack(line);
-        line->removeFromSuperview();
-        m_pUsedLines[itr->first] = NULL;
+        unsigned int index = flatRow - m_nFirstUsedRow;
+        CC_CONTINUE_IF(m_pUsedTableCells[index]);
+        
+        unsigned int i = indexPath.section;
+        unsigned int j = indexPath.row;
+        CCRect cellRect = this->getRowRect(i, j);
+        
+        // the images of the cells in view are decoded before the prefetched ones
+        int asyncPriority = CAImageView::getAsyncPriority();
+        CAImageView::setAsyncPriority(kCAImageViewAsyncPriorityVisible);
+        CATableViewCell* cell = m_pTableViewDataSource->tableCellAtIndex(this, cellRect.size, i, j);
+        CAImageView::setAsyncPriority(asyncPriority);
+        CC_CONTINUE_IF(cell == NULL);
+        cell->m_nSection = i;
+        cell->m_nRow = j;
+        cell->updateDisplayedAlpha(this->getAlpha());
+        m_pContainer->addSubview(cell);
+        cell->setFrame(cellRect);
+        m_pUsedTableCells[index] = cell;
+        if (m_pSelectedTableCells.count(indexPath))
+        {
+            cell->setControlStateSelected();
+        }
+        
+        CAView* view = this->dequeueReusableLine();
+        CCRect lineRect = this->getLineRect(i, j);
+        if (view == NULL)
+        {
+            view = CAView::createWithFrame(lineRect, m_obSeparatorColor);
+        }
+        m_pUsedLines[index] = view;
+        this->insertSubview(view, 1);
+        view->setFrame(lineRect);
+    }
+}
+
+void CATableView::recoveryTableCell()
+{
+    unsigned int first = 0, last = 0;
+    bool visible = this->getVisibleRows(first, last);
+    
+    // the rows leave the ring by its ends
+    while (!m_pUsedTableCells.empty() && (!visible || m_nFirstUsedRow < first || m_nFirstUsedRow > last))
+    {
+        this->recycleTableCell(m_pUsedTableCells.front(), m_pUsedLines.front());
+        m_pUsedTableCells.pop_front();
+        m_pUsedLines.pop_front();
+        ++m_nFirstUsedRow;
+    }
+    
+    while (!m_pUsedTableCells.empty() && m_nFirstUsedRow + m_pUsedTableCells.size() - 1 > last)
+    {
+        this->recycleTableCell(m_pUsedTableCells.back(), m_pUsedLines.back());
+        m_pUsedTableCells.pop_back();
+        m_pUsedLines.pop_back();
     }
 }
 
@@ -653,14 +1057,26 @@ CAView* CATableView::dequeueReusableLine()
 
 void CATableView::updateSectionHeaderAndFooterRects()
 {
+    CC_RETURN_IF(m_obItemHeights.empty());
+    
     CCRect rect = this->getBounds();
 	rect.origin = getContentOffset();
     
-    std::vector<CCRect>::iterator itr;
-    for (itr=m_rSectionRects.begin(); itr!=m_rSectionRects.end(); itr++)
+    float top = rect.getMinY() - this->getItemsOriginY();
+    float bottom = rect.getMaxY() - this->getItemsOriginY();
+    CC_RETURN_IF(bottom < 0);
+    
+    // only the sections in view
+    unsigned int firstItem = m_obItemHeights.indexOf(top > 0 ? (unsigned int)top : 0);
+    unsigned int lastItem = m_obItemHeights.indexOf((unsigned int)bottom);
+    CC_RETURN_IF(firstItem >= m_obItemHeights.size());
+    lastItem = MIN(lastItem, m_obItemHeights.size() - 1);
+    
+    unsigned int lastSection = this->getSectionOfItem(lastItem);
+    for (unsigned int i=this->getSectionOfItem(firstItem); i<=lastSection; i++)
     {
-        CC_CONTINUE_IF(!rect.intersectsRect(*itr));
-        int i = itr - m_rSectionRects.begin();
+        CCRect sectionRect = this->getSectionRect(i);
+        CC_CONTINUE_IF(!rect.intersectsRect(sectionRect));
         CAView* header = NULL;
         CAView* footer = NULL;
         float headerHeight = m_nSectionHeaderHeights[i];
@@ -676,8 +1092,8 @@ void CATableView::updateSectionHeaderAndFooterRects()
         if (header && m_bAlwaysTopSectionHeader)
         {
             CCPoint p1 = rect.origin;
-            p1.y = MAX(p1.y, itr->origin.y);
-            p1.y = MIN(p1.y, itr->origin.y + itr->size.height
+            p1.y = MAX(p1.y, sectionRect.origin.y);
+            p1.y = MIN(p1.y, sectionRect.origin.y + sectionRect.size.height
                        - headerHeight - footerHeight);
             header->setFrameOrigin(p1);
         }
@@ -685,8 +1101,8 @@ void CATableView::updateSectionHeaderAndFooterRects()
         {
             CCPoint p2 = CCPointZero;
             p2.y = MIN(rect.origin.y + this->getBounds().size.height - footerHeight,
-                       itr->origin.y + itr->size.height - footerHeight);
-            p2.y = MAX(p2.y, itr->origin.y + headerHeight);
+                       sectionRect.origin.y + sectionRect.size.height - footerHeight);
+            p2.y = MAX(p2.y, sectionRect.origin.y + headerHeight);
             footer->setFrameOrigin(p2);
         }
     }
@@ -696,6 +1112,284 @@ void CATableView::update(float dt)
 {
     CAScrollView::update(dt);
     
+    // the rows are being changed, endUpdates lays them out
+    CC_RETURN_IF(m_nUpdatesCount > 0);
+    
+    this->recoveryTableCell();
+    this->loadTableCell();
+    this->updateSectionHeaderAndFooterRects();
+    this->prefetchTableCells();
+}
+
+void CATableView::beginUpdates()
+{
+    ++m_nUpdatesCount;
+}
+
+void CATableView::endUpdates()
+{
+    CC_RETURN_IF(m_nUpdatesCount == 0);
+    --m_nUpdatesCount;
+    CC_RETURN_IF(m_nUpdatesCount > 0);
+    
+    this->applyUpdates();
+}
+
+void CATableView::insertRowsAtIndexPaths(const std::vector<CAIndexPath2E>& indexPaths)
+{
+    CC_RETURN_IF(m_pTableViewDataSource == NULL);
+    
+    // the lower rows are inserted first, so every index path is the one of the new row
+    std::vector<CAIndexPath2E> sorted = indexPaths;
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+    
+    this->beginUpdates();
+    for (size_t i=0; i<sorted.size(); i++)
+    {
+        unsigned int section = sorted[i].section;
+        unsigned int row = sorted[i].row;
+        CC_CONTINUE_IF(section >= m_nSections || row > m_nRowsInSections[section]);
+        
+        unsigned int height = m_nEstimatedRowHeight;
+        if (height == 0)
+        {
+            height = m_pTableViewDataSource->tableViewHeightForRowAtIndexPath(this, section, row);
+        }
+        this->insertRowItem(section, row, height, m_nEstimatedRowHeight == 0, NULL, NULL);
+    }
+    this->endUpdates();
+}
+
+void CATableView::deleteRowsAtIndexPaths(const std::vector<CAIndexPath2E>& indexPaths)
+{
+    // the higher rows are deleted first, so every index path is the one of the row before the call
+    std::vector<CAIndexPath2E> sorted = indexPaths;
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+    
+    this->beginUpdates();
+    std::vector<CAIndexPath2E>::reverse_iterator itr;
+    for (itr=sorted.rbegin(); itr!=sorted.rend(); itr++)
+    {
+        CC_CONTINUE_IF(itr->section >= m_nSections || itr->row >= m_nRowsInSections[itr->section]);
+        
+        CATableViewCell* cell = NULL;
+        CAView* line = NULL;
+        this->eraseRowItem(itr->section, itr->row, cell, line);
+        this->recycleTableCell(cell, line);
+    }
+    this->endUpdates();
+}
+
+void CATableView::reloadRowsAtIndexPaths(const std::vector<CAIndexPath2E>& indexPaths)
+{
+    CC_RETURN_IF(m_pTableViewDataSource == NULL);
+    
+    this->beginUpdates();
+    std::vector<CAIndexPath2E>::const_iterator itr;
+    for (itr=indexPaths.begin(); itr!=indexPaths.end(); itr++)
+    {
+        unsigned int section = itr->section;
+        unsigned int row = itr->row;
+        CC_CONTINUE_IF(section >= m_nSections || row >= m_nRowsInSections[section]);
+        
+        // with an estimate, the row is measured again when it is in view
+        unsigned int height = m_nRowHeightss[section][row];
+        m_bRowMeasuredss[section][row] = m_nEstimatedRowHeight == 0;
+        if (m_nEstimatedRowHeight == 0)
+        {
+            height = m_pTableViewDataSource->tableViewHeightForRowAtIndexPath(this, section, row);
+        }
+        
+        if (height != m_nRowHeightss[section][row])
+        {
+            m_nSectionHeights[section] += (int)height - (int)m_nRowHeightss[section][row];
+            m_nRowHeightss[section][row] = height;
+            m_nFirstUpdatedItem = MIN(m_nFirstUpdatedItem, m_nSectionItemStarts[section] + 1 + row);
+        }
+        
+        unsigned int flatRow = this->getFlatRow(section, row);
+        if (flatRow >= m_nFirstUsedRow && flatRow < m_nFirstUsedRow + m_pUsedTableCells.size())
+        {
+            unsigned int index = flatRow - m_nFirstUsedRow;
+            this->recycleTableCell(m_pUsedTableCells[index], m_pUsedLines[index]);
+            m_pUsedTableCells[index] = NULL;
+            m_pUsedLines[index] = NULL;
+        }
+    }
+    this->endUpdates();
+}
+
+void CATableView::moveRowAtIndexPath(const CAIndexPath2E& indexPath, const CAIndexPath2E& newIndexPath)
+{
+    CC_RETURN_IF(indexPath == newIndexPath);
+    CC_RETURN_IF(indexPath.section >= m_nSections || indexPath.row >= m_nRowsInSections[indexPath.section]);
+    CC_RETURN_IF(newIndexPath.section >= m_nSections);
+    
+    unsigned int rows = m_nRowsInSections[newIndexPath.section];
+    if (newIndexPath.section == indexPath.section)
+    {
+        --rows;
+    }
+    CC_RETURN_IF(newIndexPath.row > rows);
+    
+    unsigned int height = m_nRowHeightss[indexPath.section][indexPath.row];
+    bool measured = m_bRowMeasuredss[indexPath.section][indexPath.row];
+    bool selected = m_pSelectedTableCells.erase(indexPath) > 0;
+    
+    this->beginUpdates();
+    
+    CATableViewCell* cell = NULL;
+    CAView* line = NULL;
+    this->eraseRowItem(indexPath.section, indexPath.row, cell, line);
+    this->insertRowItem(newIndexPath.section, newIndexPath.row, height, measured, cell, line);
+    
+    if (selected)
+    {
+        m_pSelectedTableCells.insert(newIndexPath);
+    }
+    
+    this->endUpdates();
+}
+
+void CATableView::insertRowItem(unsigned int section, unsigned int row, unsigned int height, bool measured, CATableViewCell* cell, CAView* line)
+{
+    this->shiftRowsInSection(section, row, 1);
+    
+    m_nRowHeightss[section].insert(m_nRowHeightss[section].begin() + row, height);
+    m_bRowMeasuredss[section].insert(m_bRowMeasuredss[section].begin() + row, measured);
+    ++m_nRowsInSections[section];
+    m_nSectionHeights[section] += height + m_nSeparatorViewHeight;
+    for (unsigned int i=section+1; i<=m_nSections; i++)
+    {
+        ++m_nSectionItemStarts[i];
+    }
+    m_nFirstUpdatedItem = MIN(m_nFirstUpdatedItem, m_nSectionItemStarts[section] + 1 + row);
+    
+    // the rows of the ring after the new one move down by one slot
+    unsigned int flatRow = this->getFlatRow(section, row);
+    if (!m_pUsedTableCells.empty() && flatRow < m_nFirstUsedRow)
+    {
+        ++m_nFirstUsedRow;
+        this->recycleTableCell(cell, line);
+    }
+    else if (!m_pUsedTableCells.empty() && flatRow <= m_nFirstUsedRow + m_pUsedTableCells.size())
+    {
+        unsigned int index = flatRow - m_nFirstUsedRow;
+        m_pUsedTableCells.insert(m_pUsedTableCells.begin() + index, cell);
+        m_pUsedLines.insert(m_pUsedLines.begin() + index, line);
+        if (cell)
+        {
+            cell->m_nSection = section;
+            cell->m_nRow = row;
+        }
+    }
+    else
+    {
+        this->recycleTableCell(cell, line);
+    }
+}
+
+void CATableView::eraseRowItem(unsigned int section, unsigned int row, CATableViewCell*& cell, CAView*& line)
+{
+    cell = NULL;
+    line = NULL;
+    
+    // the rows of the ring after the erased one move up by one slot
+    unsigned int flatRow = this->getFlatRow(section, row);
+    if (!m_pUsedTableCells.empty() && flatRow < m_nFirstUsedRow)
+    {
+        --m_nFirstUsedRow;
+    }
+    else if (!m_pUsedTableCells.empty() && flatRow < m_nFirstUsedRow + m_pUsedTableCells.size())
+    {
+        unsigned int index = flatRow - m_nFirstUsedRow;
+        cell = m_pUsedTableCells[index];
+        line = m_pUsedLines[index];
+        m_pUsedTableCells.erase(m_pUsedTableCells.begin() + index);
+        m_pUsedLines.erase(m_pUsedLines.begin() + index);
+    }
+    
+    m_pSelectedTableCells.erase(CAIndexPath2E(section, row));
+    this->shiftRowsInSection(section, row + 1, -1);
+    
+    m_nSectionHeights[section] -= m_nRowHeightss[section][row] + m_nSeparatorViewHeight;
+    m_nRowHeightss[section].erase(m_nRowHeightss[section].begin() + row);
+    m_bRowMeasuredss[section].erase(m_bRowMeasuredss[section].begin() + row);
+    --m_nRowsInSections[section];
+    for (unsigned int i=section+1; i<=m_nSections; i++)
+    {
+        --m_nSectionItemStarts[i];
+    }
+    m_nFirstUpdatedItem = MIN(m_nFirstUpdatedItem, m_nSectionItemStarts[section] + 1 + row);
+}
+
+void CATableView::shiftRowsInSection(unsigned int section, unsigned int fromRow, int delta)
+{
+    // the cells in view and the selection follow their rows
+    std::deque<CATableViewCell*>::iterator itr;
+    for (itr=m_pUsedTableCells.begin(); itr!=m_pUsedTableCells.end(); itr++)
+    {
+        CATableViewCell* cell = *itr;
+        CC_CONTINUE_IF(cell == NULL);
+        CC_CONTINUE_IF(cell->m_nSection != section || cell->m_nRow < fromRow);
+        cell->m_nRow += delta;
+    }
+    
+    CC_RETURN_IF(m_pSelectedTableCells.empty());
+    
+    std::set<CAIndexPath2E> selectedTableCells;
+    std::set<CAIndexPath2E>::iterator itr2;
+    for (itr2=m_pSelectedTableCells.begin(); itr2!=m_pSelectedTableCells.end(); itr2++)
+    {
+        CAIndexPath2E indexPath = *itr2;
+        if (indexPath.section == section && indexPath.row >= fromRow)
+        {
+            indexPath.row += delta;
+        }
+        selectedTableCells.insert(indexPath);
+    }
+    m_pSelectedTableCells = selectedTableCells;
+}
+
+void CATableView::updateItemHeights(unsigned int firstItem)
+{
+    // the items from the first one changed are laid out again, the offsets before it are kept
+    std::vector<unsigned int> itemHeights;
+    for (unsigned int i=this->getSectionOfItem(firstItem); i<m_nSections; i++)
+    {
+        unsigned int start = m_nSectionItemStarts[i];
+        for (unsigned int item=MAX(firstItem, start); item<m_nSectionItemStarts[i + 1]; item++)
+        {
+            unsigned int local = item - start;
+            if (local == 0)
+            {
+                itemHeights.push_back(m_nSectionHeaderHeights[i]);
+            }
+            else if (local <= m_nRowsInSections[i])
+            {
+                itemHeights.push_back(m_nRowHeightss[i][local - 1] + m_nSeparatorViewHeight);
+            }
+            else
+            {
+                itemHeights.push_back(m_nSectionFooterHeights[i]);
+            }
+        }
+    }
+    m_obItemHeights.assign(firstItem, itemHeights);
+}
+
+void CATableView::applyUpdates()
+{
+    if (m_nFirstUpdatedItem != 0xffffffff)
+    {
+        this->updateItemHeights(m_nFirstUpdatedItem);
+        m_nFirstUpdatedItem = 0xffffffff;
+        this->layoutTableViews();
+    }
+    
+    // only the rows missing in the ring are asked to the data source
     this->recoveryTableCell();
     this->loadTableCell();
     this->updateSectionHeaderAndFooterRects();
@@ -17,6 +17,8 @@
 #include "cocoa/CCArray.h"
 #include "control/CAControl.h"
 #include "basics/CAIndexPath.h"
+#include "basics/CAFenwickTree.h"
+#include <deque>
 
 NS_CC_BEGIN
 
@@ -53,6 +55,13 @@ public:
         return 0;
     }
     
+    //Optional. An estimate of the heights of the rows: when it isn't 0, the height of a row
+    //is only asked when the row comes near the view, and the layout is corrected then
+    virtual unsigned int tableViewEstimatedRowHeight(CATableView* table)
+    {
+        return 0;
+    }
+    
     //Necessary
     virtual unsigned int numberOfRowsInSection(CATableView *table, unsigned int section)
     {
@@ -64,6 +73,18 @@ public:
         return 1;
     }
     
+    //Optional. The rows ahead of the scroll, before their cells are asked
+    virtual void tableViewPrefetchRowsAtIndexPaths(CATableView* table, const std::vector<CAIndexPath2E>& indexPaths)
+    {
+        
+    }
+    
+    //Optional. A cell made in an idle frame for the reuse pool of the identifier, see prewarmReusableCells
+    virtual CATableViewCell* tableCellWithReuseIdentifier(CATableView* table, const std::string& reuseIdentifier)
+    {
+        return NULL;
+    }
+    
     virtual CAView* tableViewSectionViewForHeaderInSection(CATableView* table, const CCSize& viewSize, unsigned int section)
     {
         return NULL;
@@ -119,6 +140,15 @@ public:
     
     CATableViewCell* dequeueReusableCellWithIdentifier(const char* reuseIdentifier);
     
+    // the freed cells of the identifier are kept up to the limit, 0 keeps them all
+    void setReusableCellsLimit(const std::string& reuseIdentifier, unsigned int limit);
+    
+    // fills the freed cells of the identifier up to count, one cell per idle frame, with tableCellWithReuseIdentifier
+    void prewarmReusableCells(const std::string& reuseIdentifier, unsigned int count);
+    
+    // releases the freed cells above count, for every identifier
+    void trimReusableCells(unsigned int count = 0);
+    
     virtual void setAllowsSelection(bool var);
     
     virtual void setAllowsMultipleSelection(bool var);
@@ -129,6 +159,23 @@ public:
     
     CATableViewCell* cellForRowAtIndexPath(unsigned int section, unsigned int row);
     
+    // the changes made between beginUpdates and endUpdates are laid out once, by endUpdates
+    void beginUpdates();
+    
+    void endUpdates();
+    
+    // the data source is already changed. The index paths are the ones of the new rows
+    void insertRowsAtIndexPaths(const std::vector<CAIndexPath2E>& indexPaths);
+    
+    // the index paths are the ones of the rows before the call
+    void deleteRowsAtIndexPaths(const std::vector<CAIndexPath2E>& indexPaths);
+    
+    // the cells of the rows are asked again to the data source, with their height
+    void reloadRowsAtIndexPaths(const std::vector<CAIndexPath2E>& indexPaths);
+    
+    // the row keeps its cell and its selection
+    void moveRowAtIndexPath(const CAIndexPath2E& indexPath, const CAIndexPath2E& newIndexPath);
+    
     CC_SYNTHESIZE(CATableViewDataSource*, m_pTableViewDataSource, TableViewDataSource);
     
     CC_SYNTHESIZE(CATableViewDelegate*, m_pTableViewDelegate, TableViewDelegate);
@@ -193,6 +240,46 @@ protected:
 
     void firstReloadData();
     
+    unsigned int getFlatRow(unsigned int section, unsigned int row);
+    
+    CAIndexPath2E getIndexPathOfFlatRow(unsigned int flatRow);
+    
+    unsigned int getSectionOfItem(unsigned int item);
+    
+    unsigned int getItemsOriginY();
+    
+    CCRect getSectionRect(unsigned int section);
+    
+    CCRect getRowRect(unsigned int section, unsigned int row);
+    
+    CCRect getLineRect(unsigned int section, unsigned int row);
+    
+    bool getRowsInRange(float top, float bottom, unsigned int& first, unsigned int& last);
+    
+    bool getVisibleRows(unsigned int& first, unsigned int& last);
+    
+    void prefetchTableCells();
+    
+    void prewarmTableCell(float dt);
+    
+    void recycleTableCell(CATableViewCell* cell, CAView* line);
+    
+    void setRowHeight(unsigned int section, unsigned int row, unsigned int height);
+    
+    void measureRowsInView();
+    
+    void layoutTableViews();
+    
+    void insertRowItem(unsigned int section, unsigned int row, unsigned int height, bool measured, CATableViewCell* cell, CAView* line);
+    
+    void eraseRowItem(unsigned int section, unsigned int row, CATableViewCell*& cell, CAView*& line);
+    
+    void shiftRowsInSection(unsigned int section, unsigned int fromRow, int delta);
+    
+    void updateItemHeights(unsigned int firstItem);
+    
+    void applyUpdates();
+    
 public:
     
     virtual bool ccTouchBegan(CATouch *pTouch, CAEvent *pEvent);
@@ -259,15 +346,23 @@ protected:
     
     std::vector<std::vector<unsigned int> > m_nRowHeightss;
     
-    std::vector<CCRect> m_rSectionRects;
+    // whether the height of a row was asked to the data source, or is still the estimate
+    std::vector<std::vector<bool> > m_bRowMeasuredss;
+    
+    unsigned int m_nEstimatedRowHeight;
+    
+    // heights of the section headers, rows (with their separator) and section footers, in layout order
+    CAFenwickTree m_obItemHeights;
+    
+    // index in m_obItemHeights of the header of every section, followed by the count of items
+    std::vector<unsigned int> m_nSectionItemStarts;
     
     std::map<int, CAView*> m_pSectionHeaderViews;
     
     std::map<int, CAView*> m_pSectionFooterViews;
-    
-    std::vector<std::vector<CCRect> > m_rTableCellRectss;
 
-    std::map<CAIndexPath2E, CATableViewCell*> m_pUsedTableCells;
+    // cells in view: a ring of consecutive rows, by flat row index from m_nFirstUsedRow
+    std::deque<CATableViewCell*> m_pUsedTableCells;
     
     std::map<std::string, CAVector<CATableViewCell*> > m_pFreedTableCells;
     
@@ -275,11 +370,26 @@ protected:
     
     CATableViewCell* m_pHighlightedTableCells;
     
-    std::vector<std::vector<CCRect> > m_rLineRectss;
+    std::deque<CAView*> m_pUsedLines;
     
-    std::map<CAIndexPath2E, CAView*> m_pUsedLines;
+    unsigned int m_nFirstUsedRow;
     
     CAList<CAView*> m_pFreedLines;
+    
+    unsigned int m_nUpdatesCount;
+    
+    // first item of m_obItemHeights changed by the updates, 0xffffffff if none
+    unsigned int m_nFirstUpdatedItem;
+    
+    // flat rows given to tableViewPrefetchRowsAtIndexPaths the last time, none if the first is after the last
+    unsigned int m_nPrefetchedFirstRow;
+    
+    unsigned int m_nPrefetchedLastRow;
+    
+    std::map<std::string, unsigned int> m_mReusableCellsLimits;
+    
+    // cells left to make for the reuse pools, by identifier
+    std::map<std::string, unsigned int> m_mPrewarmCounts;
 };
 
 class CC_DLL CATableViewCell: public CAControl
@@ -25,6 +25,7 @@
 #include "shaders/CAShaderCache.h"
 #include "shaders/CAGLProgram.h"
 #include "shaders/ccGLStateCache.h"
+#include "shaders/CARenderQueue.h"
 #include "CCEGLView.h"
 #include "cocoa/CCSet.h"
 #include "CAImageView.h"
@@ -56,6 +57,42 @@ static int viewCount = 0;
 
 static int s_globalOrderOfArrival = 1;
 
+// state of the visit in progress, propagated from the superview to its subviews:
+// visible world rect, world rotation and world scale of the superview
+static CAView* s_pVisitSuperview = NULL;
+
+// modelview the world transforms of the visited views apply to: the modelview the visit started
+// with, less the world transform of the superview of the view it started from
+static kmMat4 s_tVisitBaseMatrix;
+
+static unsigned int s_uVisitBaseVersion = 0;
+
+// versions of the world transforms and of the base matrices, 0 is never given
+static unsigned int s_uTransformVersion = 0;
+
+static CCRect s_obVisitCullingRect = CCRectZero;
+
+static int s_nVisitRotation = 0;
+
+static float s_fVisitScaleX = 1.0f;
+
+static float s_fVisitScaleY = 1.0f;
+
+static unsigned int s_uVisitCullingPaused = 0;
+
+static unsigned int s_uVisitRenderTargets = 0;
+
+// grid of the subviews boxes, built by hitTestSubview
+struct CAView::CAHitTestIndex
+{
+    CCRect rect;                                    // union of the subviews boxes, in the node space of the view
+    unsigned int columns;
+    unsigned int rows;
+    float cellWidth;
+    float cellHeight;
+    std::vector<std::vector<unsigned int> > cells;  // indices of the subviews overlapping each cell, in z order
+};
+
 CAView::CAView(void)
 : m_fRotationX(0.0f)
 , m_fRotationY(0.0f)
@@ -89,6 +126,17 @@ CAView::CAView(void)
 , _displayedColor(CAColor_white)
 , _realColor(CAColor_white)
 , m_bDisplayRange(true)
+, m_obWorldRect(CCRectZero)
+, m_sWorldTransform(CATransformationIdentity)
+, m_sWorldInverse(CATransformationIdentity)
+, m_fWorldVertexZ(0.0f)
+, m_bWorldTransformDirty(true)
+, m_uWorldTransformVersion(0)
+, m_uWorldSuperviewVersion(0)
+, m_uWorldInverseVersion(0)
+, m_uWorldRectVersion(0)
+, m_uVisitMatrixVersion(0)
+, m_uVisitBaseVersion(0)
 , m_pobImage(NULL)
 , m_bShouldBeHidden(false)
 , m_bFlipX(false)
@@ -98,11 +146,15 @@ CAView::CAView(void)
 , m_bHasChildren(false)
 , m_pViewDelegate(NULL)
 , m_bFrame(true)
-, m_bRestoreScissor(false)
-, m_obRestoreScissorRect(CCRectZero)
 , m_pobBatchView(NULL)
 , m_pobImageAtlas(NULL)
+, m_bUpdateDrawDeferred(false)
+, m_bUpdateDrawPending(false)
+, m_pHitTestIndex(NULL)
+, m_bHitTestIndexDirty(true)
 {
+    m_eResponderType = CAResponderTypeView;
+    
     m_pActionManager = CAApplication::getApplication()->getActionManager();
     m_pActionManager->retain();
     
@@ -143,6 +195,7 @@ CAView::~CAView(void)
     }
     m_obSubviews.clear();
     CC_SAFE_RELEASE(m_pobImage);
+    CC_SAFE_DELETE(m_pHitTestIndex);
     
     --viewCount;
     //CCLog("~CAView = %d\n",viewCount);
@@ -831,18 +884,88 @@ const char* CAView::description()
 void CAView::reViewlayout()
 {
     m_bTransformDirty = m_bInverseDirty = true;
+    m_bWorldTransformDirty = true;
+    
+    if (m_pSuperview)
+    {
+        m_pSuperview->m_bHitTestIndexDirty = true;
+    }
 }
 
 void CAView::updateDraw()
 {
+    if (m_bUpdateDrawDeferred)
+    {
+        m_bUpdateDrawPending = true;
+        return;
+    }
+    
     SET_DIRTY_RECURSIVELY();
     if (this->getSuperview())
     {
         this->reViewlayout();
-        CAApplication::getApplication()->updateDraw();
+        this->updateDrawRect();
+    }
+}
+
+void CAView::updateDrawRect()
+{
+    CAApplication* application = CAApplication::getApplication();
+    if (application->isPartialDraw())
+    {
+        application->updateDraw(this->getUpdateDrawRect());
+    }
+    else
+    {
+        application->updateDraw();
     }
 }
 
+CCRect CAView::getUpdateDrawRect()
+{
+    // everything drawn in the subtree of a clipping view lays in its bounds
+    CCSize winSize = CAApplication::getApplication()->getWinSize();
+    CCRect clipRect = CCRect(0, 0, winSize.width, winSize.height);
+    for (CAView* parent = m_pSuperview; parent; parent = parent->getSuperview())
+    {
+        if (!parent->m_bDisplayRange)
+        {
+            clipRect = parent->m_obWorldRect;
+            break;
+        }
+    }
+    
+    // the subviews may lay out of the bounds, views without size may draw free-form content
+    if ((m_bDisplayRange && !m_obSubviews.empty())
+        || m_obContentSize.width <= 0
+        || m_obContentSize.height <= 0)
+    {
+        return clipRect;
+    }
+    
+    // the bounds at the last visit and the current bounds
+    CCRect rect = CCRectApplyAffineTransform(this->getBounds(), this->nodeToWorldTransform());
+    if (m_obWorldRect.size.width > 0 && m_obWorldRect.size.height > 0)
+    {
+        float x = MIN(rect.getMinX(), m_obWorldRect.getMinX());
+        float y = MIN(rect.getMinY(), m_obWorldRect.getMinY());
+        float xx = MAX(rect.getMaxX(), m_obWorldRect.getMaxX());
+        float yy = MAX(rect.getMaxY(), m_obWorldRect.getMaxY());
+        rect = CCRect(x, y, xx - x, yy - y);
+    }
+    
+    float x = MAX(rect.getMinX(), clipRect.getMinX());
+    float y = MAX(rect.getMinY(), clipRect.getMinY());
+    float xx = MIN(rect.getMaxX(), clipRect.getMaxX());
+    float yy = MIN(rect.getMaxY(), clipRect.getMaxY());
+    if (xx <= x || yy <= y)
+    {
+        return CCRectZero;
+    }
+    
+    return CCRect(x, y, xx - x, yy - y);
+}
+
 CAView* CAView::getSubviewByTag(int aTag)
 {
     CCAssert( aTag != kCAObjectTagInvalid, "Invalid tag");
@@ -901,6 +1024,7 @@ void CAView::insertSubview(CAView* subview, int z)
     }
     
     m_bReorderChildDirty = true;
+    m_bHitTestIndexDirty = true;
     m_obSubviews.pushBack(subview);
     subview->_setZOrder(z);
     
@@ -988,6 +1112,9 @@ void CAView::removeAllSubviews()
         {
             if(m_bRunning)
             {
+                // the subview may lay out of the bounds, its rect is known while it is attached
+                (*itr)->updateDrawRect();
+                
                 (*itr)->onExitTransitionDidStart();
                 (*itr)->onExit();
             }
@@ -999,6 +1126,7 @@ void CAView::removeAllSubviews()
     }
 
     m_bHasChildren = false;
+    m_bHitTestIndexDirty = true;
 }
 
 
@@ -1009,6 +1137,9 @@ void CAView::detachSubview(CAView *subview)
     //  -2nd cleanup
     if (m_bRunning)
     {
+        // the subview may lay out of the bounds, its rect is known while it is attached
+        subview->updateDrawRect();
+        
         subview->onExitTransitionDidStart();
         subview->onExit();
     }
@@ -1017,6 +1148,7 @@ void CAView::detachSubview(CAView *subview)
     subview->setSuperview(NULL);
     
     m_obSubviews.eraseObject(subview);
+    m_bHitTestIndexDirty = true;
     
     this->updateDraw();
 }
@@ -1045,6 +1177,7 @@ void CAView::sortAllSubviews()
     if (m_bReorderChildDirty && !m_obSubviews.empty())
     {
         std::sort(m_obSubviews.begin(), m_obSubviews.end(), compareSubviewZOrder);
+        m_bHitTestIndexDirty = true;
     
         if (m_pobBatchView)
         {
@@ -1062,6 +1195,27 @@ void CAView::draw()
     CC_RETURN_IF(m_pobImage == NULL);
     CC_RETURN_IF(m_pShaderProgram == NULL);
     
+    CC_PROFILER_START_CATEGORY(kCCProfilerCategorySprite, "CAView - draw");
+    
+#ifndef EMSCRIPTEN
+    CARenderQueue* pRenderQueue = CARenderQueue::sharedRenderQueue();
+    if (pRenderQueue->isEnabled())
+    {
+        kmMat4 matrixMV;
+        kmGLGetMatrix(KM_GL_MODELVIEW, &matrixMV);
+        pRenderQueue->addQuad(m_sQuad, matrixMV, m_pobImage->getName(), m_pShaderProgram, m_sBlendFunc);
+        
+#if CC_SPRITE_DEBUG_DRAW > 0
+        // the box is drawn over the quad
+        pRenderQueue->flush();
+        this->drawDebugBox();
+#endif
+        
+        CC_PROFILER_STOP_CATEGORY(kCCProfilerCategorySprite, "CAView - draw");
+        return;
+    }
+#endif
+    
     CC_NODE_DRAW_SETUP();
     
     ccGLBlendFunc(m_sBlendFunc.src, m_sBlendFunc.dst);
@@ -1112,6 +1266,18 @@ void CAView::draw()
     CHECK_GL_ERROR_DEBUG();
     
     
+#if CC_SPRITE_DEBUG_DRAW > 0
+    this->drawDebugBox();
+#endif
+    
+    CC_INCREMENT_GL_DRAWS(1);
+    
+    CC_PROFILER_STOP_CATEGORY(kCCProfilerCategorySprite, "CAView - draw");
+}
+
+#if CC_SPRITE_DEBUG_DRAW > 0
+void CAView::drawDebugBox()
+{
 #if CC_SPRITE_DEBUG_DRAW == 1
     // draw bounding box
     CCPoint vertices[4]=
@@ -1135,43 +1301,143 @@ void CAView::draw()
     };
     ccDrawPoly(vertices, 4, true);
 #endif // CC_SPRITE_DEBUG_DRAW
-    
-    CC_INCREMENT_GL_DRAWS(1);
-    
-    CC_PROFILER_STOP_CATEGORY(kCCProfilerCategorySprite, "CAView - draw");
 }
+#endif
 
 void CAView::visit()
 {
     CC_RETURN_IF(!m_bVisible);
     
-    kmGLPushMatrix();
-
-    this->transform();
+    // state of the visit of the superview, restored before returning
+    CAView* pVisitSuperview = s_pVisitSuperview;
+    CCRect obVisitCullingRect = s_obVisitCullingRect;
+    int nVisitRotation = s_nVisitRotation;
+    float fVisitScaleX = s_fVisitScaleX;
+    float fVisitScaleY = s_fVisitScaleY;
+    kmMat4 tVisitBaseMatrix = s_tVisitBaseMatrix;
+    unsigned int uVisitBaseVersion = s_uVisitBaseVersion;
+    
+    if (s_pVisitSuperview == NULL || s_pVisitSuperview != m_pSuperview)
+    {
+        // visited out of the subviews of the superview (root view, stencil, render target),
+        // the state of the superview is computed from the ancestors once
+        s_nVisitRotation = 0;
+        s_fVisitScaleX = s_fVisitScaleY = 1.0f;
+        for (CAView* parent = m_pSuperview; parent; parent = parent->getSuperview())
+        {
+            s_nVisitRotation += parent->getRotation();
+            s_fVisitScaleX *= parent->getScaleX();
+            s_fVisitScaleY *= parent->getScaleY();
+        }
+        
+        // the current modelview is the one the view is drawn in, before its own transform
+        CAView::updateVisitBaseMatrix(m_pSuperview);
+        
+        this->updateWorldTransform();
+        
+        // the visible rect is the redrawn rect of the screen, with a margin for the subpixel offset of the scene
+        const CCRect& drawRect = CAApplication::getApplication()->getDrawRect();
+        s_obVisitCullingRect = CCRect(drawRect.origin.x - 1.0f,
+                                      drawRect.origin.y - 1.0f,
+                                      drawRect.size.width + 2.0f,
+                                      drawRect.size.height + 2.0f);
+    }
+    else
+    {
+        // the superview was visited just before, its world transform is up to date
+        this->updateWorldTransformFromSuperview();
+    }
     
-    if (!m_bDisplayRange)
+    CCRect obSuperviewCullingRect = s_obVisitCullingRect;
+    
+    // world state of this view, used by its subviews
+    s_pVisitSuperview = this;
+    s_nVisitRotation += this->getRotation();
+    s_fVisitScaleX *= this->getScaleX();
+    s_fVisitScaleY *= this->getScaleY();
+    
+    if (m_pCamera)
+    {
+        this->pauseVisitCulling();
+    }
+    
+    bool bDrawSelf = true;
+    
+    CCRect worldRect = m_obWorldRect;
+    if (m_uWorldRectVersion != m_uWorldTransformVersion)
+    {
+        worldRect = CCRectApplyAffineTransform(this->getBounds(), m_sWorldTransform);
+        
+        // the rect of the screen is kept while the view is drawn into an image
+        if (s_uVisitRenderTargets == 0)
+        {
+            m_obWorldRect = worldRect;
+            m_uWorldRectVersion = m_uWorldTransformVersion;
+        }
+    }
+    
+    if (s_uVisitCullingPaused == 0 && CAApplication::getApplication()->isViewCulling())
     {
-        if (glIsEnabled(GL_SCISSOR_TEST))
+        if (!worldRect.intersectsRect(obSuperviewCullingRect))
         {
-            GLfloat params[4];
-            glGetFloatv(GL_SCISSOR_BOX, params);
-            m_bRestoreScissor = true;
-            m_obRestoreScissorRect = CCRect(params[0] - 1.0f, params[1], params[2] + 1.0f, params[3] + 1.0f);
+            // the subviews are clipped to the bounds, nothing of the subtree can be seen
+            if (!m_bDisplayRange)
+            {
+                s_pVisitSuperview = pVisitSuperview;
+                s_obVisitCullingRect = obVisitCullingRect;
+                s_nVisitRotation = nVisitRotation;
+                s_fVisitScaleX = fVisitScaleX;
+                s_fVisitScaleY = fVisitScaleY;
+                s_tVisitBaseMatrix = tVisitBaseMatrix;
+                s_uVisitBaseVersion = uVisitBaseVersion;
+                return;
+            }
+            
+            // the subviews may lay out of the bounds, only the view itself is skipped.
+            // views without size are kept, they may draw free-form content
+            bDrawSelf = m_obContentSize.width <= 0 || m_obContentSize.height <= 0;
         }
+        else if (!m_bDisplayRange)
+        {
+            float x = MAX(worldRect.getMinX(), obSuperviewCullingRect.getMinX());
+            float y = MAX(worldRect.getMinY(), obSuperviewCullingRect.getMinY());
+            float xx = MIN(worldRect.getMaxX(), obSuperviewCullingRect.getMaxX());
+            float yy = MIN(worldRect.getMaxY(), obSuperviewCullingRect.getMaxY());
+            s_obVisitCullingRect = CCRect(x, y, xx - x, yy - y);
+        }
+    }
+    
+    kmGLPushMatrix();
+    
+    // the modelview is multiplied again only when the view, one of its ancestors or the base moved
+    if (m_uVisitMatrixVersion != m_uWorldTransformVersion || m_uVisitBaseVersion != s_uVisitBaseVersion)
+    {
+        kmMat4 world;
+        CGAffineToGL(&m_sWorldTransform, world.mat);
+        world.mat[14] = m_fWorldVertexZ;
+        kmMat4Multiply(&m_tVisitMatrix, &s_tVisitBaseMatrix, &world);
+        m_uVisitMatrixVersion = m_uWorldTransformVersion;
+        m_uVisitBaseVersion = s_uVisitBaseVersion;
+    }
+    kmGLLoadMatrix(&m_tVisitMatrix);
+    
+    if (m_pCamera)
+    {
+        // the subviews are drawn in the space of the camera
+        this->transformCamera();
+        CAView::updateVisitBaseMatrix(this);
+    }
+    
+    if (!m_bDisplayRange)
+    {
+        CARenderQueue::sharedRenderQueue()->flush();
         
         CCPoint point = CCPointZero;
         
         CCSize size = this->getBounds().size;
         
         {
-            int rotation = this->getRotation();
-            
-            CAView* parent = this->getSuperview();
-            while (parent)
-            {
-                rotation += parent->getRotation();
-                parent = parent->getSuperview();
-            }
+            int rotation = s_nVisitRotation;
             
             if (fabsf(rotation % 360 - 90) < FLT_EPSILON)
             {
@@ -1196,8 +1462,9 @@ void CAView::visit()
                 point = CCPoint(0, this->getBounds().size.height);
             }
         }
-        point = this->convertToWorldSpace(point);
-        point = CAApplication::getApplication()->convertToGL(point);
+        // node space to GL window space, with the world transform of the visit
+        point.y = this->getBounds().size.height - point.y;
+        point = CCPointApplyAffineTransform(point, m_sWorldTransform);
         
         
         CCEGLView* pGLView = CCEGLView::sharedOpenGLView();
@@ -1207,37 +1474,15 @@ void CAView::visit()
         float off_X = pGLView->getViewPortRect().origin.x;
         float off_Y = pGLView->getViewPortRect().origin.y;
         
-        float scaleX = this->getScaleX();
-        float scaleY = this->getScaleY();
-        
-        CAView* parent = this->getSuperview();
-        while (parent)
-        {
-            scaleX *= parent->getScaleX();
-            scaleY *= parent->getScaleY();
-            parent = parent->getSuperview();
-        }
+        float scaleX = s_fVisitScaleX;
+        float scaleY = s_fVisitScaleY;
         
         CCRect frame = CCRect((point.x - 0) * glScaleX + off_X,
                                   (point.y - 0) * glScaleY + off_Y,
                                   (size.width + 0) * scaleX * glScaleX,
                                   (size.height + 0) * scaleY * glScaleY);
-        if (m_bRestoreScissor)
-        {
-            if (frame.intersectsRect(m_obRestoreScissorRect))
-            {
-                float x = MAX(frame.origin.x, m_obRestoreScissorRect.origin.x);
-                float y = MAX(frame.origin.y, m_obRestoreScissorRect.origin.y);
-                float xx = MIN(frame.origin.x+frame.size.width, m_obRestoreScissorRect.origin.x+m_obRestoreScissorRect.size.width);
-                float yy = MIN(frame.origin.y+frame.size.height, m_obRestoreScissorRect.origin.y+m_obRestoreScissorRect.size.height);
-                glScissor(x - 0.5f, y + 0.5f, xx-x + 1.0f, yy-y);
-            }
-        }
-        else
-        {
-            glEnable(GL_SCISSOR_TEST);
-            glScissor(frame.origin.x - 0.5f, frame.origin.y + 0.5f, frame.size.width + 1.0f, frame.size.height);
-        }
+        
+        ccGLPushScissor(frame.origin.x - 0.5f, frame.origin.y + 0.5f, frame.size.width + 1.0f, frame.size.height);
     }
 
     this->sortAllSubviews();
@@ -1250,7 +1495,10 @@ void CAView::visit()
         itr++;
     }
     
-    this->draw();
+    if (bDrawSelf)
+    {
+        this->draw();
+    }
     
     while (itr!=m_obSubviews.end())
     {
@@ -1262,20 +1510,76 @@ void CAView::visit()
     
     if (!m_bDisplayRange)
     {
-        if (m_bRestoreScissor)
-        {
-            glScissor(m_obRestoreScissorRect.origin.x,
-                      m_obRestoreScissorRect.origin.y,
-                      m_obRestoreScissorRect.size.width, 
-                      m_obRestoreScissorRect.size.height);
-        }
-        else
-        {
-            glDisable(GL_SCISSOR_TEST);
-        }
+        CARenderQueue::sharedRenderQueue()->flush();
+        
+        ccGLPopScissor();
     }
 
     kmGLPopMatrix();
+    
+    if (m_pCamera)
+    {
+        this->resumeVisitCulling();
+    }
+    
+    s_pVisitSuperview = pVisitSuperview;
+    s_obVisitCullingRect = obVisitCullingRect;
+    s_nVisitRotation = nVisitRotation;
+    s_fVisitScaleX = fVisitScaleX;
+    s_fVisitScaleY = fVisitScaleY;
+    s_tVisitBaseMatrix = tVisitBaseMatrix;
+    s_uVisitBaseVersion = uVisitBaseVersion;
+}
+
+void CAView::updateVisitBaseMatrix(CAView* superview)
+{
+    kmMat4 matrix;
+    kmGLGetMatrix(KM_GL_MODELVIEW, &matrix);
+    
+    if (superview)
+    {
+        // the world transform is an affine transform of x and y with a translation of z
+        kmMat4 inverse;
+        CATransformation obInverse = superview->worldToNodeTransform();
+        CGAffineToGL(&obInverse, inverse.mat);
+        inverse.mat[14] = -superview->m_fWorldVertexZ;
+        kmMat4Multiply(&matrix, &matrix, &inverse);
+    }
+    
+    // the modelviews of the views stay valid while the base does not change
+    if (s_uVisitBaseVersion == 0 || memcmp(&matrix, &s_tVisitBaseMatrix, sizeof(kmMat4)) != 0)
+    {
+        s_tVisitBaseMatrix = matrix;
+        s_uVisitBaseVersion = ++s_uTransformVersion;
+    }
+}
+
+void CAView::pauseVisitCulling()
+{
+    ++s_uVisitCullingPaused;
+}
+
+void CAView::resumeVisitCulling()
+{
+    if (s_uVisitCullingPaused > 0)
+    {
+        --s_uVisitCullingPaused;
+    }
+}
+
+void CAView::beginVisitRenderTarget()
+{
+    ++s_uVisitRenderTargets;
+    pauseVisitCulling();
+}
+
+void CAView::endVisitRenderTarget()
+{
+    resumeVisitCulling();
+    if (s_uVisitRenderTargets > 0)
+    {
+        --s_uVisitRenderTargets;
+    }
 }
 
 void CAView::transformAncestors()
@@ -1300,7 +1604,11 @@ void CAView::transform()
     
     kmGLMultMatrix( &transfrom4x4 );
     
-    
+    this->transformCamera();
+}
+
+void CAView::transformCamera()
+{
     // XXX: Expensive calls. Camera should be integrated into the cached affine matrix
     if ( m_pCamera != NULL)
     {
@@ -1566,7 +1874,8 @@ CATransformation CAView::nodeToParentTransform(void)
 void CAView::setAdditionalTransform(const CATransformation& additionalTransform)
 {
     m_sAdditionalTransform = additionalTransform;
-    m_bTransformDirty = true;
+    m_bTransformDirty = m_bInverseDirty = true;
+    m_bWorldTransformDirty = true;
     m_bAdditionalTransformDirty = true;
 }
 
@@ -1581,19 +1890,52 @@ CATransformation CAView::parentToNodeTransform(void)
     return m_sInverse;
 }
 
-CATransformation CAView::nodeToWorldTransform()
+void CAView::updateWorldTransform()
 {
-    CATransformation t = this->nodeToParentTransform();
+    if (m_pSuperview)
+    {
+        m_pSuperview->updateWorldTransform();
+    }
+    this->updateWorldTransformFromSuperview();
+}
+
+void CAView::updateWorldTransformFromSuperview()
+{
+    // a move of an ancestor changes the version of its world transform, the ones below follow here
+    unsigned int uSuperviewVersion = m_pSuperview ? m_pSuperview->m_uWorldTransformVersion : 0;
+    CC_RETURN_IF(!m_bWorldTransformDirty && m_uWorldSuperviewVersion == uSuperviewVersion);
     
-    for (CAView *p = m_pSuperview; p != NULL; p = p->getSuperview())
-        t = CATransformationConcat(t, p->nodeToParentTransform());
+    if (m_pSuperview)
+    {
+        m_sWorldTransform = CATransformationConcat(this->nodeToParentTransform(), m_pSuperview->m_sWorldTransform);
+        m_fWorldVertexZ = m_pSuperview->m_fWorldVertexZ + m_fVertexZ;
+    }
+    else
+    {
+        m_sWorldTransform = this->nodeToParentTransform();
+        m_fWorldVertexZ = m_fVertexZ;
+    }
     
-    return t;
+    m_bWorldTransformDirty = false;
+    m_uWorldSuperviewVersion = uSuperviewVersion;
+    m_uWorldTransformVersion = ++s_uTransformVersion;
+}
+
+CATransformation CAView::nodeToWorldTransform()
+{
+    this->updateWorldTransform();
+    return m_sWorldTransform;
 }
 
 CATransformation CAView::worldToNodeTransform(void)
 {
-    return CATransformationInvert(this->nodeToWorldTransform());
+    this->updateWorldTransform();
+    if (m_uWorldInverseVersion != m_uWorldTransformVersion)
+    {
+        m_sWorldInverse = CATransformationInvert(m_sWorldTransform);
+        m_uWorldInverseVersion = m_uWorldTransformVersion;
+    }
+    return m_sWorldInverse;
 }
 
 CCRect CAView::convertRectToNodeSpace(const CrossApp::CCRect &worldRect)
@@ -1653,6 +1995,154 @@ CCPoint CAView::convertTouchToNodeSpaceAR(CATouch *touch)
     return this->convertToNodeSpaceAR(point);
 }
 
+// below this count the subviews are tested one by one
+static const unsigned int s_uHitTestIndexMinSubviews = 16;
+
+static const unsigned int s_uHitTestIndexMaxColumns = 16;
+
+static bool hitTestSubviewAtPoint(CAView* subview, const CCPoint& point, CCPoint& nodePoint)
+{
+    if (!subview->isVisible() || !subview->isTouchEnabled())
+    {
+        return false;
+    }
+    
+    // parentToNodeTransform is the inverse cached until the layout of the subview changes
+    nodePoint = CCPointApplyAffineTransform(point, subview->parentToNodeTransform());
+    
+    CCRect bounds = subview->getBounds();
+    return bounds.containsPoint(CCPoint(nodePoint.x, bounds.size.height - nodePoint.y));
+}
+
+CAView* CAView::hitTestSubview(CCPoint& point)
+{
+    this->sortAllSubviews();
+    
+    CCPoint nodePoint;
+    
+    if (m_obSubviews.size() < s_uHitTestIndexMinSubviews)
+    {
+        CAVector<CAView*>::const_reverse_iterator itr;
+        for (itr=m_obSubviews.rbegin(); itr!=m_obSubviews.rend(); itr++)
+        {
+            if (hitTestSubviewAtPoint(*itr, point, nodePoint))
+            {
+                point = nodePoint;
+                return *itr;
+            }
+        }
+        return NULL;
+    }
+    
+    if (m_pHitTestIndex == NULL)
+    {
+        m_pHitTestIndex = new CAHitTestIndex();
+        m_bHitTestIndexDirty = true;
+    }
+    
+    CAHitTestIndex& index = *m_pHitTestIndex;
+    
+    if (m_bHitTestIndexDirty)
+    {
+        unsigned int count = (unsigned int)m_obSubviews.size();
+        
+        std::vector<CCRect> boxes(count);
+        for (unsigned int i=0; i<count; i++)
+        {
+            CAView* subview = m_obSubviews.at(i);
+            boxes[i] = CCRectApplyAffineTransform(subview->getBounds(), subview->nodeToParentTransform());
+            
+            if (i == 0)
+            {
+                index.rect = boxes[i];
+            }
+            else
+            {
+                float x = MIN(index.rect.getMinX(), boxes[i].getMinX());
+                float y = MIN(index.rect.getMinY(), boxes[i].getMinY());
+                float xx = MAX(index.rect.getMaxX(), boxes[i].getMaxX());
+                float yy = MAX(index.rect.getMaxY(), boxes[i].getMaxY());
+                index.rect = CCRect(x, y, xx - x, yy - y);
+            }
+        }
+        
+        // about one subview per cell
+        unsigned int side = (unsigned int)ceilf(sqrtf((float)count));
+        side = MIN(side, s_uHitTestIndexMaxColumns);
+        index.columns = index.rect.size.width > 0 ? side : 1;
+        index.rows = index.rect.size.height > 0 ? side : 1;
+        index.cellWidth = index.rect.size.width / index.columns;
+        index.cellHeight = index.rect.size.height / index.rows;
+        
+        // the vectors of the cells keep their capacity between the builds
+        index.cells.resize(index.columns * index.rows);
+        std::vector<std::vector<unsigned int> >::iterator itr_cell;
+        for (itr_cell=index.cells.begin(); itr_cell!=index.cells.end(); itr_cell++)
+        {
+            itr_cell->clear();
+        }
+        
+        for (unsigned int i=0; i<count; i++)
+        {
+            unsigned int minColumn = 0, maxColumn = 0, minRow = 0, maxRow = 0;
+            if (index.columns > 1)
+            {
+                minColumn = (unsigned int)((boxes[i].getMinX() - index.rect.getMinX()) / index.cellWidth);
+                maxColumn = (unsigned int)((boxes[i].getMaxX() - index.rect.getMinX()) / index.cellWidth);
+                maxColumn = MIN(maxColumn, index.columns - 1);
+                minColumn = MIN(minColumn, maxColumn);
+            }
+            if (index.rows > 1)
+            {
+                minRow = (unsigned int)((boxes[i].getMinY() - index.rect.getMinY()) / index.cellHeight);
+                maxRow = (unsigned int)((boxes[i].getMaxY() - index.rect.getMinY()) / index.cellHeight);
+                maxRow = MIN(maxRow, index.rows - 1);
+                minRow = MIN(minRow, maxRow);
+            }
+            
+            for (unsigned int row=minRow; row<=maxRow; row++)
+            {
+                for (unsigned int column=minColumn; column<=maxColumn; column++)
+                {
+                    index.cells[row * index.columns + column].push_back(i);
+                }
+            }
+        }
+        
+        m_bHitTestIndexDirty = false;
+    }
+    
+    if (!index.rect.containsPoint(point))
+    {
+        return NULL;
+    }
+    
+    unsigned int column = 0, row = 0;
+    if (index.columns > 1)
+    {
+        column = (unsigned int)((point.x - index.rect.getMinX()) / index.cellWidth);
+        column = MIN(column, index.columns - 1);
+    }
+    if (index.rows > 1)
+    {
+        row = (unsigned int)((point.y - index.rect.getMinY()) / index.cellHeight);
+        row = MIN(row, index.rows - 1);
+    }
+    
+    const std::vector<unsigned int>& cell = index.cells[row * index.columns + column];
+    std::vector<unsigned int>::const_reverse_iterator itr;
+    for (itr=cell.rbegin(); itr!=cell.rend(); itr++)
+    {
+        CAView* subview = m_obSubviews.at(*itr);
+        if (hitTestSubviewAtPoint(subview, point, nodePoint))
+        {
+            point = nodePoint;
+            return subview;
+        }
+    }
+    return NULL;
+}
+
 void CAView::updateTransform()
 {
     // Recursively iterate over children
@@ -260,6 +260,8 @@ public:
     void transform(void);
     
     void transformAncestors(void);
+    
+    void transformCamera(void);
 
     virtual void updateTransform(void);
 
@@ -287,6 +289,11 @@ public:
 
     CCPoint convertTouchToNodeSpaceAR(CATouch * touch);
     
+    /** the topmost visible, touch enabled subview containing the point, NULL if none;
+     the point is in the node space of this view (y up, as after worldToNodeTransform)
+     and is converted in place to the node space of the subview found */
+    CAView* hitTestSubview(CCPoint& point);
+    
     virtual void setOrderOfArrival(unsigned int uOrderOfArrival);
     
     virtual unsigned int getOrderOfArrival();
@@ -370,9 +377,19 @@ protected:
     void detachSubview(CAView *subview);
 
     void updateDraw();
+    
+    /** the rect of the screen to redraw after a change of the view, in world (GL) points */
+    CCRect getUpdateDrawRect();
+    
+    /** marks the rect of the view dirty, or the whole screen when the rects are not used */
+    void updateDrawRect();
 
     void updateColor(void);
     
+#if CC_SPRITE_DEBUG_DRAW > 0
+    void drawDebugBox();
+#endif
+    
     virtual void setPoint(const CCPoint &point);
     
     virtual void setContentSize(const CCSize& contentSize);
@@ -397,8 +414,29 @@ protected:
     
     virtual void updateImageRect();
     
+    /** disables the culling of the views visited until the matching resumeVisitCulling(),
+     used when the current world transform or screen does not apply (stencils, render targets) */
+    static void pauseVisitCulling();
+    
+    static void resumeVisitCulling();
+    
+    /** the views visited until the matching endVisitRenderTarget() are drawn into an image,
+     their culling is paused and the rects of the screen they lay on are kept */
+    static void beginVisitRenderTarget();
+    
+    static void endVisitRenderTarget();
+    
 protected:
     
+    /** computes the world transform again if the view or one of its ancestors moved since */
+    void updateWorldTransform();
+    
+    /** same, the world transform of the superview being up to date */
+    void updateWorldTransformFromSuperview();
+    
+    /** sets the base matrix of the visit from the current modelview, the one of the superview */
+    static void updateVisitBaseMatrix(CAView* superview);
+    
     CC_SYNTHESIZE(CAViewDelegate*, m_pViewDelegate, ViewDelegate);
     
     CC_SYNTHESIZE_IS_READONLY(bool, m_bFrame, Frame);
@@ -465,8 +503,21 @@ protected:
     CAColor4B   _realColor;
     
     bool m_bDisplayRange;
-    bool m_bRestoreScissor;
-    CCRect m_obRestoreScissorRect;
+    
+    CCRect m_obWorldRect;               ///< bounds in world (GL) points at the last visit
+    
+    CATransformation m_sWorldTransform;         ///< nodeToWorldTransform, valid while the versions below match
+    CATransformation m_sWorldInverse;           ///< worldToNodeTransform
+    float m_fWorldVertexZ;                      ///< vertexZ of the view added to the ones of its ancestors
+    bool m_bWorldTransformDirty;                ///< the transform to the superview changed
+    unsigned int m_uWorldTransformVersion;      ///< changes every time the world transform is computed
+    unsigned int m_uWorldSuperviewVersion;      ///< version of the world transform of the superview it comes from
+    unsigned int m_uWorldInverseVersion;        ///< version of the world transform m_sWorldInverse comes from
+    unsigned int m_uWorldRectVersion;           ///< version of the world transform m_obWorldRect comes from
+    
+    kmMat4 m_tVisitMatrix;                      ///< modelview of the last visit
+    unsigned int m_uVisitMatrixVersion;         ///< version of the world transform m_tVisitMatrix comes from
+    unsigned int m_uVisitBaseVersion;           ///< version of the base matrix of the visit m_tVisitMatrix comes from
 
     unsigned int        m_uAtlasIndex;          /// Absolute (real) Index on the SpriteSheet
     
@@ -495,6 +546,13 @@ protected:
     
     CAImage*       m_pobImage;            /// CAImage object that is used to render the sprite
     
+    bool m_bUpdateDrawDeferred;                 /// set while CAViewAnimation changes several properties, updateDraw waits for the last one
+    bool m_bUpdateDrawPending;                  /// updateDraw was called while deferred
+    
+    struct CAHitTestIndex;
+    CAHitTestIndex* m_pHitTestIndex;            /// grid of the subviews boxes, for the views with many subviews
+    bool m_bHitTestIndexDirty;                  /// a subview was added, removed, reordered or moved since the index was built
+    
     friend class CAViewAnimation;
 };
 